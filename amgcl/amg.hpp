@@ -33,11 +33,26 @@ THE SOFTWARE.
 
 #include <iostream>
 #include <iomanip>
+#include <algorithm>
 #include <list>
+#include <map>
 #include <memory>
+#include <vector>
+#include <string>
+#include <sstream>
+
+#ifdef _OPENMP
+#  include <omp.h>
+#endif
 
 #include <amgcl/backend/builtin.hpp>
+#include <amgcl/backend/multi_vector.hpp>
 #include <amgcl/solver/detail/default_inner_product.hpp>
+#include <amgcl/coarsening/detail/galerkin.hpp>
+#include <amgcl/detail/object_pool.hpp>
+#include <amgcl/detail/cycle.hpp>
+#include <amgcl/detail/team_cycle.hpp>
+#include <amgcl/io/binary.hpp>
 #include <amgcl/util.hpp>
 
 /// Primary namespace.
@@ -59,6 +74,11 @@ namespace amgcl {
  *
  * Instance of the class builds the AMG hierarchy for the given system matrix
  * and is intended to be used as a preconditioner.
+ *
+ * The hierarchy is not modified during the solution phase. The temporary
+ * vectors needed for a cycle are kept in a workspace, which is either
+ * provided by the caller, or is taken from an internal pool. Hence, the same
+ * instance may be applied from several threads at once.
  */
 template <
     class Backend,
@@ -76,7 +96,9 @@ class amg {
         typedef Coarsening<Backend>          coarsening_type;
         typedef Relax<Backend>               relax_type;
 
-        typedef typename backend::builtin<value_type>::matrix build_matrix;
+        typedef typename Backend::col_type col_type;
+        typedef typename Backend::ptr_type ptr_type;
+        typedef typename backend::builtin<value_type, col_type, ptr_type>::matrix build_matrix;
 
         typedef typename math::scalar_of<value_type>::type scalar_type;
 
@@ -126,14 +148,143 @@ class amg {
             /// Number of cycles (1 for V-cycle, 2 for W-cycle, etc.).
             unsigned ncycle;
 
+            /// Type of the cycle.
+            /**
+             * The standard cycle visits each coarse level ncycle times. The
+             * F-cycle visits each coarse level with an F-cycle followed by a
+             * standard cycle. The K-cycle replaces the coarse level correction
+             * with one or two steps of the flexible conjugate gradient method
+             * preconditioned with the K-cycle on the coarse level. The K-cycle
+             * needs two more temporary vectors per level, and falls back to
+             * the standard cycle when applied to multi-vectors. The additive
+             * cycle restricts the residual to all of the levels, smooths the
+             * levels independently, and sums the interpolated corrections.
+             * The levels are smoothed at the same time by the disjoint teams
+             * of threads when the nested parallelism is enabled by the caller
+             * (e.g. with OMP_MAX_ACTIVE_LEVELS=2), and one after another
+             * otherwise.
+             */
+            cycle_type::type cycle;
+
             /// Number of cycles to make as part of preconditioning.
             unsigned pre_cycles;
 
+            /// Keep the data needed for the rebuild of the hierarchy.
+            /**
+             * When set, the hierarchy may be rebuilt with amg::rebuild() for
+             * a new matrix. The system matrices and the transfer operators
+             * of all levels are kept in the build format, together with the
+             * aggregates (or the C/F splitting), and the intermediate
+             * products of the Galerkin operators. This increases the memory
+             * footprint of the hierarchy.
+             */
+            bool allow_rebuild;
+
+            /// Minimize the peak memory of the setup.
+            /**
+             * When set, the Galerkin operators are computed without storing
+             * the intermediate A * P products completely (for the
+             * coarsenings that support this, see
+             * coarsening::detail::lean_tag). This is slower, but reduces the
+             * peak memory of the setup. The option has no effect on the
+             * levels where the products are kept for the rebuild (see
+             * allow_rebuild).
+             */
+            bool lean_setup;
+
+            /// Execute the cycle by a single team of threads.
+            /**
+             * When set, the standard cycle is executed inside a single
+             * parallel region instead of opening a parallel region in each
+             * of the kernels. The rows of each level are split into blocks,
+             * and a block waits only for its neighbour blocks to complete
+             * the previous step of the cycle. The threads are synchronized
+             * with barriers only around the transfers between the levels.
+             * The levels with fewer than team_min_rows rows, and the levels
+             * below them, are processed by a single thread. Only the builtin
+             * backend and the smoothers that support row updates (spai0 and
+             * damped_jacobi) are supported; the usual cycle is used
+             * otherwise.
+             */
+            bool team_cycle;
+
+            /// The smallest level that is processed by the team of threads.
+            unsigned team_min_rows;
+
+            /// Minimum number of rows per thread in the kernels of a level.
+            /**
+             * When set, the work of each level is estimated at the setup,
+             * and the kernels of the level use one thread per
+             * min_rows_per_thread rows of the finest level worth of work
+             * (but at least one thread). The work is the number of nonzeros
+             * for the smoothed levels, and the size of the factorization
+             * for the directly solved coarsest level. The small coarse
+             * levels, where the fork/join overhead and the false sharing
+             * outweigh the work, are processed by a few threads, or by a
+             * single one. The default of 4096 rows gives each thread about
+             * ten times the fork/join cost of a parallel region worth of
+             * SpMV work. Zero means all of the available threads are used
+             * on each level.
+             */
+            unsigned min_rows_per_thread;
+
+            /// Smoother and the number of sweeps on a level.
+            struct level_params {
+                relax_params relax; ///< Relaxation parameters.
+                unsigned     npre;  ///< Number of pre-relaxations.
+                unsigned     npost; ///< Number of post-relaxations.
+
+                level_params() : npre(1), npost(1) {}
+
+                level_params(const relax_params &relax, unsigned npre, unsigned npost)
+                    : relax(relax), npre(npre), npost(npost) {}
+
+#ifndef AMGCL_NO_BOOST
+                // The values missing in the property tree are taken from
+                // the given defaults.
+                level_params(const boost::property_tree::ptree &p,
+                        const relax_params &relax, unsigned npre, unsigned npost)
+                    : relax(p.count("relax") ? relax_params(p.get_child("relax")) : relax),
+                      npre(p.get("npre", npre)), npost(p.get("npost", npost))
+                {
+                    check_params(p, {"relax", "npre", "npost"});
+                }
+
+                void get(boost::property_tree::ptree &p, const std::string &path) const {
+                    AMGCL_PARAMS_EXPORT_CHILD(p, path, relax);
+                    AMGCL_PARAMS_EXPORT_VALUE(p, path, npre);
+                    AMGCL_PARAMS_EXPORT_VALUE(p, path, npost);
+                }
+#endif
+            };
+
+            /// Per-level overrides of the smoother and of the number of sweeps.
+            /**
+             * The key is the level index (0 is the finest level). The levels
+             * without an override use relax, npre, and npost. In the
+             * property tree the overrides are set as `level.<i>.relax`,
+             * `level.<i>.npre`, and `level.<i>.npost`; the values that are
+             * not set are taken from the global ones (the relax subtree
+             * replaces the global one as a whole). With the runtime
+             * relaxation wrapper this allows to select the smoother type for
+             * each level. The overrides are applied during the setup, and
+             * are ignored for the directly solved coarsest level.
+             */
+            std::map<unsigned, level_params> level;
+
+            /// Returns the smoother parameters for the given level.
+            level_params level_prm(size_t i) const {
+                auto l = level.find(static_cast<unsigned>(i));
+                return l == level.end() ? level_params(relax, npre, npost) : l->second;
+            }
+
             params() :
                 coarse_enough( Backend::direct_solver::coarse_enough() ),
                 direct_coarse(true),
                 max_levels( std::numeric_limits<unsigned>::max() ),
-                npre(1), npost(1), ncycle(1), pre_cycles(1)
+                npre(1), npost(1), ncycle(1), cycle(cycle_type::standard),
+                pre_cycles(1), allow_rebuild(false), lean_setup(false),
+                team_cycle(false), team_min_rows(4096), min_rows_per_thread(4096)
             {}
 
 #ifndef AMGCL_NO_BOOST
@@ -146,13 +297,28 @@ class amg {
                   AMGCL_PARAMS_IMPORT_VALUE(p, npre),
                   AMGCL_PARAMS_IMPORT_VALUE(p, npost),
                   AMGCL_PARAMS_IMPORT_VALUE(p, ncycle),
-                  AMGCL_PARAMS_IMPORT_VALUE(p, pre_cycles)
+                  AMGCL_PARAMS_IMPORT_VALUE(p, cycle),
+                  AMGCL_PARAMS_IMPORT_VALUE(p, pre_cycles),
+                  AMGCL_PARAMS_IMPORT_VALUE(p, allow_rebuild),
+                  AMGCL_PARAMS_IMPORT_VALUE(p, lean_setup),
+                  AMGCL_PARAMS_IMPORT_VALUE(p, team_cycle),
+                  AMGCL_PARAMS_IMPORT_VALUE(p, team_min_rows),
+                  AMGCL_PARAMS_IMPORT_VALUE(p, min_rows_per_thread)
             {
                 check_params(p, {"coarsening", "relax", "coarse_enough",
                         "direct_coarse", "max_levels", "npre", "npost",
-                        "ncycle",  "pre_cycles"});
+                        "ncycle", "cycle", "pre_cycles", "allow_rebuild",
+                        "lean_setup", "team_cycle", "team_min_rows",
+                        "min_rows_per_thread", "level"});
 
                 precondition(max_levels > 0, "max_levels should be positive");
+
+                for(const auto &v : p.get_child("level", amgcl::detail::empty_ptree())) {
+                    std::istringstream s(v.first);
+                    unsigned i;
+                    precondition(s >> i && s.eof(), "Invalid level index: " + v.first);
+                    level[i] = level_params(v.second, relax, npre, npost);
+                }
             }
 
             void get(
@@ -168,7 +334,16 @@ class amg {
                 AMGCL_PARAMS_EXPORT_VALUE(p, path, npre);
                 AMGCL_PARAMS_EXPORT_VALUE(p, path, npost);
                 AMGCL_PARAMS_EXPORT_VALUE(p, path, ncycle);
+                AMGCL_PARAMS_EXPORT_VALUE(p, path, cycle);
                 AMGCL_PARAMS_EXPORT_VALUE(p, path, pre_cycles);
+                AMGCL_PARAMS_EXPORT_VALUE(p, path, allow_rebuild);
+                AMGCL_PARAMS_EXPORT_VALUE(p, path, lean_setup);
+                AMGCL_PARAMS_EXPORT_VALUE(p, path, team_cycle);
+                AMGCL_PARAMS_EXPORT_VALUE(p, path, team_min_rows);
+                AMGCL_PARAMS_EXPORT_VALUE(p, path, min_rows_per_thread);
+
+                for(const auto &l : level)
+                    l.second.get(p, path + "level." + std::to_string(l.first) + ".");
             }
 #endif
         } prm;
@@ -188,12 +363,14 @@ class amg {
                 const Matrix &M,
                 const params &p = params(),
                 const backend_params &bprm = backend_params()
-           ) : prm(p)
+           ) : prm(p), bprm(bprm), peak_bytes(0)
         {
             auto A = std::make_shared<build_matrix>(M);
             sort_rows(*A);
 
-            do_init(A, bprm);
+            // The copy of the matrix is handed over, so that it may be
+            // released as soon as it is moved to the backend.
+            do_init(std::move(A), bprm);
         }
 
         /// Builds the AMG hierarchy for the system matrix.
@@ -213,11 +390,197 @@ class amg {
                 std::shared_ptr<build_matrix> A,
                 const params &p = params(),
                 const backend_params &bprm = backend_params()
-           ) : prm(p)
+           ) : prm(p), bprm(bprm), peak_bytes(0)
         {
             do_init(A, bprm);
         }
 
+        /// Loads the hierarchy saved with save().
+        /**
+         * The coarsening is skipped: the system matrices and the transfer
+         * operators of every level are read from the stream, and only the
+         * smoothers and the coarse level solver are created (with the
+         * relaxation and the backend parameters passed here).
+         *
+         * \param h The stream with the saved hierarchy.
+         * \param p AMG parameters. The parameters related to the coarsening
+         *          are ignored.
+         *
+         * \sa amgcl/io/binary.hpp
+         */
+        amg(
+                const io::saved_hierarchy &h,
+                const params &p = params(),
+                const backend_params &bprm = backend_params()
+           ) : prm(p), bprm(bprm), peak_bytes(0)
+        {
+            do_load(h);
+        }
+
+        /// Saves the hierarchy to a binary stream.
+        /**
+         * The system matrix and the transfer operators of every level are
+         * written in the internal (build) format, which requires either the
+         * builtin backend, or prm.allow_rebuild set during the setup. The
+         * factorization of the coarse level solver is saved as well, when
+         * the direct solver supports it (see amgcl::solver::skyline_lu::save()).
+         * The smoothers are not saved, since they are cheap to recreate from
+         * the level matrices. The stream should be opened in binary mode.
+         *
+         * The file consists of io::hierarchy_header, followed for each level
+         * by a 64-bit word of flags (1 for the coarsest level solved
+         * directly, 2 for the level with the transfer operators), the system
+         * matrix, the size in bytes and the data of the direct solver (for
+         * the coarsest level), and the P and R operators (when present). The
+         * matrices are written with io::write_crs(). All of the arrays start
+         * at the offsets aligned to 8 bytes, so the file may be
+         * memory-mapped.
+         */
+        void save(std::ostream &f) const {
+            io::hierarchy_header hdr;
+            hdr.value_size = sizeof(value_type);
+            hdr.col_size   = sizeof(col_type);
+            hdr.ptr_size   = sizeof(ptr_type);
+            hdr.levels     = levels.size();
+            hdr.rows       = levels.front().rows();
+
+            precondition(io::write(f, hdr), "File I/O error");
+
+            for(const level &lvl : levels) {
+                std::uint64_t flags = (lvl.solve ? 1 : 0) | (lvl.P ? 2 : 0);
+                precondition(io::write(f, flags), "File I/O error");
+
+                auto A = lvl.Ab ? lvl.Ab : build_format(lvl.A);
+                precondition(A, "The hierarchy may only be saved with the "
+                        "builtin backend or with allow_rebuild set");
+                io::write_crs(f, *A);
+
+                if (lvl.solve) {
+                    std::ostringstream buf(std::ios::out | std::ios::binary);
+                    save_solver(*lvl.solve, buf, 0);
+
+                    const std::string data = buf.str();
+                    const std::uint64_t size = data.size();
+
+                    precondition(
+                            io::write(f, size) &&
+                            io::detail::write_array(f, data.data(), size),
+                            "File I/O error");
+                }
+
+                if (lvl.P) {
+                    auto P = lvl.Pb ? lvl.Pb : build_format(lvl.P);
+                    auto R = lvl.Rb ? lvl.Rb : build_format(lvl.R);
+                    precondition(P && R, "The hierarchy may only be saved with the "
+                            "builtin backend or with allow_rebuild set");
+                    io::write_crs(f, *P);
+                    io::write_crs(f, *R);
+                }
+            }
+        }
+
+        /// Rebuilds the hierarchy for a new system matrix.
+        /**
+         * Requires prm.allow_rebuild to be set during the setup. The
+         * hierarchy should not be used from other threads during the
+         * rebuild.
+         *
+         * \param M The new system matrix. Should be convertible to
+         *          amgcl::backend::crs<>.
+         * \param update_transfer_ops When set, the values of the transfer
+         *          operators are recomputed for the new matrix. The
+         *          aggregates (or the C/F splitting), and the nonzero
+         *          patterns of the transfer operators and of the coarse level
+         *          matrices are kept, so the nonzero pattern of \p M should
+         *          match the one used during the setup. Otherwise, the
+         *          transfer operators are reused as is, and only the coarse
+         *          level matrices are recomputed. In this case \p M may have
+         *          a different nonzero pattern. The smoothers and the coarse
+         *          level solver are recomputed in both cases.
+         */
+        template <class Matrix>
+        void rebuild(const Matrix &M, bool update_transfer_ops = true) {
+            auto A = std::make_shared<build_matrix>(M);
+            sort_rows(*A);
+
+            do_rebuild(A, update_transfer_ops);
+        }
+
+        /// Rebuilds the hierarchy for a new system matrix.
+        /**
+         * The shared pointer to the new matrix is passed here, see the
+         * corresponding constructor.
+         */
+        void rebuild(std::shared_ptr<build_matrix> A, bool update_transfer_ops = true) {
+            do_rebuild(A, update_transfer_ops);
+        }
+
+    private:
+        // Temporary vectors for a level of the hierarchy.
+        template <class Vector>
+        struct level_work {
+            std::shared_ptr<Vector> f, u, t;
+
+            // Only used by the K-cycle.
+            std::shared_ptr<Vector> v, c;
+        };
+    public:
+        /// Temporary vectors used by a single application of the preconditioner.
+        /**
+         * A workspace may only be used by one thread at a time, but any
+         * number of workspaces may be used with the same hierarchy
+         * concurrently.
+         */
+        class workspace {
+            public:
+                size_t bytes() const {
+                    size_t b = 0;
+                    for(const auto &w : work) {
+                        if (w.f) b += backend::bytes(*w.f);
+                        if (w.u) b += backend::bytes(*w.u);
+                        if (w.t) b += backend::bytes(*w.t);
+                        if (w.v) b += backend::bytes(*w.v);
+                        if (w.c) b += backend::bytes(*w.c);
+                    }
+                    return b + progress.bytes();
+                }
+            private:
+                std::vector< level_work<vector> > work;
+
+                // Only used by the team cycle.
+                detail::block_progress progress;
+
+                friend class amg;
+        };
+
+        /// Creates the workspace for use with the hierarchy.
+        std::shared_ptr<workspace> create_workspace() const {
+            auto ws = std::make_shared<workspace>();
+            ws->work.reserve(levels.size());
+
+            // The finest level uses the user-provided rhs and x instead of f
+            // and u, and the direct solver on the coarsest level does not
+            // need t.
+            bool finest = true;
+            for(const level &lvl : levels) {
+                level_work<vector> w;
+                if (!finest) {
+                    w.f = Backend::create_vector(lvl.rows(), bprm);
+                    w.u = Backend::create_vector(lvl.rows(), bprm);
+                }
+                if (!lvl.solve)
+                    w.t = Backend::create_vector(lvl.rows(), bprm);
+                if (!finest && !lvl.solve && prm.cycle == cycle_type::kcycle) {
+                    w.v = Backend::create_vector(lvl.rows(), bprm);
+                    w.c = Backend::create_vector(lvl.rows(), bprm);
+                }
+                ws->work.push_back(w);
+                finest = false;
+            }
+
+            return ws;
+        }
+
         /// Performs single V-cycle for the given right-hand side and solution.
         /**
          * \param rhs Right-hand side vector.
@@ -225,7 +588,38 @@ class amg {
          */
         template <class Vec1, class Vec2>
         void cycle(const Vec1 &rhs, Vec2 &&x) const {
-            cycle(levels.begin(), rhs, x);
+            auto ws = get_workspace();
+            cycle(rhs, x, *ws);
+        }
+
+        /// Performs single V-cycle using the provided workspace.
+        /**
+         * \param rhs Right-hand side vector.
+         * \param x   Solution vector.
+         * \param ws  Workspace created with create_workspace().
+         */
+        template <class Vec1, class Vec2>
+        void cycle(const Vec1 &rhs, Vec2 &&x, workspace &ws) const {
+            if (prm.team_cycle && prm.cycle == cycle_type::standard)
+                team_cycle(rhs, x, ws, std::integral_constant<bool,
+                        std::is_same<matrix, build_matrix>::value &&
+                        has_update_rows<relax_type>::value>());
+            else
+                cycle(levels.begin(), rhs, x, ws.work.cbegin(), prm.cycle);
+        }
+
+        /// Performs single V-cycle for the given set of right-hand sides.
+        /**
+         * The hierarchy is traversed once for all vectors in the
+         * multi-vector. Temporary multi-vectors are allocated for each call.
+         *
+         * \param rhs Right-hand sides.
+         * \param x   Solutions.
+         */
+        template <class T>
+        void cycle(const backend::multi_vector<T> &rhs, backend::multi_vector<T> &x) const {
+            auto work = multi_workspace<T>(x.cols());
+            cycle(levels.begin(), rhs, x, work.cbegin(), prm.cycle);
         }
 
         /// Performs single V-cycle after clearing x.
@@ -237,10 +631,40 @@ class amg {
          */
         template <class Vec1, class Vec2>
         void apply(const Vec1 &rhs, Vec2 &&x) const {
+            if (prm.pre_cycles) {
+                auto ws = get_workspace();
+                apply(rhs, x, *ws);
+            } else {
+                backend::copy(rhs, x);
+            }
+        }
+
+        /// Performs single V-cycle after clearing x using the provided workspace.
+        /**
+         * \param rhs Right-hand side vector.
+         * \param x   Solution vector.
+         * \param ws  Workspace created with create_workspace().
+         */
+        template <class Vec1, class Vec2>
+        void apply(const Vec1 &rhs, Vec2 &&x, workspace &ws) const {
             if (prm.pre_cycles) {
                 backend::clear(x);
                 for(unsigned i = 0; i < prm.pre_cycles; ++i)
-                    cycle(rhs, x);
+                    cycle(rhs, x, ws);
+            } else {
+                backend::copy(rhs, x);
+            }
+        }
+
+        /// Performs single V-cycle for the given set of right-hand sides after clearing x.
+        template <class T>
+        void apply(const backend::multi_vector<T> &rhs, backend::multi_vector<T> &x) const {
+            if (prm.pre_cycles) {
+                auto work = multi_workspace<T>(x.cols());
+
+                backend::clear(x);
+                for(unsigned i = 0; i < prm.pre_cycles; ++i)
+                    cycle(levels.begin(), rhs, x, work.cbegin(), prm.cycle);
             } else {
                 backend::copy(rhs, x);
             }
@@ -258,31 +682,81 @@ class amg {
         size_t bytes() const {
             size_t b = 0;
             for(const auto &lvl : levels) b += lvl.bytes();
+            pool.for_each([&b](const workspace &ws) { b += ws.bytes(); });
             return b;
         }
+
+        /// Estimated peak memory used during the hierarchy setup.
+        /**
+         * The estimate accounts for the matrices that are alive at each stage
+         * of the setup (the levels constructed so far, the build copies of
+         * the system matrix and of the transfer operators, and the coarse
+         * matrix being computed), but not for the temporary structures of
+         * the coarsening algorithms.
+         */
+        size_t peak_setup_bytes() const {
+            return peak_bytes;
+        }
     private:
+        backend_params bprm;
+        size_t peak_bytes;
+
+        // Tracks the memory used during the setup.
+        struct setup_memory {
+            size_t base, peak;
+
+            void update(size_t b) {
+                peak = std::max(peak, base + b);
+            }
+        };
+
+        // Uses the memory-lean Galerkin product when the coarsening supports it.
+        template <class CT>
+        static auto lean_coarse_operator(const CT &C,
+                const build_matrix &A, const build_matrix &P, const build_matrix &R, int
+                ) -> decltype(C.coarse_operator(A, P, R, coarsening::detail::lean_tag()))
+        {
+            return C.coarse_operator(A, P, R, coarsening::detail::lean_tag());
+        }
+
+        template <class CT>
+        static std::shared_ptr<build_matrix> lean_coarse_operator(const CT &C,
+                const build_matrix &A, const build_matrix &P, const build_matrix &R, long)
+        {
+            return C.coarse_operator(A, P, R);
+        }
+
+        typedef typename coarsening_type::template rebuild_data<build_matrix> rebuild_data;
+
         struct level {
             size_t m_rows, m_nonzeros;
 
-            std::shared_ptr<vector> f;
-            std::shared_ptr<vector> u;
-            std::shared_ptr<vector> t;
-
             std::shared_ptr<matrix> A;
             std::shared_ptr<matrix> P;
             std::shared_ptr<matrix> R;
 
+            // The operators in the build format and the coarsening data,
+            // kept when prm.allow_rebuild is set. With the builtin backend
+            // the matrices are shared with the ones above. The matrix of the
+            // directly solved coarsest level is always kept for save().
+            std::shared_ptr<build_matrix> Ab, Pb, Rb;
+            std::shared_ptr<rebuild_data> rd;
+
             std::shared_ptr< typename Backend::direct_solver > solve;
 
             std::shared_ptr<relax_type> relax;
+            unsigned npre, npost;
+
+            // The number of threads for the kernels of the level (zero for
+            // no limit), see prm.min_rows_per_thread.
+            size_t nthreads;
+
+            // Row blocks for the team cycle, created on the first use.
+            mutable std::shared_ptr<const detail::row_blocks> blocks;
 
             size_t bytes() const {
                 size_t b = 0;
 
-                if (f) b += backend::bytes(*f);
-                if (u) b += backend::bytes(*u);
-                if (t) b += backend::bytes(*t);
-
                 if (A) b += backend::bytes(*A);
                 if (P) b += backend::bytes(*P);
                 if (R) b += backend::bytes(*R);
@@ -290,37 +764,77 @@ class amg {
                 if (solve) b += backend::bytes(*solve);
                 if (relax) b += backend::bytes(*relax);
 
+                if (!std::is_same<matrix, build_matrix>::value || !A) {
+                    if (Ab) b += backend::bytes(*Ab);
+                    if (Pb) b += backend::bytes(*Pb) + backend::bytes(*Rb);
+                }
+
+                return b;
+            }
+
+            // Memory of the level together with the build matrices that
+            // are not shared with it.
+            size_t bytes(std::initializer_list< std::shared_ptr<build_matrix> > extra) const {
+                size_t b = bytes();
+                for(const auto &B : extra)
+                    if (B && !shares(*B)) b += backend::bytes(*B);
                 return b;
             }
 
-            level() {}
+            bool shares(const build_matrix &B) const {
+                const void *p = &B;
+                return
+                    p == static_cast<const void*>(A.get())  ||
+                    p == static_cast<const void*>(P.get())  ||
+                    p == static_cast<const void*>(R.get())  ||
+                    p == static_cast<const void*>(Ab.get()) ||
+                    p == static_cast<const void*>(Pb.get()) ||
+                    p == static_cast<const void*>(Rb.get());
+            }
+
+            level() : npre(0), npost(0), nthreads(0) {}
 
             level(std::shared_ptr<build_matrix> A,
-                    params &prm, const backend_params &bprm)
-                : m_rows(backend::rows(*A)), m_nonzeros(backend::nonzeros(*A))
+                    params &prm, const backend_params &bprm, size_t depth)
+                : m_rows(backend::rows(*A)), m_nonzeros(backend::nonzeros(*A)),
+                  nthreads(0)
             {
                 AMGCL_TIC("move to backend");
-                f = Backend::create_vector(m_rows, bprm);
-                u = Backend::create_vector(m_rows, bprm);
-                t = Backend::create_vector(m_rows, bprm);
                 this->A = Backend::copy_matrix(A, bprm);
                 AMGCL_TOC("move to backend");
 
                 AMGCL_TIC("relaxation");
-                relax = std::make_shared<relax_type>(*A, prm.relax, bprm);
+                typename params::level_params lp = prm.level_prm(depth);
+                relax = std::make_shared<relax_type>(*A, lp.relax, bprm);
+                npre  = lp.npre;
+                npost = lp.npost;
                 AMGCL_TOC("relaxation");
+
+                if (prm.allow_rebuild) Ab = A;
             }
 
+            // Creates the transfer operators and returns the coarse level
+            // matrix. The fine level matrix is released here (unless it is
+            // shared with the level) as soon as the coarse matrix is
+            // computed, and the build copies of the transfer operators are
+            // released as soon as they are moved to the backend.
             std::shared_ptr<build_matrix> step_down(
                     std::shared_ptr<build_matrix> A,
-                    coarsening_type &C, const backend_params &bprm)
+                    coarsening_type &C, const backend_params &bprm,
+                    const params &prm, setup_memory &mem)
             {
                 AMGCL_TIC("transfer operators");
                 std::shared_ptr<build_matrix> P, R;
 
+                if (prm.allow_rebuild) rd = std::make_shared<rebuild_data>();
+
                 try {
-                    std::tie(P, R) = C.transfer_operators(*A);
+                    if (rd)
+                        std::tie(P, R) = C.transfer_operators(*A, *rd);
+                    else
+                        std::tie(P, R) = C.transfer_operators(*A);
                 } catch(error::empty_level) {
+                    rd.reset();
                     AMGCL_TOC("transfer operators");
                     return std::shared_ptr<build_matrix>();
                 }
@@ -329,32 +843,108 @@ class amg {
                 sort_rows(*R);
                 AMGCL_TOC("transfer operators");
 
+                mem.update(bytes({A, P, R}));
+
+                AMGCL_TIC("coarse operator");
+                std::shared_ptr<build_matrix> Ac;
+                if (rd) {
+                    Ac = C.coarse_operator(*A, *P, *R, *rd);
+                    Pb = P;
+                    Rb = R;
+                } else if (prm.lean_setup) {
+                    Ac = lean_coarse_operator(C, *A, *P, *R, 0);
+                } else {
+                    Ac = C.coarse_operator(*A, *P, *R);
+                }
+                sort_rows(*Ac);
+                AMGCL_TOC("coarse operator");
+
+                mem.update(bytes({A, P, R, Ac}));
+                A.reset();
+
                 AMGCL_TIC("move to backend");
                 this->P = Backend::copy_matrix(P, bprm);
                 this->R = Backend::copy_matrix(R, bprm);
                 AMGCL_TOC("move to backend");
 
-                AMGCL_TIC("coarse operator");
-                A = C.coarse_operator(*A, *P, *R);
-                sort_rows(*A);
-                AMGCL_TOC("coarse operator");
+                mem.update(bytes({P, R, Ac}));
 
-                return A;
+                return Ac;
             }
 
             void create_coarse(
                     std::shared_ptr<build_matrix> A,
-                    const backend_params &bprm, bool single_level)
+                    const backend_params &bprm, bool single_level,
+                    std::shared_ptr<typename Backend::direct_solver> S =
+                        std::shared_ptr<typename Backend::direct_solver>())
             {
                 m_rows     = backend::rows(*A);
                 m_nonzeros = backend::nonzeros(*A);
 
-                u = Backend::create_vector(m_rows, bprm);
-                f = Backend::create_vector(m_rows, bprm);
-
-                solve = Backend::create_solver(A, bprm);
+                solve = S ? S : Backend::create_solver(A, bprm);
                 if (single_level)
                     this->A = Backend::copy_matrix(A, bprm);
+
+                Ab = A;
+            }
+
+            // Sets the transfer operators read from a saved hierarchy.
+            void load_transfer_operators(
+                    std::shared_ptr<build_matrix> P,
+                    std::shared_ptr<build_matrix> R,
+                    const backend_params &bprm, bool allow_rebuild)
+            {
+                this->P = Backend::copy_matrix(P, bprm);
+                this->R = Backend::copy_matrix(R, bprm);
+
+                if (allow_rebuild) {
+                    Pb = P;
+                    Rb = R;
+                }
+            }
+
+            // Recomputes the level for the new Ab. The next level matrix
+            // (nxt->Ab) is updated as well.
+            void rebuild(const coarsening_type &C, const params &prm,
+                    const backend_params &bprm, level *nxt,
+                    bool update_transfer_ops, size_t depth)
+            {
+                m_nonzeros = backend::nonzeros(*Ab);
+
+                if (solve) {
+                    AMGCL_TIC("coarsest level");
+                    solve = Backend::create_solver(Ab, bprm);
+                    if (A) A = Backend::copy_matrix(Ab, bprm);
+                    AMGCL_TOC("coarsest level");
+                    return;
+                }
+
+                AMGCL_TIC("move to backend");
+                A = Backend::copy_matrix(Ab, bprm);
+                AMGCL_TOC("move to backend");
+
+                AMGCL_TIC("relaxation");
+                relax = std::make_shared<relax_type>(*Ab, prm.level_prm(depth).relax, bprm);
+                AMGCL_TOC("relaxation");
+
+                if (!nxt) return;
+
+                if (!update_transfer_ops) {
+                    AMGCL_TIC("coarse operator");
+                    nxt->Ab = C.coarse_operator(*Ab, *Pb, *Rb);
+                    sort_rows(*nxt->Ab);
+                    AMGCL_TOC("coarse operator");
+                    return;
+                }
+
+                AMGCL_TIC("transfer operators");
+                C.rebuild(*Ab, *rd, *Pb, *Rb, *nxt->Ab);
+                AMGCL_TOC("transfer operators");
+
+                AMGCL_TIC("move to backend");
+                P = Backend::copy_matrix(Pb, bprm);
+                R = Backend::copy_matrix(Rb, bprm);
+                AMGCL_TOC("move to backend");
             }
 
             size_t rows() const {
@@ -370,6 +960,13 @@ class amg {
 
         std::list<level> levels;
 
+        // Workspaces that are not currently in use.
+        mutable detail::object_pool<workspace> pool;
+
+        typename detail::object_pool<workspace>::handle get_workspace() const {
+            return pool.get([this]() { return create_workspace(); });
+        }
+
         void do_init(
                 std::shared_ptr<build_matrix> A,
                 const backend_params &bprm = backend_params()
@@ -383,13 +980,17 @@ class amg {
             bool direct_coarse_solve = true;
 
             coarsening_type C(prm.coarsening);
+            setup_memory mem = {0, 0};
 
             while( backend::rows(*A) > prm.coarse_enough) {
-                levels.push_back( level(A, prm, bprm) );
+                levels.push_back( level(A, prm, bprm, levels.size()) );
+                mem.update(levels.back().bytes({A}));
 
                 if (levels.size() >= prm.max_levels) break;
 
-                A = levels.back().step_down(A, C, bprm);
+                A = levels.back().step_down(std::move(A), C, bprm, prm, mem);
+                mem.base += levels.back().bytes();
+
                 if (!A) {
                     // Zero-sized coarse level. Probably the system matrix on
                     // this level is diagonal, should be easily solvable with a
@@ -411,48 +1012,620 @@ class amg {
                     l.create_coarse(A, bprm, levels.empty());
                     levels.push_back(l);
                 } else {
-                    levels.push_back( level(A, prm, bprm) );
+                    levels.push_back( level(A, prm, bprm, levels.size()) );
                 }
+                mem.update(levels.back().bytes({A}));
                 AMGCL_TOC("coarsest level");
             }
+
+            // Allocate the workspace for the first (or the only) thread
+            // using the preconditioner.
+            AMGCL_TIC("move to backend");
+            pool.put(create_workspace());
+            AMGCL_TOC("move to backend");
+
+            setup_threads();
+
+            peak_bytes = std::max(mem.peak, bytes());
+        }
+
+        void do_load(const io::saved_hierarchy &h) {
+            const io::hierarchy_header &hdr = h.header();
+            std::istream &f = h.stream();
+
+            precondition(
+                    hdr.value_size == sizeof(value_type) &&
+                    hdr.col_size   == sizeof(col_type) &&
+                    hdr.ptr_size   == sizeof(ptr_type),
+                    "The hierarchy was saved with different value or index types"
+                    );
+            precondition(hdr.levels > 0, "Empty AMG hierarchy");
+
+            size_t expected_rows = hdr.rows;
+
+            for(std::uint64_t i = 0; i < hdr.levels; ++i) {
+                std::uint64_t flags;
+                precondition(io::read(f, flags), "File I/O error");
+
+                auto A = std::make_shared<build_matrix>();
+                io::read_crs(f, *A);
+
+                precondition(
+                        backend::rows(*A) == expected_rows &&
+                        backend::cols(*A) == expected_rows,
+                        "Inconsistent AMG hierarchy"
+                        );
+
+                if (flags & 1) {
+                    AMGCL_TIC("coarsest level");
+                    std::uint64_t size;
+                    precondition(io::read(f, size), "File I/O error");
+
+                    std::shared_ptr<typename Backend::direct_solver> solve;
+                    if (size) {
+                        std::string data(size, '\0');
+                        precondition(io::detail::read_array(f, &data[0], size),
+                                "File I/O error");
+
+                        std::istringstream buf(data, std::ios::in | std::ios::binary);
+                        solve = load_solver<typename Backend::direct_solver>(buf, 0);
+                    }
+
+                    level l;
+                    l.create_coarse(A, bprm, hdr.levels == 1, solve);
+                    levels.push_back(l);
+                    AMGCL_TOC("coarsest level");
+                } else {
+                    levels.push_back( level(A, prm, bprm, levels.size()) );
+                }
+
+                if (flags & 2) {
+                    auto P = std::make_shared<build_matrix>();
+                    auto R = std::make_shared<build_matrix>();
+
+                    io::read_crs(f, *P);
+                    io::read_crs(f, *R);
+
+                    precondition(
+                            backend::rows(*P) == expected_rows &&
+                            backend::cols(*R) == expected_rows &&
+                            backend::cols(*P) == backend::rows(*R),
+                            "Inconsistent AMG hierarchy"
+                            );
+
+                    expected_rows = backend::cols(*P);
+
+                    levels.back().load_transfer_operators(P, R, bprm, prm.allow_rebuild);
+                }
+            }
+
+            AMGCL_TIC("move to backend");
+            pool.put(create_workspace());
+            AMGCL_TOC("move to backend");
+
+            setup_threads();
+
+            peak_bytes = bytes();
+        }
+
+        // Estimates the work of each level, and chooses the number of
+        // threads for its kernels (see prm.min_rows_per_thread). The work
+        // is measured in nonzeros, and the cost of the direct solver is
+        // estimated with the size of its factorization.
+        void setup_threads() {
+            const level &fine = levels.front();
+            const double grain = prm.min_rows_per_thread *
+                std::max(1.0, 1.0 * fine.nonzeros() / fine.rows());
+
+            for(level &lvl : levels) {
+                if (!prm.min_rows_per_thread) {
+                    lvl.nthreads = 0;
+                    continue;
+                }
+
+                double work = lvl.solve ?
+                    1.0 * backend::bytes(*lvl.solve) / sizeof(value_type) :
+                    1.0 * lvl.nonzeros();
+
+                lvl.nthreads = static_cast<size_t>(std::max(1.0, std::min(1e9, work / grain)));
+            }
+        }
+
+        // Returns the matrix in the build format when the backend uses the
+        // format, and an empty pointer otherwise.
+        static std::shared_ptr<build_matrix> build_format(std::shared_ptr<build_matrix> A) {
+            return A;
+        }
+
+        template <class M>
+        static std::shared_ptr<build_matrix> build_format(std::shared_ptr<M>) {
+            return std::shared_ptr<build_matrix>();
+        }
+
+        // Saves the direct solver factorization, when the solver supports it.
+        template <class S>
+        static auto save_solver(const S &s, std::ostream &f, int) -> decltype(s.save(f)) {
+            s.save(f);
+        }
+
+        template <class S>
+        static void save_solver(const S&, std::ostream&, long) {}
+
+        // Loads the direct solver factorization. Returns an empty pointer
+        // when the solver does not support it, or when the saved
+        // factorization belongs to another solver. The solver is then
+        // recreated from the coarse level matrix.
+        template <class S>
+        static auto load_solver(std::istream &f, int) -> decltype(S::load(f)) {
+            return S::load(f);
+        }
+
+        template <class S>
+        static std::shared_ptr<S> load_solver(std::istream&, long) {
+            return std::shared_ptr<S>();
+        }
+
+        void do_rebuild(std::shared_ptr<build_matrix> A, bool update_transfer_ops) {
+            precondition(prm.allow_rebuild,
+                    "allow_rebuild should be set during the setup");
+
+            const build_matrix &A0 = *levels.front().Ab;
+            const size_t n = backend::rows(A0), nnz = backend::nonzeros(A0);
+
+            precondition(backend::rows(*A) == n,
+                    "The size of the matrix has changed");
+
+            bool same_pattern =
+                backend::nonzeros(*A) == nnz &&
+                std::equal(A->ptr, A->ptr + n + 1, A0.ptr) &&
+                std::equal(A->col, A->col + nnz, A0.col);
+
+            if (update_transfer_ops) {
+                precondition(same_pattern,
+                        "The nonzero pattern of the matrix has changed");
+                precondition(levels.size() == 1 || levels.front().rd,
+                        "The transfer operators may not be updated after "
+                        "the change of the nonzero pattern or for a loaded "
+                        "hierarchy");
+            } else if (!same_pattern) {
+                // The coarsening data refers to the old nonzero pattern.
+                for(auto &lvl : levels) lvl.rd.reset();
+            }
+
+            // The coarsening parameters that are used by the rebuild do not
+            // change between the levels.
+            coarsening_type C(prm.coarsening);
+
+            levels.front().Ab = A;
+            size_t depth = 0;
+            for(auto lvl = levels.begin(), end = levels.end(); lvl != end; ++depth) {
+                level &cur = *lvl;
+                level *nxt = (++lvl == end) ? nullptr : &*lvl;
+                cur.rebuild(C, prm, bprm, nxt, update_transfer_ops, depth);
+            }
+
+            setup_threads();
+        }
+
+        // Temporary multi-vectors for each level of the hierarchy.
+        template <class T>
+        std::vector< level_work< backend::multi_vector<T> > > multi_workspace(size_t m) const {
+            std::vector< level_work< backend::multi_vector<T> > > work;
+            work.reserve(levels.size());
+
+            // The vectors are always written before they are read. The
+            // finest level uses the user-provided rhs and x instead of f and u.
+            for(const level &lvl : levels) {
+                level_work< backend::multi_vector<T> > w;
+                if (!work.empty()) {
+                    w.f = std::make_shared< backend::multi_vector<T> >(lvl.rows(), m, false);
+                    w.u = std::make_shared< backend::multi_vector<T> >(lvl.rows(), m, false);
+                }
+                w.t = std::make_shared< backend::multi_vector<T> >(lvl.rows(), m, false);
+                work.push_back(w);
+            }
+
+            return work;
+        }
+
+        template <class Solver, class Vec1, class Vec2>
+        static void coarse_solve(const Solver &S, const Vec1 &rhs, Vec2 &x) {
+            S(rhs, x);
+        }
+
+        template <class Solver, class T>
+        static void coarse_solve(const Solver &S,
+                const backend::multi_vector<T> &rhs, backend::multi_vector<T> &x)
+        {
+            backend::solve_columns(S, rhs, x);
+        }
+
+        // Computes the coarse level correction u for the restricted residual f.
+        template <class Vec, class Work>
+        void coarse_correction(level_iterator lvl, Vec &f, Vec &u, Work w,
+                cycle_type::type type) const
+        {
+            if (type == cycle_type::kcycle && !lvl->solve) {
+                detail::kcycle(*lvl->A, f, u, *w->v, *w->c, *w->t,
+                        solver::detail::default_inner_product(),
+                        [&](const Vec &r, Vec &c) { cycle(lvl, r, c, w, type); });
+            } else {
+                backend::clear(u);
+                cycle(lvl, f, u, w, type);
+                if (type == cycle_type::fcycle)
+                    cycle(lvl, f, u, w, cycle_type::standard);
+            }
+        }
+
+        // The K-cycle falls back to the standard cycle for multi-vectors, since the
+        // coefficients of the Krylov steps are different for each column.
+        template <class T, class Work>
+        void coarse_correction(level_iterator lvl,
+                backend::multi_vector<T> &f, backend::multi_vector<T> &u, Work w,
+                cycle_type::type type) const
+        {
+            backend::clear(u);
+            if (type == cycle_type::fcycle) {
+                cycle(lvl, f, u, w, type);
+                cycle(lvl, f, u, w, cycle_type::standard);
+            } else {
+                cycle(lvl, f, u, w, cycle_type::standard);
+            }
+        }
+
+        // The additive cycle. The corrections from all of the levels are
+        // computed independently of each other, so all of the levels are
+        // smoothed at the same time by the disjoint teams of threads.
+        template <class Vec1, class Vec2, class Work>
+        void additive_cycle(level_iterator fine, const Vec1 &rhs, Vec2 &x, Work w) const
+        {
+            static const scalar_type one  = math::identity<scalar_type>();
+            static const scalar_type zero = math::zero<scalar_type>();
+
+            level_iterator end = levels.end();
+
+            // Restrict the residual to all of the levels.
+            backend::residual(rhs, *fine->A, x, *w->t);
+            backend::spmv(one, *fine->R, *w->t, zero, *(w+1)->f);
+
+            level_iterator lvl = fine, nxt = fine;
+            Work wl = w;
+            for(++lvl, ++nxt, ++nxt, ++wl; nxt != end; ++lvl, ++nxt, ++wl) {
+                level_threads guard(*lvl);
+                backend::spmv(one, *lvl->R, *wl->f, zero, *(wl+1)->f);
+            }
+
+            // Smooth the levels.
+            auto smooth = [&](level_iterator first, level_iterator last, Work wk) {
+                for(level_iterator c = first; c != last; ++c, ++wk) {
+                    level_threads guard(*c);
+
+                    if (c == fine) {
+                        for(size_t i = 0; i < c->npre;  ++i) c->relax->apply_pre (*c->A, rhs, x, *wk->t);
+                        for(size_t i = 0; i < c->npost; ++i) c->relax->apply_post(*c->A, rhs, x, *wk->t);
+                    } else {
+                        backend::clear(*wk->u);
+                        if (c->solve) {
+                            coarse_solve(*c->solve, *wk->f, *wk->u);
+                        } else {
+                            for(size_t i = 0; i < c->npre;  ++i) c->relax->apply_pre (*c->A, *wk->f, *wk->u, *wk->t);
+                            for(size_t i = 0; i < c->npost; ++i) c->relax->apply_post(*c->A, *wk->f, *wk->u, *wk->t);
+                        }
+                    }
+                }
+            };
+
+            AMGCL_TIC("relax");
+#ifdef _OPENMP
+            const int nt = omp_get_max_threads();
+
+            // The teams are nested in the region that starts them. The number
+            // of active levels is a device-wide setting (and the cycle may be
+            // applied concurrently), so it is left to the caller: without
+            // the nested parallelism the levels are smoothed one after
+            // another.
+            if (nt > 1 && !omp_in_parallel() && omp_get_max_active_levels() > 1) {
+                int nteams = 0;
+                additive_teams(fine, w, nt,
+                        [&](int k, level_iterator, level_iterator, Work, int) {
+                            nteams = k + 1;
+                        });
+
+#pragma omp parallel num_threads(nteams)
+                {
+                    const int tid = omp_get_thread_num();
+                    const int nto = omp_get_num_threads();
+
+                    additive_teams(fine, w, nt,
+                            [&](int k, level_iterator first, level_iterator last, Work wk, int team) {
+                                if (k % nto != tid) return;
+                                omp_set_num_threads(team);
+                                smooth(first, last, wk);
+                            });
+                }
+            } else
+#endif
+            {
+                smooth(fine, end, w);
+            }
+            AMGCL_TOC("relax");
+
+            // Interpolate and sum the corrections.
+            for(; lvl != fine; --lvl, --wl) {
+                level_iterator prv = lvl; --prv;
+                level_threads guard(*prv);
+
+                if (prv == fine)
+                    backend::spmv(one, *prv->P, *wl->u, one, x);
+                else
+                    backend::spmv(one, *prv->P, *wl->u, one, *(wl-1)->u);
+            }
+        }
+
+        // Splits the levels of the additive cycle between the disjoint teams
+        // of the nt threads. Each level gets its own team with the share of
+        // the remaining threads proportional to the number of nonzeros of
+        // the level (but at least one thread). When the threads run out, the
+        // remaining coarse levels are processed one after another by the
+        // last team. Calls f(k, first, last, work, team) for each team k of
+        // team threads, where [first, last) are the levels of the team, and
+        // work is the workspace of the first level.
+        template <class Work, class Func>
+        void additive_teams(level_iterator fine, Work w, int nt, Func &&f) const
+        {
+            level_iterator end = levels.end();
+
+            size_t rest = 0;
+            for(level_iterator l = fine; l != end; ++l) rest += l->nonzeros();
+
+            level_iterator lvl = fine;
+            for(int k = 0; ; ++k, ++lvl, ++w) {
+                level_iterator nxt = lvl; ++nxt;
+
+                if (nt == 1 || nxt == end) {
+                    f(k, lvl, end, w, nt);
+                    return;
+                }
+
+                int team = static_cast<int>(1.0 * nt * lvl->nonzeros() / rest + 0.5);
+                team = std::min(nt - 1, std::max(1, team));
+
+                f(k, lvl, nxt, w, team);
+
+                rest -= lvl->nonzeros();
+                nt   -= team;
+            }
+        }
+
+        // Does the smoother support the row updates x += M r used by the
+        // team cycle?
+        template <class R, class Enable = void>
+        struct has_update_rows : std::false_type {};
+
+        template <class R>
+        struct has_update_rows<R, decltype(std::declval<const R&>().update_rows(
+                    std::declval<const vector&>(), std::declval<vector&>(), 0, 0))
+            > : std::true_type {};
+
+        // The runtime wrapper only supports the row updates for some of the
+        // smoothers.
+        template <class R>
+        static auto supports_update_rows(const R &r, int) -> decltype(r.supports_update_rows()) {
+            return r.supports_update_rows();
+        }
+
+        template <class R>
+        static bool supports_update_rows(const R&, long) {
+            return true;
+        }
+
+        // The state of a thread executing the team cycle.
+        struct team_thread {
+            int id, size;
+            const std::vector< std::shared_ptr<const detail::row_blocks> > &blocks;
+            detail::block_progress &progress;
+            std::vector<unsigned> phase; // The last started phase of each level.
+
+            // Runs the next phase of the level.
+            template <class Op>
+            void run(size_t l, Op &&op) {
+                const detail::row_blocks &B = *blocks[l];
+                detail::team_phase(B, progress, l * B.nblocks, ++phase[l], id, size, op);
+            }
+        };
+
+        // The team cycle is only supported by the builtin backend, and by
+        // the smoothers with the row updates.
+        template <class Vec1, class Vec2>
+        void team_cycle(const Vec1 &rhs, Vec2 &x, workspace &ws, std::false_type) const {
+            cycle(levels.begin(), rhs, x, ws.work.cbegin(), prm.cycle);
         }
 
         template <class Vec1, class Vec2>
-        void cycle(level_iterator lvl, const Vec1 &rhs, Vec2 &x) const
+        void team_cycle(const Vec1 &rhs, Vec2 &x, workspace &ws, std::true_type) const {
+#ifdef _OPENMP
+            const int nt = omp_get_max_threads();
+
+            // The leading levels that are large enough to be processed by
+            // the team.
+            std::vector< std::shared_ptr<const detail::row_blocks> > blocks;
+            if (nt > 1 && !omp_in_parallel()) {
+                for(const level &lvl : levels) {
+                    if (lvl.solve || lvl.rows() < prm.team_min_rows || !supports_update_rows(*lvl.relax, 0))
+                        break;
+                    blocks.push_back(detail::row_blocks::get(lvl.blocks, *lvl.A, nt));
+                }
+            }
+
+            if (!blocks.empty()) {
+                ws.progress.resize(blocks.size() * nt);
+
+#pragma omp parallel
+                {
+                    team_thread tt = {omp_get_thread_num(), omp_get_num_threads(),
+                        blocks, ws.progress, std::vector<unsigned>(blocks.size(), 0)};
+
+                    for(size_t l = 0; l < blocks.size(); ++l)
+                        for(int b = tt.id; b < nt; b += tt.size)
+                            ws.progress.reset(l * nt + b);
+
+#pragma omp barrier
+
+                    team_cycle(levels.begin(), rhs, x, ws.work.cbegin(), 0, tt);
+                }
+
+                return;
+            }
+#endif
+            cycle(levels.begin(), rhs, x, ws.work.cbegin(), prm.cycle);
+        }
+
+        // The standard cycle executed by the thread of the team. The
+        // level l is processed by the whole team, the level l + 1 is
+        // processed either by the team as well, or by the master thread
+        // together with the rest of the hierarchy.
+        template <class Vec1, class Vec2, class Work>
+        void team_cycle(level_iterator lvl, const Vec1 &rhs, Vec2 &x, Work w,
+                size_t l, team_thread &tt) const
+        {
+            level_iterator nxt = lvl, end = levels.end();
+            Work wnxt = w;
+            ++nxt;
+            ++wnxt;
+
+            const build_matrix &A = *lvl->A;
+            const relax_type   &S = *lvl->relax;
+            vector             &t = *w->t;
+
+            auto smooth = [&](size_t n) {
+                for(size_t i = 0; i < n; ++i) {
+                    tt.run(l, [&](ptrdiff_t beg, ptrdiff_t end) {
+                            detail::residual_rows(rhs, A, x, t, beg, end);
+                            });
+                    tt.run(l, [&](ptrdiff_t beg, ptrdiff_t end) {
+                            S.update_rows(t, x, beg, end);
+                            });
+                }
+            };
+
+            if (nxt == end) {
+                smooth(lvl->npre);
+                smooth(lvl->npost);
+                return;
+            }
+
+            const build_matrix &P = *lvl->P;
+            const build_matrix &R = *lvl->R;
+            vector &f = *wnxt->f;
+            vector &u = *wnxt->u;
+
+            for(size_t j = 0; j < prm.ncycle; ++j) {
+                smooth(lvl->npre);
+
+                tt.run(l, [&](ptrdiff_t beg, ptrdiff_t end) {
+                        detail::residual_rows(rhs, A, x, t, beg, end);
+                        });
+
+#pragma omp barrier
+
+                if (l + 1 < tt.blocks.size()) {
+                    tt.run(l + 1, [&](ptrdiff_t beg, ptrdiff_t end) {
+                            detail::spmv_rows(R, t, f, false, beg, end);
+                            for(ptrdiff_t i = beg; i < end; ++i)
+                                u[i] = math::zero<typename backend::value_type<vector>::type>();
+                            });
+
+                    team_cycle(nxt, f, u, wnxt, l + 1, tt);
+                } else {
+#pragma omp master
+                    {
+                        backend::spmv(math::identity<scalar_type>(), R, t, math::zero<scalar_type>(), f);
+                        backend::clear(u);
+                        cycle(nxt, f, u, wnxt, cycle_type::standard);
+                    }
+                }
+
+#pragma omp barrier
+
+                tt.run(l, [&](ptrdiff_t beg, ptrdiff_t end) {
+                        detail::spmv_rows(P, u, x, true, beg, end);
+                        });
+
+                smooth(lvl->npost);
+            }
+        }
+
+        // Limits the number of threads used by the kernels of a level (see
+        // prm.min_rows_per_thread). The previous limit is restored on exit.
+        // Nothing is changed when the level is not limited.
+        struct level_threads {
+#ifdef _OPENMP
+            int prev;
+
+            explicit level_threads(const level &lvl) : prev(0) {
+                if (lvl.nthreads) {
+                    int nt = omp_get_max_threads();
+                    if (lvl.nthreads < static_cast<size_t>(nt)) {
+                        prev = nt;
+                        omp_set_num_threads(static_cast<int>(lvl.nthreads));
+                    }
+                }
+            }
+
+            ~level_threads() {
+                if (prev) omp_set_num_threads(prev);
+            }
+#else
+            explicit level_threads(const level&) {}
+#endif
+        };
+
+        // The temporary vectors f, u, and t for each level are taken from
+        // the work iterator, which points into either a workspace, or the
+        // temporary multi-vectors.
+        template <class Vec1, class Vec2, class Work>
+        void cycle(level_iterator lvl, const Vec1 &rhs, Vec2 &x, Work w,
+                cycle_type::type type) const
         {
+            level_threads guard(*lvl);
+
             level_iterator nxt = lvl, end = levels.end();
+            Work wnxt = w;
             ++nxt;
+            ++wnxt;
 
             if (nxt == end) {
                 if (lvl->solve) {
                     AMGCL_TIC("coarse");
-                    (*lvl->solve)(rhs, x);
+                    coarse_solve(*lvl->solve, rhs, x);
                     AMGCL_TOC("coarse");
                 } else {
                     AMGCL_TIC("relax");
-                    for(size_t i = 0; i < prm.npre;  ++i) lvl->relax->apply_pre(*lvl->A, rhs, x, *lvl->t);
-                    for(size_t i = 0; i < prm.npost; ++i) lvl->relax->apply_post(*lvl->A, rhs, x, *lvl->t);
+                    for(size_t i = 0; i < lvl->npre;  ++i) lvl->relax->apply_pre(*lvl->A, rhs, x, *w->t);
+                    for(size_t i = 0; i < lvl->npost; ++i) lvl->relax->apply_post(*lvl->A, rhs, x, *w->t);
                     AMGCL_TOC("relax");
                 }
+            } else if (type == cycle_type::additive) {
+                additive_cycle(lvl, rhs, x, w);
             } else {
-                for (size_t j = 0; j < prm.ncycle; ++j) {
+                size_t ncycle = (type == cycle_type::standard) ? prm.ncycle : 1;
+                for (size_t j = 0; j < ncycle; ++j) {
                     AMGCL_TIC("relax");
-                    for(size_t i = 0; i < prm.npre; ++i)
-                        lvl->relax->apply_pre(*lvl->A, rhs, x, *lvl->t);
+                    for(size_t i = 0; i < lvl->npre; ++i)
+                        lvl->relax->apply_pre(*lvl->A, rhs, x, *w->t);
                     AMGCL_TOC("relax");
 
-                    backend::residual(rhs, *lvl->A, x, *lvl->t);
+                    backend::residual(rhs, *lvl->A, x, *w->t);
 
-                    backend::spmv(math::identity<scalar_type>(), *lvl->R, *lvl->t, math::zero<scalar_type>(), *nxt->f);
+                    backend::spmv(math::identity<scalar_type>(), *lvl->R, *w->t, math::zero<scalar_type>(), *wnxt->f);
 
-                    backend::clear(*nxt->u);
-                    cycle(nxt, *nxt->f, *nxt->u);
+                    coarse_correction(nxt, *wnxt->f, *wnxt->u, wnxt, type);
 
-                    backend::spmv(math::identity<scalar_type>(), *lvl->P, *nxt->u, math::identity<scalar_type>(), x);
+                    backend::spmv(math::identity<scalar_type>(), *lvl->P, *wnxt->u, math::identity<scalar_type>(), x);
 
                     AMGCL_TIC("relax");
-                    for(size_t i = 0; i < prm.npost; ++i)
-                        lvl->relax->apply_post(*lvl->A, rhs, x, *lvl->t);
+                    for(size_t i = 0; i < lvl->npost; ++i)
+                        lvl->relax->apply_post(*lvl->A, rhs, x, *w->t);
                     AMGCL_TOC("relax");
                 }
             }
@@ -485,6 +1658,7 @@ std::ostream& operator<<(std::ostream &os, const amg<B, C, R> &a)
         << "\nGrid complexity:     " << std::fixed << std::setprecision(2)
         << 1.0 * sum_dof / a.levels.front().rows()
         << "\nMemory footprint:    " << human_readable_memory(sum_mem)
+        << "\nPeak setup memory:   " << human_readable_memory(a.peak_bytes)
         << "\n\n"
            "level     unknowns       nonzeros      memory\n"
            "---------------------------------------------\n";
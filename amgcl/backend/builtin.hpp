@@ -32,6 +32,7 @@ THE SOFTWARE.
  */
 
 #include <vector>
+#include <algorithm>
 #include <numeric>
 #include <memory>
 #include <random>
@@ -106,13 +107,15 @@ struct crs {
 
         ptr[0] = ptr_range[0];
 #pragma omp parallel for
-        for(ptrdiff_t i = 0; i < static_cast<ptrdiff_t>(nrows); ++i) {
+        for(ptrdiff_t i = 0; i < static_cast<ptrdiff_t>(nrows); ++i)
             ptr[i+1] = ptr_range[i+1];
-            for(ptr_type j = ptr_range[i]; j < ptr_range[i+1]; ++j) {
-                col[j] = col_range[j];
-                val[j] = val_range[j];
-            }
-        }
+
+        for_each_nonzero_block([&](ptrdiff_t beg, ptrdiff_t end) {
+                for(ptrdiff_t j = beg; j < end; ++j) {
+                    col[j] = col_range[j];
+                    val[j] = val_range[j];
+                }
+            });
     }
 
     template <class Matrix>
@@ -130,20 +133,23 @@ struct crs {
             ptr[i+1] = row_width;
         }
 
-        nnz = scan_row_sizes();
-        col = new col_type[nnz];
-        val = new val_type[nnz];
+        set_nonzeros(scan_row_sizes());
 
-#pragma omp parallel for
-        for(ptrdiff_t i = 0; i < static_cast<ptrdiff_t>(nrows); ++i) {
-            ptr_type row_head = ptr[i];
-            for(auto a = backend::row_begin(A, i); a; ++a) {
-                col[row_head] = a.col();
-                val[row_head] = a.value();
+        for_each_nonzero_block([&](ptrdiff_t beg, ptrdiff_t end) {
+                if (beg >= end) return;
 
-                ++row_head;
-            }
-        }
+                // The block may start and end in the middle of a row.
+                ptrdiff_t i = std::upper_bound(ptr, ptr + nrows + 1, beg) - ptr - 1;
+
+                for(; ptr[i] < end; ++i) {
+                    ptrdiff_t j = ptr[i];
+                    for(auto a = backend::row_begin(A, i); a && j < end; ++a, ++j) {
+                        if (j < beg) continue;
+                        col[j] = a.col();
+                        val[j] = a.value();
+                    }
+                }
+            });
     }
 
     crs(const crs &other) :
@@ -151,26 +157,14 @@ struct crs {
         ptr(0), col(0), val(0), own_data(true)
     {
         if (other.ptr && other.col && other.val) {
-            ptr = new ptr_type[nrows + 1];
-            col = new col_type[nnz];
-            val = new val_type[nnz];
-
-            ptr[0] = other.ptr[0];
-#pragma omp parallel for
-            for(ptrdiff_t i = 0; i < static_cast<ptrdiff_t>(nrows); ++i) {
-                ptr[i+1] = other.ptr[i+1];
-                for(ptr_type j = other.ptr[i]; j < other.ptr[i+1]; ++j) {
-                    col[j] = other.col[j];
-                    val[j] = other.val[j];
-                }
-            }
+            copy_data(other);
         }
     }
 
     crs(crs &&other) :
         nrows(other.nrows), ncols(other.ncols), nnz(other.nnz),
         ptr(other.ptr), col(other.col), val(other.val),
-        own_data(other.own_data)
+        own_data(other.own_data), mp(std::move(other.mp))
     {
         other.nrows = 0;
         other.ncols = 0;
@@ -188,19 +182,7 @@ struct crs {
         nnz   = other.nnz;
 
         if (other.ptr && other.col && other.val) {
-            ptr = new ptr_type[nrows + 1];
-            col = new col_type[nnz];
-            val = new val_type[nnz];
-
-            ptr[0] = other.ptr[0];
-#pragma omp parallel for
-            for(ptrdiff_t i = 0; i < static_cast<ptrdiff_t>(nrows); ++i) {
-                ptr[i+1] = other.ptr[i+1];
-                for(ptr_type j = other.ptr[i]; j < other.ptr[i+1]; ++j) {
-                    col[j] = other.col[j];
-                    val[j] = other.val[j];
-                }
-            }
+            copy_data(other);
         }
 
         return *this;
@@ -214,6 +196,7 @@ struct crs {
         std::swap(col,      other.col);
         std::swap(val,      other.val);
         std::swap(own_data, other.own_data);
+        std::swap(mp,       other.mp);
 
         return *this;
     }
@@ -224,6 +207,7 @@ struct crs {
             delete[] col; col = 0;
             delete[] val; val = 0;
         }
+        mp.reset();
     }
 
     void set_size(size_t n, size_t m, bool clean_ptr = false) {
@@ -243,24 +227,36 @@ struct crs {
     }
 
     ptr_type scan_row_sizes() {
+        mp.reset();
         std::partial_sum(ptr, ptr + nrows + 1, ptr);
         return ptr[nrows];
     }
 
+    /// Allocates and clears storage for the nonzero values of the matrix.
+    /**
+     * The arrays are cleared in parallel, each thread touching the nonzeros
+     * it is going to process in SpMV (see for_each_nonzero_block). On NUMA
+     * systems this places the matrix storage into the memory local to the
+     * threads that use it.
+     */
     void set_nonzeros() {
         set_nonzeros(ptr[nrows]);
 
-#pragma omp parallel for
-        for(ptrdiff_t i = 0; i < static_cast<ptrdiff_t>(nrows); ++i) {
-            ptrdiff_t row_beg = ptr[i];
-            ptrdiff_t row_end = ptr[i+1];
-            for(ptrdiff_t j = row_beg; j < row_end; ++j) {
-                col[j] = 0;
-                val[j] = math::zero<val_type>();
-            }
-        }
+        for_each_nonzero_block([&](ptrdiff_t beg, ptrdiff_t end) {
+                for(ptrdiff_t j = beg; j < end; ++j) {
+                    col[j] = 0;
+                    val[j] = math::zero<val_type>();
+                }
+            });
     }
 
+    /// Allocates storage for the nonzero values of the matrix.
+    /**
+     * The arrays are left uninitialized. The pages of the arrays are placed
+     * by the first write, so the caller should fill the nonzeros in parallel
+     * with the row partition that is later used in SpMV (e.g. with a static
+     * OpenMP schedule over the rows, or with for_each_nonzero_block).
+     */
     void set_nonzeros(size_t n, bool need_values = true) {
         precondition(!col && !val, "matrix data has already been allocated!");
 
@@ -315,6 +311,16 @@ struct crs {
         return row_iterator(col + p, col + e, val + p);
     }
 
+    /// Nonzero-balanced partition of the rows for the current number of threads.
+    /**
+     * The partition is computed on the first call and is cached, so the
+     * matrix structure should not be changed after the matrix was used in
+     * SpMV or residual operations.
+     */
+    std::shared_ptr<const detail::merge_path_partition> merge_path() const {
+        return detail::merge_path_partition::get(mp, nrows, ptr);
+    }
+
     size_t bytes() const {
         if (own_data) {
             return sizeof(ptr_type) * (nrows + 1)
@@ -324,6 +330,78 @@ struct crs {
             return 0;
         }
     }
+
+    /// Calls f(beg, end) in parallel for the blocks of the nonzero arrays.
+    /**
+     * Each block is processed by the OpenMP thread that works with the same
+     * nonzeros in the SpMV and residual kernels. When the row pointers are
+     * already known, the blocks follow the merge-path partition of the
+     * matrix, otherwise the nonzeros are split evenly between the threads.
+     * Since the threads are assigned to the parts of the partition in order,
+     * each socket gets a contiguous block of rows when the threads are bound
+     * to the cores (e.g. with OMP_PROC_BIND=close and OMP_PLACES=cores).
+     */
+    template <class Func>
+    void for_each_nonzero_block(Func &&f) const {
+        if (ptr && ptr[0] == 0 && static_cast<size_t>(ptr[nrows]) == nnz) {
+#ifdef _OPENMP
+            int np = omp_get_max_threads();
+#else
+            int np = 1;
+#endif
+            // The partition is not cached here, as the row pointers may be
+            // changed by the caller after the nonzeros are allocated.
+            detail::merge_path_partition part(nrows, ptr, np);
+
+#pragma omp parallel
+            {
+#ifdef _OPENMP
+                int tid = omp_get_thread_num();
+                int nt  = omp_get_num_threads();
+#else
+                int tid = 0;
+                int nt  = 1;
+#endif
+                for(int p = tid; p < np; p += nt)
+                    f(part.nnz[p], part.nnz[p+1]);
+            }
+        } else {
+#pragma omp parallel
+            {
+#ifdef _OPENMP
+                int tid = omp_get_thread_num();
+                int nt  = omp_get_num_threads();
+#else
+                int tid = 0;
+                int nt  = 1;
+#endif
+                ptrdiff_t chunk = (nnz + nt - 1) / nt;
+                ptrdiff_t beg = std::min<ptrdiff_t>(nnz, tid * chunk);
+                ptrdiff_t end = std::min<ptrdiff_t>(nnz, beg + chunk);
+
+                f(beg, end);
+            }
+        }
+    }
+
+    private:
+        mutable std::shared_ptr<const detail::merge_path_partition> mp;
+
+        void copy_data(const crs &other) {
+            ptr = new ptr_type[nrows + 1];
+            col = new col_type[nnz];
+            val = new val_type[nnz];
+
+            ptr[0] = other.ptr[0];
+#pragma omp parallel for
+            for(ptrdiff_t i = 0; i < static_cast<ptrdiff_t>(nrows); ++i)
+                ptr[i+1] = other.ptr[i+1];
+
+            for_each_nonzero_block([&](ptrdiff_t beg, ptrdiff_t end) {
+                    std::copy(other.col + beg, other.col + end, col + beg);
+                    std::copy(other.val + beg, other.val + end, val + beg);
+                });
+        }
 };
 
 /// Sort rows of the matrix column-wise.
@@ -371,27 +449,68 @@ std::shared_ptr< crs<V,C,P> > transpose(const crs<V, C, P> &A)
     return T;
 }
 
+/// Transpose of a sparse matrix with the known nonzero pattern of the result.
+/**
+ * Only the values of T are updated. T should have the pattern of the
+ * transpose of A with sorted rows, e.g. T was returned by transpose() for a
+ * matrix with the same nonzero pattern as A.
+ */
+template < typename V, typename C, typename P >
+void numeric_transpose(const crs<V, C, P> &A, crs<V, C, P> &T)
+{
+    const ptrdiff_t n = rows(A);
+
+#pragma omp parallel for
+    for(ptrdiff_t i = 0; i < n; ++i) {
+        for(P j = A.ptr[i], e = A.ptr[i + 1]; j < e; ++j) {
+            C c = A.col[j];
+            C *t = std::lower_bound(T.col + T.ptr[c], T.col + T.ptr[c + 1], static_cast<C>(i));
+            T.val[t - T.col] = A.val[j];
+        }
+    }
+}
+
 /// Matrix-matrix product.
 template <class Val, class Col, class Ptr>
 std::shared_ptr< crs<Val, Col, Ptr> >
 product(const crs<Val,Col,Ptr> &A, const crs<Val,Col,Ptr> &B, bool sort = false) {
     auto C = std::make_shared< crs<Val,Col,Ptr> >();
+    spgemm(A, B, *C, sort);
+    return C;
+}
 
-#ifdef _OPENMP
-    int nt = omp_get_max_threads();
-#else
-    int nt = 1;
-#endif
-
-    if (nt > 16) {
-        spgemm_rmerge(A, B, *C);
-    } else {
-        spgemm_saad(A, B, *C, sort);
-    }
+/// Matrix-matrix product with the known nonzero pattern of the result.
+/**
+ * Only the values of C are recomputed. The pattern of C should contain the
+ * pattern of A * B, e.g. C was returned by product() for the matrices with
+ * the same nonzero patterns as A and B.
+ */
+template <class Val, class Col, class Ptr>
+void numeric_product(const crs<Val,Col,Ptr> &A, const crs<Val,Col,Ptr> &B, crs<Val,Col,Ptr> &C) {
+    spgemm_numeric(A, B, C);
+}
 
+/// Triple matrix product R * A * P.
+/**
+ * The product is computed row by row without storing the A * P matrix. The
+ * rows of A * P are recomputed for each row of R they contribute to, so this
+ * is only efficient when each column of R has about one nonzero, as with the
+ * unsmoothed aggregation.
+ */
+template <class Val, class Col, class Ptr>
+std::shared_ptr< crs<Val, Col, Ptr> >
+product(const crs<Val,Col,Ptr> &R, const crs<Val,Col,Ptr> &A, const crs<Val,Col,Ptr> &P, bool sort = false) {
+    auto C = std::make_shared< crs<Val,Col,Ptr> >();
+    spgemm_rap(R, A, P, *C, sort);
     return C;
 }
 
+/// Triple matrix product with the known nonzero pattern of the result.
+template <class Val, class Col, class Ptr>
+void numeric_product(const crs<Val,Col,Ptr> &R, const crs<Val,Col,Ptr> &A, const crs<Val,Col,Ptr> &P, crs<Val,Col,Ptr> &C) {
+    spgemm_rap_numeric(R, A, P, C);
+}
+
 /// Sum of two matrices
 template <class Val, class Col, class Ptr>
 std::shared_ptr< crs<Val, Col, Ptr> >
@@ -494,11 +613,12 @@ void scale(crs<Val, Col, Ptr> &A, T s) {
 }
 
 // Reduce matrix to a pointwise one
-template <class value_type>
-std::shared_ptr< crs<typename math::scalar_of<value_type>::type> >
-pointwise_matrix(const crs<value_type> &A, unsigned block_size) {
+template <class value_type, class col_type, class ptr_type>
+std::shared_ptr< crs<typename math::scalar_of<value_type>::type, col_type, ptr_type> >
+pointwise_matrix(const crs<value_type, col_type, ptr_type> &A, unsigned block_size) {
     typedef value_type V;
     typedef typename math::scalar_of<V>::type S;
+    typedef crs<S, col_type, ptr_type> Matrix;
 
     AMGCL_TIC("pointwise_matrix");
     const ptrdiff_t n  = A.nrows;
@@ -509,8 +629,8 @@ pointwise_matrix(const crs<value_type> &A, unsigned block_size) {
     precondition(np * block_size == n,
             "Matrix size should be divisible by block_size");
 
-    auto ap = std::make_shared< crs<S> >();
-    crs<S> &Ap = *ap;
+    auto ap = std::make_shared<Matrix>();
+    Matrix &Ap = *ap;
 
     Ap.set_size(np, mp, true);
 
@@ -908,20 +1028,39 @@ spectral_radius(const Matrix &A, int power_iters = 0) {
  * instances of ``std::vector<value_type>``. There is no usual overhead of
  * moving the constructed hierarchy to the builtin backend, since the backend
  * is used internally during setup.
+ *
+ * The column and row pointer types of the matrices may be changed with the
+ * second and third template parameters. Using 32-bit indices (for example,
+ * ``builtin<double, int>``) reduces the memory footprint of the hierarchy and
+ * the memory traffic of the SpMV and smoothing kernels. The pointer type
+ * should be wide enough to hold the number of nonzeros of the finest matrix,
+ * so ``builtin<double, int, ptrdiff_t>`` may be used for very large systems.
+ *
+ * The last template parameter is the direct solver used at the coarsest
+ * level of the AMG hierarchy. The serial amgcl::solver::skyline_lu is used by
+ * default; amgcl::solver::supernodal_lu is multithreaded and allows to use
+ * much larger coarse levels.
  */
-template <typename ValueType>
+template <
+    typename ValueType,
+    typename ColumnType   = ptrdiff_t,
+    typename PointerType  = ColumnType,
+    class    DirectSolver = solver::skyline_lu<ValueType>
+    >
 struct builtin {
     typedef ValueType      value_type;
     typedef ptrdiff_t      index_type;
+    typedef ColumnType     col_type;
+    typedef PointerType    ptr_type;
 
     typedef typename math::rhs_of<value_type>::type rhs_type;
 
     struct provides_row_iterator : std::true_type {};
 
-    typedef crs<value_type, index_type>    matrix;
+    typedef crs<value_type, col_type, ptr_type> matrix;
     typedef numa_vector<rhs_type>          vector;
     typedef numa_vector<value_type>        matrix_diagonal;
-    typedef solver::skyline_lu<value_type> direct_solver;
+    typedef DirectSolver                   direct_solver;
 
     /// The backend has no parameters.
     typedef amgcl::detail::empty_params params;
@@ -1003,8 +1142,10 @@ struct is_builtin_vector< numa_vector<V> > : std::true_type {};
 //---------------------------------------------------------------------------
 // Specialization of backend interface
 //---------------------------------------------------------------------------
-template <typename T1, typename T2>
-struct backends_compatible< builtin<T1>, builtin<T2> > : std::true_type {};
+template <typename T1, typename C1, typename P1, typename S1,
+          typename T2, typename C2, typename P2, typename S2>
+struct backends_compatible< builtin<T1, C1, P1, S1>, builtin<T2, C2, P2, S2> >
+    : std::true_type {};
 
 template < typename V, typename C, typename P >
 struct rows_impl< crs<V, C, P> > {
@@ -1337,6 +1478,11 @@ struct use_builtin_matrix_ops< amgcl::backend::crs<V, C, P> >
     : std::true_type
 {};
 
+template <typename V, typename C, typename P>
+struct has_merge_path< amgcl::backend::crs<V, C, P> >
+    : std::true_type
+{};
+
 } // namespace detail
 
 } // namespace backend
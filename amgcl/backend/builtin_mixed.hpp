@@ -0,0 +1,147 @@
+#ifndef AMGCL_BACKEND_BUILTIN_MIXED_HPP
+#define AMGCL_BACKEND_BUILTIN_MIXED_HPP
+
+/*
+The MIT License
+
+Copyright (c) 2012-2021 Denis Demidov <dennis.demidov@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/**
+ * \file   amgcl/backend/builtin_mixed.hpp
+ * \author Denis Demidov <dennis.demidov@gmail.com>
+ * \brief  Builtin backend with reduced precision matrix storage.
+ *
+ * The matrices of the AMG hierarchy are stored with the reduced precision
+ * (float by default), while the vectors and all of the arithmetic operations
+ * use the full precision of the backend value type. Since the SpMV-type
+ * operations are memory bound, this reduces the time spent in the solution
+ * phase without affecting the accuracy of the outer Krylov solver.
+ */
+
+#include <memory>
+#include <type_traits>
+
+#include <amgcl/backend/interface.hpp>
+#include <amgcl/backend/builtin.hpp>
+#include <amgcl/value_type/interface.hpp>
+
+namespace amgcl {
+namespace backend {
+
+/// Builtin backend with reduced precision matrix storage.
+/**
+ * \param ValueType     Value type used during setup, for the vectors, and
+ *                      in the arithmetic operations.
+ * \param StorageScalar Scalar type used to store the matrix values in the
+ *                      solution phase.
+ */
+template <
+    typename ValueType,
+    typename StorageScalar = float,
+    typename ColumnType = ptrdiff_t,
+    typename PointerType = ColumnType
+    >
+struct builtin_mixed : builtin<ValueType, ColumnType, PointerType> {
+    typedef builtin<ValueType, ColumnType, PointerType> Base;
+
+    typedef typename Base::value_type value_type;
+    typedef typename Base::col_type   col_type;
+    typedef typename Base::ptr_type   ptr_type;
+    typedef typename Base::vector     vector;
+
+    typedef typename math::replace_scalar<value_type, StorageScalar>::type storage_type;
+    typedef crs<storage_type, col_type, ptr_type> matrix;
+
+    typedef typename Base::params params;
+
+    static std::string name() { return "builtin_mixed"; }
+
+    /// Convert matrix from the builtin backend to the reduced precision.
+    static std::shared_ptr<matrix>
+    copy_matrix(std::shared_ptr< typename Base::matrix > A, const params&)
+    {
+        return std::make_shared<matrix>(*A);
+    }
+
+    /// Create direct solver for coarse level
+    /**
+     * The coarse level system is solved in the full precision.
+     */
+    static std::shared_ptr<typename Base::direct_solver>
+    create_solver(std::shared_ptr< typename Base::matrix > A, const params&) {
+        return std::make_shared<typename Base::direct_solver>(*A);
+    }
+};
+
+//---------------------------------------------------------------------------
+// Specialization of backend interface
+//---------------------------------------------------------------------------
+template <typename T1, typename S1, typename C1, typename P1,
+          typename T2, typename S2, typename C2, typename P2>
+struct backends_compatible< builtin_mixed<T1, S1, C1, P1>, builtin_mixed<T2, S2, C2, P2> >
+    : std::true_type {};
+
+template <typename T1, typename C1, typename P1, typename D1,
+          typename T2, typename S2, typename C2, typename P2>
+struct backends_compatible< builtin<T1, C1, P1, D1>, builtin_mixed<T2, S2, C2, P2> >
+    : std::true_type {};
+
+template <typename T1, typename S1, typename C1, typename P1,
+          typename T2, typename C2, typename P2, typename D2>
+struct backends_compatible< builtin_mixed<T1, S1, C1, P1>, builtin<T2, C2, P2, D2> >
+    : std::true_type {};
+
+} // namespace backend
+
+namespace relaxation {
+namespace detail {
+
+template <class Backend> class ilu_solve;
+
+// Use the exact triangular solves of the builtin backend for the ILU-type
+// smoothers. The triangular factors are kept in the full precision.
+template <class V, class S, class C, class P>
+class ilu_solve< backend::builtin_mixed<V, S, C, P> >
+    : public ilu_solve< backend::builtin<V, C, P> >
+{
+    typedef ilu_solve< backend::builtin<V, C, P> > Base;
+
+    public:
+        typedef typename backend::builtin_mixed<V, S, C, P>::params backend_params;
+        typedef typename Base::params      params;
+        typedef typename Base::build_matrix build_matrix;
+
+        template <class Matrix, class MatrixDiagonal>
+        ilu_solve(
+                std::shared_ptr<Matrix> L,
+                std::shared_ptr<Matrix> U,
+                std::shared_ptr<MatrixDiagonal> D,
+                const params &prm, const backend_params &bprm
+                ) : Base(L, U, D, prm, bprm)
+        {}
+};
+
+} // namespace detail
+} // namespace relaxation
+} // namespace amgcl
+
+#endif
@@ -59,25 +59,24 @@ template <class T>
 struct cuda_skyline_lu : solver::skyline_lu<T> {
     typedef solver::skyline_lu<T> Base;
 
-    mutable std::vector<T> _rhs, _x;
-
     template <class Matrix, class Params>
     cuda_skyline_lu(const Matrix &A, const Params&)
-        : Base(*A), _rhs(backend::rows(*A)), _x(backend::rows(*A))
+        : Base(*A)
     { }
 
     template <class Vec1, class Vec2>
     void operator()(const Vec1 &rhs, Vec2 &x) const {
-        thrust::copy(rhs.begin(), rhs.end(), _rhs.begin());
-        static_cast<const Base*>(this)->operator()(_rhs, _x);
-        thrust::copy(_x.begin(), _x.end(), x.begin());
+        // The host vectors are allocated for each call, so that the solver
+        // may be used from several threads at once.
+        std::vector<T> rhs_host(x.size()), x_host(x.size());
+
+        thrust::copy(rhs.begin(), rhs.end(), rhs_host.begin());
+        static_cast<const Base*>(this)->operator()(rhs_host, x_host);
+        thrust::copy(x_host.begin(), x_host.end(), x.begin());
     }
 
     size_t bytes() const {
-        return
-            backend::bytes(*static_cast<const Base*>(this)) +
-            backend::bytes(_rhs) +
-            backend::bytes(_x);
+        return backend::bytes(*static_cast<const Base*>(this));
     }
 };
 
@@ -387,6 +386,8 @@ struct cuda {
                 );
 
     typedef real value_type;
+    typedef ptrdiff_t col_type;
+    typedef ptrdiff_t ptr_type;
     typedef cuda_matrix<real>       matrix;
     typedef thrust::device_vector<real> vector;
     typedef thrust::device_vector<real> matrix_diagonal;
@@ -31,7 +31,15 @@ THE SOFTWARE.
  * \brief   Sparse matrix operations for matrices that provide row_iterator.
  */
 
+#include <vector>
+#include <memory>
+#include <algorithm>
 #include <type_traits>
+
+#ifdef _OPENMP
+#  include <omp.h>
+#endif
+
 #include <amgcl/backend/interface.hpp>
 #include <amgcl/value_type/interface.hpp>
 
@@ -42,6 +50,138 @@ namespace detail {
 template <class Matrix, class Enable = void>
 struct use_builtin_matrix_ops : std::false_type {};
 
+/// Nonzero-balanced partition of a CRS matrix between threads.
+/**
+ * The partition follows the merge-path approach [1]: the rows and the
+ * nonzeros of the matrix are considered as a single list of work items, and
+ * each part gets an equal share of the list. A part may start or end in the
+ * middle of a row, so that even a single dense row is split between several
+ * threads. The partial sums of the split rows are combined after the main
+ * loop.
+ *
+ * [1] Merrill D, Garland M. Merge-based parallel sparse matrix-vector
+ *     multiplication. In SC'16: Proceedings of the International Conference
+ *     for High Performance Computing, Networking, Storage and Analysis 2016
+ *     (pp. 678-689). IEEE.
+ */
+struct merge_path_partition {
+    int nparts;
+    std::vector<ptrdiff_t> row; // First row of each part.
+    std::vector<ptrdiff_t> nnz; // First nonzero of each part.
+
+    template <class Ptr>
+    merge_path_partition(ptrdiff_t n, const Ptr *ptr, int nparts)
+        : nparts(nparts), row(nparts + 1), nnz(nparts + 1)
+    {
+        const ptrdiff_t nz    = ptr[n] - ptr[0];
+        const ptrdiff_t total = n + nz;
+
+        for(int p = 0; p <= nparts; ++p) {
+            ptrdiff_t diag = std::min(total, p * ((total + nparts - 1) / nparts));
+
+            // Find the split point on the diagonal.
+            ptrdiff_t lo = std::max<ptrdiff_t>(0, diag - nz);
+            ptrdiff_t hi = std::min(diag, n);
+
+            while(lo < hi) {
+                ptrdiff_t mid = (lo + hi) / 2;
+                if (ptr[mid + 1] - ptr[0] <= diag - mid - 1)
+                    lo = mid + 1;
+                else
+                    hi = mid;
+            }
+
+            row[p] = lo;
+            nnz[p] = ptr[0] + diag - lo;
+        }
+    }
+
+    /// Returns partition of the matrix for the current number of threads.
+    /**
+     * The partition is cached in the given pointer. The function is safe to
+     * call concurrently from several threads.
+     */
+    template <class Ptr>
+    static std::shared_ptr<const merge_path_partition>
+    get(std::shared_ptr<const merge_path_partition> &cache, ptrdiff_t n, const Ptr *ptr)
+    {
+#ifdef _OPENMP
+        int nt = omp_get_max_threads();
+#else
+        int nt = 1;
+#endif
+        std::shared_ptr<const merge_path_partition> p;
+
+#pragma omp critical(amgcl_merge_path_partition)
+        {
+            if (!cache || cache->nparts != nt)
+                cache = std::make_shared<merge_path_partition>(n, ptr, nt);
+            p = cache;
+        }
+
+        return p;
+    }
+};
+
+/// Is the vector a multi-vector (see amgcl/backend/multi_vector.hpp)?
+/**
+ * Multi-vectors have their own SpMV and residual kernels, so the generic
+ * row-wise kernels below are disabled for them.
+ */
+template <class Vector, class Enable = void>
+struct is_multi_vector : std::false_type {};
+
+/// Does the matrix provide a (cached) merge-path partition?
+template <class Matrix, class Enable = void>
+struct has_merge_path : std::false_type {};
+
+// Computes A * x over the parts of the matrix assigned to the current
+// thread. Each thread of the team gets a contiguous range of parts, so that
+// the rows split between the parts of the range are finished by the thread
+// itself. The rows completed within the range are passed to the
+// row_op(i, sum) callback. The partial sum of the last row of the range
+// (which is finished by one of the next threads) is passed to the
+// carry_op(i, sum) callback after all threads are done with their rows.
+template <class S, class Matrix, class Vector, class RowOp, class CarryOp>
+void merge_path_spmv(const Matrix &A, const merge_path_partition &part,
+        const Vector &x, RowOp &&row_op, CarryOp &&carry_op)
+{
+#ifdef _OPENMP
+    const int tid = omp_get_thread_num();
+    const int nt  = omp_get_num_threads();
+#else
+    const int tid = 0;
+    const int nt  = 1;
+#endif
+    const int np = part.nparts;
+    const int pb = static_cast<int>(static_cast<ptrdiff_t>(np) * tid / nt);
+    const int pe = static_cast<int>(static_cast<ptrdiff_t>(np) * (tid + 1) / nt);
+
+    ptrdiff_t j = part.nnz[pb];
+
+    for(ptrdiff_t i = part.row[pb], e = part.row[pe]; i < e; ++i) {
+        S sum = math::zero<S>();
+        for(ptrdiff_t end = A.ptr[i+1]; j < end; ++j)
+            sum += A.val[j] * x[A.col[j]];
+        row_op(i, sum);
+    }
+
+    const ptrdiff_t i = part.row[pe];
+    const bool split = j < part.nnz[pe];
+
+    S carry = math::zero<S>();
+    for(ptrdiff_t end = part.nnz[pe]; j < end; ++j)
+        carry += A.val[j] * x[A.col[j]];
+
+    // The split row is written by the thread that finishes it, and several
+    // threads may hold carries for the same row.
+#pragma omp barrier
+    if (split) {
+#pragma omp critical(amgcl_merge_path_carry)
+        carry_op(i, carry);
+    }
+}
+
 } // namespace detail
 
 template <class Alpha, class Matrix, class Vector1, class Beta, class Vector2>
@@ -49,6 +189,8 @@ struct spmv_impl<
     Alpha, Matrix, Vector1, Beta, Vector2,
     typename std::enable_if<
         detail::use_builtin_matrix_ops<Matrix>::value &&
+        !detail::is_multi_vector<Vector1>::value &&
+        !detail::is_multi_vector<Vector2>::value &&
         math::static_rows<typename value_type<Matrix>::type>::value == math::static_rows<typename value_type<Vector1>::type>::value &&
         math::static_rows<typename value_type<Matrix>::type>::value == math::static_rows<typename value_type<Vector2>::type>::value
         >::type
@@ -57,6 +199,42 @@ struct spmv_impl<
     static void apply(
             Alpha alpha, const Matrix &A, const Vector1 &x, Beta beta, Vector2 &y
             )
+    {
+        apply(alpha, A, x, beta, y, detail::has_merge_path<Matrix>());
+    }
+
+    static void apply(
+            Alpha alpha, const Matrix &A, const Vector1 &x, Beta beta, Vector2 &y,
+            std::true_type
+            )
+    {
+        typedef typename value_type<Vector2>::type V;
+
+        auto part = A.merge_path();
+        const bool scale = !math::is_zero(beta);
+
+        auto finish = [&](ptrdiff_t i, const V &carry) { y[i] += alpha * carry; };
+
+#pragma omp parallel
+        {
+            if (scale) {
+                detail::merge_path_spmv<V>(A, *part, x,
+                        [&](ptrdiff_t i, const V &sum) {
+                            y[i] = alpha * sum + beta * y[i];
+                        }, finish);
+            } else {
+                detail::merge_path_spmv<V>(A, *part, x,
+                        [&](ptrdiff_t i, const V &sum) {
+                            y[i] = alpha * sum;
+                        }, finish);
+            }
+        }
+    }
+
+    static void apply(
+            Alpha alpha, const Matrix &A, const Vector1 &x, Beta beta, Vector2 &y,
+            std::false_type
+            )
     {
         typedef typename value_type<Vector2>::type V;
 
@@ -87,6 +265,9 @@ struct residual_impl<
     Matrix, Vector1, Vector2, Vector3,
     typename std::enable_if<
         detail::use_builtin_matrix_ops<Matrix>::value &&
+        !detail::is_multi_vector<Vector1>::value &&
+        !detail::is_multi_vector<Vector2>::value &&
+        !detail::is_multi_vector<Vector3>::value &&
         math::static_rows<typename value_type<Matrix>::type>::value == math::static_rows<typename value_type<Vector1>::type>::value &&
         math::static_rows<typename value_type<Matrix>::type>::value == math::static_rows<typename value_type<Vector2>::type>::value &&
         math::static_rows<typename value_type<Matrix>::type>::value == math::static_rows<typename value_type<Vector3>::type>::value
@@ -99,6 +280,41 @@ struct residual_impl<
             Vector2 const &x,
             Vector3       &res
             )
+    {
+        apply(rhs, A, x, res, detail::has_merge_path<Matrix>());
+    }
+
+    static void apply(
+            Vector1 const &rhs,
+            Matrix  const &A,
+            Vector2 const &x,
+            Vector3       &res,
+            std::true_type
+            )
+    {
+        typedef typename value_type<Vector3>::type V;
+
+        auto part = A.merge_path();
+
+#pragma omp parallel
+        {
+            detail::merge_path_spmv<V>(A, *part, x,
+                    [&](ptrdiff_t i, const V &sum) {
+                        res[i] = rhs[i] - sum;
+                    },
+                    [&](ptrdiff_t i, const V &carry) {
+                        res[i] -= carry;
+                    });
+        }
+    }
+
+    static void apply(
+            Vector1 const &rhs,
+            Matrix  const &A,
+            Vector2 const &x,
+            Vector3       &res,
+            std::false_type
+            )
     {
         typedef typename value_type<Vector3>::type V;
 
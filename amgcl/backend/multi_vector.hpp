@@ -0,0 +1,514 @@
+#ifndef AMGCL_BACKEND_MULTI_VECTOR_HPP
+#define AMGCL_BACKEND_MULTI_VECTOR_HPP
+
+/*
+The MIT License
+
+Copyright (c) 2012-2021 Denis Demidov <dennis.demidov@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/**
+ * \file   amgcl/backend/multi_vector.hpp
+ * \author Denis Demidov <dennis.demidov@gmail.com>
+ * \brief  Multi-vector (a block of right-hand sides) for the builtin backend.
+ *
+ * A multi-vector holds k vectors of size n in row-major order, so that the
+ * k values belonging to the same unknown are stored next to each other. The
+ * sparse matrix-vector product becomes a sparse matrix by dense matrix
+ * product (SpMM), where each matrix nonzero is loaded once for all of the k
+ * vectors. This allows to apply a single AMG hierarchy to several
+ * right-hand sides with a single traversal of the hierarchy.
+ */
+
+#include <vector>
+#include <algorithm>
+#include <type_traits>
+
+#include <amgcl/util.hpp>
+#include <amgcl/backend/interface.hpp>
+#include <amgcl/backend/builtin.hpp>
+#include <amgcl/value_type/interface.hpp>
+
+namespace amgcl {
+namespace backend {
+
+/// A set of vectors stored in row-major order.
+template <class T>
+class multi_vector {
+    static_assert(std::is_arithmetic<T>::value,
+            "multi_vector supports scalar value types only");
+
+    public:
+        typedef T value_type;
+
+        multi_vector() : n(0), m(0) {}
+
+        /// Creates n x m multi-vector.
+        multi_vector(size_t n, size_t m, bool init = true)
+            : n(n), m(m), buf(n * m, init) {}
+
+        /// Number of rows (the size of each of the vectors).
+        size_t size() const {
+            return n;
+        }
+
+        /// Number of vectors.
+        size_t cols() const {
+            return m;
+        }
+
+        const T& operator()(size_t i, size_t j) const {
+            return buf[i * m + j];
+        }
+
+        T& operator()(size_t i, size_t j) {
+            return buf[i * m + j];
+        }
+
+        /// Pointer to the i-th row.
+        const T* row(size_t i) const {
+            return buf.data() + i * m;
+        }
+
+        T* row(size_t i) {
+            return buf.data() + i * m;
+        }
+
+        const T* data() const {
+            return buf.data();
+        }
+
+        T* data() {
+            return buf.data();
+        }
+
+        size_t bytes() const {
+            return sizeof(T) * n * m;
+        }
+
+        /// Copies the j-th vector into x.
+        template <class Vector>
+        void get_column(size_t j, Vector &x) const {
+#pragma omp parallel for
+            for(ptrdiff_t i = 0; i < static_cast<ptrdiff_t>(n); ++i)
+                x[i] = buf[i * m + j];
+        }
+
+        /// Sets the j-th vector from x.
+        template <class Vector>
+        void set_column(size_t j, const Vector &x) {
+#pragma omp parallel for
+            for(ptrdiff_t i = 0; i < static_cast<ptrdiff_t>(n); ++i)
+                buf[i * m + j] = x[i];
+        }
+
+        void swap(multi_vector &other) {
+            std::swap(n, other.n);
+            std::swap(m, other.m);
+            buf.swap(other.buf);
+        }
+    private:
+        size_t n, m;
+        numa_vector<T> buf;
+};
+
+/// Computes inner products of the corresponding columns of x and y.
+/**
+ * On output, s[j] holds the inner product of the j-th vectors of x and y.
+ */
+template <class T>
+void column_inner_products(
+        const multi_vector<T> &x, const multi_vector<T> &y, std::vector<T> &s)
+{
+    const ptrdiff_t n = x.size();
+    const size_t    m = x.cols();
+
+    s.assign(m, math::zero<T>());
+
+#pragma omp parallel
+    {
+        std::vector<T> loc(m, math::zero<T>());
+
+#pragma omp for nowait
+        for(ptrdiff_t i = 0; i < n; ++i) {
+            const T *xi = x.row(i);
+            const T *yi = y.row(i);
+            for(size_t j = 0; j < m; ++j)
+                loc[j] += xi[j] * yi[j];
+        }
+
+#pragma omp critical
+        for(size_t j = 0; j < m; ++j) s[j] += loc[j];
+    }
+}
+
+namespace detail {
+
+// Adds the products of the i-th row of x with the K columns of the i-th row
+// of y starting with c to the row-major matrix G.
+template <int K, class T>
+inline void gram_chunk(const T *xi, size_t mx, const T *yi, size_t my, size_t c, T *G) {
+    T y[K];
+    for(int k = 0; k < K; ++k) y[k] = yi[c + k];
+
+    for(size_t a = 0; a < mx; ++a) {
+        const T v = xi[a];
+        T *g = G + a * my + c;
+        for(int k = 0; k < K; ++k) g[k] += v * y[k];
+    }
+}
+
+// Computes the K elements starting with c of the product of the row xi with
+// the row-major matrix M.
+template <int K, class T>
+inline void mul_chunk(const T *xi, size_t mx, const T *M, size_t my, size_t c, T *sum) {
+    T s[K];
+    for(int k = 0; k < K; ++k) s[k] = math::zero<T>();
+
+    for(size_t a = 0; a < mx; ++a) {
+        const T  v = xi[a];
+        const T *m = M + a * my + c;
+        for(int k = 0; k < K; ++k) s[k] += v * m[k];
+    }
+
+    for(int k = 0; k < K; ++k) sum[c + k] = s[k];
+}
+
+} // namespace detail
+
+/// Computes the matrix of inner products of all columns of x and y.
+/**
+ * On output, G is the dense x.cols() by y.cols() matrix \f$X^T Y\f$ stored in
+ * row-major order. Both multi-vectors are read once.
+ */
+template <class T>
+void gram(const multi_vector<T> &x, const multi_vector<T> &y, std::vector<T> &G)
+{
+    const ptrdiff_t n  = x.size();
+    const size_t    mx = x.cols();
+    const size_t    my = y.cols();
+
+    G.assign(mx * my, math::zero<T>());
+
+#pragma omp parallel
+    {
+        std::vector<T> loc(mx * my, math::zero<T>());
+        T *g = loc.data();
+
+#pragma omp for nowait
+        for(ptrdiff_t i = 0; i < n; ++i) {
+            const T *xi = x.row(i);
+            const T *yi = y.row(i);
+
+            size_t c = 0;
+            for(; c + 8 <= my; c += 8) detail::gram_chunk<8>(xi, mx, yi, my, c, g);
+            if (c + 4 <= my) { detail::gram_chunk<4>(xi, mx, yi, my, c, g); c += 4; }
+            if (c + 2 <= my) { detail::gram_chunk<2>(xi, mx, yi, my, c, g); c += 2; }
+            if (c < my)      { detail::gram_chunk<1>(xi, mx, yi, my, c, g); }
+        }
+
+#pragma omp critical
+        for(size_t j = 0; j < mx * my; ++j) G[j] += loc[j];
+    }
+}
+
+/// Computes y = a * x * M + b * y, where M is a small dense matrix.
+/**
+ * M is the x.cols() by y.cols() matrix stored in row-major order. x and y
+ * may refer to the same multi-vector when M is square.
+ */
+template <class T>
+void mul_add(T a, const multi_vector<T> &x, const std::vector<T> &M,
+        T b, multi_vector<T> &y)
+{
+    const ptrdiff_t n  = x.size();
+    const size_t    mx = x.cols();
+    const size_t    my = y.cols();
+    const bool scale   = !math::is_zero(b);
+    const T       *pm  = M.data();
+
+#pragma omp parallel
+    {
+        std::vector<T> sum(my);
+
+#pragma omp for
+        for(ptrdiff_t i = 0; i < n; ++i) {
+            const T *xi = x.row(i);
+
+            size_t c = 0;
+            for(; c + 8 <= my; c += 8) detail::mul_chunk<8>(xi, mx, pm, my, c, sum.data());
+            if (c + 4 <= my) { detail::mul_chunk<4>(xi, mx, pm, my, c, sum.data()); c += 4; }
+            if (c + 2 <= my) { detail::mul_chunk<2>(xi, mx, pm, my, c, sum.data()); c += 2; }
+            if (c < my)      { detail::mul_chunk<1>(xi, mx, pm, my, c, sum.data()); }
+
+            T *yi = y.row(i);
+            if (scale) {
+                for(size_t j = 0; j < my; ++j) yi[j] = a * sum[j] + b * yi[j];
+            } else {
+                for(size_t j = 0; j < my; ++j) yi[j] = a * sum[j];
+            }
+        }
+    }
+}
+
+/// Copies columns xc of x to the columns yc of y.
+template <class T>
+void copy_columns(const multi_vector<T> &x, const std::vector<size_t> &xc,
+        multi_vector<T> &y, const std::vector<size_t> &yc)
+{
+    const ptrdiff_t n = x.size();
+    const size_t    m = xc.size();
+
+#pragma omp parallel for
+    for(ptrdiff_t i = 0; i < n; ++i) {
+        const T *xi = x.row(i);
+        T       *yi = y.row(i);
+        for(size_t j = 0; j < m; ++j)
+            yi[yc[j]] = xi[xc[j]];
+    }
+}
+
+/// Solves the system for each vector of the multi-vector in turn.
+/**
+ * This is used for the solvers that only work with single vectors (e.g. the
+ * direct solvers on the coarsest level of the AMG hierarchy).
+ */
+template <class Solver, class T>
+void solve_columns(const Solver &S, const multi_vector<T> &rhs, multi_vector<T> &x)
+{
+    const size_t n = rhs.size();
+
+    numa_vector<T> f(n, false), u(n, false);
+
+    for(size_t j = 0; j < rhs.cols(); ++j) {
+        rhs.get_column(j, f);
+        x.get_column(j, u);
+        S(f, u);
+        x.set_column(j, u);
+    }
+}
+
+//---------------------------------------------------------------------------
+// Specialization of backend interface
+//---------------------------------------------------------------------------
+namespace detail {
+
+template <class T>
+struct is_multi_vector< multi_vector<T> > : std::true_type {};
+
+} // namespace detail
+
+template <class T>
+struct clear_impl< multi_vector<T> > {
+    static void apply(multi_vector<T> &x) {
+        const ptrdiff_t n = x.size() * x.cols();
+        T *p = x.data();
+
+#pragma omp parallel for
+        for(ptrdiff_t i = 0; i < n; ++i) p[i] = math::zero<T>();
+    }
+};
+
+template <class T>
+struct copy_impl< multi_vector<T>, multi_vector<T> > {
+    static void apply(const multi_vector<T> &x, multi_vector<T> &y) {
+        const ptrdiff_t n = x.size() * x.cols();
+        const T *px = x.data();
+        T       *py = y.data();
+
+#pragma omp parallel for
+        for(ptrdiff_t i = 0; i < n; ++i) py[i] = px[i];
+    }
+};
+
+template <class A, class B, class T>
+struct axpby_impl< A, multi_vector<T>, B, multi_vector<T> > {
+    static void apply(A a, const multi_vector<T> &x, B b, multi_vector<T> &y) {
+        const ptrdiff_t n = x.size() * x.cols();
+        const T *px = x.data();
+        T       *py = y.data();
+
+        if (!math::is_zero(b)) {
+#pragma omp parallel for
+            for(ptrdiff_t i = 0; i < n; ++i) py[i] = a * px[i] + b * py[i];
+        } else {
+#pragma omp parallel for
+            for(ptrdiff_t i = 0; i < n; ++i) py[i] = a * px[i];
+        }
+    }
+};
+
+template <class A, class B, class C, class T>
+struct axpbypcz_impl< A, multi_vector<T>, B, multi_vector<T>, C, multi_vector<T> > {
+    static void apply(A a, const multi_vector<T> &x, B b, const multi_vector<T> &y,
+            C c, multi_vector<T> &z)
+    {
+        const ptrdiff_t n = x.size() * x.cols();
+        const T *px = x.data();
+        const T *py = y.data();
+        T       *pz = z.data();
+
+        if (!math::is_zero(c)) {
+#pragma omp parallel for
+            for(ptrdiff_t i = 0; i < n; ++i) pz[i] = a * px[i] + b * py[i] + c * pz[i];
+        } else {
+#pragma omp parallel for
+            for(ptrdiff_t i = 0; i < n; ++i) pz[i] = a * px[i] + b * py[i];
+        }
+    }
+};
+
+// z = a * diag(x) * y + b * z, where x is a single (diagonal) vector.
+template <class Alpha, class Vec1, class Beta, class T>
+struct vmul_impl<
+    Alpha, Vec1, multi_vector<T>, Beta, multi_vector<T>,
+    typename std::enable_if< is_builtin_vector<Vec1>::value >::type
+    >
+{
+    static void apply(Alpha a, const Vec1 &x, const multi_vector<T> &y, Beta b, multi_vector<T> &z)
+    {
+        const ptrdiff_t n = y.size();
+        const size_t    m = y.cols();
+
+        if (!math::is_zero(b)) {
+#pragma omp parallel for
+            for(ptrdiff_t i = 0; i < n; ++i) {
+                const T  d  = a * x[i];
+                const T *yi = y.row(i);
+                T       *zi = z.row(i);
+                for(size_t j = 0; j < m; ++j) zi[j] = d * yi[j] + b * zi[j];
+            }
+        } else {
+#pragma omp parallel for
+            for(ptrdiff_t i = 0; i < n; ++i) {
+                const T  d  = a * x[i];
+                const T *yi = y.row(i);
+                T       *zi = z.row(i);
+                for(size_t j = 0; j < m; ++j) zi[j] = d * yi[j];
+            }
+        }
+    }
+};
+
+namespace detail {
+
+// Computes the K columns starting with c of the i-th row of A * X.
+template <int K, class V, class C, class P, class T>
+inline void spmm_chunk(const crs<V, C, P> &A, ptrdiff_t i,
+        const multi_vector<T> &x, size_t c, T *sum)
+{
+    const size_t m = x.cols();
+    const T *px = x.data() + c;
+
+    T s[K];
+    for(int k = 0; k < K; ++k) s[k] = math::zero<T>();
+
+    for(P j = A.ptr[i], e = A.ptr[i+1]; j < e; ++j) {
+        const T  v  = A.val[j];
+        const T *xc = px + A.col[j] * m;
+        for(int k = 0; k < K; ++k) s[k] += v * xc[k];
+    }
+
+    for(int k = 0; k < K; ++k) sum[c + k] = s[k];
+}
+
+// Computes the i-th row of A * X. The columns are processed in chunks of
+// the compile-time width, so that the partial sums are kept in registers.
+template <class V, class C, class P, class T>
+inline void spmm_row(const crs<V, C, P> &A, ptrdiff_t i,
+        const multi_vector<T> &x, T *sum)
+{
+    const size_t m = x.cols();
+
+    size_t c = 0;
+    for(; c + 8 <= m; c += 8) spmm_chunk<8>(A, i, x, c, sum);
+    if (c + 4 <= m) { spmm_chunk<4>(A, i, x, c, sum); c += 4; }
+    if (c + 2 <= m) { spmm_chunk<2>(A, i, x, c, sum); c += 2; }
+    if (c < m)      { spmm_chunk<1>(A, i, x, c, sum); }
+}
+
+} // namespace detail
+
+// Sparse matrix - dense matrix product.
+template <class Alpha, class V, class C, class P, class Beta, class T>
+struct spmv_impl<
+    Alpha, crs<V, C, P>, multi_vector<T>, Beta, multi_vector<T>,
+    typename std::enable_if< std::is_arithmetic<V>::value >::type
+    >
+{
+    static void apply(Alpha alpha, const crs<V, C, P> &A,
+            const multi_vector<T> &x, Beta beta, multi_vector<T> &y)
+    {
+        const ptrdiff_t n = A.nrows;
+        const size_t    m = x.cols();
+        const bool scale  = !math::is_zero(beta);
+
+#pragma omp parallel
+        {
+            std::vector<T> sum(m);
+
+#pragma omp for
+            for(ptrdiff_t i = 0; i < n; ++i) {
+                detail::spmm_row(A, i, x, sum.data());
+
+                T *yi = y.row(i);
+                if (scale) {
+                    for(size_t k = 0; k < m; ++k) yi[k] = alpha * sum[k] + beta * yi[k];
+                } else {
+                    for(size_t k = 0; k < m; ++k) yi[k] = alpha * sum[k];
+                }
+            }
+        }
+    }
+};
+
+template <class V, class C, class P, class T>
+struct residual_impl<
+    crs<V, C, P>, multi_vector<T>, multi_vector<T>, multi_vector<T>,
+    typename std::enable_if< std::is_arithmetic<V>::value >::type
+    >
+{
+    static void apply(const multi_vector<T> &f, const crs<V, C, P> &A,
+            const multi_vector<T> &x, multi_vector<T> &r)
+    {
+        const ptrdiff_t n = A.nrows;
+        const size_t    m = x.cols();
+
+#pragma omp parallel
+        {
+            std::vector<T> sum(m);
+
+#pragma omp for
+            for(ptrdiff_t i = 0; i < n; ++i) {
+                detail::spmm_row(A, i, x, sum.data());
+
+                const T *fi = f.row(i);
+                T       *ri = r.row(i);
+                for(size_t k = 0; k < m; ++k) ri[k] = fi[k] - sum[k];
+            }
+        }
+    }
+};
+
+} // namespace backend
+} // namespace amgcl
+
+#endif
@@ -0,0 +1,734 @@
+#ifndef AMGCL_BACKEND_SELL_HPP
+#define AMGCL_BACKEND_SELL_HPP
+
+/*
+The MIT License
+
+Copyright (c) 2012-2021 Denis Demidov <dennis.demidov@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/**
+ * \file   amgcl/backend/sell.hpp
+ * \author Denis Demidov <dennis.demidov@gmail.com>
+ * \brief  Sparse matrix in SELL-C-sigma format and the builtin_sell backend.
+ *
+ * The rows of the matrix are split into chunks of C consecutive rows. Each
+ * chunk is padded to the length of its longest row and is stored in
+ * column-major order, so that the SpMV kernel processes C rows at once with
+ * unit-stride loads of values and column numbers. Optionally, rows are sorted
+ * by their length inside windows of sigma rows in order to reduce the padding
+ * [1].
+ *
+ * [1] Kreutzer M, Hager G, Wellein G, Fehske H, Bishop AR. A unified sparse
+ *     matrix data format for efficient general sparse matrix-vector
+ *     multiplication on modern processors with wide SIMD units. SIAM Journal
+ *     on Scientific Computing. 2014;36(5):C401-23.
+ */
+
+#include <vector>
+#include <algorithm>
+#include <numeric>
+#include <type_traits>
+
+#if defined(__AVX2__) || defined(__AVX512F__)
+#  include <immintrin.h>
+#endif
+
+#include <amgcl/util.hpp>
+#include <amgcl/backend/interface.hpp>
+#include <amgcl/backend/builtin.hpp>
+#include <amgcl/value_type/interface.hpp>
+
+namespace amgcl {
+namespace backend {
+
+namespace detail {
+
+// Number of rows in a SELL chunk. Chunks of scalar values fill a 64 byte
+// cache line (which is also the width of an AVX-512 register).
+template <class V, class Enable = void>
+struct sell_chunk_size : std::integral_constant<int, 4> {};
+
+template <class V>
+struct sell_chunk_size<V,
+    typename std::enable_if<std::is_arithmetic<V>::value>::type
+    > : std::integral_constant<int, (64 / sizeof(V) < 4 ? 4 : 64 / sizeof(V))>
+{};
+
+} // namespace detail
+
+/// Sparse matrix in SELL-C-sigma format.
+/**
+ * \param V Value type.
+ * \param C Column number type.
+ * \param P Index type.
+ */
+template < typename V, typename C, typename P >
+struct sell {
+    typedef V value_type;
+    typedef V val_type;
+    typedef C col_type;
+    typedef P ptr_type;
+
+    /// Number of rows in a chunk.
+    static const int chunk = detail::sell_chunk_size<V>::value;
+
+    size_t nrows, ncols, nnz, nchunks;
+
+    numa_vector<ptr_type> cptr; // Chunk offsets into col and val.
+    numa_vector<col_type> rlen; // Row lengths (in the sorted order).
+    numa_vector<col_type> col;
+    numa_vector<val_type> val;
+
+    // Sorted position -> original row and its inverse.
+    // Empty when the rows are not sorted (sigma = 1).
+    std::vector<col_type> perm, iperm;
+
+    /// Converts matrix in CRS format to SELL-C-sigma format.
+    /**
+     * \param A     Input matrix.
+     * \param sigma Sorting scope. Rows are sorted by their lengths within
+     *              windows of sigma rows (rounded up to the multiple of the
+     *              chunk size). The rows are not sorted when sigma < 2.
+     */
+    template < class Matrix >
+    sell(const Matrix &A, int sigma = 1)
+        : nrows(backend::rows(A)), ncols(backend::cols(A)), nnz(0),
+          nchunks((nrows + chunk - 1) / chunk), cptr(nchunks + 1, false),
+          rlen(nrows, false)
+    {
+        const ptrdiff_t n = nrows;
+
+        numa_vector<col_type> width(n, false);
+
+#pragma omp parallel for
+        for(ptrdiff_t i = 0; i < n; ++i) {
+            col_type w = 0;
+            for(auto a = backend::row_begin(A, i); a; ++a) ++w;
+            width[i] = w;
+        }
+
+        if (sigma > 1) {
+            const ptrdiff_t scope = chunk * ((sigma + chunk - 1) / chunk);
+            const ptrdiff_t nwin  = (n + scope - 1) / scope;
+
+            perm.resize(n);
+            iperm.resize(n);
+
+#pragma omp parallel for
+            for(ptrdiff_t w = 0; w < nwin; ++w) {
+                ptrdiff_t beg = w * scope;
+                ptrdiff_t end = std::min(n, beg + scope);
+
+                for(ptrdiff_t i = beg; i < end; ++i) perm[i] = i;
+
+                std::stable_sort(&perm[0] + beg, &perm[0] + end,
+                        [&width](col_type a, col_type b) {
+                            return width[a] > width[b];
+                        });
+
+                for(ptrdiff_t i = beg; i < end; ++i) iperm[perm[i]] = i;
+            }
+        }
+
+        cptr[0] = 0;
+
+#pragma omp parallel for
+        for(ptrdiff_t k = 0; k < static_cast<ptrdiff_t>(nchunks); ++k) {
+            ptrdiff_t beg = k * chunk;
+            ptrdiff_t end = std::min<ptrdiff_t>(n, beg + chunk);
+
+            col_type w = 0;
+            for(ptrdiff_t i = beg; i < end; ++i) {
+                col_type l = width[perm.empty() ? i : perm[i]];
+                rlen[i] = l;
+                w = std::max(w, l);
+            }
+
+            cptr[k + 1] = w * chunk;
+        }
+
+        std::partial_sum(cptr.data(), cptr.data() + nchunks + 1, cptr.data());
+
+        col.resize(cptr[nchunks], false);
+        val.resize(cptr[nchunks], false);
+
+        // Fill the chunks. The padding refers to the last nonzero column of
+        // the row (or to the column 0 for empty rows), so that the padded
+        // elements do not pull extra cache lines of the vector.
+        size_t nz = 0;
+#pragma omp parallel for reduction(+:nz)
+        for(ptrdiff_t k = 0; k < static_cast<ptrdiff_t>(nchunks); ++k) {
+            ptrdiff_t beg = k * chunk;
+            ptr_type  w   = (cptr[k + 1] - cptr[k]) / chunk;
+
+            for(int r = 0; r < chunk; ++r) {
+                ptrdiff_t i    = beg + r;
+                ptr_type  head = cptr[k] + r;
+                col_type  last = 0;
+
+                if (i < n) {
+                    for(auto a = backend::row_begin(A, perm.empty() ? i : perm[i]); a; ++a, head += chunk) {
+                        col[head] = last = a.col();
+                        val[head] = a.value();
+                        ++nz;
+                    }
+                }
+
+                for(; head < cptr[k] + w * chunk; head += chunk) {
+                    col[head] = last;
+                    val[head] = math::zero<val_type>();
+                }
+            }
+        }
+
+        nnz = nz;
+    }
+
+    sell(const sell&) = delete;
+    sell& operator=(const sell&) = delete;
+
+    /// Position of the row in the sorted order.
+    ptrdiff_t sorted(ptrdiff_t i) const {
+        return iperm.empty() ? i : iperm[i];
+    }
+
+    /// Original number of the row at the given sorted position.
+    ptrdiff_t original(ptrdiff_t i) const {
+        return perm.empty() ? i : perm[i];
+    }
+
+    class row_iterator {
+        public:
+            row_iterator(
+                    const col_type * col,
+                    const col_type * end,
+                    const val_type * val
+                    ) : m_col(col), m_end(end), m_val(val)
+            {}
+
+            operator bool() const {
+                return m_col < m_end;
+            }
+
+            row_iterator& operator++() {
+                m_col += chunk;
+                m_val += chunk;
+                return *this;
+            }
+
+            col_type col() const {
+                return *m_col;
+            }
+
+            val_type value() const {
+                return *m_val;
+            }
+
+        private:
+            const col_type * m_col;
+            const col_type * m_end;
+            const val_type * m_val;
+    };
+
+    row_iterator row_begin(size_t row) const {
+        ptrdiff_t i = sorted(row);
+        ptr_type  p = cptr[i / chunk] + i % chunk;
+
+        return row_iterator(
+                col.data() + p,
+                col.data() + p + rlen[i] * chunk,
+                val.data() + p);
+    }
+
+    size_t bytes() const {
+        return sizeof(ptr_type) * cptr.size()
+             + sizeof(col_type) * (rlen.size() + col.size() + perm.size() + iperm.size())
+             + sizeof(val_type) * val.size();
+    }
+};
+
+template < typename V, typename C, typename P >
+const int sell<V, C, P>::chunk;
+
+namespace detail {
+
+// Computes products of the chunk rows with the vector x.
+template <class V, class C, class S, class Vector, class Enable = void>
+struct sell_chunk_product {
+    template <int chunk>
+    static void apply(ptrdiff_t width, const C *col, const V *val, const Vector &x, S *sum)
+    {
+        for(int r = 0; r < chunk; ++r)
+            sum[r] = math::zero<S>();
+
+        for(ptrdiff_t j = 0; j < width; ++j, col += chunk, val += chunk)
+            for(int r = 0; r < chunk; ++r)
+                sum[r] += val[r] * x[col[r]];
+    }
+};
+
+#if defined(__AVX512F__) || defined(__AVX2__)
+// Explicitly vectorized kernels for double precision values. Both 32 and 64
+// bit column numbers are supported through the corresponding gather
+// instructions.
+template <class C, class Vector>
+struct sell_chunk_product<double, C, double, Vector,
+    typename std::enable_if<
+        std::is_integral<C>::value && std::is_signed<C>::value &&
+        (sizeof(C) == 4 || sizeof(C) == 8) &&
+        is_builtin_vector<Vector>::value &&
+        std::is_same<typename backend::value_type<Vector>::type, double>::value
+        >::type
+    >
+{
+    template <int chunk>
+    static void apply(ptrdiff_t width, const C *col, const double *val, const Vector &x, double *sum)
+    {
+        static_assert(chunk % 8 == 0, "Unexpected chunk size");
+
+        const double *xp = &x[0];
+
+        for(int r = 0; r < chunk; r += 8)
+            apply8(width, chunk, col + r, val + r, xp, sum + r,
+                    std::integral_constant<bool, sizeof(C) == 4>());
+    }
+
+#if defined(__AVX512F__)
+    // The masked gathers with the explicit zero source are used, since the
+    // unmasked ones trigger false uninitialized value warnings in GCC.
+    static __m512d gather(__m256i c, const double *x) {
+        return _mm512_mask_i32gather_pd(_mm512_setzero_pd(), 0xFF, c, x, 8);
+    }
+
+    static __m512d gather(__m512i c, const double *x) {
+        return _mm512_mask_i64gather_pd(_mm512_setzero_pd(), 0xFF, c, x, 8);
+    }
+
+    static void apply8(ptrdiff_t width, int stride, const C *col,
+            const double *val, const double *x, double *sum, std::true_type)
+    {
+        __m512d s = _mm512_setzero_pd();
+
+        for(ptrdiff_t j = 0; j < width; ++j, col += stride, val += stride) {
+            __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(col));
+            s = _mm512_fmadd_pd(_mm512_loadu_pd(val), gather(c, x), s);
+        }
+
+        _mm512_storeu_pd(sum, s);
+    }
+
+    static void apply8(ptrdiff_t width, int stride, const C *col,
+            const double *val, const double *x, double *sum, std::false_type)
+    {
+        __m512d s = _mm512_setzero_pd();
+
+        for(ptrdiff_t j = 0; j < width; ++j, col += stride, val += stride) {
+            __m512i c = _mm512_loadu_si512(reinterpret_cast<const void*>(col));
+            s = _mm512_fmadd_pd(_mm512_loadu_pd(val), gather(c, x), s);
+        }
+
+        _mm512_storeu_pd(sum, s);
+    }
+#else
+    // The masked gathers with the explicit zero source are used, since the
+    // unmasked ones trigger false uninitialized value warnings in GCC.
+    static __m256d gather(__m128i c, const double *x) {
+        const __m256d all = _mm256_castsi256_pd(_mm256_set1_epi64x(-1));
+        return _mm256_mask_i32gather_pd(_mm256_setzero_pd(), x, c, all, 8);
+    }
+
+    static __m256d gather(__m256i c, const double *x) {
+        const __m256d all = _mm256_castsi256_pd(_mm256_set1_epi64x(-1));
+        return _mm256_mask_i64gather_pd(_mm256_setzero_pd(), x, c, all, 8);
+    }
+
+    static __m256d fma(__m256d a, __m256d b, __m256d c) {
+#  if defined(__FMA__)
+        return _mm256_fmadd_pd(a, b, c);
+#  else
+        return _mm256_add_pd(_mm256_mul_pd(a, b), c);
+#  endif
+    }
+
+    static void apply8(ptrdiff_t width, int stride, const C *col,
+            const double *val, const double *x, double *sum, std::true_type)
+    {
+        __m256d s0 = _mm256_setzero_pd();
+        __m256d s1 = _mm256_setzero_pd();
+
+        for(ptrdiff_t j = 0; j < width; ++j, col += stride, val += stride) {
+            __m128i c0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(col));
+            __m128i c1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(col + 4));
+
+            s0 = fma(_mm256_loadu_pd(val    ), gather(c0, x), s0);
+            s1 = fma(_mm256_loadu_pd(val + 4), gather(c1, x), s1);
+        }
+
+        _mm256_storeu_pd(sum,     s0);
+        _mm256_storeu_pd(sum + 4, s1);
+    }
+
+    static void apply8(ptrdiff_t width, int stride, const C *col,
+            const double *val, const double *x, double *sum, std::false_type)
+    {
+        __m256d s0 = _mm256_setzero_pd();
+        __m256d s1 = _mm256_setzero_pd();
+
+        for(ptrdiff_t j = 0; j < width; ++j, col += stride, val += stride) {
+            __m256i c0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(col));
+            __m256i c1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(col + 4));
+
+            s0 = fma(_mm256_loadu_pd(val    ), gather(c0, x), s0);
+            s1 = fma(_mm256_loadu_pd(val + 4), gather(c1, x), s1);
+        }
+
+        _mm256_storeu_pd(sum,     s0);
+        _mm256_storeu_pd(sum + 4, s1);
+    }
+#endif
+};
+#endif
+
+} // namespace detail
+
+/// Builtin backend with matrices stored in SELL-C-sigma format.
+/**
+ * The backend uses the same vectors as amgcl::backend::builtin, but converts
+ * the matrices of the AMG hierarchy into the sliced ELLPACK format.  The
+ * format works best for matrices with regular (and short) rows, such as the
+ * discretizations of PDEs on structured grids. The SpMV and residual kernels
+ * are explicitly vectorized with AVX2 or AVX-512 instructions for double
+ * precision values when the code is compiled with the corresponding target
+ * flags, and fall back to portable loops otherwise.
+ *
+ * \param ValueType   Value type.
+ * \param ColumnType  Column number type.
+ * \param PointerType Index type.
+ * \ingroup backends
+ */
+template <
+    typename ValueType,
+    typename ColumnType  = ptrdiff_t,
+    typename PointerType = ColumnType
+    >
+struct builtin_sell : builtin<ValueType, ColumnType, PointerType> {
+    typedef builtin<ValueType, ColumnType, PointerType> Base;
+
+    typedef typename Base::value_type value_type;
+    typedef typename Base::col_type   col_type;
+    typedef typename Base::ptr_type   ptr_type;
+    typedef typename Base::vector     vector;
+
+    typedef sell<value_type, col_type, ptr_type> matrix;
+
+    struct provides_row_iterator : std::true_type {};
+
+    /// Backend parameters.
+    struct params {
+        /// Sorting scope for the matrix rows.
+        /**
+         * Rows are sorted by their lengths inside windows of sigma rows in
+         * order to reduce the padding. The default value of 1 means the rows
+         * are not reordered, which preserves the locality of the vector
+         * accesses and works best for the regular stencils.
+         */
+        int sigma;
+
+        params() : sigma(1) {}
+
+#ifndef AMGCL_NO_BOOST
+        params(const boost::property_tree::ptree &p)
+            : AMGCL_PARAMS_IMPORT_VALUE(p, sigma)
+        {
+            check_params(p, {"sigma"});
+        }
+
+        void get(boost::property_tree::ptree &p, const std::string &path) const {
+            AMGCL_PARAMS_EXPORT_VALUE(p, path, sigma);
+        }
+#endif
+    };
+
+    static std::string name() { return "builtin_sell"; }
+
+    /// Copy matrix from builtin backend.
+    static std::shared_ptr<matrix>
+    copy_matrix(std::shared_ptr< typename Base::matrix > A, const params &prm)
+    {
+        return std::make_shared<matrix>(*A, prm.sigma);
+    }
+
+    /// Copy vector to builtin backend.
+    template <class T>
+    static std::shared_ptr< numa_vector<T> >
+    copy_vector(const std::vector<T> &x, const params&)
+    {
+        return std::make_shared< numa_vector<T> >(x);
+    }
+
+    /// Copy vector to builtin backend. This is a noop.
+    template <class T>
+    static std::shared_ptr< numa_vector<T> >
+    copy_vector(std::shared_ptr< numa_vector<T> > x, const params&)
+    {
+        return x;
+    }
+
+    /// Create vector of the specified size.
+    static std::shared_ptr<vector>
+    create_vector(size_t size, const params&)
+    {
+        return std::make_shared<vector>(size);
+    }
+
+    struct gather : Base::gather {
+        gather(size_t size, const std::vector<ptrdiff_t> &I, const params&)
+            : Base::gather(size, I, typename Base::params()) { }
+    };
+
+    struct scatter : Base::scatter {
+        scatter(size_t size, const std::vector<ptrdiff_t> &I, const params&)
+            : Base::scatter(size, I, typename Base::params()) { }
+    };
+
+    /// Create direct solver for coarse level
+    static std::shared_ptr<typename Base::direct_solver>
+    create_solver(std::shared_ptr< typename Base::matrix > A, const params&) {
+        return std::make_shared<typename Base::direct_solver>(*A);
+    }
+};
+
+//---------------------------------------------------------------------------
+// Specialization of backend interface
+//---------------------------------------------------------------------------
+template <typename T1, typename C1, typename P1, typename T2, typename C2, typename P2>
+struct backends_compatible< builtin_sell<T1, C1, P1>, builtin_sell<T2, C2, P2> > : std::true_type {};
+
+template <typename T1, typename C1, typename P1, typename D1, typename T2, typename C2, typename P2>
+struct backends_compatible< builtin<T1, C1, P1, D1>, builtin_sell<T2, C2, P2> > : std::true_type {};
+
+template <typename T1, typename C1, typename P1, typename T2, typename C2, typename P2, typename D2>
+struct backends_compatible< builtin_sell<T1, C1, P1>, builtin<T2, C2, P2, D2> > : std::true_type {};
+
+template < typename V, typename C, typename P >
+struct rows_impl< sell<V, C, P> > {
+    static size_t get(const sell<V, C, P> &A) {
+        return A.nrows;
+    }
+};
+
+template < typename V, typename C, typename P >
+struct cols_impl< sell<V, C, P> > {
+    static size_t get(const sell<V, C, P> &A) {
+        return A.ncols;
+    }
+};
+
+template < typename V, typename C, typename P >
+struct nonzeros_impl< sell<V, C, P> > {
+    static size_t get(const sell<V, C, P> &A) {
+        return A.nnz;
+    }
+};
+
+template < typename V, typename C, typename P >
+struct row_nonzeros_impl< sell<V, C, P> > {
+    static size_t get(const sell<V, C, P> &A, size_t row) {
+        return A.rlen[A.sorted(row)];
+    }
+};
+
+template <class Alpha, class V, class C, class P, class Vector1, class Beta, class Vector2>
+struct spmv_impl<
+    Alpha, sell<V, C, P>, Vector1, Beta, Vector2,
+    typename std::enable_if<
+        math::static_rows<V>::value == math::static_rows<typename value_type<Vector1>::type>::value &&
+        math::static_rows<V>::value == math::static_rows<typename value_type<Vector2>::type>::value
+        >::type
+    >
+{
+    typedef sell<V, C, P> matrix;
+
+    static void apply(Alpha alpha, const matrix &A, const Vector1 &x, Beta beta, Vector2 &y)
+    {
+        typedef typename value_type<Vector2>::type S;
+        typedef detail::sell_chunk_product<V, C, S, Vector1> kernel;
+
+        const int       chunk = matrix::chunk;
+        const ptrdiff_t n     = A.nrows;
+        const ptrdiff_t nc    = A.nchunks;
+        const bool      scale = !math::is_zero(beta);
+
+#pragma omp parallel for
+        for(ptrdiff_t k = 0; k < nc; ++k) {
+            S sum[chunk];
+
+            P beg = A.cptr[k];
+            kernel::template apply<chunk>((A.cptr[k+1] - beg) / chunk,
+                    A.col.data() + beg, A.val.data() + beg, x, sum);
+
+            ptrdiff_t row = k * chunk;
+            int m = static_cast<int>(std::min<ptrdiff_t>(chunk, n - row));
+
+            for(int r = 0; r < m; ++r) {
+                ptrdiff_t i = A.original(row + r);
+                if (scale)
+                    y[i] = alpha * sum[r] + beta * y[i];
+                else
+                    y[i] = alpha * sum[r];
+            }
+        }
+    }
+};
+
+template <class V, class C, class P, class Vector1, class Vector2, class Vector3>
+struct residual_impl<
+    sell<V, C, P>, Vector1, Vector2, Vector3,
+    typename std::enable_if<
+        math::static_rows<V>::value == math::static_rows<typename value_type<Vector1>::type>::value &&
+        math::static_rows<V>::value == math::static_rows<typename value_type<Vector2>::type>::value &&
+        math::static_rows<V>::value == math::static_rows<typename value_type<Vector3>::type>::value
+        >::type
+    >
+{
+    typedef sell<V, C, P> matrix;
+
+    static void apply(const Vector1 &rhs, const matrix &A, const Vector2 &x, Vector3 &r)
+    {
+        typedef typename value_type<Vector3>::type S;
+        typedef detail::sell_chunk_product<V, C, S, Vector2> kernel;
+
+        const int       chunk = matrix::chunk;
+        const ptrdiff_t n     = A.nrows;
+        const ptrdiff_t nc    = A.nchunks;
+
+#pragma omp parallel for
+        for(ptrdiff_t k = 0; k < nc; ++k) {
+            S sum[chunk];
+
+            P beg = A.cptr[k];
+            kernel::template apply<chunk>((A.cptr[k+1] - beg) / chunk,
+                    A.col.data() + beg, A.val.data() + beg, x, sum);
+
+            ptrdiff_t row = k * chunk;
+            int m = static_cast<int>(std::min<ptrdiff_t>(chunk, n - row));
+
+            for(int j = 0; j < m; ++j) {
+                ptrdiff_t i = A.original(row + j);
+                r[i] = rhs[i] - sum[j];
+            }
+        }
+    }
+};
+
+/* Allows to do matrix-vector products with mixed scalar/nonscalar types.
+ * Reinterprets pointers to the vectors data into appropriate types.
+ */
+template <class Alpha, class V, class C, class P, class Vector1, class Beta, class Vector2>
+struct spmv_impl<
+    Alpha, sell<V, C, P>, Vector1, Beta, Vector2,
+    typename std::enable_if<
+        math::static_rows<V>::value != math::static_rows<typename value_type<Vector1>::type>::value ||
+        math::static_rows<V>::value != math::static_rows<typename value_type<Vector2>::type>::value
+        >::type
+    >
+{
+    static void apply(Alpha alpha, const sell<V, C, P> &A, const Vector1 &x, Beta beta, Vector2 &y)
+    {
+        typedef typename math::rhs_of<V>::type rhs_type;
+        typedef typename math::replace_scalar<rhs_type, typename math::scalar_of<typename value_type<Vector1>::type>::type>::type x_type;
+        typedef typename math::replace_scalar<rhs_type, typename math::scalar_of<typename value_type<Vector2>::type>::type>::type y_type;
+
+        x_type const * xptr = reinterpret_cast<x_type const *>(&x[0]);
+        y_type       * yptr = reinterpret_cast<y_type       *>(&y[0]);
+
+        iterator_range<x_type const *> xrng(xptr, xptr + A.ncols);
+        iterator_range<y_type       *> yrng(yptr, yptr + A.nrows);
+
+        spmv(alpha, A, xrng, beta, yrng);
+    }
+};
+
+template <class V, class C, class P, class Vector1, class Vector2, class Vector3>
+struct residual_impl<
+    sell<V, C, P>, Vector1, Vector2, Vector3,
+    typename std::enable_if<
+        math::static_rows<V>::value != math::static_rows<typename value_type<Vector1>::type>::value ||
+        math::static_rows<V>::value != math::static_rows<typename value_type<Vector2>::type>::value ||
+        math::static_rows<V>::value != math::static_rows<typename value_type<Vector3>::type>::value
+        >::type
+    >
+{
+    static void apply(const Vector1 &f, const sell<V, C, P> &A, const Vector2 &x, Vector3 &r)
+    {
+        typedef typename math::rhs_of<V>::type rhs_type;
+        typedef typename math::replace_scalar<rhs_type, typename math::scalar_of<typename value_type<Vector1>::type>::type>::type f_type;
+        typedef typename math::replace_scalar<rhs_type, typename math::scalar_of<typename value_type<Vector2>::type>::type>::type x_type;
+        typedef typename math::replace_scalar<rhs_type, typename math::scalar_of<typename value_type<Vector3>::type>::type>::type r_type;
+
+        x_type const * xptr = reinterpret_cast<x_type const *>(&x[0]);
+        f_type const * fptr = reinterpret_cast<f_type const *>(&f[0]);
+        r_type       * rptr = reinterpret_cast<r_type       *>(&r[0]);
+
+        iterator_range<x_type const *> xrng(xptr, xptr + A.ncols);
+        iterator_range<f_type const *> frng(fptr, fptr + A.nrows);
+        iterator_range<r_type       *> rrng(rptr, rptr + A.nrows);
+
+        residual(frng, A, xrng, rrng);
+    }
+};
+
+} // namespace backend
+
+namespace relaxation {
+namespace detail {
+
+template <class Backend> class ilu_solve;
+
+// Use the exact triangular solves of the builtin backend for the ILU-type
+// smoothers. The triangular factors are kept in the CRS format.
+template <class V, class C, class P>
+class ilu_solve< backend::builtin_sell<V, C, P> >
+    : public ilu_solve< backend::builtin<V, C, P> >
+{
+    typedef ilu_solve< backend::builtin<V, C, P> > Base;
+
+    public:
+        typedef typename backend::builtin_sell<V, C, P>::params backend_params;
+        typedef typename Base::params      params;
+        typedef typename Base::build_matrix build_matrix;
+
+        template <class Matrix, class MatrixDiagonal>
+        ilu_solve(
+                std::shared_ptr<Matrix> L,
+                std::shared_ptr<Matrix> U,
+                std::shared_ptr<MatrixDiagonal> D,
+                const params &prm, const backend_params&
+                ) : Base(L, U, D, prm, typename Base::backend_params())
+        {}
+};
+
+} // namespace detail
+} // namespace relaxation
+} // namespace amgcl
+
+#endif
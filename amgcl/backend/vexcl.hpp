@@ -58,25 +58,24 @@ struct vexcl_skyline_lu : solver::skyline_lu<value_type> {
     typedef solver::skyline_lu<value_type> Base;
     typedef typename math::rhs_of<value_type>::type rhs_type;
 
-    mutable std::vector<rhs_type> _rhs, _x;
-
     template <class Matrix, class Params>
     vexcl_skyline_lu(const Matrix &A, const Params&)
-        : Base(*A), _rhs(backend::rows(*A)), _x(backend::rows(*A))
+        : Base(*A)
     { }
 
     template <class Vec1, class Vec2>
     void operator()(const Vec1 &rhs, Vec2 &x) const {
-        vex::copy(rhs, _rhs);
-        static_cast<const Base*>(this)->operator()(_rhs, _x);
-        vex::copy(_x, x);
+        // The host vectors are allocated for each call, so that the solver
+        // may be used from several threads at once.
+        std::vector<rhs_type> rhs_host(x.size()), x_host(x.size());
+
+        vex::copy(rhs, rhs_host);
+        static_cast<const Base*>(this)->operator()(rhs_host, x_host);
+        vex::copy(x_host, x);
     }
 
     size_t bytes() const {
-        return
-            backend::bytes(*static_cast<const Base*>(this)) +
-            backend::bytes(_rhs) +
-            backend::bytes(_x);
+        return backend::bytes(*static_cast<const Base*>(this));
     }
 };
 
@@ -132,6 +131,8 @@ template <typename real, class DirectSolver = solver::vexcl_skyline_lu<real> >
 struct vexcl {
     typedef real      value_type;
     typedef ptrdiff_t index_type;
+    typedef ptrdiff_t col_type;
+    typedef ptrdiff_t ptr_type;
 
     typedef vex::sparse::distributed<
                 vex::sparse::matrix<value_type, index_type, index_type>
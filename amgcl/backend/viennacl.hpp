@@ -57,18 +57,20 @@ template <class T>
 struct viennacl_skyline_lu : solver::skyline_lu<T> {
     typedef solver::skyline_lu<T> Base;
 
-    mutable std::vector<T> _rhs, _x;
-
     template <class Matrix, class Params>
     viennacl_skyline_lu(const Matrix &A, const Params&)
-        : Base(*A), _rhs(backend::rows(*A)), _x(backend::rows(*A))
+        : Base(*A)
     { }
 
     template <class Vec1, class Vec2>
     void operator()(const Vec1 &rhs, Vec2 &x) const {
-        viennacl::fast_copy(rhs, _rhs);
-        static_cast<const Base*>(this)->operator()(_rhs, _x);
-        viennacl::fast_copy(_x, x);
+        // The host vectors are allocated for each call, so that the solver
+        // may be used from several threads at once.
+        std::vector<T> rhs_host(x.size()), x_host(x.size());
+
+        viennacl::fast_copy(rhs, rhs_host);
+        static_cast<const Base*>(this)->operator()(rhs_host, x_host);
+        viennacl::fast_copy(x_host, x);
     }
 };
 
@@ -93,6 +95,8 @@ template <
 struct viennacl {
     typedef typename backend::value_type<Matrix>::type value_type;
     typedef ptrdiff_t                                  index_type;
+    typedef ptrdiff_t                                  col_type;
+    typedef ptrdiff_t                                  ptr_type;
     typedef Matrix                                     matrix;
     typedef ::viennacl::vector<value_type>             vector;
     typedef ::viennacl::vector<value_type>             matrix_diagonal;
@@ -36,6 +36,7 @@ THE SOFTWARE.
 
 #include <amgcl/backend/builtin.hpp>
 #include <amgcl/coarsening/detail/scaled_galerkin.hpp>
+#include <amgcl/coarsening/detail/aggregate_galerkin.hpp>
 #include <amgcl/coarsening/pointwise_aggregates.hpp>
 #include <amgcl/coarsening/tentative_prolongation.hpp>
 #include <amgcl/util.hpp>
@@ -139,9 +140,15 @@ struct aggregation {
         auto P = tentative_prolongation<Matrix>(
                 n, aggr.count, aggr.id, prm.nullspace, prm.aggr.block_size
                 );
+
+        std::shared_ptr<Matrix> R;
+        if (prm.nullspace.cols > 0)
+            R = transpose(*P);
+        else
+            R = detail::aggregate_restriction<Matrix>(aggr.count, aggr.id);
         AMGCL_TOC("interpolation");
 
-        return std::make_tuple(P, transpose(*P));
+        return std::make_tuple(P, R);
     }
 
     /// Creates system matrix for the coarser level.
@@ -154,7 +161,69 @@ struct aggregation {
     template <class Matrix>
     std::shared_ptr<Matrix>
     coarse_operator(const Matrix &A, const Matrix &P, const Matrix &R) const {
-        return detail::scaled_galerkin(A, P, R, 1 / prm.over_interp);
+        if (prm.nullspace.cols > 0)
+            return detail::scaled_galerkin(A, P, R, 1 / prm.over_interp);
+        else
+            return detail::aggregate_galerkin(A, P, R, 1 / prm.over_interp);
+    }
+
+    /// Creates system matrix for the coarser level with the least memory.
+    /**
+     * The intermediate A * P product is never stored completely, which is
+     * slower, but reduces the peak memory of the setup.
+     *
+     * \sa amgcl::amg::params::lean_setup
+     */
+    template <class Matrix>
+    std::shared_ptr<Matrix>
+    coarse_operator(const Matrix &A, const Matrix &P, const Matrix &R, detail::lean_tag) const {
+        if (prm.nullspace.cols > 0)
+            return detail::scaled_galerkin(A, P, R, 1 / prm.over_interp, detail::lean_tag());
+        else
+            return detail::aggregate_galerkin(A, P, R, 1 / prm.over_interp);
+    }
+
+    /// Data needed to rebuild the level for a new matrix with the same nonzero pattern.
+    /**
+     * \sa amgcl::amg::params::allow_rebuild
+     */
+    template <class Matrix>
+    struct rebuild_data {
+        std::shared_ptr<Matrix> AP; ///< The A * P product (only used with the near nullspace).
+    };
+
+    /// Creates transfer operators and saves the data needed for rebuild().
+    template <class Matrix>
+    std::tuple<
+        std::shared_ptr<Matrix>,
+        std::shared_ptr<Matrix>
+        >
+    transfer_operators(const Matrix &A, rebuild_data<Matrix>&) {
+        return transfer_operators(A);
+    }
+
+    /// Creates system matrix for the coarser level and saves the data needed for rebuild().
+    template <class Matrix>
+    std::shared_ptr<Matrix>
+    coarse_operator(const Matrix &A, const Matrix &P, const Matrix &R, rebuild_data<Matrix> &d) const {
+        if (prm.nullspace.cols > 0)
+            return detail::scaled_galerkin(A, P, R, 1 / prm.over_interp, d.AP);
+        else
+            return detail::aggregate_galerkin(A, P, R, 1 / prm.over_interp);
+    }
+
+    /// Recomputes the values of the operators for a new matrix with the same nonzero pattern.
+    /**
+     * The aggregates and the nonzero patterns of P, R, and of the coarse
+     * operator Ac are kept from the initial setup.
+     */
+    template <class Matrix>
+    void rebuild(const Matrix &A, rebuild_data<Matrix> &d, Matrix &P, Matrix &R, Matrix &Ac) const {
+        // The tentative prolongation does not depend on the matrix values.
+        if (prm.nullspace.cols > 0)
+            detail::numeric_scaled_galerkin(A, P, R, 1 / prm.over_interp, d.AP, Ac);
+        else
+            detail::numeric_aggregate_galerkin(A, P, R, 1 / prm.over_interp, Ac);
     }
 };
 
@@ -0,0 +1,210 @@
+#ifndef AMGCL_COARSENING_DETAIL_AGGREGATE_GALERKIN_HPP
+#define AMGCL_COARSENING_DETAIL_AGGREGATE_GALERKIN_HPP
+
+/*
+The MIT License
+
+Copyright (c) 2012-2021 Denis Demidov <dennis.demidov@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/**
+ * \file   amgcl/coarsening/detail/aggregate_galerkin.hpp
+ * \author Denis Demidov <dennis.demidov@gmail.com>
+ * \brief  Transfer operators and Galerkin operator for the piecewise-constant
+ *         interpolation.
+ */
+
+#include <vector>
+#include <atomic>
+#include <memory>
+#include <algorithm>
+
+#include <amgcl/backend/builtin.hpp>
+#include <amgcl/value_type/interface.hpp>
+
+namespace amgcl {
+namespace coarsening {
+namespace detail {
+
+/// Restriction operator for the piecewise-constant interpolation.
+/**
+ * The rows of R = P^T are the lists of the aggregate members, so R is
+ * obtained from the aggregate ids directly with a parallel counting sort.
+ * Variables with negative ids do not belong to any aggregate.
+ */
+template <class Matrix>
+std::shared_ptr<Matrix> aggregate_restriction(
+        size_t naggr, const std::vector<ptrdiff_t> &id)
+{
+    typedef typename backend::value_type<Matrix>::type value_type;
+    typedef typename Matrix::col_type col_type;
+
+    const ptrdiff_t n = id.size();
+
+    auto R = std::make_shared<Matrix>();
+    R->set_size(naggr, n, true);
+
+    std::vector< std::atomic<ptrdiff_t> > pos(naggr);
+    for(size_t i = 0; i < naggr; ++i) pos[i] = 0;
+
+#pragma omp parallel for
+    for(ptrdiff_t i = 0; i < n; ++i)
+        if (id[i] >= 0) ++pos[id[i]];
+
+    for(size_t i = 0; i < naggr; ++i) R->ptr[i+1] = pos[i];
+    R->set_nonzeros(R->scan_row_sizes());
+
+    for(size_t i = 0; i < naggr; ++i) pos[i] = R->ptr[i];
+
+#pragma omp parallel for
+    for(ptrdiff_t i = 0; i < n; ++i) {
+        if (id[i] < 0) continue;
+        ptrdiff_t j = pos[id[i]].fetch_add(1);
+        R->col[j] = static_cast<col_type>(i);
+        R->val[j] = math::identity<value_type>();
+    }
+
+    // The order of the members is not deterministic after the parallel loop.
+#pragma omp parallel for
+    for(ptrdiff_t i = 0; i < static_cast<ptrdiff_t>(naggr); ++i)
+        std::sort(R->col + R->ptr[i], R->col + R->ptr[i+1]);
+
+    return R;
+}
+
+/// Galerkin operator for the piecewise-constant interpolation.
+/**
+ * Each row of P has at most one unit entry, so that the coarse operator is
+ * obtained in a single pass over A by summing the entries of A for each pair
+ * of aggregates. The aggregate ids are taken from P, and the lists of the
+ * aggregate members are taken from R. The result is scaled by s.
+ */
+template <class Matrix>
+std::shared_ptr<Matrix> aggregate_galerkin(
+        const Matrix &A, const Matrix &P, const Matrix &R, float s)
+{
+    const ptrdiff_t nc = backend::rows(R);
+
+    auto Ac = std::make_shared<Matrix>();
+    Ac->set_size(nc, backend::cols(P));
+    Ac->ptr[0] = 0;
+
+#pragma omp parallel
+    {
+        std::vector<ptrdiff_t> marker(nc, -1);
+
+#pragma omp for
+        for(ptrdiff_t ic = 0; ic < nc; ++ic) {
+            ptrdiff_t row_width = 0;
+            for(ptrdiff_t jr = R.ptr[ic], er = R.ptr[ic+1]; jr < er; ++jr) {
+                ptrdiff_t i = R.col[jr];
+                for(ptrdiff_t ja = A.ptr[i], ea = A.ptr[i+1]; ja < ea; ++ja) {
+                    ptrdiff_t j = A.col[ja];
+                    if (P.ptr[j] == P.ptr[j+1]) continue;
+
+                    ptrdiff_t jc = P.col[P.ptr[j]];
+                    if (marker[jc] != ic) {
+                        marker[jc] = ic;
+                        ++row_width;
+                    }
+                }
+            }
+            Ac->ptr[ic+1] = row_width;
+        }
+    }
+
+    Ac->set_nonzeros(Ac->scan_row_sizes());
+
+#pragma omp parallel
+    {
+        std::vector<ptrdiff_t> marker(nc, -1);
+
+#pragma omp for
+        for(ptrdiff_t ic = 0; ic < nc; ++ic) {
+            ptrdiff_t row_beg = Ac->ptr[ic];
+            ptrdiff_t row_end = row_beg;
+
+            for(ptrdiff_t jr = R.ptr[ic], er = R.ptr[ic+1]; jr < er; ++jr) {
+                ptrdiff_t i = R.col[jr];
+                for(ptrdiff_t ja = A.ptr[i], ea = A.ptr[i+1]; ja < ea; ++ja) {
+                    ptrdiff_t j = A.col[ja];
+                    if (P.ptr[j] == P.ptr[j+1]) continue;
+
+                    ptrdiff_t jc = P.col[P.ptr[j]];
+                    if (marker[jc] < row_beg) {
+                        marker[jc] = row_end;
+                        Ac->col[row_end] = jc;
+                        Ac->val[row_end] = A.val[ja];
+                        ++row_end;
+                    } else {
+                        Ac->val[marker[jc]] += A.val[ja];
+                    }
+                }
+            }
+
+            for(ptrdiff_t j = row_beg; j < row_end; ++j)
+                Ac->val[j] *= s;
+        }
+    }
+
+    return Ac;
+}
+
+/// Recomputes the values of the Galerkin operator for the piecewise-constant interpolation.
+template <class Matrix>
+void numeric_aggregate_galerkin(
+        const Matrix &A, const Matrix &P, const Matrix &R, float s, Matrix &Ac)
+{
+    typedef typename backend::value_type<Matrix>::type value_type;
+
+    const ptrdiff_t nc = backend::rows(R);
+
+#pragma omp parallel
+    {
+        std::vector<ptrdiff_t> marker(nc, -1);
+
+#pragma omp for
+        for(ptrdiff_t ic = 0; ic < nc; ++ic) {
+            for(ptrdiff_t j = Ac.ptr[ic], e = Ac.ptr[ic+1]; j < e; ++j) {
+                marker[Ac.col[j]] = j;
+                Ac.val[j] = math::zero<value_type>();
+            }
+
+            for(ptrdiff_t jr = R.ptr[ic], er = R.ptr[ic+1]; jr < er; ++jr) {
+                ptrdiff_t i = R.col[jr];
+                for(ptrdiff_t ja = A.ptr[i], ea = A.ptr[i+1]; ja < ea; ++ja) {
+                    ptrdiff_t j = A.col[ja];
+                    if (P.ptr[j] == P.ptr[j+1]) continue;
+                    Ac.val[marker[P.col[P.ptr[j]]]] += A.val[ja];
+                }
+            }
+
+            for(ptrdiff_t j = Ac.ptr[ic], e = Ac.ptr[ic+1]; j < e; ++j)
+                Ac.val[j] *= s;
+        }
+    }
+}
+
+} // namespace detail
+} // namespace coarsening
+} // namespace amgcl
+
+#endif
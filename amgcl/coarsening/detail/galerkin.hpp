@@ -46,6 +46,102 @@ std::shared_ptr<Matrix> galerkin(
     return product(R, *product(A, P));
 }
 
+/// Checks if the Galerkin operator should be computed without storing A * P.
+/**
+ * This is the case when each fine variable contributes to a single row of R
+ * on average (e.g. with the unsmoothed aggregation), so that the rows of
+ * A * P are not recomputed by the fused triple product.
+ */
+template <class Val, class Col, class Ptr>
+bool fused_galerkin(const backend::crs<Val, Col, Ptr> &R) {
+    return R.nnz <= R.ncols;
+}
+
+template <class Val, class Col, class Ptr>
+std::shared_ptr< backend::crs<Val, Col, Ptr> > galerkin(
+        const backend::crs<Val, Col, Ptr> &A,
+        const backend::crs<Val, Col, Ptr> &P,
+        const backend::crs<Val, Col, Ptr> &R
+        )
+{
+    if (fused_galerkin(R)) return product(R, A, P);
+    return product(R, *product(A, P));
+}
+
+/// Tag that requests the coarse operator computed with the least memory.
+/**
+ * The coarsenings that support the tag provide the overload of
+ * coarse_operator() taking it as the last argument (see
+ * amgcl::amg::params::lean_setup).
+ */
+struct lean_tag {};
+
+template <class Matrix>
+std::shared_ptr<Matrix> galerkin(
+        const Matrix &A, const Matrix &P, const Matrix &R, lean_tag
+        )
+{
+    return galerkin(A, P, R);
+}
+
+/// Galerkin operator computed without storing A * P.
+/**
+ * The rows of A * P are only kept for a chunk of the coarse rows at a time,
+ * which is somewhat slower than the two-step product, but needs much less
+ * memory.
+ */
+template <class Val, class Col, class Ptr>
+std::shared_ptr< backend::crs<Val, Col, Ptr> > galerkin(
+        const backend::crs<Val, Col, Ptr> &A,
+        const backend::crs<Val, Col, Ptr> &P,
+        const backend::crs<Val, Col, Ptr> &R,
+        lean_tag
+        )
+{
+    if (fused_galerkin(R)) return product(R, A, P);
+
+    auto C = std::make_shared< backend::crs<Val, Col, Ptr> >();
+    backend::spgemm_rap_chunked(R, A, P, *C);
+    return C;
+}
+
+/// Galerkin operator that may be recomputed numerically.
+/**
+ * The intermediate product A * P is kept in AP, so that the operator for a
+ * new matrix with the same nonzero pattern may be obtained with
+ * numeric_galerkin() without the symbolic phase of the products. AP is left
+ * empty when the fused triple product is used.
+ */
+template <class Matrix>
+std::shared_ptr<Matrix> galerkin(
+        const Matrix &A, const Matrix &P, const Matrix &R,
+        std::shared_ptr<Matrix> &AP
+        )
+{
+    if (fused_galerkin(R)) {
+        AP.reset();
+        return product(R, A, P);
+    }
+
+    AP = product(A, P);
+    return product(R, *AP);
+}
+
+/// Recomputes the values of the Galerkin operator Ac = R A P.
+template <class Matrix>
+void numeric_galerkin(
+        const Matrix &A, const Matrix &P, const Matrix &R,
+        const std::shared_ptr<Matrix> &AP, Matrix &Ac
+        )
+{
+    if (AP) {
+        numeric_product(A, P, *AP);
+        numeric_product(R, *AP, Ac);
+    } else {
+        numeric_product(R, A, P, Ac);
+    }
+}
+
 } // namespace detail
 } // namespace coarsening
 } // namespace amgcl
@@ -50,6 +50,48 @@ std::shared_ptr<Matrix> scaled_galerkin(
         return a;
 }
 
+template <class Matrix>
+std::shared_ptr<Matrix> scaled_galerkin(
+        const Matrix &A,
+        const Matrix &P,
+        const Matrix &R,
+        float s,
+        std::shared_ptr<Matrix> &AP
+        )
+{
+        auto a = galerkin(A, P, R, AP);
+        scale(*a, s);
+        return a;
+}
+
+template <class Matrix>
+std::shared_ptr<Matrix> scaled_galerkin(
+        const Matrix &A,
+        const Matrix &P,
+        const Matrix &R,
+        float s,
+        lean_tag
+        )
+{
+        auto a = galerkin(A, P, R, lean_tag());
+        scale(*a, s);
+        return a;
+}
+
+template <class Matrix>
+void numeric_scaled_galerkin(
+        const Matrix &A,
+        const Matrix &P,
+        const Matrix &R,
+        float s,
+        const std::shared_ptr<Matrix> &AP,
+        Matrix &Ac
+        )
+{
+        numeric_galerkin(A, P, R, AP, Ac);
+        scale(Ac, s);
+}
+
 } // namespace detail
 } // namespace coarsening
 } // namespace amgcl
@@ -33,6 +33,12 @@ THE SOFTWARE.
 
 #include <vector>
 #include <numeric>
+#include <algorithm>
+#include <cstdint>
+
+#ifdef _OPENMP
+#  include <omp.h>
+#endif
 
 #include <amgcl/util.hpp>
 #include <amgcl/backend/builtin.hpp>
@@ -58,6 +64,16 @@ namespace coarsening {
  * beloning to this aggregate. Later they may be claimed by other aggregates;
  * if nobody claims them, then they just stay in their initial aggregate.
  *
+ * The single pass is inherently serial. When params::parallel is set, the
+ * aggregates are built from a distance-2 maximal independent set of the
+ * strong connectivity graph instead \cite Bell2012. The independent set is
+ * found with the Luby-type iterations, where each of the undecided variables
+ * compares its random weight with the weights of its distance-2 neighbours.
+ * The independent set variables become the aggregate roots, and each of the
+ * remaining variables joins an aggregate of its neighbour. The algorithm has
+ * fine-grained parallelism, and its result does not depend on the number of
+ * threads.
+ *
  * \ingroup aggregates
  */
 struct plain_aggregates {
@@ -72,17 +88,22 @@ struct plain_aggregates {
          */
         float eps_strong;
 
-        params() : eps_strong(0.08f) {}
+        /// Use the parallel (MIS-2 based) aggregation algorithm.
+        bool parallel;
+
+        params() : eps_strong(0.08f), parallel(false) {}
 
 #ifndef AMGCL_NO_BOOST
         params(const boost::property_tree::ptree &p)
-            : AMGCL_PARAMS_IMPORT_VALUE(p, eps_strong)
+            : AMGCL_PARAMS_IMPORT_VALUE(p, eps_strong),
+              AMGCL_PARAMS_IMPORT_VALUE(p, parallel)
         {
-            check_params(p, {"eps_strong", "block_size"});
+            check_params(p, {"eps_strong", "parallel", "block_size"});
         }
 
         void get(boost::property_tree::ptree &p, const std::string &path) const {
             AMGCL_PARAMS_EXPORT_VALUE(p, path, eps_strong);
+            AMGCL_PARAMS_EXPORT_VALUE(p, path, parallel);
         }
 #endif
     };
@@ -140,10 +161,9 @@ struct plain_aggregates {
         /* 2. Get aggregate ids */
 
         // Remove lonely nodes.
-        size_t max_neib = 0;
-        for(size_t i = 0; i < n; ++i) {
+#pragma omp parallel for
+        for(ptrdiff_t i = 0; i < static_cast<ptrdiff_t>(n); ++i) {
             ptrdiff_t j = A.ptr[i], e = A.ptr[i+1];
-            max_neib    = std::max<size_t>(max_neib, e - j);
 
             ptrdiff_t state = removed;
             for(; j < e; ++j)
@@ -155,56 +175,298 @@ struct plain_aggregates {
             id[i] = state;
         }
 
-        std::vector<ptrdiff_t> neib;
-        neib.reserve(max_neib);
+        if (prm.parallel)
+            parallel_aggregation(A);
+        else
+            serial_aggregation(A);
 
-        // Perform plain aggregation
-        for(size_t i = 0; i < n; ++i) {
-            if (id[i] != undefined) continue;
+        if (!count) throw error::empty_level();
+    }
 
-            // The point is not adjacent to a core of any previous aggregate:
-            // so its a seed of a new aggregate.
-            ptrdiff_t cur_id = static_cast<ptrdiff_t>(count++);
-            id[i] = cur_id;
+    private:
+        // Plain greedy aggregation.
+        template <class Matrix>
+        void serial_aggregation(const Matrix &A) {
+            const size_t n = rows(A);
 
-            // (*) Include its neighbors as well.
-            neib.clear();
-            for(ptrdiff_t j = A.ptr[i], e = A.ptr[i+1]; j < e; ++j) {
-                ptrdiff_t c = A.col[j];
-                if (strong_connection[j] && id[c] != removed) {
-                    id[c] = cur_id;
-                    neib.push_back(c);
+            size_t max_neib = 0;
+            for(size_t i = 0; i < n; ++i)
+                max_neib = std::max<size_t>(max_neib, A.ptr[i+1] - A.ptr[i]);
+
+            std::vector<ptrdiff_t> neib;
+            neib.reserve(max_neib);
+
+            // Perform plain aggregation
+            for(size_t i = 0; i < n; ++i) {
+                if (id[i] != undefined) continue;
+
+                // The point is not adjacent to a core of any previous aggregate:
+                // so its a seed of a new aggregate.
+                ptrdiff_t cur_id = static_cast<ptrdiff_t>(count++);
+                id[i] = cur_id;
+
+                // (*) Include its neighbors as well.
+                neib.clear();
+                for(ptrdiff_t j = A.ptr[i], e = A.ptr[i+1]; j < e; ++j) {
+                    ptrdiff_t c = A.col[j];
+                    if (strong_connection[j] && id[c] != removed) {
+                        id[c] = cur_id;
+                        neib.push_back(c);
+                    }
+                }
+
+                // Temporarily mark undefined points adjacent to the new aggregate
+                // as members of the aggregate.
+                // If nobody claims them later, they will stay here.
+                for(ptrdiff_t c : neib) {
+                    for(ptrdiff_t j = A.ptr[c], e = A.ptr[c+1]; j < e; ++j) {
+                        ptrdiff_t cc = A.col[j];
+                        if (strong_connection[j] && id[cc] == undefined)
+                            id[cc] = cur_id;
+                    }
+                }
+            }
+
+            if (!count) return;
+
+            // Some of the aggregates could potentially vanish during expansion
+            // step (*) above. We need to exclude those and renumber the rest.
+            std::vector<ptrdiff_t> cnt(count, 0);
+            for(ptrdiff_t i : id)
+                if (i >= 0) cnt[i] = 1;
+            std::partial_sum(cnt.begin(), cnt.end(), cnt.begin());
+
+            if (static_cast<ptrdiff_t>(count) > cnt.back()) {
+                count = cnt.back();
+
+                for(size_t i = 0; i < n; ++i)
+                    if (id[i] >= 0) id[i] = cnt[id[i]] - 1;
+            }
+        }
+
+        // MIS-2 based aggregation.
+        template <class Matrix>
+        void parallel_aggregation(const Matrix &A) {
+            const ptrdiff_t n = rows(A);
+
+            // The keys of the variables consist of the state (in the two
+            // highest bits) and the pseudo-random weight. The independent
+            // set members dominate the undecided variables, and the
+            // undecided variables dominate the rest. The weights are unique,
+            // so the maximum key in a neighbourhood is unique as well.
+            const std::uint64_t deleted  = 0;
+            const std::uint64_t undone   = 1ULL << 62;
+            const std::uint64_t selected = 2ULL << 62;
+            const std::uint64_t weight   = undone - 1;
+
+            // t holds the keys of the variables, and c holds the maximum
+            // keys over the immediate neighbourhoods of the variables. The
+            // work lists contain the undecided variables and the variables
+            // with the undecided neighbourhoods.
+            std::vector<std::uint64_t> t(n), c(n);
+            std::vector<ptrdiff_t> w1(n), w2(n);
+
+#pragma omp parallel for
+            for(ptrdiff_t i = 0; i < n; ++i) {
+                t[i] = (id[i] == removed ? deleted : undone) | hash(i);
+                w1[i] = i;
+                w2[i] = i;
+            }
+
+            // Find distance-2 maximal independent set.
+            while(!w1.empty()) {
+                const ptrdiff_t n1 = w1.size(), n2 = w2.size();
+
+#pragma omp parallel for
+                for(ptrdiff_t k = 0; k < n2; ++k) {
+                    ptrdiff_t i = w2[k];
+                    c[i] = max_neighbour(A, t, i);
+                }
+
+#pragma omp parallel for
+                for(ptrdiff_t k = 0; k < n1; ++k) {
+                    ptrdiff_t i = w1[k];
+                    if ((t[i] & ~weight) != undone) continue;
+
+                    std::uint64_t m = max_neighbour(A, c, i);
+
+                    if (m == t[i]) {
+                        t[i] = selected | (t[i] & weight);
+                    } else if ((m & ~weight) == selected) {
+                        t[i] = deleted | (t[i] & weight);
+                    }
+                }
+
+                // Once a neighbourhood contains a selected variable, or all of
+                // its variables are deleted, its maximum key does not change.
+                compact(w1, [&](ptrdiff_t i){ return (t[i] & ~weight) == undone; });
+                compact(w2, [&](ptrdiff_t i){ return (c[i] & ~weight) == undone; });
+            }
+
+            // Number the roots of the aggregates. The rows are split into
+            // a fixed number of chunks, which are distributed between the
+            // threads that actually join the team.
+#ifdef _OPENMP
+            const int nc = omp_get_max_threads();
+#else
+            const int nc = 1;
+#endif
+            const ptrdiff_t chunk = (n + nc - 1) / nc;
+            std::vector<ptrdiff_t> offset(nc + 1, 0);
+
+#pragma omp parallel
+            {
+#ifdef _OPENMP
+                const int tid = omp_get_thread_num();
+                const int nt  = omp_get_num_threads();
+#else
+                const int tid = 0;
+                const int nt  = 1;
+#endif
+                for(int p = tid; p < nc; p += nt) {
+                    const ptrdiff_t beg = std::min(n, p * chunk);
+                    const ptrdiff_t end = std::min(n, beg + chunk);
+
+                    ptrdiff_t cnt = 0;
+                    for(ptrdiff_t i = beg; i < end; ++i)
+                        if ((t[i] & ~weight) == selected) ++cnt;
+
+                    offset[p + 1] = cnt;
+                }
+
+#pragma omp barrier
+#pragma omp single
+                std::partial_sum(offset.begin(), offset.end(), offset.begin());
+
+                for(int p = tid; p < nc; p += nt) {
+                    const ptrdiff_t beg = std::min(n, p * chunk);
+                    const ptrdiff_t end = std::min(n, beg + chunk);
+
+                    ptrdiff_t cnt = offset[p];
+                    for(ptrdiff_t i = beg; i < end; ++i)
+                        if ((t[i] & ~weight) == selected) id[i] = cnt++;
                 }
             }
 
-            // Temporarily mark undefined points adjacent to the new aggregate
-            // as members of the aggregate.
-            // If nobody claims them later, they will stay here.
-            for(ptrdiff_t c : neib) {
-                for(ptrdiff_t j = A.ptr[c], e = A.ptr[c+1]; j < e; ++j) {
-                    ptrdiff_t cc = A.col[j];
-                    if (strong_connection[j] && id[cc] == undefined)
-                        id[cc] = cur_id;
+            count = offset.back();
+
+            // The neighbours of the roots join their aggregates. Since the
+            // roots are at least three edges apart, the choice is unique
+            // for symmetric connectivity.
+            std::vector<ptrdiff_t> id1(id);
+
+#pragma omp parallel for
+            for(ptrdiff_t i = 0; i < n; ++i) {
+                if (id[i] != undefined) continue;
+
+                for(ptrdiff_t j = A.ptr[i], e = A.ptr[i+1]; j < e; ++j) {
+                    ptrdiff_t c = A.col[j];
+                    if (strong_connection[j] && (t[c] & ~weight) == selected) {
+                        id1[i] = id[c];
+                        break;
+                    }
+                }
+            }
+
+            // The rest of the variables join an aggregate of a neighbour.
+#pragma omp parallel for
+            for(ptrdiff_t i = 0; i < n; ++i) {
+                id[i] = id1[i];
+                if (id[i] != undefined) continue;
+
+                for(ptrdiff_t j = A.ptr[i], e = A.ptr[i+1]; j < e; ++j) {
+                    ptrdiff_t c = A.col[j];
+                    if (strong_connection[j] && id1[c] >= 0) {
+                        id[i] = id1[c];
+                        break;
+                    }
                 }
             }
+
+            // With nonsymmetric connectivity a few variables may be left
+            // out. Those become separate aggregates.
+            for(ptrdiff_t i = 0; i < n; ++i)
+                if (id[i] == undefined) id[i] = static_cast<ptrdiff_t>(count++);
         }
 
-        if (!count) throw error::empty_level();
+        // Maximum key over the strong neighbourhood of the variable.
+        template <class Matrix>
+        std::uint64_t max_neighbour(const Matrix &A,
+                const std::vector<std::uint64_t> &x, ptrdiff_t i) const
+        {
+            std::uint64_t m = x[i];
 
-        // Some of the aggregates could potentially vanish during expansion
-        // step (*) above. We need to exclude those and renumber the rest.
-        std::vector<ptrdiff_t> cnt(count, 0);
-        for(ptrdiff_t i : id)
-            if (i >= 0) cnt[i] = 1;
-        std::partial_sum(cnt.begin(), cnt.end(), cnt.begin());
+            for(ptrdiff_t j = A.ptr[i], e = A.ptr[i+1]; j < e; ++j)
+                if (strong_connection[j]) m = std::max(m, x[A.col[j]]);
 
-        if (static_cast<ptrdiff_t>(count) > cnt.back()) {
-            count = cnt.back();
+            return m;
+        }
 
-            for(size_t i = 0; i < n; ++i)
-                if (id[i] >= 0) id[i] = cnt[id[i]] - 1;
+        // Removes the elements that do not satisfy the predicate from the
+        // work list, keeping the order of the rest.
+        template <class Pred>
+        static void compact(std::vector<ptrdiff_t> &w, Pred &&keep) {
+            const ptrdiff_t n = w.size();
+
+#ifdef _OPENMP
+            const int nc = omp_get_max_threads();
+#else
+            const int nc = 1;
+#endif
+            const ptrdiff_t chunk = (n + nc - 1) / nc;
+            std::vector<ptrdiff_t> offset(nc + 1, 0);
+            std::vector<ptrdiff_t> v;
+
+#pragma omp parallel
+            {
+#ifdef _OPENMP
+                const int tid = omp_get_thread_num();
+                const int nt  = omp_get_num_threads();
+#else
+                const int tid = 0;
+                const int nt  = 1;
+#endif
+                for(int p = tid; p < nc; p += nt) {
+                    const ptrdiff_t beg = std::min(n, p * chunk);
+                    const ptrdiff_t end = std::min(n, beg + chunk);
+
+                    ptrdiff_t cnt = 0;
+                    for(ptrdiff_t k = beg; k < end; ++k)
+                        if (keep(w[k])) ++cnt;
+
+                    offset[p + 1] = cnt;
+                }
+
+#pragma omp barrier
+#pragma omp single
+                {
+                    std::partial_sum(offset.begin(), offset.end(), offset.begin());
+                    v.resize(offset.back());
+                }
+
+                for(int p = tid; p < nc; p += nt) {
+                    const ptrdiff_t beg = std::min(n, p * chunk);
+                    const ptrdiff_t end = std::min(n, beg + chunk);
+
+                    ptrdiff_t cnt = offset[p];
+                    for(ptrdiff_t k = beg; k < end; ++k)
+                        if (keep(w[k])) v[cnt++] = w[k];
+                }
+            }
+
+            w.swap(v);
+        }
+
+        // Pseudo-random weight of a variable. The function is a bijection
+        // on [0, 2^62), so that the weights are unique.
+        static std::uint64_t hash(ptrdiff_t i) {
+            const std::uint64_t mask = (1ULL << 62) - 1;
+
+            std::uint64_t h = static_cast<std::uint64_t>(i);
+            h = ((h ^ (h >> 31)) * 0xbf58476d1ce4e5b9ULL) & mask;
+            h = ((h ^ (h >> 29)) * 0x94d049bb133111ebULL) & mask;
+            return h ^ (h >> 32);
         }
-    }
 };
 
 } // namespace coarsening
@@ -66,7 +66,7 @@ class pointwise_aggregates {
                 : plain_aggregates::params(p),
                   AMGCL_PARAMS_IMPORT_VALUE(p, block_size)
             {
-                check_params(p, {"eps_strong", "block_size"});
+                check_params(p, {"eps_strong", "parallel", "block_size"});
             }
 
             void get(boost::property_tree::ptree &p, const std::string &path) const {
@@ -93,8 +93,6 @@ class pointwise_aggregates {
         pointwise_aggregates(const Matrix &A, const params &prm, unsigned min_aggregate)
             : count(0)
         {
-            typedef typename backend::value_type<Matrix>::type value_type;
-            typedef typename math::scalar_of<value_type>::type scalar_type;
             if (prm.block_size == 1) {
                 plain_aggregates aggr(A, prm);
 
@@ -108,7 +106,7 @@ class pointwise_aggregates {
                 id.resize( rows(A) );
 
                 auto ap = backend::pointwise_matrix(A, prm.block_size);
-                backend::crs<scalar_type> &Ap = *ap;
+                auto &Ap = *ap;
 
                 plain_aggregates pw_aggr(Ap, prm);
 
@@ -31,12 +31,19 @@ THE SOFTWARE.
  * \brief  Ruge-Stuben coarsening with direct interpolation.
  */
 
+#include <iostream>
 #include <algorithm>
 #include <numeric>
+#include <atomic>
+#include <cstdint>
 
 #include <tuple>
 #include <memory>
 
+#ifdef _OPENMP
+#  include <omp.h>
+#endif
+
 #include <amgcl/backend/builtin.hpp>
 #include <amgcl/coarsening/detail/scaled_galerkin.hpp>
 #include <amgcl/util.hpp>
@@ -44,6 +51,47 @@ THE SOFTWARE.
 namespace amgcl {
 namespace coarsening {
 
+/// Algorithms for the C/F splitting in the Ruge-Stuben coarsening.
+namespace cf_splitting {
+
+enum type {
+    classic,    ///< Classic (serial) first pass of the Ruge-Stuben algorithm.
+    pmis,       ///< Parallel modified independent set.
+    hmis        ///< Hybrid: classic splitting in the thread blocks, PMIS at the block boundaries.
+};
+
+inline std::ostream& operator<<(std::ostream &os, type s) {
+    switch (s) {
+        case classic:
+            return os << "classic";
+        case pmis:
+            return os << "pmis";
+        case hmis:
+            return os << "hmis";
+        default:
+            return os << "???";
+    }
+}
+
+inline std::istream& operator>>(std::istream &in, type &s) {
+    std::string val;
+    in >> val;
+
+    if (val == "classic")
+        s = classic;
+    else if (val == "pmis")
+        s = pmis;
+    else if (val == "hmis")
+        s = hmis;
+    else
+        throw std::invalid_argument("Invalid C/F splitting type. "
+                "Valid choices are: classic, pmis, hmis.");
+
+    return in;
+}
+
+} // namespace cf_splitting
+
 /// Classic Ruge-Stuben coarsening with direct interpolation.
 /**
  * \ingroup coarsening
@@ -79,31 +127,63 @@ struct ruge_stuben {
         /// Truncation parameter \f$\varepsilon_{tr}\f$.
         float eps_trunc;
 
-        params() : eps_strong(0.25f), do_trunc(true), eps_trunc(0.2f) {}
+        /// C/F splitting algorithm.
+        /**
+         * The classic splitting is inherently serial. The PMIS algorithm
+         * \cite DeSterck2006 selects the C-variables as an independent set
+         * of the strong connectivity graph in parallel, and usually results
+         * in a lower operator complexity. HMIS applies the classic splitting
+         * inside the blocks of rows processed by each of the threads, and
+         * then uses PMIS to complete the splitting at the block boundaries.
+         */
+        cf_splitting::type split;
+
+        params()
+            : eps_strong(0.25f), do_trunc(true), eps_trunc(0.2f),
+              split(cf_splitting::classic)
+        {}
 
 #ifndef AMGCL_NO_BOOST
         params(const boost::property_tree::ptree &p)
             : AMGCL_PARAMS_IMPORT_VALUE(p, eps_strong),
               AMGCL_PARAMS_IMPORT_VALUE(p, do_trunc),
-              AMGCL_PARAMS_IMPORT_VALUE(p, eps_trunc)
+              AMGCL_PARAMS_IMPORT_VALUE(p, eps_trunc),
+              AMGCL_PARAMS_IMPORT_VALUE(p, split)
         {
-            check_params(p, {"eps_strong", "do_trunc", "eps_trunc"});
+            check_params(p, {"eps_strong", "do_trunc", "eps_trunc", "split"});
         }
 
         void get(boost::property_tree::ptree &p, const std::string &path) const {
             AMGCL_PARAMS_EXPORT_VALUE(p, path, eps_strong);
             AMGCL_PARAMS_EXPORT_VALUE(p, path, do_trunc);
             AMGCL_PARAMS_EXPORT_VALUE(p, path, eps_trunc);
+            AMGCL_PARAMS_EXPORT_VALUE(p, path, split);
         }
 #endif
     } prm;
 
     ruge_stuben(const params &prm = params()) : prm(prm) {}
 
+    /// \copydoc amgcl::coarsening::aggregation::rebuild_data
+    template <class Matrix>
+    struct rebuild_data {
+        std::vector<char> strong;   ///< Strong connections of the system matrix.
+        std::vector<char> cf;       ///< C/F splitting.
+        std::shared_ptr<Matrix> AP; ///< The A * P product of the Galerkin operator.
+    };
+
     /// \copydoc amgcl::coarsening::aggregation::transfer_operators
     template <class Matrix>
     std::tuple< std::shared_ptr<Matrix>, std::shared_ptr<Matrix> >
     transfer_operators(const Matrix &A) const {
+        rebuild_data<Matrix> d;
+        return transfer_operators(A, d);
+    }
+
+    /// \copydoc amgcl::coarsening::aggregation::transfer_operators(const Matrix&, rebuild_data<Matrix>&)
+    template <class Matrix>
+    std::tuple< std::shared_ptr<Matrix>, std::shared_ptr<Matrix> >
+    transfer_operators(const Matrix &A, rebuild_data<Matrix> &d) const {
         typedef typename backend::value_type<Matrix>::type Val;
         typedef typename math::scalar_of<Val>::type        Scalar;
 
@@ -114,11 +194,21 @@ struct ruge_stuben {
         static const Val zero = math::zero<Val>();
 
         std::vector<char> cf(n, 'U');
-        backend::crs<char, ptrdiff_t, ptrdiff_t> S;
+        backend::crs<char, typename Matrix::col_type, typename Matrix::ptr_type> S;
 
         AMGCL_TIC("C/F split");
         connect(A, prm.eps_strong, S, cf);
-        cfsplit(A, S, cf);
+        switch (prm.split) {
+            case cf_splitting::classic:
+                cfsplit(A, S, cf);
+                break;
+            case cf_splitting::pmis:
+                pmis(A, S, cf);
+                break;
+            case cf_splitting::hmis:
+                hmis(A, S, cf);
+                break;
+        }
         AMGCL_TOC("C/F split");
 
         AMGCL_TIC("interpolation");
@@ -243,6 +333,9 @@ struct ruge_stuben {
         }
         AMGCL_TOC("interpolation");
 
+        d.strong.assign(S.val, S.val + nonzeros(A));
+        d.cf.swap(cf);
+
         return std::make_tuple(P, transpose(*P));
     }
 
@@ -253,6 +346,121 @@ struct ruge_stuben {
         return detail::galerkin(A, P, R);
     }
 
+    /// \copydoc amgcl::coarsening::aggregation::coarse_operator(const Matrix&, const Matrix&, const Matrix&, detail::lean_tag) const
+    template <class Matrix>
+    std::shared_ptr<Matrix>
+    coarse_operator(const Matrix &A, const Matrix &P, const Matrix &R, detail::lean_tag) const {
+        return detail::galerkin(A, P, R, detail::lean_tag());
+    }
+
+    /// \copydoc amgcl::coarsening::aggregation::coarse_operator(const Matrix&, const Matrix&, const Matrix&, rebuild_data<Matrix>&) const
+    template <class Matrix>
+    std::shared_ptr<Matrix>
+    coarse_operator(const Matrix &A, const Matrix &P, const Matrix &R, rebuild_data<Matrix> &d) const {
+        return detail::galerkin(A, P, R, d.AP);
+    }
+
+    /// \copydoc amgcl::coarsening::aggregation::rebuild
+    /**
+     * The interpolation weights are recomputed for the C/F splitting and the
+     * (possibly truncated) interpolation pattern from the initial setup. The
+     * truncated weights are rescaled with the sums over the kept entries.
+     */
+    template <class Matrix>
+    void rebuild(const Matrix &A, rebuild_data<Matrix> &d, Matrix &P, Matrix &R, Matrix &Ac) const {
+        typedef typename backend::value_type<Matrix>::type Val;
+        typedef typename math::scalar_of<Val>::type        Scalar;
+
+        const ptrdiff_t n = rows(A);
+
+        static const Scalar eps = amgcl::detail::eps<Scalar>(1);
+        static const Val zero = math::zero<Val>();
+
+        const std::vector<char> &S  = d.strong;
+        const std::vector<char> &cf = d.cf;
+
+        AMGCL_TIC("interpolation");
+        std::vector<ptrdiff_t> cidx(n);
+        for(ptrdiff_t i = 0, nc = 0; i < n; ++i)
+            if (cf[i] == 'C') cidx[i] = nc++;
+
+#pragma omp parallel
+        {
+            std::vector<ptrdiff_t> marker(P.ncols, -1);
+
+#pragma omp for
+            for(ptrdiff_t i = 0; i < n; ++i) {
+                if (cf[i] == 'C') continue;
+
+                ptrdiff_t row_beg = P.ptr[i];
+                for(ptrdiff_t j = row_beg, e = P.ptr[i+1]; j < e; ++j) {
+                    marker[P.col[j]] = j;
+                    P.val[j] = zero;
+                }
+
+                Val dia   = zero;
+                Val a_num = zero, a_den = zero;
+                Val b_num = zero, b_den = zero;
+                Val k_neg = zero, k_pos = zero;
+
+                for(ptrdiff_t j = A.ptr[i], e = A.ptr[i + 1]; j < e; ++j) {
+                    ptrdiff_t c = A.col[j];
+                    Val  v = A.val[j];
+
+                    if (c == i) {
+                        dia = v;
+                        continue;
+                    }
+
+                    bool interp = S[j] && cf[c] == 'C';
+                    bool kept   = interp && marker[cidx[c]] >= row_beg;
+
+                    if (v < zero) {
+                        a_num += v;
+                        if (interp) a_den += v;
+                        if (kept)   k_neg += v;
+                    } else {
+                        b_num += v;
+                        if (interp) b_den += v;
+                        if (kept)   k_pos += v;
+                    }
+                }
+
+                Scalar cf_neg = 1;
+                Scalar cf_pos = 1;
+
+                if (prm.do_trunc) {
+                    if (math::norm(k_neg) > eps)
+                        cf_neg = math::norm(a_den) / math::norm(k_neg);
+
+                    if (math::norm(k_pos) > eps)
+                        cf_pos = math::norm(b_den) / math::norm(k_pos);
+                }
+
+                if (zero < b_num && math::norm(b_den) < eps) dia += b_num;
+
+                Scalar alpha = math::norm(a_den) > eps ? -cf_neg * math::norm(a_num) / (math::norm(dia) * math::norm(a_den)) : 0;
+                Scalar beta  = math::norm(b_den) > eps ? -cf_pos * math::norm(b_num) / (math::norm(dia) * math::norm(b_den)) : 0;
+
+                for(ptrdiff_t j = A.ptr[i], e = A.ptr[i + 1]; j < e; ++j) {
+                    ptrdiff_t c = A.col[j];
+                    if (!S[j] || cf[c] != 'C') continue;
+
+                    ptrdiff_t k = marker[cidx[c]];
+                    if (k < row_beg) continue;
+
+                    Val v = A.val[j];
+                    P.val[k] = (v < zero ? alpha : beta) * v;
+                }
+            }
+        }
+
+        numeric_transpose(P, R);
+        AMGCL_TOC("interpolation");
+
+        detail::numeric_galerkin(A, P, R, d.AP, Ac);
+    }
+
     private:
         //-------------------------------------------------------------------
         // On return S will hold both strong connection matrix (in S.val, which
@@ -290,6 +498,8 @@ struct ruge_stuben {
 
                 if (math::norm(a_min) < eps) {
                     cf[i] = 'F';
+                    for(Ptr j = A.ptr[i], e = A.ptr[i + 1]; j < e; ++j)
+                        S.val[j] = 0;
                     continue;
                 }
 
@@ -299,19 +509,37 @@ struct ruge_stuben {
                     S.val[j] = (A.col[j] != i && A.val[j] < a_min);
             }
 
-            // Transposition of S:
-            for(size_t i = 0; i < nnz; ++i)
-                if (S.val[i]) ++( S.ptr[ A.col[i] + 1] );
+            // Transposition of S. The rows of the transposition are filled
+            // concurrently, and then sorted.
+            std::vector< std::atomic<Ptr> > pos(n);
+
+#pragma omp parallel for
+            for(ptrdiff_t i = 0; i < static_cast<ptrdiff_t>(n); ++i)
+                pos[i].store(0, std::memory_order_relaxed);
+
+#pragma omp parallel for
+            for(ptrdiff_t i = 0; i < static_cast<ptrdiff_t>(nnz); ++i)
+                if (S.val[i]) pos[A.col[i]].fetch_add(1, std::memory_order_relaxed);
+
+            for(size_t i = 0; i < n; ++i)
+                S.ptr[i+1] = pos[i].load(std::memory_order_relaxed);
 
             S.scan_row_sizes();
             S.col = new Col[S.ptr[n]];
 
-            for(size_t i = 0; i < n; ++i)
+#pragma omp parallel for
+            for(ptrdiff_t i = 0; i < static_cast<ptrdiff_t>(n); ++i)
+                pos[i].store(S.ptr[i], std::memory_order_relaxed);
+
+#pragma omp parallel for
+            for(ptrdiff_t i = 0; i < static_cast<ptrdiff_t>(n); ++i)
                 for(Ptr j = A.ptr[i], e = A.ptr[i + 1]; j < e; ++j)
-                    if (S.val[j]) S.col[ S.ptr[ A.col[j] ]++ ] = i;
+                    if (S.val[j])
+                        S.col[pos[A.col[j]].fetch_add(1, std::memory_order_relaxed)] = i;
 
-            std::rotate(S.ptr, S.ptr + n, S.ptr + n + 1);
-            S.ptr[0] = 0;
+#pragma omp parallel for
+            for(ptrdiff_t i = 0; i < static_cast<ptrdiff_t>(n); ++i)
+                std::sort(S.col + S.ptr[i], S.col + S.ptr[i+1]);
         }
 
         // Split variables into C(oarse) and F(ine) sets.
@@ -434,6 +662,222 @@ struct ruge_stuben {
                 }
             }
         }
+
+        // Parallel modified independent set (PMIS) splitting. The variables
+        // that are already marked as C are used as the initial C-set.
+        template <typename Val, typename Col, typename Ptr>
+        static void pmis(
+                backend::crs<Val,  Col, Ptr> const &A,
+                backend::crs<char, Col, Ptr> const &S,
+                std::vector<char>                  &cf
+                )
+        {
+            const ptrdiff_t n = rows(A);
+
+            // The weight of a variable is the number of variables it
+            // influences plus a random number. The ties are broken by the
+            // variable index.
+            std::vector<std::uint64_t> w(n);
+            std::vector<char> sel(n);
+
+#pragma omp parallel for
+            for(ptrdiff_t i = 0; i < n; ++i) {
+                std::uint64_t ninf = S.ptr[i+1] - S.ptr[i];
+                w[i] = (ninf << 32) | hash(i);
+
+                sel[i] = (cf[i] == 'C');
+
+                // Variables that do not influence other variables become F.
+                if (cf[i] == 'U' && !ninf) cf[i] = 'F';
+            }
+
+            auto greater = [&w](ptrdiff_t i, ptrdiff_t j) {
+                return w[i] > w[j] || (w[i] == w[j] && i > j);
+            };
+
+            for(;;) {
+                // Mark the new C-variables.
+#pragma omp parallel for
+                for(ptrdiff_t i = 0; i < n; ++i)
+                    if (sel[i]) cf[i] = 'C';
+
+                // Undecided variables that strongly depend on the new
+                // C-variables become F-variables.
+#pragma omp parallel for
+                for(ptrdiff_t i = 0; i < n; ++i) {
+                    if (cf[i] != 'U') continue;
+
+                    for(Ptr j = A.ptr[i], e = A.ptr[i+1]; j < e; ++j) {
+                        if (S.val[j] && sel[A.col[j]]) {
+                            cf[i] = 'F';
+                            break;
+                        }
+                    }
+                }
+
+                // Undecided variables with the maximum weight among their
+                // undecided neighbours become the new C-variables.
+                ptrdiff_t n_undone = 0;
+#pragma omp parallel for reduction(+:n_undone)
+                for(ptrdiff_t i = 0; i < n; ++i) {
+                    sel[i] = false;
+                    if (cf[i] != 'U') continue;
+
+                    ++n_undone;
+
+                    bool is_max = true;
+
+                    for(Ptr j = A.ptr[i], e = A.ptr[i+1]; is_max && j < e; ++j) {
+                        Col c = A.col[j];
+                        if (S.val[j] && cf[c] == 'U' && greater(c, i)) is_max = false;
+                    }
+
+                    for(Ptr j = S.ptr[i], e = S.ptr[i+1]; is_max && j < e; ++j) {
+                        Col c = S.col[j];
+                        if (cf[c] == 'U' && greater(c, i)) is_max = false;
+                    }
+
+                    sel[i] = is_max;
+                }
+
+                if (!n_undone) break;
+            }
+
+            // F-variables that strongly depend on other variables but have no
+            // strong C-connections become C, so that the interpolation is
+            // defined for every variable.
+#pragma omp parallel for
+            for(ptrdiff_t i = 0; i < n; ++i) {
+                if (cf[i] != 'F') continue;
+
+                bool strong = false, coarse = false;
+                for(Ptr j = A.ptr[i], e = A.ptr[i+1]; j < e && !coarse; ++j) {
+                    if (!S.val[j]) continue;
+                    strong = true;
+                    if (cf[A.col[j]] == 'C') coarse = true;
+                }
+
+                sel[i] = strong && !coarse;
+            }
+
+#pragma omp parallel for
+            for(ptrdiff_t i = 0; i < n; ++i)
+                if (sel[i]) cf[i] = 'C';
+        }
+
+        // Hybrid MIS splitting. The classic splitting is applied to the
+        // global strength graph restricted to the diagonal block owned by
+        // each of the threads, and the resulting C-variables are used as the
+        // initial C-set for PMIS.
+        template <typename Val, typename Col, typename Ptr>
+        static void hmis(
+                backend::crs<Val,  Col, Ptr> const &A,
+                backend::crs<char, Col, Ptr> const &S,
+                std::vector<char>                  &cf
+                )
+        {
+            const ptrdiff_t n = rows(A);
+
+            // The rows are split into a fixed number of chunks, which are
+            // distributed between the threads that actually join the team,
+            // so that the splitting does not depend on the team size.
+#ifdef _OPENMP
+            const int nc = omp_get_max_threads();
+#else
+            const int nc = 1;
+#endif
+            const ptrdiff_t chunk = (n + nc - 1) / nc;
+
+#pragma omp parallel
+            {
+#ifdef _OPENMP
+                const int tid = omp_get_thread_num();
+                const int nt  = omp_get_num_threads();
+#else
+                const int tid = 0;
+                const int nt  = 1;
+#endif
+                for(int p = tid; p < nc; p += nt) {
+                    const ptrdiff_t beg = std::min(n, p * chunk);
+                    const ptrdiff_t end = std::min(n, beg + chunk);
+                    const ptrdiff_t m   = end - beg;
+
+                    if (m > 0) {
+                        // The structure of the block (only the structure is
+                        // used by cfsplit), and the restriction of S to the
+                        // block: S.val follows the nonzeros of A, and the
+                        // rows of S (ptr, col) hold the transposed graph.
+                        backend::crs<Val, Col, Ptr> Aloc;
+                        backend::crs<char, Col, Ptr> Sloc;
+
+                        Aloc.set_size(m, m, true);
+                        Sloc.set_size(m, m, true);
+
+                        for(ptrdiff_t i = beg; i < end; ++i) {
+                            Ptr cnt = 0;
+                            for(Ptr j = A.ptr[i], e = A.ptr[i+1]; j < e; ++j) {
+                                Col c = A.col[j];
+                                if (beg <= c && c < end) ++cnt;
+                            }
+                            Aloc.ptr[i - beg + 1] = cnt;
+
+                            cnt = 0;
+                            for(Ptr j = S.ptr[i], e = S.ptr[i+1]; j < e; ++j) {
+                                Col c = S.col[j];
+                                if (beg <= c && c < end) ++cnt;
+                            }
+                            Sloc.ptr[i - beg + 1] = cnt;
+                        }
+
+                        Aloc.set_nonzeros(Aloc.scan_row_sizes(), false);
+                        Sloc.set_nonzeros(Sloc.scan_row_sizes(), false);
+                        Sloc.val = new char[Aloc.nnz];
+
+                        // The variables without strong couplings inside the
+                        // block are left for PMIS.
+                        std::vector<char> cfloc(m, 'F');
+
+                        for(ptrdiff_t i = beg; i < end; ++i) {
+                            Ptr head = Aloc.ptr[i - beg];
+                            for(Ptr j = A.ptr[i], e = A.ptr[i+1]; j < e; ++j) {
+                                Col c = A.col[j];
+                                if (beg <= c && c < end) {
+                                    Aloc.col[head] = c - beg;
+                                    Sloc.val[head] = S.val[j];
+                                    if (S.val[j]) {
+                                        cfloc[i - beg] = 'U';
+                                        cfloc[c - beg] = 'U';
+                                    }
+                                    ++head;
+                                }
+                            }
+
+                            head = Sloc.ptr[i - beg];
+                            for(Ptr j = S.ptr[i], e = S.ptr[i+1]; j < e; ++j) {
+                                Col c = S.col[j];
+                                if (beg <= c && c < end)
+                                    Sloc.col[head++] = c - beg;
+                            }
+                        }
+
+                        cfsplit(Aloc, Sloc, cfloc);
+
+                        for(ptrdiff_t i = beg; i < end; ++i)
+                            if (cf[i] == 'U' && cfloc[i - beg] == 'C') cf[i] = 'C';
+                    }
+                }
+            }
+
+            pmis(A, S, cf);
+        }
+
+        // Pseudo-random weight of a variable.
+        static std::uint32_t hash(ptrdiff_t i) {
+            std::uint64_t h = static_cast<std::uint64_t>(i);
+            h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+            h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+            return static_cast<std::uint32_t>(h ^ (h >> 31));
+        }
 };
 
 } // namespace coarsening
@@ -161,6 +161,78 @@ struct wrapper {
             AMGCL_RUNTIME_COARSENING(smoothed_aggregation);
             AMGCL_RUNTIME_COARSENING(smoothed_aggr_emin);
 
+#undef AMGCL_RUNTIME_COARSENING
+
+            default:
+                throw std::invalid_argument("Unsupported coarsening type");
+        }
+    }
+
+    /// Data needed to rebuild the level, see amgcl::amg::params::allow_rebuild.
+    template <class Matrix>
+    struct rebuild_data {
+        std::shared_ptr<void> data;
+    };
+
+    template <class Matrix>
+    std::tuple<
+        std::shared_ptr<Matrix>,
+        std::shared_ptr<Matrix>
+        >
+    transfer_operators(const Matrix &A, rebuild_data<Matrix> &d) {
+        switch(c) {
+
+#define AMGCL_RUNTIME_COARSENING(type) \
+            case type: \
+                return make_operators<amgcl::coarsening::type>(A, d)
+
+            AMGCL_RUNTIME_COARSENING(ruge_stuben);
+            AMGCL_RUNTIME_COARSENING(aggregation);
+            AMGCL_RUNTIME_COARSENING(smoothed_aggregation);
+            AMGCL_RUNTIME_COARSENING(smoothed_aggr_emin);
+
+#undef AMGCL_RUNTIME_COARSENING
+
+            default:
+                throw std::invalid_argument("Unsupported coarsening type");
+        }
+    }
+
+    template <class Matrix>
+    std::shared_ptr<Matrix>
+    coarse_operator(const Matrix &A, const Matrix &P, const Matrix &R, rebuild_data<Matrix> &d) const {
+        switch(c) {
+
+#define AMGCL_RUNTIME_COARSENING(type) \
+            case type: \
+                return make_coarse<amgcl::coarsening::type>(A, P, R, d)
+
+            AMGCL_RUNTIME_COARSENING(ruge_stuben);
+            AMGCL_RUNTIME_COARSENING(aggregation);
+            AMGCL_RUNTIME_COARSENING(smoothed_aggregation);
+            AMGCL_RUNTIME_COARSENING(smoothed_aggr_emin);
+
+#undef AMGCL_RUNTIME_COARSENING
+
+            default:
+                throw std::invalid_argument("Unsupported coarsening type");
+        }
+    }
+
+    template <class Matrix>
+    void rebuild(const Matrix &A, rebuild_data<Matrix> &d, Matrix &P, Matrix &R, Matrix &Ac) const {
+        switch(c) {
+
+#define AMGCL_RUNTIME_COARSENING(type) \
+            case type: \
+                call_rebuild<amgcl::coarsening::type>(A, d, P, R, Ac); \
+                break
+
+            AMGCL_RUNTIME_COARSENING(ruge_stuben);
+            AMGCL_RUNTIME_COARSENING(aggregation);
+            AMGCL_RUNTIME_COARSENING(smoothed_aggregation);
+            AMGCL_RUNTIME_COARSENING(smoothed_aggr_emin);
+
 #undef AMGCL_RUNTIME_COARSENING
 
             default:
@@ -182,6 +254,27 @@ struct wrapper {
             AMGCL_RUNTIME_COARSENING(smoothed_aggregation);
             AMGCL_RUNTIME_COARSENING(smoothed_aggr_emin);
 
+#undef AMGCL_RUNTIME_COARSENING
+
+            default:
+                throw std::invalid_argument("Unsupported coarsening type");
+        }
+    }
+
+    template <class Matrix>
+    std::shared_ptr<Matrix>
+    coarse_operator(const Matrix &A, const Matrix &P, const Matrix &R, amgcl::coarsening::detail::lean_tag) const {
+        switch(c) {
+
+#define AMGCL_RUNTIME_COARSENING(type) \
+            case type: \
+                return make_coarse<amgcl::coarsening::type>(A, P, R, amgcl::coarsening::detail::lean_tag())
+
+            AMGCL_RUNTIME_COARSENING(ruge_stuben);
+            AMGCL_RUNTIME_COARSENING(aggregation);
+            AMGCL_RUNTIME_COARSENING(smoothed_aggregation);
+            AMGCL_RUNTIME_COARSENING(smoothed_aggr_emin);
+
 #undef AMGCL_RUNTIME_COARSENING
 
             default:
@@ -265,6 +358,91 @@ struct wrapper {
     make_coarse(const Matrix&, const Matrix&, const Matrix&) const {
         throw std::logic_error("The coarsening is not supported by the backend");
     }
+
+    template <template <class> class Coarsening, class Matrix>
+    typename std::enable_if<
+        backend::coarsening_is_supported<Backend, Coarsening>::value,
+        std::shared_ptr<Matrix>
+    >::type
+    make_coarse(const Matrix &A, const Matrix &P, const Matrix &R, amgcl::coarsening::detail::lean_tag) const {
+        return static_cast<Coarsening<Backend>*>(handle)->coarse_operator(A, P, R, amgcl::coarsening::detail::lean_tag());
+    }
+
+    template <template <class> class Coarsening, class Matrix>
+    typename std::enable_if<
+        !backend::coarsening_is_supported<Backend, Coarsening>::value,
+        std::shared_ptr<Matrix>
+    >::type
+    make_coarse(const Matrix&, const Matrix&, const Matrix&, amgcl::coarsening::detail::lean_tag) const {
+        throw std::logic_error("The coarsening is not supported by the backend");
+    }
+
+    template <template <class> class Coarsening, class Matrix>
+    typename std::enable_if<
+        backend::coarsening_is_supported<Backend, Coarsening>::value,
+        std::tuple<
+            std::shared_ptr<Matrix>,
+            std::shared_ptr<Matrix>
+            >
+    >::type
+    make_operators(const Matrix &A, rebuild_data<Matrix> &d) const {
+        typedef typename Coarsening<Backend>::template rebuild_data<Matrix> data_type;
+        auto data = std::make_shared<data_type>();
+        d.data = data;
+        return static_cast<Coarsening<Backend>*>(handle)->transfer_operators(A, *data);
+    }
+
+    template <template <class> class Coarsening, class Matrix>
+    typename std::enable_if<
+        !backend::coarsening_is_supported<Backend, Coarsening>::value,
+        std::tuple<
+            std::shared_ptr<Matrix>,
+            std::shared_ptr<Matrix>
+            >
+    >::type
+    make_operators(const Matrix&, rebuild_data<Matrix>&) {
+        throw std::logic_error("The coarsening is not supported by the backend");
+    }
+
+    template <template <class> class Coarsening, class Matrix>
+    typename std::enable_if<
+        backend::coarsening_is_supported<Backend, Coarsening>::value,
+        std::shared_ptr<Matrix>
+    >::type
+    make_coarse(const Matrix &A, const Matrix &P, const Matrix &R, rebuild_data<Matrix> &d) const {
+        typedef typename Coarsening<Backend>::template rebuild_data<Matrix> data_type;
+        return static_cast<Coarsening<Backend>*>(handle)->coarse_operator(
+                A, P, R, *std::static_pointer_cast<data_type>(d.data));
+    }
+
+    template <template <class> class Coarsening, class Matrix>
+    typename std::enable_if<
+        !backend::coarsening_is_supported<Backend, Coarsening>::value,
+        std::shared_ptr<Matrix>
+    >::type
+    make_coarse(const Matrix&, const Matrix&, const Matrix&, rebuild_data<Matrix>&) const {
+        throw std::logic_error("The coarsening is not supported by the backend");
+    }
+
+    template <template <class> class Coarsening, class Matrix>
+    typename std::enable_if<
+        backend::coarsening_is_supported<Backend, Coarsening>::value,
+        void
+    >::type
+    call_rebuild(const Matrix &A, rebuild_data<Matrix> &d, Matrix &P, Matrix &R, Matrix &Ac) const {
+        typedef typename Coarsening<Backend>::template rebuild_data<Matrix> data_type;
+        static_cast<Coarsening<Backend>*>(handle)->rebuild(
+                A, *std::static_pointer_cast<data_type>(d.data), P, R, Ac);
+    }
+
+    template <template <class> class Coarsening, class Matrix>
+    typename std::enable_if<
+        !backend::coarsening_is_supported<Backend, Coarsening>::value,
+        void
+    >::type
+    call_rebuild(const Matrix&, rebuild_data<Matrix>&, Matrix&, Matrix&, Matrix&) const {
+        throw std::logic_error("The coarsening is not supported by the backend");
+    }
 };
 
 } // namespace coarsening
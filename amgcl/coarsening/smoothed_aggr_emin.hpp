@@ -82,6 +82,14 @@ struct smoothed_aggr_emin {
 
     smoothed_aggr_emin(const params &prm = params()) : prm(prm) {}
 
+    /// \copydoc amgcl::coarsening::aggregation::rebuild_data
+    template <class Matrix>
+    struct rebuild_data {
+        std::shared_ptr<Matrix> P_tent;     ///< Tentative prolongation.
+        std::vector<char> strong_connection; ///< Strong connections of the system matrix.
+        std::shared_ptr<Matrix> AP;         ///< The A * P product of the Galerkin operator.
+    };
+
     /// \copydoc amgcl::coarsening::aggregation::transfer_operators
     template <class Matrix>
     std::tuple<
@@ -89,88 +97,153 @@ struct smoothed_aggr_emin {
         std::shared_ptr<Matrix>
         >
     transfer_operators(const Matrix &A) {
-        typedef typename backend::value_type<Matrix>::type Val;
-        typedef ptrdiff_t Idx;
+        rebuild_data<Matrix> d;
+        return transfer_operators(A, d);
+    }
 
+    /// \copydoc amgcl::coarsening::aggregation::transfer_operators(const Matrix&, rebuild_data<Matrix>&)
+    template <class Matrix>
+    std::tuple<
+        std::shared_ptr<Matrix>,
+        std::shared_ptr<Matrix>
+        >
+    transfer_operators(const Matrix &A, rebuild_data<Matrix> &d) {
         AMGCL_TIC("aggregates");
         Aggregates aggr(A, prm.aggr, prm.nullspace.cols);
         prm.aggr.eps_strong *= 0.5;
         AMGCL_TOC("aggregates");
 
         AMGCL_TIC("interpolation");
-        auto P_tent = tentative_prolongation<Matrix>(
+        d.P_tent = tentative_prolongation<Matrix>(
                 rows(A), aggr.count, aggr.id, prm.nullspace, prm.aggr.block_size
                 );
+        d.strong_connection.swap(aggr.strong_connection);
+
+        auto PR = smoothed_operators(A, d.strong_connection, *d.P_tent);
+        AMGCL_TOC("interpolation");
+
+        return PR;
+    }
+
+    template <class Matrix>
+    std::shared_ptr<Matrix>
+    coarse_operator(const Matrix &A, const Matrix &P, const Matrix &R) const {
+        return detail::galerkin(A, P, R);
+    }
+
+    /// \copydoc amgcl::coarsening::aggregation::coarse_operator(const Matrix&, const Matrix&, const Matrix&, detail::lean_tag) const
+    template <class Matrix>
+    std::shared_ptr<Matrix>
+    coarse_operator(const Matrix &A, const Matrix &P, const Matrix &R, detail::lean_tag) const {
+        return detail::galerkin(A, P, R, detail::lean_tag());
+    }
+
+    /// \copydoc amgcl::coarsening::aggregation::coarse_operator(const Matrix&, const Matrix&, const Matrix&, rebuild_data<Matrix>&) const
+    template <class Matrix>
+    std::shared_ptr<Matrix>
+    coarse_operator(const Matrix &A, const Matrix &P, const Matrix &R, rebuild_data<Matrix> &d) const {
+        return detail::galerkin(A, P, R, d.AP);
+    }
+
+    /// \copydoc amgcl::coarsening::aggregation::rebuild
+    /**
+     * The smoothed operators are recomputed with the aggregates and the
+     * strong connections from the initial setup. Since the nonzero patterns
+     * of the operators only depend on those, the values are copied into the
+     * existing P and R.
+     */
+    template <class Matrix>
+    void rebuild(const Matrix &A, rebuild_data<Matrix> &d, Matrix &P, Matrix &R, Matrix &Ac) const {
+        AMGCL_TIC("interpolation");
+        std::shared_ptr<Matrix> p, r;
+        std::tie(p, r) = smoothed_operators(A, d.strong_connection, *d.P_tent);
+
+        precondition(
+                nonzeros(*p) == nonzeros(P) && nonzeros(*r) == nonzeros(R),
+                "Transfer operator pattern has changed during rebuild"
+                );
+
+        std::copy(p->val, p->val + nonzeros(P), P.val);
+        std::copy(r->val, r->val + nonzeros(R), R.val);
+        AMGCL_TOC("interpolation");
+
+        detail::numeric_galerkin(A, P, R, d.AP, Ac);
+    }
+
+    private:
+        template <class Matrix>
+        static std::tuple<
+            std::shared_ptr<Matrix>,
+            std::shared_ptr<Matrix>
+            >
+        smoothed_operators(const Matrix &A,
+                const std::vector<char> &strong_connection,
+                const Matrix &P_tent)
+        {
+            typedef typename backend::value_type<Matrix>::type Val;
+            typedef ptrdiff_t Idx;
 
-        // Filter the system matrix
-        backend::crs<Val> Af;
-        Af.set_size(rows(A), cols(A));
-        Af.ptr[0] = 0;
+            // Filter the system matrix
+            Matrix Af;
+            Af.set_size(rows(A), cols(A));
+            Af.ptr[0] = 0;
 
-        std::vector<Val> dia(Af.nrows);
+            std::vector<Val> dia(Af.nrows);
 
 #pragma omp parallel for
-        for(Idx i = 0; i < static_cast<Idx>(Af.nrows); ++i) {
-            Idx row_begin = A.ptr[i];
-            Idx row_end   = A.ptr[i+1];
-            Idx row_width = row_end - row_begin;
-
-            Val D = math::zero<Val>();
-            for(Idx j = row_begin; j < row_end; ++j) {
-                Idx c = A.col[j];
-                Val v = A.val[j];
-
-                if (c == i)
-                    D += v;
-                else if (!aggr.strong_connection[j]) {
-                    D += v;
-                    --row_width;
+            for(Idx i = 0; i < static_cast<Idx>(Af.nrows); ++i) {
+                Idx row_begin = A.ptr[i];
+                Idx row_end   = A.ptr[i+1];
+                Idx row_width = row_end - row_begin;
+
+                Val D = math::zero<Val>();
+                for(Idx j = row_begin; j < row_end; ++j) {
+                    Idx c = A.col[j];
+                    Val v = A.val[j];
+
+                    if (c == i)
+                        D += v;
+                    else if (!strong_connection[j]) {
+                        D += v;
+                        --row_width;
+                    }
                 }
-            }
 
-            dia[i] = D;
-            Af.ptr[i+1] = row_width;
-        }
+                dia[i] = D;
+                Af.ptr[i+1] = row_width;
+            }
 
-        Af.set_nonzeros(Af.scan_row_sizes());
+            Af.set_nonzeros(Af.scan_row_sizes());
 
 #pragma omp parallel for
-        for(Idx i = 0; i < static_cast<Idx>(Af.nrows); ++i) {
-            Idx row_begin = A.ptr[i];
-            Idx row_end   = A.ptr[i+1];
-            Idx row_head  = Af.ptr[i];
-
-            for(Idx j = row_begin; j < row_end; ++j) {
-                Idx c = A.col[j];
-
-                if (c == i) {
-                    Af.col[row_head] = i;
-                    Af.val[row_head] = dia[i];
-                    ++row_head;
-                } else if (aggr.strong_connection[j]) {
-                    Af.col[row_head] = c;
-                    Af.val[row_head] = A.val[j];
-                    ++row_head;
+            for(Idx i = 0; i < static_cast<Idx>(Af.nrows); ++i) {
+                Idx row_begin = A.ptr[i];
+                Idx row_end   = A.ptr[i+1];
+                Idx row_head  = Af.ptr[i];
+
+                for(Idx j = row_begin; j < row_end; ++j) {
+                    Idx c = A.col[j];
+
+                    if (c == i) {
+                        Af.col[row_head] = i;
+                        Af.val[row_head] = dia[i];
+                        ++row_head;
+                    } else if (strong_connection[j]) {
+                        Af.col[row_head] = c;
+                        Af.val[row_head] = A.val[j];
+                        ++row_head;
+                    }
                 }
             }
-        }
 
-        std::vector<Val> omega;
+            std::vector<Val> omega;
 
-        auto P = interpolation(Af, dia, *P_tent, omega);
-        auto R = restriction  (Af, dia, *P_tent, omega);
-        AMGCL_TOC("interpolation");
+            auto P = interpolation(Af, dia, P_tent, omega);
+            auto R = restriction  (Af, dia, P_tent, omega);
 
-        return std::make_tuple(P, R);
-    }
-
-    template <class Matrix>
-    std::shared_ptr<Matrix>
-    coarse_operator(const Matrix &A, const Matrix &P, const Matrix &R) const {
-        return detail::galerkin(A, P, R);
-    }
+            return std::make_tuple(P, R);
+        }
 
-    private:
         template <class AMatrix, typename Val, typename Col, typename Ptr>
         static std::shared_ptr< backend::crs<Val, Col, Ptr> >
         interpolation(
@@ -126,10 +126,26 @@ struct smoothed_aggregation {
 
     smoothed_aggregation(const params &prm = params()) : prm(prm) {}
 
+    /// \copydoc amgcl::coarsening::aggregation::rebuild_data
+    template <class Matrix>
+    struct rebuild_data {
+        std::shared_ptr<Matrix> P_tent;     ///< Tentative prolongation.
+        std::vector<char> strong_connection; ///< Strong connections of the system matrix.
+        std::shared_ptr<Matrix> AP;         ///< The A * P product of the Galerkin operator.
+    };
+
     /// \copydoc amgcl::coarsening::aggregation::transfer_operators
     template <class Matrix>
     std::tuple< std::shared_ptr<Matrix>, std::shared_ptr<Matrix> >
     transfer_operators(const Matrix &A) {
+        rebuild_data<Matrix> d;
+        return transfer_operators(A, d);
+    }
+
+    /// \copydoc amgcl::coarsening::aggregation::transfer_operators(const Matrix&, rebuild_data<Matrix>&)
+    template <class Matrix>
+    std::tuple< std::shared_ptr<Matrix>, std::shared_ptr<Matrix> >
+    transfer_operators(const Matrix &A, rebuild_data<Matrix> &d) {
         typedef typename backend::value_type<Matrix>::type value_type;
         typedef typename math::scalar_of<value_type>::type scalar_type;
 
@@ -147,12 +163,7 @@ struct smoothed_aggregation {
         auto P = std::make_shared<Matrix>();
         P->set_size(rows(*P_tent), cols(*P_tent), true);
 
-        scalar_type omega = prm.relax;
-        if (prm.estimate_spectral_radius) {
-            omega *= static_cast<scalar_type>(4.0/3) / backend::spectral_radius<true>(A, prm.power_iters);
-        } else {
-            omega *= static_cast<scalar_type>(2.0/3);
-        }
+        scalar_type omega = damping(A);
 
         AMGCL_TIC("smoothing");
 #pragma omp parallel
@@ -231,6 +242,9 @@ struct smoothed_aggregation {
         }
         AMGCL_TOC("smoothing");
 
+        d.P_tent = P_tent;
+        d.strong_connection.swap(aggr.strong_connection);
+
         return std::make_tuple(P, transpose(*P));
     }
 
@@ -240,6 +254,90 @@ struct smoothed_aggregation {
     coarse_operator(const Matrix &A, const Matrix &P, const Matrix &R) const {
         return detail::galerkin(A, P, R);
     }
+
+    /// \copydoc amgcl::coarsening::aggregation::coarse_operator(const Matrix&, const Matrix&, const Matrix&, detail::lean_tag) const
+    template <class Matrix>
+    std::shared_ptr<Matrix>
+    coarse_operator(const Matrix &A, const Matrix &P, const Matrix &R, detail::lean_tag) const {
+        return detail::galerkin(A, P, R, detail::lean_tag());
+    }
+
+    /// \copydoc amgcl::coarsening::aggregation::coarse_operator(const Matrix&, const Matrix&, const Matrix&, rebuild_data<Matrix>&) const
+    template <class Matrix>
+    std::shared_ptr<Matrix>
+    coarse_operator(const Matrix &A, const Matrix &P, const Matrix &R, rebuild_data<Matrix> &d) const {
+        return detail::galerkin(A, P, R, d.AP);
+    }
+
+    /// \copydoc amgcl::coarsening::aggregation::rebuild
+    template <class Matrix>
+    void rebuild(const Matrix &A, rebuild_data<Matrix> &d, Matrix &P, Matrix &R, Matrix &Ac) const {
+        typedef typename backend::value_type<Matrix>::type value_type;
+        typedef typename math::scalar_of<value_type>::type scalar_type;
+
+        const ptrdiff_t n = rows(A);
+        const Matrix &P_tent = *d.P_tent;
+        const std::vector<char> &strong = d.strong_connection;
+
+        scalar_type omega = damping(A);
+
+        AMGCL_TIC("smoothing");
+#pragma omp parallel
+        {
+            std::vector<ptrdiff_t> marker(P.ncols, -1);
+
+            // The pattern of P is kept, only the values are recomputed.
+#pragma omp for
+            for(ptrdiff_t i = 0; i < n; ++i) {
+                for(ptrdiff_t j = P.ptr[i], e = P.ptr[i+1]; j < e; ++j) {
+                    marker[P.col[j]] = j;
+                    P.val[j] = math::zero<value_type>();
+                }
+
+                value_type dia = math::zero<value_type>();
+                for(ptrdiff_t j = A.ptr[i], e = A.ptr[i+1]; j < e; ++j) {
+                    if (A.col[j] == i || !strong[j])
+                        dia += A.val[j];
+                }
+                dia = -omega * math::inverse(dia);
+
+                for(ptrdiff_t ja = A.ptr[i], ea = A.ptr[i + 1]; ja < ea; ++ja) {
+                    ptrdiff_t ca = A.col[ja];
+
+                    if (ca != i && !strong[ja]) continue;
+
+                    value_type va = (ca == i)
+                        ? static_cast<value_type>(static_cast<scalar_type>(1 - omega) * math::identity<value_type>())
+                        : dia * A.val[ja];
+
+                    for(ptrdiff_t jp = P_tent.ptr[ca], ep = P_tent.ptr[ca+1]; jp < ep; ++jp)
+                        P.val[marker[P_tent.col[jp]]] += va * P_tent.val[jp];
+                }
+            }
+        }
+
+        numeric_transpose(P, R);
+        AMGCL_TOC("smoothing");
+
+        detail::numeric_galerkin(A, P, R, d.AP, Ac);
+    }
+
+    private:
+        // Damping factor for the prolongation smoother.
+        template <class Matrix>
+        typename math::scalar_of<typename backend::value_type<Matrix>::type>::type
+        damping(const Matrix &A) const {
+            typedef typename backend::value_type<Matrix>::type value_type;
+            typedef typename math::scalar_of<value_type>::type scalar_type;
+
+            scalar_type omega = prm.relax;
+            if (prm.estimate_spectral_radius) {
+                omega *= static_cast<scalar_type>(4.0/3) / backend::spectral_radius<true>(A, prm.power_iters);
+            } else {
+                omega *= static_cast<scalar_type>(2.0/3);
+            }
+            return omega;
+        }
 };
 
 } // namespace coarsening
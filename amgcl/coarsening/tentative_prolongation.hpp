@@ -126,6 +126,7 @@ std::shared_ptr<Matrix> tentative_prolongation(
         )
 {
     typedef typename backend::value_type<Matrix>::type value_type;
+    typedef typename Matrix::col_type col_type;
 
     auto P = std::make_shared<Matrix>();
 
@@ -190,7 +191,7 @@ std::shared_ptr<Matrix> tentative_prolongation(
                         Bnew[i * nullspace.cols * nullspace.cols + kk] = qr.R(ii,jj);
 
                 for(ptrdiff_t j = aggr_beg, ii = 0; j < aggr_end; ++j, ++ii) {
-                    ptrdiff_t  *c = &P->col[P->ptr[order[j]]];
+                    col_type   *c = &P->col[P->ptr[order[j]]];
                     value_type *v = &P->val[P->ptr[order[j]]];
 
                     for(int jj = 0; jj < nullspace.cols; ++jj) {
@@ -57,7 +57,9 @@ class deflated_solver : public amgcl::detail::non_copyable {
 
         typedef typename backend_type::value_type value_type;
         typedef typename backend_type::params backend_params;
-        typedef typename backend::builtin<value_type>::matrix build_matrix;
+        typedef typename backend_type::col_type col_type;
+        typedef typename backend_type::ptr_type ptr_type;
+        typedef typename backend::builtin<value_type, col_type, ptr_type>::matrix build_matrix;
 
         typedef typename math::scalar_of<value_type>::type scalar_type;
 
@@ -0,0 +1,156 @@
+#ifndef AMGCL_DETAIL_CYCLE_HPP
+#define AMGCL_DETAIL_CYCLE_HPP
+
+/*
+The MIT License
+
+Copyright (c) 2012-2021 Denis Demidov <dennis.demidov@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/**
+ * \file   amgcl/detail/cycle.hpp
+ * \author Denis Demidov <dennis.demidov@gmail.com>
+ * \brief  AMG cycle types.
+ */
+
+#include <iostream>
+#include <string>
+#include <stdexcept>
+#include <cmath>
+
+#include <amgcl/backend/interface.hpp>
+#include <amgcl/value_type/interface.hpp>
+
+namespace amgcl {
+namespace cycle_type {
+
+enum type {
+    standard,   ///< V-cycle, W-cycle, etc., depending on the ncycle parameter.
+    fcycle,     ///< F-cycle.
+    kcycle,     ///< Krylov-accelerated K-cycle.
+    additive    ///< Additive multigrid.
+};
+
+inline std::ostream& operator<<(std::ostream &os, type c) {
+    switch (c) {
+        case standard:
+            return os << "standard";
+        case fcycle:
+            return os << "fcycle";
+        case kcycle:
+            return os << "kcycle";
+        case additive:
+            return os << "additive";
+        default:
+            return os << "???";
+    }
+}
+
+inline std::istream& operator>>(std::istream &in, type &c) {
+    std::string val;
+    in >> val;
+
+    if (val == "standard")
+        c = standard;
+    else if (val == "fcycle")
+        c = fcycle;
+    else if (val == "kcycle")
+        c = kcycle;
+    else if (val == "additive")
+        c = additive;
+    else
+        throw std::invalid_argument("Invalid AMG cycle type. "
+                "Valid choices are: standard, fcycle, kcycle, additive.");
+
+    return in;
+}
+
+} // namespace cycle_type
+
+namespace detail {
+
+/// Krylov-accelerated coarse level correction.
+/**
+ * Makes one or two steps of the flexible conjugate gradient method for the
+ * coarse level system \f$A u = f\f$, preconditioned with the cycle B on the
+ * level [NoVa08]. The second step is skipped when the first one reduces the
+ * residual norm at least four times. The right-hand side f is overwritten
+ * with the residual; v, c, and t are the temporary vectors (t may be used by
+ * B as well).
+ */
+template <class Matrix, class Vector, class InnerProduct, class Precond>
+void kcycle(const Matrix &A, Vector &f, Vector &u,
+        Vector &v, Vector &c, Vector &t,
+        const InnerProduct &inner_product, const Precond &B)
+{
+    typedef typename backend::value_type<Vector>::type value_type;
+    typedef typename math::scalar_of<value_type>::type scalar_type;
+    typedef typename math::inner_product_impl<value_type>::return_type coef_type;
+
+    const scalar_type one  = math::identity<scalar_type>();
+    const scalar_type zero = math::zero<scalar_type>();
+
+    // The first step: u = a1 * B(f).
+    backend::clear(u);
+    B(f, u);
+
+    backend::spmv(one, A, u, zero, v);
+
+    coef_type rho1   = inner_product(u, v);
+    coef_type alpha1 = inner_product(u, f);
+
+    if (math::is_zero(rho1)) return;
+
+    coef_type a1 = alpha1 / rho1;
+
+    scalar_type norm_f = std::sqrt(math::norm(inner_product(f, f)));
+    backend::axpby(-a1, v, one, f);
+    scalar_type norm_r = std::sqrt(math::norm(inner_product(f, f)));
+
+    if (norm_r <= 0.25 * norm_f) {
+        backend::axpby(a1, u, zero, u);
+        return;
+    }
+
+    // The second step, with c = B(r) orthogonalized to u in A-norm.
+    backend::clear(c);
+    B(f, c);
+
+    backend::spmv(one, A, c, zero, t);
+
+    coef_type gamma  = inner_product(c, v);
+    coef_type beta   = inner_product(c, t);
+    coef_type alpha2 = inner_product(c, f);
+    coef_type rho2   = beta - gamma * gamma / rho1;
+
+    if (math::is_zero(rho2)) {
+        backend::axpby(a1, u, zero, u);
+        return;
+    }
+
+    coef_type a2 = alpha2 / rho2;
+    backend::axpby(a2, c, a1 - gamma * a2 / rho1, u);
+}
+
+} // namespace detail
+} // namespace amgcl
+
+#endif
@@ -0,0 +1,126 @@
+#ifndef AMGCL_DETAIL_OBJECT_POOL_HPP
+#define AMGCL_DETAIL_OBJECT_POOL_HPP
+
+/*
+The MIT License
+
+Copyright (c) 2012-2021 Denis Demidov <dennis.demidov@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/**
+ * \file   amgcl/detail/object_pool.hpp
+ * \author Denis Demidov <dennis.demidov@gmail.com>
+ * \brief  Thread-safe pool of reusable objects.
+ */
+
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+#include <amgcl/util.hpp>
+
+namespace amgcl {
+namespace detail {
+
+/// Thread-safe pool of reusable objects.
+/**
+ * The pool is used to keep the temporary data (e.g. work vectors) needed
+ * for the application of a preconditioner or a solver, so that several
+ * threads may use the same instance at once. An object is taken from the
+ * pool for the duration of the call, and is returned back when the handle
+ * goes out of scope. New objects are only created when all of the existing
+ * ones are in use, so that a single-threaded application keeps reusing the
+ * same object.
+ */
+template <class T>
+class object_pool : public non_copyable {
+    public:
+        typedef std::shared_ptr<T> pointer;
+
+        /// Gives access to the object taken from the pool, and returns it
+        /// to the pool on destruction.
+        class handle {
+            public:
+                handle(object_pool &pool, pointer obj)
+                    : pool(&pool), obj(std::move(obj)) {}
+
+                handle(handle &&other)
+                    : pool(other.pool), obj(std::move(other.obj)) {}
+
+                handle(const handle&) = delete;
+                void operator=(const handle&) = delete;
+
+                ~handle() {
+                    if (obj) pool->put(std::move(obj));
+                }
+
+                T& operator*() const {
+                    return *obj;
+                }
+
+                T* operator->() const {
+                    return obj.get();
+                }
+            private:
+                object_pool *pool;
+                pointer obj;
+        };
+
+        object_pool() {}
+
+        /// Takes an object from the pool. When the pool is empty, a new
+        /// object is created with the call to create().
+        template <class Create>
+        handle get(Create &&create) {
+            {
+                std::lock_guard<std::mutex> lock(mx);
+                if (!free.empty()) {
+                    pointer obj = std::move(free.back());
+                    free.pop_back();
+                    return handle(*this, std::move(obj));
+                }
+            }
+
+            return handle(*this, create());
+        }
+
+        /// Adds the object to the pool.
+        void put(pointer obj) {
+            std::lock_guard<std::mutex> lock(mx);
+            free.push_back(std::move(obj));
+        }
+
+        /// Calls f for each of the objects currently stored in the pool.
+        template <class Func>
+        void for_each(Func &&f) const {
+            std::lock_guard<std::mutex> lock(mx);
+            for(const pointer &obj : free) f(*obj);
+        }
+    private:
+        mutable std::mutex mx;
+        std::vector<pointer> free;
+};
+
+} // namespace detail
+} // namespace amgcl
+
+#endif
@@ -30,19 +30,31 @@ THE SOFTWARE.
  * \author Denis Demidov <dennis.demidov@gmail.com>
  * \brief  Sparse matrix-matrix product algorithms.
  *
- * This implements two algorithms.
+ * This implements three algorithms.
  *
  * The first is an OpenMP-enabled modification of classic algorithm from Saad
- * [1]. It is used whenever number of OpenMP cores is 4 or less.
+ * [1]. Each thread uses a dense marker array with the size equal to the
+ * number of columns in the result.
  *
  * The second is Row-merge algorithm from Rupp et al. [2]. The algorithm
  * requires less memory and shows much better scalability than classic one.
- * It is used when number of OpenMP cores is more than 4.
+ * It requires the rows of the second matrix to be sorted.
+ *
+ * The third uses thread-local hash tables sized by the upper bounds of the
+ * row widths as the accumulators [3]. It has the same structure as the
+ * classic algorithm, but the memory required by each thread does not depend
+ * on the number of columns in the result.
+ *
+ * spgemm() selects the algorithm based on the row width statistics of the
+ * matrices and on the number of OpenMP threads.
  *
  * [1] Saad, Yousef. Iterative methods for sparse linear systems. Siam, 2003.
  * [2] Rupp K, Rudolf F, Weinbub J, Morhammer A, Grasser T, Jungel A. Optimized
  *     Sparse Matrix-Matrix Multiplication for Multi-Core CPUs, GPUs, and Xeon
  *     Phi. Submitted
+ * [3] Nagasaka Y, Matsuoka S, Azad A, Buluc A. High-performance sparse
+ *     matrix-matrix products on Intel KNL and multicore architectures.
+ *     ICPP Workshops, 2018.
  */
 #include <vector>
 #include <algorithm>
@@ -125,6 +137,198 @@ void spgemm_saad(const AMatrix &A, const BMatrix &B, CMatrix &C, bool sort = tru
     }
 }
 
+//---------------------------------------------------------------------------
+// Size of the hash table for a row of the product with at most n nonzeros.
+// The table is at most half full.
+inline size_t spgemm_hash_size(ptrdiff_t n) {
+    size_t s = 8;
+    while(s < 2 * static_cast<size_t>(n)) s *= 2;
+    return s;
+}
+
+template <class Col>
+inline size_t spgemm_hash_key(Col c, size_t mask) {
+    return (static_cast<size_t>(c) * 107) & mask;
+}
+
+template <class AMatrix, class BMatrix, class CMatrix>
+void spgemm_hash(const AMatrix &A, const BMatrix &B, CMatrix &C, bool sort = true)
+{
+    typedef typename backend::value_type<CMatrix>::type Val;
+    typedef typename CMatrix::col_type Col;
+    typedef ptrdiff_t Idx;
+
+    const Col empty = static_cast<Col>(-1);
+
+    C.set_size(A.nrows, B.ncols);
+    C.ptr[0] = 0;
+
+    // Upper bounds for the row widths of the product.
+    Idx max_width = 0;
+
+#pragma omp parallel
+    {
+        Idx my_max = 0;
+
+#pragma omp for
+        for(Idx ia = 0; ia < static_cast<Idx>(A.nrows); ++ia) {
+            Idx w = 0;
+            for(Idx ja = A.ptr[ia], ea = A.ptr[ia+1]; ja < ea; ++ja) {
+                Idx ca = A.col[ja];
+                w += B.ptr[ca+1] - B.ptr[ca];
+            }
+            C.ptr[ia+1] = w;
+            my_max = std::max(my_max, w);
+        }
+
+#pragma omp critical
+        max_width = std::max(max_width, my_max);
+    }
+
+    max_width = std::min<Idx>(max_width, B.ncols);
+
+    // Symbolic phase. Only the used slots of the hash table are reset
+    // after each row.
+#pragma omp parallel
+    {
+        std::vector<Col>    hcol(spgemm_hash_size(max_width), empty);
+        std::vector<size_t> used(max_width);
+
+#pragma omp for
+        for(Idx ia = 0; ia < static_cast<Idx>(A.nrows); ++ia) {
+            Idx row_beg = A.ptr[ia];
+            Idx row_end = A.ptr[ia+1];
+
+            // The rows of B do not have duplicates.
+            if (row_end - row_beg <= 1) continue;
+
+            size_t mask = spgemm_hash_size(
+                    std::min<Idx>(C.ptr[ia+1], B.ncols)) - 1;
+
+            Idx C_cols = 0;
+            for(Idx ja = row_beg; ja < row_end; ++ja) {
+                Idx ca = A.col[ja];
+
+                for(Idx jb = B.ptr[ca], eb = B.ptr[ca+1]; jb < eb; ++jb) {
+                    Col cb = B.col[jb];
+
+                    for(size_t h = spgemm_hash_key(cb, mask); ; h = (h + 1) & mask) {
+                        if (hcol[h] == cb) break;
+                        if (hcol[h] == empty) {
+                            hcol[h] = cb;
+                            used[C_cols++] = h;
+                            break;
+                        }
+                    }
+                }
+            }
+
+            for(Idx j = 0; j < C_cols; ++j) hcol[used[j]] = empty;
+            C.ptr[ia+1] = C_cols;
+        }
+    }
+
+    C.set_nonzeros(C.scan_row_sizes());
+
+    // Numeric phase. The hash table maps the column numbers to the positions
+    // in the row of C, so the columns are stored in the order of appearance.
+#pragma omp parallel
+    {
+        std::vector<Col> hcol(spgemm_hash_size(max_width), empty);
+        std::vector<Idx> hpos(hcol.size());
+
+#pragma omp for
+        for(Idx ia = 0; ia < static_cast<Idx>(A.nrows); ++ia) {
+            Idx row_beg = A.ptr[ia];
+            Idx row_end = A.ptr[ia+1];
+            Idx c_beg   = C.ptr[ia];
+            Idx c_end   = c_beg;
+
+            if (row_end - row_beg == 1) {
+                Idx ca = A.col[row_beg];
+                Val va = A.val[row_beg];
+
+                for(Idx jb = B.ptr[ca], eb = B.ptr[ca+1]; jb < eb; ++jb, ++c_end) {
+                    C.col[c_end] = B.col[jb];
+                    C.val[c_end] = va * B.val[jb];
+                }
+            } else if (row_end - row_beg > 1) {
+                size_t mask = spgemm_hash_size(C.ptr[ia+1] - c_beg) - 1;
+
+                for(Idx ja = row_beg; ja < row_end; ++ja) {
+                    Idx ca = A.col[ja];
+                    Val va = A.val[ja];
+
+                    for(Idx jb = B.ptr[ca], eb = B.ptr[ca+1]; jb < eb; ++jb) {
+                        Col cb = B.col[jb];
+                        Val vb = B.val[jb];
+
+                        for(size_t h = spgemm_hash_key(cb, mask); ; h = (h + 1) & mask) {
+                            if (hcol[h] == cb) {
+                                C.val[hpos[h]] += va * vb;
+                                break;
+                            }
+                            if (hcol[h] == empty) {
+                                hcol[h] = cb;
+                                hpos[h] = c_end;
+                                C.col[c_end] = cb;
+                                C.val[c_end] = va * vb;
+                                ++c_end;
+                                break;
+                            }
+                        }
+                    }
+                }
+
+                for(Idx j = c_beg; j < c_end; ++j) {
+                    Col c = C.col[j];
+                    for(size_t h = spgemm_hash_key(c, mask); ; h = (h + 1) & mask) {
+                        if (hcol[h] == c) {
+                            hcol[h] = empty;
+                            break;
+                        }
+                    }
+                }
+            }
+
+            if (sort) amgcl::detail::sort_row(
+                    C.col + c_beg, C.val + c_beg, c_end - c_beg);
+        }
+    }
+}
+
+//---------------------------------------------------------------------------
+// Numeric phase of the product: only the values of C are recomputed. The
+// pattern of C should contain the pattern of A * B (e.g. C was computed with
+// one of the algorithms above for matrices with the same patterns).
+template <class AMatrix, class BMatrix, class CMatrix>
+void spgemm_numeric(const AMatrix &A, const BMatrix &B, CMatrix &C)
+{
+    typedef typename backend::value_type<CMatrix>::type Val;
+    typedef ptrdiff_t Idx;
+
+#pragma omp parallel
+    {
+        std::vector<ptrdiff_t> marker(C.ncols, -1);
+
+#pragma omp for
+        for(Idx ia = 0; ia < static_cast<Idx>(A.nrows); ++ia) {
+            for(Idx j = C.ptr[ia], e = C.ptr[ia+1]; j < e; ++j) {
+                marker[C.col[j]] = j;
+                C.val[j] = math::zero<Val>();
+            }
+
+            for(Idx ja = A.ptr[ia], ea = A.ptr[ia+1]; ja < ea; ++ja) {
+                Idx ca = A.col[ja];
+                Val va = A.val[ja];
+
+                for(Idx jb = B.ptr[ca], eb = B.ptr[ca+1]; jb < eb; ++jb)
+                    C.val[marker[B.col[jb]]] += va * B.val[jb];
+            }
+        }
+    }
+}
+
 //---------------------------------------------------------------------------
 template <bool need_out, class Idx>
 Idx* merge_rows(
@@ -210,13 +414,15 @@ Idx* merge_rows(
     return col3;
 }
 
-template <class Idx>
-Idx prod_row_width(
-        const Idx *acol, const Idx *acol_end,
-        const Idx *bptr, const Idx *bcol,
-        Idx *tmp_col1, Idx *tmp_col2, Idx *tmp_col3
+template <class Col, class Ptr>
+ptrdiff_t prod_row_width(
+        const Col *acol, const Col *acol_end,
+        const Ptr *bptr, const Col *bcol,
+        Col *tmp_col1, Col *tmp_col2, Col *tmp_col3
         )
 {
+    typedef ptrdiff_t Idx;
+
     const Idx nrows = acol_end - acol;
 
     /* No rows to merge, nothing to do */
@@ -227,8 +433,8 @@ Idx prod_row_width(
 
     /* Two rows, merge them */
     if (nrows == 2) {
-        int a1 = acol[0];
-        int a2 = acol[1];
+        Col a1 = acol[0];
+        Col a2 = acol[1];
 
         return merge_rows<false>(
                 bcol + bptr[a1], bcol + bptr[a1+1],
@@ -244,8 +450,8 @@ Idx prod_row_width(
      * Merging by pairs allows to work with short rows as often as possible.
      */
     // Merge first two.
-    Idx a1 = *acol++;
-    Idx a2 = *acol++;
+    Col a1 = *acol++;
+    Col a2 = *acol++;
     Idx c_col1 = merge_rows<true>(
             bcol + bptr[a1], bcol + bptr[a1+1],
             bcol + bptr[a2], bcol + bptr[a2+1],
@@ -289,15 +495,17 @@ Idx prod_row_width(
             ) - tmp_col2;
 }
 
-template <class Idx, class Val>
+template <class Col, class Ptr, class Val>
 void prod_row(
-        const Idx *acol, const Idx *acol_end, const Val *aval,
-        const Idx *bptr, const Idx *bcol, const Val *bval,
-        Idx *out_col, Val *out_val,
-        Idx *tm2_col, Val *tm2_val,
-        Idx *tm3_col, Val *tm3_val
+        const Col *acol, const Col *acol_end, const Val *aval,
+        const Ptr *bptr, const Col *bcol, const Val *bval,
+        Col *out_col, Val *out_val,
+        Col *tm2_col, Val *tm2_val,
+        Col *tm3_col, Val *tm3_val
         )
 {
+    typedef ptrdiff_t Idx;
+
     const Idx nrows = acol_end - acol;
 
     /* No rows to merge, nothing to do */
@@ -305,12 +513,12 @@ void prod_row(
 
     /* Single row, just copy it to output */
     if (nrows == 1) {
-        Idx ac = *acol;
+        Col ac = *acol;
         Val av = *aval;
 
         const Val *bv = bval + bptr[ac];
-        const Idx *bc = bcol + bptr[ac];
-        const Idx *be = bcol + bptr[ac+1];
+        const Col *bc = bcol + bptr[ac];
+        const Col *be = bcol + bptr[ac+1];
 
         while(bc != be) {
             *out_col++ = *bc++;
@@ -322,8 +530,8 @@ void prod_row(
 
     /* Two rows, merge them */
     if (nrows == 2) {
-        Idx ac1 = acol[0];
-        Idx ac2 = acol[1];
+        Col ac1 = acol[0];
+        Col ac2 = acol[1];
 
         Val av1 = aval[0];
         Val av2 = aval[1];
@@ -344,13 +552,13 @@ void prod_row(
      * Merging by pairs allows to work with short rows as often as possible.
      */
     // Merge first two.
-    Idx ac1 = *acol++;
-    Idx ac2 = *acol++;
+    Col ac1 = *acol++;
+    Col ac2 = *acol++;
 
     Val av1 = *aval++;
     Val av2 = *aval++;
 
-    Idx *tm1_col = out_col;
+    Col *tm1_col = out_col;
     Val *tm1_val = out_val;
 
     Idx c_col1 = merge_rows(
@@ -409,6 +617,7 @@ void prod_row(
 template <class AMatrix, class BMatrix, class CMatrix>
 void spgemm_rmerge(const AMatrix &A, const BMatrix &B, CMatrix &C) {
     typedef typename backend::value_type<CMatrix>::type Val;
+    typedef typename CMatrix::col_type Col;
     typedef ptrdiff_t Idx;
 
     Idx max_row_width = 0;
@@ -418,7 +627,7 @@ void spgemm_rmerge(const AMatrix &A, const BMatrix &B, CMatrix &C) {
         Idx my_max = 0;
 
 #pragma omp for
-        for(int i = 0; i < static_cast<Idx>(A.nrows); ++i) {
+        for(Idx i = 0; i < static_cast<Idx>(A.nrows); ++i) {
             Idx row_beg = A.ptr[i];
             Idx row_end = A.ptr[i+1];
             Idx row_width = 0;
@@ -439,7 +648,7 @@ void spgemm_rmerge(const AMatrix &A, const BMatrix &B, CMatrix &C) {
     const int nthreads = 1;
 #endif
 
-    std::vector< std::vector<Idx> > tmp_col(nthreads);
+    std::vector< std::vector<Col> > tmp_col(nthreads);
     std::vector< std::vector<Val> > tmp_val(nthreads);
 
     for(int i = 0; i < nthreads; ++i) {
@@ -459,7 +668,7 @@ void spgemm_rmerge(const AMatrix &A, const BMatrix &B, CMatrix &C) {
         const int tid = 0;
 #endif
 
-        Idx *t_col = &tmp_col[tid][0];
+        Col *t_col = &tmp_col[tid][0];
 
 #pragma omp for
         for(Idx i = 0; i < static_cast<Idx>(A.nrows); ++i) {
@@ -483,7 +692,7 @@ void spgemm_rmerge(const AMatrix &A, const BMatrix &B, CMatrix &C) {
         const int tid = 0;
 #endif
 
-        Idx *t_col = tmp_col[tid].data();
+        Col *t_col = tmp_col[tid].data();
         Val *t_val = tmp_val[tid].data();
 
 #pragma omp for
@@ -501,6 +710,310 @@ void spgemm_rmerge(const AMatrix &A, const BMatrix &B, CMatrix &C) {
     }
 }
 
+//---------------------------------------------------------------------------
+// Triple product C = R * A * P computed row by row. The rows of the A * P
+// product are recomputed for each of the rows of R they contribute to, so
+// that the A * P matrix is never stored. When each row of P has a single
+// nonzero (as with the unsmoothed aggregation), the contributions of each
+// fine variable are accumulated directly into the row of its aggregate, and
+// the number of operations is the same as for the A * P product alone.
+template <class RMatrix, class AMatrix, class PMatrix, class CMatrix>
+void spgemm_rap(const RMatrix &R, const AMatrix &A, const PMatrix &P, CMatrix &C, bool sort = false)
+{
+    typedef typename backend::value_type<CMatrix>::type Val;
+    typedef ptrdiff_t Idx;
+
+    C.set_size(R.nrows, P.ncols);
+    C.ptr[0] = 0;
+
+#pragma omp parallel
+    {
+        std::vector<ptrdiff_t> marker(P.ncols, -1);
+
+#pragma omp for
+        for(Idx ir = 0; ir < static_cast<Idx>(R.nrows); ++ir) {
+            Idx C_cols = 0;
+            for(Idx jr = R.ptr[ir], er = R.ptr[ir+1]; jr < er; ++jr) {
+                Idx cr = R.col[jr];
+
+                for(Idx ja = A.ptr[cr], ea = A.ptr[cr+1]; ja < ea; ++ja) {
+                    Idx ca = A.col[ja];
+
+                    for(Idx jp = P.ptr[ca], ep = P.ptr[ca+1]; jp < ep; ++jp) {
+                        Idx cp = P.col[jp];
+                        if (marker[cp] != ir) {
+                            marker[cp] = ir;
+                            ++C_cols;
+                        }
+                    }
+                }
+            }
+            C.ptr[ir + 1] = C_cols;
+        }
+    }
+
+    C.set_nonzeros(C.scan_row_sizes());
+
+#pragma omp parallel
+    {
+        std::vector<ptrdiff_t> marker(P.ncols, -1);
+
+#pragma omp for
+        for(Idx ir = 0; ir < static_cast<Idx>(R.nrows); ++ir) {
+            Idx row_beg = C.ptr[ir];
+            Idx row_end = row_beg;
+
+            for(Idx jr = R.ptr[ir], er = R.ptr[ir+1]; jr < er; ++jr) {
+                Idx cr = R.col[jr];
+                Val vr = R.val[jr];
+
+                for(Idx ja = A.ptr[cr], ea = A.ptr[cr+1]; ja < ea; ++ja) {
+                    Idx ca = A.col[ja];
+                    Val va = vr * A.val[ja];
+
+                    for(Idx jp = P.ptr[ca], ep = P.ptr[ca+1]; jp < ep; ++jp) {
+                        Idx cp = P.col[jp];
+                        Val vp = P.val[jp];
+
+                        if (marker[cp] < row_beg) {
+                            marker[cp] = row_end;
+                            C.col[row_end] = cp;
+                            C.val[row_end] = va * vp;
+                            ++row_end;
+                        } else {
+                            C.val[marker[cp]] += va * vp;
+                        }
+                    }
+                }
+            }
+
+            if (sort) amgcl::detail::sort_row(
+                    C.col + row_beg, C.val + row_beg, row_end - row_beg);
+        }
+    }
+}
+
+// Numeric phase of the triple product: only the values of C are recomputed.
+template <class RMatrix, class AMatrix, class PMatrix, class CMatrix>
+void spgemm_rap_numeric(const RMatrix &R, const AMatrix &A, const PMatrix &P, CMatrix &C)
+{
+    typedef typename backend::value_type<CMatrix>::type Val;
+    typedef ptrdiff_t Idx;
+
+#pragma omp parallel
+    {
+        std::vector<ptrdiff_t> marker(C.ncols, -1);
+
+#pragma omp for
+        for(Idx ir = 0; ir < static_cast<Idx>(R.nrows); ++ir) {
+            for(Idx j = C.ptr[ir], e = C.ptr[ir+1]; j < e; ++j) {
+                marker[C.col[j]] = j;
+                C.val[j] = math::zero<Val>();
+            }
+
+            for(Idx jr = R.ptr[ir], er = R.ptr[ir+1]; jr < er; ++jr) {
+                Idx cr = R.col[jr];
+                Val vr = R.val[jr];
+
+                for(Idx ja = A.ptr[cr], ea = A.ptr[cr+1]; ja < ea; ++ja) {
+                    Idx ca = A.col[ja];
+                    Val va = vr * A.val[ja];
+
+                    for(Idx jp = P.ptr[ca], ep = P.ptr[ca+1]; jp < ep; ++jp)
+                        C.val[marker[P.col[jp]]] += va * P.val[jp];
+                }
+            }
+        }
+    }
+}
+
+//---------------------------------------------------------------------------
+// Triple product C = R * A * P with the bounded memory footprint. The rows
+// of R are processed in chunks. For each chunk, the rows of A * P required
+// by the chunk are computed once and kept until the chunk is done, so only
+// the rows of A * P shared between the chunks are recomputed, and the
+// complete A * P matrix is never stored. The rows of C are collected in
+// per-chunk buffers and are copied into C at the end.
+template <class RMatrix, class AMatrix, class PMatrix, class CMatrix>
+void spgemm_rap_chunked(const RMatrix &R, const AMatrix &A, const PMatrix &P,
+        CMatrix &C, bool sort = false, ptrdiff_t chunk = 256)
+{
+    typedef typename backend::value_type<CMatrix>::type Val;
+    typedef typename CMatrix::col_type Col;
+    typedef ptrdiff_t Idx;
+
+    const Idx nc = R.nrows;
+    const Idx nchunks = (nc + chunk - 1) / chunk;
+
+    C.set_size(R.nrows, P.ncols);
+    C.ptr[0] = 0;
+
+    std::vector< std::vector<Col> > chunk_col(nchunks);
+    std::vector< std::vector<Val> > chunk_val(nchunks);
+
+#pragma omp parallel
+    {
+        std::vector<ptrdiff_t> marker(P.ncols, -1);
+
+        std::vector<Idx> rows;
+        std::vector<Idx> ap_ptr;
+        std::vector<Col> ap_col;
+        std::vector<Val> ap_val;
+
+#pragma omp for schedule(dynamic)
+        for(Idx ic = 0; ic < nchunks; ++ic) {
+            Idx beg = ic * chunk;
+            Idx end = std::min(nc, beg + chunk);
+
+            // The fine rows required by the chunk.
+            rows.clear();
+            for(Idx j = R.ptr[beg]; j < R.ptr[end]; ++j)
+                rows.push_back(R.col[j]);
+            std::sort(rows.begin(), rows.end());
+            rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+
+            // The rows of A * P for the chunk.
+            ap_ptr.clear();
+            ap_col.clear();
+            ap_val.clear();
+            ap_ptr.push_back(0);
+
+            for(Idx k : rows) {
+                Idx row_beg = ap_col.size();
+                for(Idx ja = A.ptr[k], ea = A.ptr[k+1]; ja < ea; ++ja) {
+                    Idx ca = A.col[ja];
+                    Val va = A.val[ja];
+
+                    for(Idx jp = P.ptr[ca], ep = P.ptr[ca+1]; jp < ep; ++jp) {
+                        Idx cp = P.col[jp];
+                        if (marker[cp] < row_beg) {
+                            marker[cp] = ap_col.size();
+                            ap_col.push_back(cp);
+                            ap_val.push_back(va * P.val[jp]);
+                        } else {
+                            ap_val[marker[cp]] += va * P.val[jp];
+                        }
+                    }
+                }
+                ap_ptr.push_back(ap_col.size());
+            }
+
+            for(size_t j = 0; j < ap_col.size(); ++j) marker[ap_col[j]] = -1;
+
+            // The rows of R * (A * P).
+            std::vector<Col> &ccol = chunk_col[ic];
+            std::vector<Val> &cval = chunk_val[ic];
+
+            for(Idx ir = beg; ir < end; ++ir) {
+                Idx row_beg = ccol.size();
+                for(Idx jr = R.ptr[ir], er = R.ptr[ir+1]; jr < er; ++jr) {
+                    Idx k = std::lower_bound(rows.begin(), rows.end(),
+                            static_cast<Idx>(R.col[jr])) - rows.begin();
+                    Val vr = R.val[jr];
+
+                    for(Idx j = ap_ptr[k], e = ap_ptr[k+1]; j < e; ++j) {
+                        Idx c = ap_col[j];
+                        if (marker[c] < row_beg) {
+                            marker[c] = ccol.size();
+                            ccol.push_back(c);
+                            cval.push_back(vr * ap_val[j]);
+                        } else {
+                            cval[marker[c]] += vr * ap_val[j];
+                        }
+                    }
+                }
+                C.ptr[ir+1] = ccol.size() - row_beg;
+
+                if (sort) amgcl::detail::sort_row(
+                        ccol.data() + row_beg, cval.data() + row_beg, ccol.size() - row_beg);
+            }
+
+            for(size_t j = 0; j < ccol.size(); ++j) marker[ccol[j]] = -1;
+        }
+    }
+
+    C.set_nonzeros(C.scan_row_sizes());
+
+#pragma omp parallel for schedule(dynamic)
+    for(Idx ic = 0; ic < nchunks; ++ic) {
+        Idx head = C.ptr[ic * chunk];
+        std::copy(chunk_col[ic].begin(), chunk_col[ic].end(), C.col + head);
+        std::copy(chunk_val[ic].begin(), chunk_val[ic].end(), C.val + head);
+        std::vector<Col>().swap(chunk_col[ic]);
+        std::vector<Val>().swap(chunk_val[ic]);
+    }
+}
+
+//---------------------------------------------------------------------------
+namespace spgemm_algorithm {
+
+enum type {
+    saad,   // Classic algorithm with dense marker arrays.
+    rmerge, // Row-merge algorithm.
+    hash    // Hash table accumulators.
+};
+
+} // namespace spgemm_algorithm
+
+// Selects the algorithm for the product A * B.
+//
+// The classic algorithm is the fastest one as long as the marker arrays of
+// all threads fit into the cache. Otherwise, the hash-based algorithm is
+// used, unless the rows of A are short enough and the rows of B are sorted,
+// in which case the row-merge algorithm needs the least memory.
+template <class AMatrix, class BMatrix>
+spgemm_algorithm::type spgemm_select(const AMatrix &A, const BMatrix &B)
+{
+    typedef ptrdiff_t Idx;
+
+    // Memory available for the marker arrays of the classic algorithm.
+    const size_t marker_limit = 1 << 26;
+
+    // Maximum average row width of A for the row-merge algorithm.
+    const double rmerge_width = 4;
+
+#ifdef _OPENMP
+    const int nthreads = omp_get_max_threads();
+#else
+    const int nthreads = 1;
+#endif
+
+    if (nthreads * B.ncols * sizeof(Idx) <= marker_limit)
+        return spgemm_algorithm::saad;
+
+    const Idx n = A.nrows;
+
+    if (n == 0 || A.ptr[n] > rmerge_width * n)
+        return spgemm_algorithm::hash;
+
+    bool sorted = true;
+
+#pragma omp parallel for reduction(&&:sorted)
+    for(Idx i = 0; i < static_cast<Idx>(B.nrows); ++i) {
+        for(Idx j = B.ptr[i] + 1, e = B.ptr[i+1]; j < e; ++j)
+            if (!(B.col[j-1] < B.col[j])) sorted = false;
+    }
+
+    return sorted ? spgemm_algorithm::rmerge : spgemm_algorithm::hash;
+}
+
+// Matrix-matrix product with the automatic selection of the algorithm.
+template <class AMatrix, class BMatrix, class CMatrix>
+void spgemm(const AMatrix &A, const BMatrix &B, CMatrix &C, bool sort = false)
+{
+    switch(spgemm_select(A, B)) {
+        case spgemm_algorithm::saad:
+            spgemm_saad(A, B, C, sort);
+            break;
+        case spgemm_algorithm::rmerge:
+            spgemm_rmerge(A, B, C);
+            break;
+        case spgemm_algorithm::hash:
+            spgemm_hash(A, B, C, sort);
+            break;
+    }
+}
+
 } // namespace backend
 } // namespace amgcl
 
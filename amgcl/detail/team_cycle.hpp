@@ -0,0 +1,254 @@
+#ifndef AMGCL_DETAIL_TEAM_CYCLE_HPP
+#define AMGCL_DETAIL_TEAM_CYCLE_HPP
+
+/*
+The MIT License
+
+Copyright (c) 2012-2021 Denis Demidov <dennis.demidov@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/**
+ * \file   amgcl/detail/team_cycle.hpp
+ * \author Denis Demidov <dennis.demidov@gmail.com>
+ * \brief  Building blocks of the AMG cycle executed by a single team of threads.
+ */
+
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <algorithm>
+
+#ifdef _OPENMP
+#  include <omp.h>
+#endif
+
+#include <amgcl/backend/interface.hpp>
+#include <amgcl/value_type/interface.hpp>
+
+namespace amgcl {
+namespace detail {
+
+/// Partition of the level rows into blocks for the team cycle.
+/**
+ * The rows of the matrix are split into contiguous blocks with equal shares
+ * of rows and nonzeros (counted together, as in the merge-path partition).
+ * Two blocks are neighbours when the matrix couples their rows in either
+ * direction, so that a block may only be updated after its neighbours are
+ * done reading it, and may only be read after its neighbours are done
+ * updating their own rows.
+ */
+struct row_blocks {
+    int nblocks;
+    std::vector<ptrdiff_t> row; // First row of each block.
+    std::vector<int> nbr_ptr;   // Neighbours of each block (in CRS format).
+    std::vector<int> nbr;
+
+    template <class Matrix>
+    row_blocks(const Matrix &A, int nblocks)
+        : nblocks(nblocks), row(nblocks + 1), nbr_ptr(nblocks + 1, 0)
+    {
+        const ptrdiff_t n     = backend::rows(A);
+        const ptrdiff_t nz    = A.ptr[n] - A.ptr[0];
+        const ptrdiff_t total = n + nz;
+
+        for(int b = 0; b <= nblocks; ++b) {
+            ptrdiff_t w = std::min(total, b * ((total + nblocks - 1) / nblocks));
+
+            ptrdiff_t lo = 0, hi = n;
+            while(lo < hi) {
+                ptrdiff_t mid = (lo + hi) / 2;
+                if (mid + A.ptr[mid] - A.ptr[0] < w)
+                    lo = mid + 1;
+                else
+                    hi = mid;
+            }
+
+            row[b] = lo;
+        }
+        row[nblocks] = n;
+
+        // The couplings between the blocks. Each block fills its own row of
+        // the adjacency matrix, which is then symmetrized.
+        std::vector<char> adj(nblocks * nblocks, 0);
+
+#pragma omp parallel for
+        for(int b = 0; b < nblocks; ++b) {
+            char *a = &adj[b * nblocks];
+            for(ptrdiff_t i = row[b], e = row[b+1]; i < e; ++i) {
+                for(ptrdiff_t j = A.ptr[i], je = A.ptr[i+1]; j < je; ++j) {
+                    ptrdiff_t c = A.col[j];
+                    if (c >= row[b] && c < e) continue;
+                    a[owner(c)] = 1;
+                }
+            }
+        }
+
+        for(int b = 0; b < nblocks; ++b)
+            for(int c = 0; c < b; ++c)
+                if (adj[b * nblocks + c] || adj[c * nblocks + b])
+                    adj[b * nblocks + c] = adj[c * nblocks + b] = 1;
+
+        for(int b = 0; b < nblocks; ++b) {
+            for(int c = 0; c < nblocks; ++c)
+                if (c != b && adj[b * nblocks + c]) nbr.push_back(c);
+            nbr_ptr[b + 1] = nbr.size();
+        }
+    }
+
+    /// Block that owns the given row.
+    int owner(ptrdiff_t i) const {
+        return static_cast<int>(std::upper_bound(row.begin(), row.end(), i) - row.begin()) - 1;
+    }
+
+    /// Returns partition of the matrix for the given number of blocks.
+    /**
+     * The partition is cached in the given pointer. The function is safe to
+     * call concurrently from several threads.
+     */
+    template <class Matrix>
+    static std::shared_ptr<const row_blocks>
+    get(std::shared_ptr<const row_blocks> &cache, const Matrix &A, int nblocks)
+    {
+        std::shared_ptr<const row_blocks> p;
+
+#pragma omp critical(amgcl_row_blocks)
+        {
+            p = cache;
+        }
+
+        if (p && p->nblocks == nblocks) return p;
+
+        p = std::make_shared<row_blocks>(A, nblocks);
+
+#pragma omp critical(amgcl_row_blocks)
+        {
+            cache = p;
+        }
+
+        return p;
+    }
+};
+
+/// Progress counters of the row blocks.
+/**
+ * Each counter holds the number of the cycle phases completed by a block.
+ * The counters are padded to separate cache lines.
+ */
+class block_progress {
+    public:
+        block_progress() : n(0) {}
+
+        /// Makes sure there are at least the given number of counters.
+        void resize(size_t size) {
+            if (size > n) {
+                c.reset(new counter[size]);
+                n = size;
+            }
+        }
+
+        /// Resets the counter of the block.
+        void reset(size_t b) {
+            c[b].phase.store(0, std::memory_order_relaxed);
+        }
+
+        /// Marks the given phase of the block as completed.
+        void done(size_t b, unsigned phase) {
+            c[b].phase.store(phase, std::memory_order_release);
+        }
+
+        /// Waits for the block to complete the given phase.
+        void wait(size_t b, unsigned phase) const {
+            for(int i = 0; c[b].phase.load(std::memory_order_acquire) < phase; ++i)
+                if (i > 64) std::this_thread::yield();
+        }
+
+        size_t bytes() const {
+            return n * sizeof(counter);
+        }
+    private:
+        struct counter {
+            std::atomic<unsigned> phase;
+            char pad[64 - sizeof(std::atomic<unsigned>)];
+        };
+
+        size_t n;
+        std::unique_ptr<counter[]> c;
+};
+
+/// Runs a phase of the team cycle on a level.
+/**
+ * The blocks tid, tid + nt, ... of the level are processed by the current
+ * thread, so that a team smaller than the number of blocks still covers all
+ * of them. Before a block is processed, its neighbours have to complete the
+ * previous phase. The counters of the level blocks start at the given offset.
+ */
+template <class Op>
+void team_phase(const row_blocks &B, block_progress &P, size_t offset,
+        unsigned phase, int tid, int nt, Op &&op)
+{
+    for(int b = tid; b < B.nblocks; b += nt) {
+        for(int j = B.nbr_ptr[b], e = B.nbr_ptr[b+1]; j < e; ++j)
+            P.wait(offset + B.nbr[j], phase - 1);
+
+        op(B.row[b], B.row[b+1]);
+
+        P.done(offset + b, phase);
+    }
+}
+
+/// Computes r = f - A x for the given rows.
+template <class Vector1, class Matrix, class Vector2, class Vector3>
+void residual_rows(const Vector1 &f, const Matrix &A, const Vector2 &x, Vector3 &r,
+        ptrdiff_t beg, ptrdiff_t end)
+{
+    typedef typename backend::value_type<Vector3>::type V;
+
+    for(ptrdiff_t i = beg; i < end; ++i) {
+        V sum = math::zero<V>();
+        for(ptrdiff_t j = A.ptr[i], e = A.ptr[i+1]; j < e; ++j)
+            sum += A.val[j] * x[A.col[j]];
+        r[i] = f[i] - sum;
+    }
+}
+
+/// Computes y = A x (or y += A x when add is set) for the given rows.
+template <class Matrix, class Vector1, class Vector2>
+void spmv_rows(const Matrix &A, const Vector1 &x, Vector2 &y, bool add,
+        ptrdiff_t beg, ptrdiff_t end)
+{
+    typedef typename backend::value_type<Vector2>::type V;
+
+    for(ptrdiff_t i = beg; i < end; ++i) {
+        V sum = math::zero<V>();
+        for(ptrdiff_t j = A.ptr[i], e = A.ptr[i+1]; j < e; ++j)
+            sum += A.val[j] * x[A.col[j]];
+        if (add)
+            y[i] += sum;
+        else
+            y[i] = sum;
+    }
+}
+
+} // namespace detail
+} // namespace amgcl
+
+#endif
@@ -34,6 +34,8 @@ THE SOFTWARE.
 #include <vector>
 #include <string>
 #include <fstream>
+#include <algorithm>
+#include <cstdint>
 
 #include <amgcl/util.hpp>
 #include <amgcl/detail/sort_row.hpp>
@@ -43,13 +45,13 @@ namespace io {
 
 /// Read single value from a binary file.
 template <class T>
-bool read(std::ifstream &f, T &val) {
+bool read(std::istream &f, T &val) {
     return static_cast<bool>(f.read((char*)&val, sizeof(T)));
 }
 
 /// Read vector from a binary file.
 template <class T>
-bool read(std::ifstream &f, std::vector<T> &vec) {
+bool read(std::istream &f, std::vector<T> &vec) {
     return static_cast<bool>(f.read((char*)&vec[0], sizeof(T) * vec.size()));
 }
 
@@ -157,16 +159,136 @@ void read_dense(const std::string &fname,
 
 /// Write single value to a binary file.
 template <class T>
-bool write(std::ofstream &f, const T &val) {
+bool write(std::ostream &f, const T &val) {
     return static_cast<bool>(f.write((char*)&val, sizeof(T)));
 }
 
 /// Write vector to a binary file.
 template <class T>
-bool write(std::ofstream &f, const std::vector<T> &vec) {
+bool write(std::ostream &f, const std::vector<T> &vec) {
     return static_cast<bool>(f.write((char*)&vec[0], sizeof(T) * vec.size()));
 }
 
+namespace detail {
+
+// The arrays are padded to the multiple of 8 bytes, so that each array in a
+// file starts at an aligned offset, and the file may be memory-mapped.
+template <class T>
+bool write_array(std::ostream &f, const T *a, size_t n) {
+    static const char pad[8] = {0};
+    size_t bytes = sizeof(T) * n;
+    return f.write((const char*)a, bytes) && f.write(pad, (8 - bytes % 8) % 8);
+}
+
+template <class T>
+bool read_array(std::istream &f, T *a, size_t n) {
+    size_t bytes = sizeof(T) * n;
+    return f.read((char*)a, bytes) && f.ignore((8 - bytes % 8) % 8);
+}
+
+} // namespace detail
+
+/// Write CRS matrix in the internal format to a binary stream.
+/**
+ * The matrix is stored as its sizes (three 64-bit integers), followed by
+ * the raw ptr, col, and val arrays. Each array is padded to the multiple of
+ * 8 bytes.
+ */
+template <class Matrix>
+void write_crs(std::ostream &f, const Matrix &A) {
+    const std::uint64_t size[3] = {A.nrows, A.ncols, A.nnz};
+
+    precondition(
+            detail::write_array(f, size, 3) &&
+            detail::write_array(f, A.ptr, A.nrows + 1) &&
+            detail::write_array(f, A.col, A.nnz) &&
+            detail::write_array(f, A.val, A.nnz),
+            "File I/O error");
+}
+
+/// Read CRS matrix in the internal format from a binary stream.
+/**
+ * The matrix should be empty, and should have the same value and index
+ * types as the one used with write_crs().
+ */
+template <class Matrix>
+void read_crs(std::istream &f, Matrix &A) {
+    std::uint64_t size[3];
+    precondition(detail::read_array(f, size, 3), "File I/O error");
+
+    A.set_size(size[0], size[1]);
+    precondition(detail::read_array(f, A.ptr, A.nrows + 1), "File I/O error");
+    precondition(static_cast<std::uint64_t>(A.ptr[A.nrows]) == size[2],
+            "Inconsistent matrix in a binary file");
+
+    A.set_nonzeros(size[2]);
+    precondition(
+            detail::read_array(f, A.col, A.nnz) &&
+            detail::read_array(f, A.val, A.nnz),
+            "File I/O error");
+}
+
+/// Header of a binary file with a serialized AMG hierarchy.
+/**
+ * The header is followed by the levels of the hierarchy, see amgcl::amg::save().
+ */
+struct hierarchy_header {
+    static const std::uint32_t current_version = 1;
+
+    char          magic[8];
+    std::uint32_t version;
+    std::uint32_t value_size; ///< sizeof(value_type) of the hierarchy.
+    std::uint32_t col_size;   ///< sizeof(col_type) of the hierarchy.
+    std::uint32_t ptr_size;   ///< sizeof(ptr_type) of the hierarchy.
+    std::uint64_t levels;     ///< Number of levels in the hierarchy.
+    std::uint64_t rows;       ///< Number of rows in the finest level matrix.
+
+    hierarchy_header()
+        : version(current_version), value_size(0), col_size(0), ptr_size(0),
+          levels(0), rows(0)
+    {
+        std::copy(signature(), signature() + 8, magic);
+    }
+
+    static const char* signature() {
+        return "AMGCLHRC";
+    }
+};
+
+/// Binary stream with a serialized AMG hierarchy.
+/**
+ * Is passed to the constructors of amgcl::amg or amgcl::make_solver
+ * instead of the system matrix in order to load the hierarchy saved with
+ * amgcl::amg::save() instead of building it. The header of the hierarchy is
+ * read and checked on construction.
+ */
+class saved_hierarchy {
+    public:
+        explicit saved_hierarchy(std::istream &f) : f(f) {
+            precondition(read(f, hdr), "File I/O error");
+            precondition(std::equal(hdr.magic, hdr.magic + 8, hierarchy_header::signature()),
+                    "Not an AMG hierarchy file");
+            precondition(hdr.version == hierarchy_header::current_version,
+                    "Unsupported version of AMG hierarchy file");
+        }
+
+        /// Number of rows in the finest level matrix.
+        size_t rows() const {
+            return hdr.rows;
+        }
+
+        const hierarchy_header& header() const {
+            return hdr;
+        }
+
+        std::istream& stream() const {
+            return f;
+        }
+    private:
+        std::istream &f;
+        hierarchy_header hdr;
+};
+
 } // namespace io
 } // namespace amgcl
 
@@ -45,9 +45,11 @@ struct ios_saver {
         : s(s), f(s.flags()), p(s.precision())
     {}
 
+    // The stream is only touched when it was actually modified, so that
+    // concurrent solvers sharing std::cout do not race here.
     ~ios_saver() {
-        s.flags(f);
-        s.precision(p);
+        if (s.flags() != f) s.flags(f);
+        if (s.precision() != p) s.precision(p);
     }
 };
 
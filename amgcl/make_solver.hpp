@@ -32,12 +32,21 @@ THE SOFTWARE.
  */
 
 #include <type_traits>
+#include <memory>
 #include <amgcl/backend/builtin.hpp>
+#include <amgcl/detail/object_pool.hpp>
+#include <amgcl/io/binary.hpp>
 #include <amgcl/util.hpp>
 
 namespace amgcl {
 
 /// Convenience class that bundles together a preconditioner and an iterative solver.
+/**
+ * The iterative solvers keep their temporary vectors as members, so each
+ * concurrent call to operator() gets its own solver instance from an internal
+ * pool. This allows to use the same make_solver instance (and the same
+ * preconditioner) from several threads at once.
+ */
 template <
     class Precond,
     class IterativeSolver
@@ -56,7 +65,9 @@ class make_solver : public amgcl::detail::non_copyable {
 
         typedef typename backend_type::value_type value_type;
         typedef typename backend_type::params backend_params;
-        typedef typename backend::builtin<value_type>::matrix build_matrix;
+        typedef typename backend_type::col_type col_type;
+        typedef typename backend_type::ptr_type ptr_type;
+        typedef typename backend::builtin<value_type, col_type, ptr_type>::matrix build_matrix;
 
         typedef typename math::scalar_of<value_type>::type scalar_type;
 
@@ -94,10 +105,12 @@ class make_solver : public amgcl::detail::non_copyable {
                 const params &prm = params(),
                 const backend_params &bprm = backend_params()
                 ) :
-            prm(prm), n(backend::rows(A)),
+            prm(prm), n(backend::rows(A)), bprm(bprm),
             P(A, prm.precond, bprm),
-            S(backend::rows(A), prm.solver, bprm)
-        {}
+            S(std::make_shared<IterativeSolver>(n, prm.solver, bprm))
+        {
+            pool.put(S);
+        }
 
         // Constructs the preconditioner and creates iterative solver.
         // Takes shared pointer to the matrix in internal format.
@@ -106,10 +119,47 @@ class make_solver : public amgcl::detail::non_copyable {
                 const params &prm = params(),
                 const backend_params &bprm = backend_params()
                 ) :
-            prm(prm), n(backend::rows(*A)),
+            prm(prm), n(backend::rows(*A)), bprm(bprm),
             P(A, prm.precond, bprm),
-            S(backend::rows(*A), prm.solver, bprm)
-        {}
+            S(std::make_shared<IterativeSolver>(n, prm.solver, bprm))
+        {
+            pool.put(S);
+        }
+
+        /** Loads the preconditioner saved with save() and creates the
+         * iterative solver. The preconditioner should support the
+         * serialization (see amgcl::amg::save()).
+         */
+        make_solver(
+                const io::saved_hierarchy &h,
+                const params &prm = params(),
+                const backend_params &bprm = backend_params()
+                ) :
+            prm(prm), n(h.rows()), bprm(bprm),
+            P(h, prm.precond, bprm),
+            S(std::make_shared<IterativeSolver>(n, prm.solver, bprm))
+        {
+            pool.put(S);
+        }
+
+        /** Saves the preconditioner to a binary stream, so that it may be
+         * loaded later instead of being set up again.
+         */
+        void save(std::ostream &f) const {
+            P.save(f);
+        }
+
+        /** Rebuilds the preconditioner for the new matrix \p A. When
+         * \p update_transfer_ops is set, the matrix should have the same
+         * nonzero pattern as the one used during initialization, and the
+         * transfer operators are recomputed for the new values. Otherwise the
+         * transfer operators are reused. The preconditioner should support
+         * the rebuild (see amgcl::amg::rebuild()).
+         */
+        template <class Matrix>
+        void rebuild(const Matrix &A, bool update_transfer_ops = true) {
+            P.rebuild(A, update_transfer_ops);
+        }
 
         /** Computes the solution for the given system matrix \p A and the
          * right-hand side \p rhs.  Returns the number of iterations made and
@@ -129,7 +179,8 @@ class make_solver : public amgcl::detail::non_copyable {
         std::tuple<size_t, scalar_type> operator()(
                 const Matrix &A, const Vec1 &rhs, Vec2 &&x) const
         {
-            return S(A, P, rhs, x);
+            auto s = get_solver();
+            return (*s)(A, P, rhs, x);
         }
 
         /** Computes the solution for the given right-hand side \p rhs.
@@ -139,7 +190,8 @@ class make_solver : public amgcl::detail::non_copyable {
          */
         template <class Vec1, class Vec2>
         std::tuple<size_t, scalar_type> operator()(const Vec1 &rhs, Vec2 &&x) const {
-            return S(P, rhs, x);
+            auto s = get_solver();
+            return (*s)(P, rhs, x);
         }
 
         /** Acts as a preconditioner. That is, applies the solver to the
@@ -184,7 +236,7 @@ class make_solver : public amgcl::detail::non_copyable {
 
         /// Returns reference to the constructed iterative solver.
         const IterativeSolver& solver() const {
-            return S;
+            return *S;
         }
 
         /// Returns the system matrix in the backend format.
@@ -209,18 +261,31 @@ class make_solver : public amgcl::detail::non_copyable {
         }
 
         size_t bytes() const {
-            return backend::bytes(S) + backend::bytes(P);
+            size_t b = backend::bytes(P);
+            pool.for_each([&b](const IterativeSolver &s) { b += backend::bytes(s); });
+            return b;
         }
 
         friend std::ostream& operator<<(std::ostream &os, const make_solver &p) {
             return os
-                << "Solver\n======\n" << p.S << std::endl
+                << "Solver\n======\n" << *p.S << std::endl
                 << "Preconditioner\n==============\n" << p.P;
         }
     private:
         size_t           n;
+        backend_params   bprm;
         Precond          P;
-        IterativeSolver  S;
+
+        // The solver instance created during the setup, and the pool of the
+        // instances that are not currently in use.
+        std::shared_ptr<IterativeSolver> S;
+        mutable detail::object_pool<IterativeSolver> pool;
+
+        typename detail::object_pool<IterativeSolver>::handle get_solver() const {
+            return pool.get([this]() {
+                    return std::make_shared<IterativeSolver>(n, prm.solver, bprm);
+                    });
+        }
 };
 
 } // namespace amgcl
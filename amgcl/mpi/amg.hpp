@@ -38,7 +38,9 @@ THE SOFTWARE.
 
 #include <amgcl/backend/interface.hpp>
 #include <amgcl/value_type/interface.hpp>
+#include <amgcl/detail/cycle.hpp>
 #include <amgcl/mpi/util.hpp>
+#include <amgcl/mpi/inner_product.hpp>
 #include <amgcl/mpi/distributed_matrix.hpp>
 #include <amgcl/mpi/direct_solver/skyline_lu.hpp>
 #include <amgcl/mpi/partition/merge.hpp>
@@ -104,13 +106,21 @@ class amg {
             /// Number of cycles (1 for V-cycle, 2 for W-cycle, etc.).
             unsigned ncycle;
 
+            /// Type of the cycle.
+            /**
+             * See amgcl::amg::params::cycle. The inner products of the
+             * K-cycle use the communicator of the coarse level matrix.
+             */
+            cycle_type::type cycle;
+
             /// Number of cycles to make as part of preconditioning.
             unsigned pre_cycles;
 
             params() :
                 coarse_enough(DirectSolver::coarse_enough()), direct_coarse(true),
                 max_levels( std::numeric_limits<unsigned>::max() ),
-                npre(1), npost(1), ncycle(1), pre_cycles(1)
+                npre(1), npost(1), ncycle(1), cycle(cycle_type::standard),
+                pre_cycles(1)
             {}
 
 #ifndef AMGCL_NO_BOOST
@@ -125,9 +135,10 @@ class amg {
                   AMGCL_PARAMS_IMPORT_VALUE(p, npre),
                   AMGCL_PARAMS_IMPORT_VALUE(p, npost),
                   AMGCL_PARAMS_IMPORT_VALUE(p, ncycle),
+                  AMGCL_PARAMS_IMPORT_VALUE(p, cycle),
                   AMGCL_PARAMS_IMPORT_VALUE(p, pre_cycles)
             {
-                check_params(p, {"coarsening", "relax", "direct", "repart", "coarse_enough",  "direct_coarse", "max_levels", "npre", "npost", "ncycle", "pre_cycles"});
+                check_params(p, {"coarsening", "relax", "direct", "repart", "coarse_enough",  "direct_coarse", "max_levels", "npre", "npost", "ncycle", "cycle", "pre_cycles"});
 
                 amgcl::precondition(max_levels > 0, "max_levels should be positive");
             }
@@ -147,6 +158,7 @@ class amg {
                 AMGCL_PARAMS_EXPORT_VALUE(p, path, npre);
                 AMGCL_PARAMS_EXPORT_VALUE(p, path, npost);
                 AMGCL_PARAMS_EXPORT_VALUE(p, path, ncycle);
+                AMGCL_PARAMS_EXPORT_VALUE(p, path, cycle);
                 AMGCL_PARAMS_EXPORT_VALUE(p, path, pre_cycles);
             }
 #endif
@@ -175,7 +187,7 @@ class amg {
 
         template <class Vec1, class Vec2>
         void cycle(const Vec1 &rhs, Vec2 &&x) const {
-            cycle(levels.begin(), rhs, x);
+            cycle(levels.begin(), rhs, x, prm.cycle);
         }
 
         template <class Vec1, class Vec2>
@@ -183,7 +195,7 @@ class amg {
             if (prm.pre_cycles) {
                 backend::clear(x);
                 for(unsigned i = 0; i < prm.pre_cycles; ++i)
-                    cycle(levels.begin(), rhs, x);
+                    cycle(levels.begin(), rhs, x, prm.cycle);
             } else {
                 backend::copy(rhs, x);
             }
@@ -204,6 +216,7 @@ class amg {
 
             std::shared_ptr<matrix>       A, P, R;
             std::shared_ptr<vector>       f, u, t;
+            std::shared_ptr<vector>       v, c; // Only used by the K-cycle.
             std::shared_ptr<Relaxation>   relax;
             std::shared_ptr<DirectSolver> solve;
 
@@ -232,6 +245,11 @@ class amg {
                     A = a;
                     t = Backend::create_vector(a->loc_rows(), bprm);
 
+                    if (prm.cycle == cycle_type::kcycle) {
+                        v = Backend::create_vector(a->loc_rows(), bprm);
+                        c = Backend::create_vector(a->loc_rows(), bprm);
+                    }
+
                     AMGCL_TIC("relaxation");
                     relax = std::make_shared<Relaxation>(*a, prm.relax, bprm);
                     AMGCL_TOC("relaxation");
@@ -299,6 +317,8 @@ class amg {
         void init(std::shared_ptr<matrix> A, const backend_params &bprm)
         {
             A->comm().check(A->glob_rows() == A->glob_cols(), "Matrix should be square!");
+            A->comm().check(prm.cycle != cycle_type::additive,
+                    "The additive cycle is not supported by mpi::amg");
 
             this->A = A;
             Coarsening C(prm.coarsening);
@@ -339,8 +359,22 @@ class amg {
             AMGCL_TOC("move to backend");
         }
 
+        // Computes the coarse level correction for the restricted residual.
+        void coarse_correction(level_iterator lvl, cycle_type::type type) const {
+            if (type == cycle_type::kcycle && !lvl->solve) {
+                amgcl::detail::kcycle(*lvl->A, *lvl->f, *lvl->u, *lvl->v, *lvl->c, *lvl->t,
+                        inner_product(lvl->A->comm()),
+                        [&](const vector &r, vector &c) { cycle(lvl, r, c, type); });
+            } else {
+                backend::clear(*lvl->u);
+                cycle(lvl, *lvl->f, *lvl->u, type);
+                if (type == cycle_type::fcycle)
+                    cycle(lvl, *lvl->f, *lvl->u, cycle_type::standard);
+            }
+        }
+
         template <class Vec1, class Vec2>
-        void cycle(level_iterator lvl, const Vec1 &rhs, Vec2 &x) const {
+        void cycle(level_iterator lvl, const Vec1 &rhs, Vec2 &x, cycle_type::type type) const {
             level_iterator nxt = lvl, end = levels.end();
             ++nxt;
 
@@ -356,7 +390,8 @@ class amg {
                     AMGCL_TOC("relax");
                 }
             } else {
-                for (size_t j = 0; j < prm.ncycle; ++j) {
+                size_t ncycle = (type == cycle_type::standard) ? prm.ncycle : 1;
+                for (size_t j = 0; j < ncycle; ++j) {
                     AMGCL_TIC("relax");
                     for(size_t i = 0; i < prm.npre; ++i)
                         lvl->relax->apply_pre(*lvl->A, rhs, x, *lvl->t);
@@ -366,8 +401,7 @@ class amg {
 
                     backend::spmv(math::identity<scalar_type>(), *lvl->R, *lvl->t, math::zero<scalar_type>(), *nxt->f);
 
-                    backend::clear(*nxt->u);
-                    cycle(nxt, *nxt->f, *nxt->u);
+                    coarse_correction(nxt, type);
 
                     backend::spmv(math::identity<scalar_type>(), *lvl->P, *nxt->u, math::identity<scalar_type>(), x);
 
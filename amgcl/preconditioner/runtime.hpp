@@ -116,6 +116,9 @@ class preconditioner {
         {
             if (!prm.erase("class")) AMGCL_PARAM_MISSING("class");
 
+            this->prm  = prm;
+            this->bprm = bprm;
+
             switch(_class) {
                 case precond_class::amg:
                     {
@@ -207,6 +210,62 @@ class preconditioner {
             }
         }
 
+        /// Rebuilds the preconditioner for the new matrix.
+        /**
+         * See amgcl::amg::rebuild(). The single-level preconditioners are
+         * constructed from scratch.
+         */
+        template <class Matrix>
+        void rebuild(const Matrix &A, bool update_transfer_ops = true) {
+            switch(_class) {
+                case precond_class::amg:
+                    {
+                        typedef
+                            amgcl::amg<Backend, runtime::coarsening::wrapper, runtime::relaxation::wrapper>
+                            Precond;
+
+                        static_cast<Precond*>(handle)->rebuild(A, update_transfer_ops);
+                    }
+                    break;
+                case precond_class::relaxation:
+                    {
+                        typedef
+                            amgcl::relaxation::as_preconditioner<Backend, runtime::relaxation::wrapper>
+                            Precond;
+
+                        Precond *p = new Precond(A, prm, bprm);
+                        delete static_cast<Precond*>(handle);
+                        handle = static_cast<void*>(p);
+                    }
+                    break;
+                case precond_class::dummy:
+                    {
+                        typedef
+                            amgcl::preconditioner::dummy<Backend>
+                            Precond;
+
+                        Precond *p = new Precond(A, prm, bprm);
+                        delete static_cast<Precond*>(handle);
+                        handle = static_cast<void*>(p);
+                    }
+                    break;
+                case precond_class::nested:
+                    {
+                        typedef
+                            make_solver<
+                                preconditioner,
+                                runtime::solver::wrapper<Backend>
+                                >
+                            Precond;
+
+                        static_cast<Precond*>(handle)->rebuild(A, update_transfer_ops);
+                    }
+                    break;
+                default:
+                    throw std::invalid_argument("Unsupported preconditioner class");
+            }
+        }
+
         template <class Vec1, class Vec2>
         void apply(const Vec1 &rhs, Vec2 &x) const {
             switch(_class) {
@@ -391,6 +450,9 @@ class preconditioner {
     private:
         const runtime::precond_class::type _class;
 
+        params prm;
+        backend_params bprm;
+
         void *handle;
 };
 
@@ -52,7 +52,9 @@ class as_preconditioner {
         typedef typename Backend::params  backend_params;
 
         typedef typename Backend::value_type value_type;
-        typedef typename backend::builtin<value_type>::matrix build_matrix;
+        typedef typename Backend::col_type col_type;
+        typedef typename Backend::ptr_type ptr_type;
+        typedef typename backend::builtin<value_type, col_type, ptr_type>::matrix build_matrix;
 
         template <class Matrix>
         as_preconditioner(
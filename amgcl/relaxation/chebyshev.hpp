@@ -40,7 +40,9 @@ THE SOFTWARE.
 #include <vector>
 #include <cmath>
 
+#include <amgcl/backend/multi_vector.hpp>
 #include <amgcl/detail/inverse.hpp>
+#include <amgcl/detail/object_pool.hpp>
 #include <amgcl/util.hpp>
 
 namespace amgcl {
@@ -114,10 +116,10 @@ class chebyshev {
         chebyshev(
                 const Matrix &A, const params &prm,
                 const typename Backend::params &backend_prm
-            ) : prm(prm),
-                p( Backend::create_vector(rows(A), backend_prm) ),
-                r( Backend::create_vector(rows(A), backend_prm) )
+            ) : prm(prm), n(rows(A)), bprm(backend_prm)
         {
+            pool.put(create_work());
+
             scalar_type hi, lo;
 
             if (prm.scale) {
@@ -161,19 +163,59 @@ class chebyshev {
         }
 
         size_t bytes() const {
-            size_t b = backend::bytes(*p) + backend::bytes(*r);
+            size_t b = 0;
             if (prm.scale) b += backend::bytes(*M);
+            pool.for_each([&b](const work &w) {
+                    b += backend::bytes(*w.p) + backend::bytes(*w.r);
+                    });
             return b;
         }
 
     private:
+        size_t n;
+        typename Backend::params bprm;
+
         std::shared_ptr<typename Backend::matrix_diagonal> M;
-        mutable std::shared_ptr<vector> p, r;
+
+        // The temporary vectors are taken from the pool for each
+        // application, so that the smoother may be used from several
+        // threads at once.
+        struct work {
+            std::shared_ptr<vector> p, r;
+        };
+
+        mutable amgcl::detail::object_pool<work> pool;
 
         scalar_type c, d;
 
+        std::shared_ptr<work> create_work() const {
+            auto w = std::make_shared<work>();
+            w->p = Backend::create_vector(n, bprm);
+            w->r = Backend::create_vector(n, bprm);
+            return w;
+        }
+
         template <class Matrix, class VectorB, class VectorX>
         void solve(const Matrix &A, const VectorB &b, VectorX &x) const
+        {
+            auto w = pool.get([this]() { return create_work(); });
+            solve(A, b, x, *w->p, *w->r);
+        }
+
+        // The temporary vectors are only allocated for single vectors, so
+        // multi-vectors get their own temporaries here.
+        template <class Matrix, class T>
+        void solve(const Matrix &A, const backend::multi_vector<T> &b,
+                backend::multi_vector<T> &x) const
+        {
+            backend::multi_vector<T> p(x.size(), x.cols(), false);
+            backend::multi_vector<T> r(x.size(), x.cols(), false);
+
+            solve(A, b, x, p, r);
+        }
+
+        template <class Matrix, class VectorB, class VectorX, class VectorP, class VectorR>
+        void solve(const Matrix &A, const VectorB &b, VectorX &x, VectorP &p, VectorR &r) const
         {
             static const scalar_type one  = math::identity<scalar_type>();
             static const scalar_type zero = math::zero<scalar_type>();
@@ -181,9 +223,9 @@ class chebyshev {
             scalar_type alpha = zero, beta = zero;
 
             for (unsigned k = 0; k < prm.degree; ++k) {
-                backend::residual(b, A, x, *r);
+                backend::residual(b, A, x, r);
 
-                if (prm.scale) backend::vmul(one, *M, *r, zero, *r);
+                if (prm.scale) backend::vmul(one, *M, r, zero, r);
 
                 if (k == 0) {
                     alpha = math::inverse(d);
@@ -196,8 +238,8 @@ class chebyshev {
                     beta  = alpha * d - one;
                 }
 
-                backend::axpby(alpha, *r, beta, *p);
-                backend::axpby(one, *p, one, x);
+                backend::axpby(alpha, r, beta, p);
+                backend::axpby(one, p, one, x);
             }
         }
 };
@@ -132,6 +132,15 @@ struct damped_jacobi {
         backend::vmul(math::identity<scalar_type>(), *dia, rhs, math::zero<scalar_type>(), x);
     }
 
+    /// \copydoc amgcl::relaxation::spai0::update_rows
+    template <class VectorR, class VectorX>
+    void update_rows(const VectorR &r, VectorX &x, ptrdiff_t beg, ptrdiff_t end) const
+    {
+        const typename Backend::matrix_diagonal &d = *dia;
+        for(ptrdiff_t i = beg; i < end; ++i)
+            x[i] += prm.damping * (d[i] * r[i]);
+    }
+
     size_t bytes() const {
         return backend::bytes(*dia);
     }
@@ -0,0 +1,405 @@
+#ifndef AMGCL_RELAXATION_DETAIL_ILU_FACTOR_HPP
+#define AMGCL_RELAXATION_DETAIL_ILU_FACTOR_HPP
+
+/*
+The MIT License
+
+Copyright (c) 2012-2021 Denis Demidov <dennis.demidov@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/**
+ * \file   amgcl/relaxation/detail/ilu_factor.hpp
+ * \author Denis Demidov <dennis.demidov@gmail.com>
+ * \brief  Parallel incomplete LU factorization on a fixed nonzero pattern.
+ */
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <numeric>
+#include <stdexcept>
+#include <memory>
+
+#include <amgcl/backend/builtin.hpp>
+#include <amgcl/util.hpp>
+
+namespace amgcl {
+namespace relaxation {
+
+/// Factorization algorithms for the ILU-type smoothers.
+namespace ilu_factorization {
+
+enum type {
+    serial,     ///< Serial row-by-row factorization.
+    levels,     ///< Exact factorization with the rows scheduled by the dependency levels.
+    iterative   ///< Fine-grained iterative factorization.
+};
+
+inline std::ostream& operator<<(std::ostream &os, type s) {
+    switch (s) {
+        case serial:
+            return os << "serial";
+        case levels:
+            return os << "levels";
+        case iterative:
+            return os << "iterative";
+        default:
+            return os << "???";
+    }
+}
+
+inline std::istream& operator>>(std::istream &in, type &s) {
+    std::string val;
+    in >> val;
+
+    if (val == "serial")
+        s = serial;
+    else if (val == "levels")
+        s = levels;
+    else if (val == "iterative")
+        s = iterative;
+    else
+        throw std::invalid_argument("Invalid ILU factorization type. "
+                "Valid choices are: serial, levels, iterative.");
+
+    return in;
+}
+
+/// Default factorization algorithm (same threshold as for the triangular solves).
+inline type default_type() {
+#ifdef _OPENMP
+    return omp_get_max_threads() < 4 ? serial : levels;
+#else
+    return serial;
+#endif
+}
+
+} // namespace ilu_factorization
+
+namespace detail {
+
+// Splits the matrix into the strictly lower part L, the strictly upper part U,
+// and the diagonal D. The rows of A are assumed to be sorted.
+template <class Matrix, class BuildMatrix, class Vector>
+void ilu_split(const Matrix &A, BuildMatrix &L, BuildMatrix &U, Vector &D) {
+    const ptrdiff_t n = backend::rows(A);
+
+    L.set_size(n, n, true);
+    U.set_size(n, n, true);
+
+    bool diag = true;
+
+#pragma omp parallel for reduction(&&:diag)
+    for(ptrdiff_t i = 0; i < n; ++i) {
+        ptrdiff_t Lw = 0, Uw = 0;
+        bool d = false;
+
+        for(ptrdiff_t j = A.ptr[i], e = A.ptr[i+1]; j < e; ++j) {
+            ptrdiff_t c = A.col[j];
+            if      (c < i) ++Lw;
+            else if (c > i) ++Uw;
+            else d = true;
+        }
+
+        L.ptr[i+1] = Lw;
+        U.ptr[i+1] = Uw;
+
+        diag = diag && d;
+    }
+
+    precondition(diag, "No diagonal value in system matrix");
+
+    L.set_nonzeros(L.scan_row_sizes());
+    U.set_nonzeros(U.scan_row_sizes());
+
+#pragma omp parallel for
+    for(ptrdiff_t i = 0; i < n; ++i) {
+        ptrdiff_t Lh = L.ptr[i], Uh = U.ptr[i];
+
+        for(ptrdiff_t j = A.ptr[i], e = A.ptr[i+1]; j < e; ++j) {
+            ptrdiff_t c = A.col[j];
+
+            if (c < i) {
+                L.col[Lh] = c;
+                L.val[Lh] = A.val[j];
+                ++Lh;
+            } else if (c > i) {
+                U.col[Uh] = c;
+                U.val[Uh] = A.val[j];
+                ++Uh;
+            } else {
+                D[i] = A.val[j];
+            }
+        }
+    }
+}
+
+// Exact ILU factorization of the matrix split with ilu_split(). The row i
+// depends on the rows referenced by the i-th row of L, so the rows are
+// grouped into the dependency levels, and the rows within each level are
+// factorized in parallel. The arithmetic operations for each row are the same
+// as in the serial algorithm, and so are the results. On output, D contains
+// the inverted diagonal of U.
+template <class BuildMatrix, class Vector>
+void ilu_levels(BuildMatrix &L, BuildMatrix &U, Vector &D) {
+    typedef typename BuildMatrix::val_type value_type;
+
+    const ptrdiff_t n = L.nrows;
+
+    std::vector<ptrdiff_t> level(n);
+    ptrdiff_t nlev = 0;
+
+    for(ptrdiff_t i = 0; i < n; ++i) {
+        ptrdiff_t l = 0;
+        for(ptrdiff_t j = L.ptr[i], e = L.ptr[i+1]; j < e; ++j)
+            l = std::max(l, level[L.col[j]] + 1);
+        level[i] = l;
+        nlev = std::max(nlev, l + 1);
+    }
+
+    std::vector<ptrdiff_t> start(nlev + 1, 0);
+    for(ptrdiff_t i = 0; i < n; ++i) ++start[level[i] + 1];
+    std::partial_sum(start.begin(), start.end(), start.begin());
+
+    std::vector<ptrdiff_t> order(n);
+    {
+        std::vector<ptrdiff_t> head(start.begin(), start.end() - 1);
+        for(ptrdiff_t i = 0; i < n; ++i) order[head[level[i]]++] = i;
+    }
+
+    bool pivot = true;
+
+#pragma omp parallel
+    for(ptrdiff_t l = 0; l < nlev; ++l) {
+#pragma omp for reduction(&&:pivot)
+        for(ptrdiff_t r = start[l]; r < start[l+1]; ++r) {
+            ptrdiff_t i = order[r];
+
+            ptrdiff_t l_beg = L.ptr[i], l_end = L.ptr[i+1];
+            ptrdiff_t u_beg = U.ptr[i], u_end = U.ptr[i+1];
+
+            value_type d = D[i];
+
+            for(ptrdiff_t j = l_beg; j < l_end; ++j) {
+                ptrdiff_t c = L.col[j];
+
+                // Compute the multiplier for the row c.
+                value_type tl = L.val[j] * D[c];
+                L.val[j] = tl;
+
+                // Subtract the row c of U from the rest of the row i.
+                ptrdiff_t jl = j + 1, ju = u_beg;
+                for(ptrdiff_t k = U.ptr[c], e = U.ptr[c+1]; k < e; ++k) {
+                    ptrdiff_t uc = U.col[k];
+
+                    if (uc < i) {
+                        while(jl < l_end && L.col[jl] < uc) ++jl;
+                        if (jl < l_end && L.col[jl] == uc)
+                            L.val[jl] -= tl * U.val[k];
+                    } else if (uc == i) {
+                        d -= tl * U.val[k];
+                    } else {
+                        while(ju < u_end && U.col[ju] < uc) ++ju;
+                        if (ju < u_end && U.col[ju] == uc)
+                            U.val[ju] -= tl * U.val[k];
+                    }
+                }
+            }
+
+            if (math::is_zero(d)) {
+                pivot = false;
+            } else {
+                D[i] = math::inverse(d);
+            }
+        }
+    }
+
+    precondition(pivot, "Zero pivot in ILU");
+}
+
+// Fine-grained iterative ILU factorization by Chow and Patel of the matrix
+// split with ilu_split(). Each sweep updates every nonzero of the factors from
+// the equation (LU)_ij = a_ij with the values from the previous sweep, so that
+// the result does not depend on the number of threads. On output, D contains
+// the inverted diagonal of U.
+template <class BuildMatrix, class Vector>
+void ilu_iterative(BuildMatrix &L, BuildMatrix &U, Vector &D, unsigned sweeps) {
+    typedef typename BuildMatrix::val_type value_type;
+
+    const ptrdiff_t n   = L.nrows;
+    const ptrdiff_t Lnz = L.nnz;
+    const ptrdiff_t Unz = U.nnz;
+
+    // Column-wise index of U: the row numbers and the positions of the
+    // nonzeros in U.val, in the ascending order of the rows.
+    std::vector<ptrdiff_t> Uc_ptr(n + 1, 0), Uc_row(Unz), Uc_pos(Unz);
+
+    for(ptrdiff_t j = 0; j < Unz; ++j) ++Uc_ptr[U.col[j] + 1];
+    std::partial_sum(Uc_ptr.begin(), Uc_ptr.end(), Uc_ptr.begin());
+    {
+        std::vector<ptrdiff_t> head(Uc_ptr.begin(), Uc_ptr.end() - 1);
+        for(ptrdiff_t i = 0; i < n; ++i) {
+            for(ptrdiff_t j = U.ptr[i], e = U.ptr[i+1]; j < e; ++j) {
+                ptrdiff_t h = head[U.col[j]]++;
+                Uc_row[h] = i;
+                Uc_pos[h] = j;
+            }
+        }
+    }
+
+    // The values of A, and the factors from the previous sweep.
+    std::vector<value_type> La(Lnz), Ua(Unz), Da(n);
+    std::vector<value_type> Lp(Lnz), Up(Unz), Dp(n);
+
+    // Initial approximation: L = A_L D^{-1}, U = A_U + D.
+#pragma omp parallel for
+    for(ptrdiff_t i = 0; i < n; ++i) {
+        Da[i] = D[i];
+        for(ptrdiff_t j = U.ptr[i], e = U.ptr[i+1]; j < e; ++j) Ua[j] = U.val[j];
+    }
+
+#pragma omp parallel for
+    for(ptrdiff_t i = 0; i < n; ++i) {
+        for(ptrdiff_t j = L.ptr[i], e = L.ptr[i+1]; j < e; ++j) {
+            La[j] = L.val[j];
+            L.val[j] = L.val[j] * math::inverse(Da[L.col[j]]);
+        }
+    }
+
+    // Sparse dot product of L(i, lb:le) and the column c of U from the
+    // previous sweep.
+    auto dot = [&](ptrdiff_t lb, ptrdiff_t le, ptrdiff_t c) -> value_type {
+        value_type s = math::zero<value_type>();
+        ptrdiff_t ub = Uc_ptr[c], ue = Uc_ptr[c+1];
+
+        while(lb < le && ub < ue) {
+            ptrdiff_t lc = L.col[lb];
+            ptrdiff_t ur = Uc_row[ub];
+
+            if (lc < ur) {
+                ++lb;
+            } else if (ur < lc) {
+                ++ub;
+            } else {
+                s += Lp[lb] * Up[Uc_pos[ub]];
+                ++lb;
+                ++ub;
+            }
+        }
+
+        return s;
+    };
+
+    for(unsigned sweep = 0; sweep < sweeps; ++sweep) {
+#pragma omp parallel for
+        for(ptrdiff_t i = 0; i < n; ++i) {
+            Dp[i] = D[i];
+            for(ptrdiff_t j = L.ptr[i], e = L.ptr[i+1]; j < e; ++j) Lp[j] = L.val[j];
+            for(ptrdiff_t j = U.ptr[i], e = U.ptr[i+1]; j < e; ++j) Up[j] = U.val[j];
+        }
+
+#pragma omp parallel for
+        for(ptrdiff_t i = 0; i < n; ++i) {
+            ptrdiff_t l_beg = L.ptr[i], l_end = L.ptr[i+1];
+
+            for(ptrdiff_t j = l_beg; j < l_end; ++j) {
+                ptrdiff_t c = L.col[j];
+                L.val[j] = (La[j] - dot(l_beg, j, c)) * math::inverse(Dp[c]);
+            }
+
+            D[i] = Da[i] - dot(l_beg, l_end, i);
+
+            for(ptrdiff_t j = U.ptr[i], e = U.ptr[i+1]; j < e; ++j)
+                U.val[j] = Ua[j] - dot(l_beg, l_end, U.col[j]);
+        }
+    }
+
+    bool pivot = true;
+
+#pragma omp parallel for reduction(&&:pivot)
+    for(ptrdiff_t i = 0; i < n; ++i) {
+        if (math::is_zero(D[i])) {
+            pivot = false;
+        } else {
+            D[i] = math::inverse(D[i]);
+        }
+    }
+
+    precondition(pivot, "Zero pivot in ILU");
+}
+
+// Returns copy of the matrix without the zero elements.
+template <class BuildMatrix>
+std::shared_ptr<BuildMatrix> ilu_drop_zeros(const BuildMatrix &A) {
+    const ptrdiff_t n = A.nrows;
+
+    auto B = std::make_shared<BuildMatrix>();
+    B->set_size(n, A.ncols, true);
+
+#pragma omp parallel for
+    for(ptrdiff_t i = 0; i < n; ++i) {
+        ptrdiff_t w = 0;
+        for(ptrdiff_t j = A.ptr[i], e = A.ptr[i+1]; j < e; ++j)
+            if (!math::is_zero(A.val[j])) ++w;
+        B->ptr[i+1] = w;
+    }
+
+    B->set_nonzeros(B->scan_row_sizes());
+
+#pragma omp parallel for
+    for(ptrdiff_t i = 0; i < n; ++i) {
+        ptrdiff_t h = B->ptr[i];
+        for(ptrdiff_t j = A.ptr[i], e = A.ptr[i+1]; j < e; ++j) {
+            if (!math::is_zero(A.val[j])) {
+                B->col[h] = A.col[j];
+                B->val[h] = A.val[j];
+                ++h;
+            }
+        }
+    }
+
+    return B;
+}
+
+// Parallel ILU factorization of A on its own nonzero pattern. The factors are
+// returned in the format expected by ilu_solve: L and U are strictly lower
+// and upper triangular, and D is the inverted diagonal of U.
+template <class Matrix, class BuildMatrix, class Vector>
+void parallel_ilu(const Matrix &A, ilu_factorization::type type, unsigned sweeps,
+        std::shared_ptr<BuildMatrix> &L, std::shared_ptr<BuildMatrix> &U, Vector &D)
+{
+    BuildMatrix Lf, Uf;
+    ilu_split(A, Lf, Uf, D);
+
+    if (type == ilu_factorization::iterative)
+        ilu_iterative(Lf, Uf, D, sweeps);
+    else
+        ilu_levels(Lf, Uf, D);
+
+    L = ilu_drop_zeros(Lf);
+    U = ilu_drop_zeros(Uf);
+}
+
+} // namespace detail
+} // namespace relaxation
+} // namespace amgcl
+
+#endif
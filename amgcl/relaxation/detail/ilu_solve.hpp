@@ -33,6 +33,8 @@ THE SOFTWARE.
  */
 
 #include <amgcl/backend/interface.hpp>
+#include <amgcl/backend/multi_vector.hpp>
+#include <amgcl/detail/object_pool.hpp>
 #include <amgcl/util.hpp>
 
 namespace amgcl {
@@ -47,7 +49,9 @@ class ilu_solve {
         typedef typename Backend::matrix matrix;
         typedef typename Backend::vector vector;
         typedef typename Backend::matrix_diagonal matrix_diagonal;
-        typedef typename backend::builtin<value_type>::matrix build_matrix;
+        typedef typename Backend::col_type col_type;
+        typedef typename Backend::ptr_type ptr_type;
+        typedef typename backend::builtin<value_type, col_type, ptr_type>::matrix build_matrix;
         typedef typename math::scalar_of<value_type>::type scalar_type;
 
         struct params {
@@ -82,18 +86,20 @@ class ilu_solve {
                 const params &prm = params(),
                 const backend_params &bprm = backend_params()
                 ) :
-            prm(prm),
+            prm(prm), bprm(bprm),
             L(Backend::copy_matrix(L, bprm)),
             U(Backend::copy_matrix(U, bprm)),
-            D(Backend::copy_vector(D, bprm)),
-            t1(Backend::create_vector(backend::rows(*L), bprm)),
-            t2(Backend::create_vector(backend::rows(*L), bprm))
-        {}
+            D(Backend::copy_vector(D, bprm))
+        {
+            pool.put(create_work());
+        }
 
         template <class Vector>
         void solve(Vector &x) {
-            vector *y0 = t1.get();
-            vector *y1 = t2.get();
+            auto w = pool.get([this]() { return create_work(); });
+
+            vector *y0 = w->t1.get();
+            vector *y1 = w->t2.get();
 
             backend::axpby(prm.damping, x, 0.0, *y0);
             for(unsigned i = 0; i < prm.iters; ++i) {
@@ -109,30 +115,49 @@ class ilu_solve {
         }
 
         size_t bytes() const {
-            return
+            size_t b =
                 backend::bytes(*L) +
                 backend::bytes(*U) +
-                backend::bytes(*D) +
-                backend::bytes(*t1) +
-                backend::bytes(*t2);
+                backend::bytes(*D);
+
+            pool.for_each([&b](const work &w) {
+                    b += backend::bytes(*w.t1) + backend::bytes(*w.t2);
+                    });
+
+            return b;
         }
 
     private:
+        backend_params bprm;
+
         std::shared_ptr<matrix> L;
         std::shared_ptr<matrix> U;
         std::shared_ptr<matrix_diagonal> D;
-        std::shared_ptr<vector> t1, t2;
+
+        // Temporary vectors, taken from the pool for each call to solve().
+        struct work {
+            std::shared_ptr<vector> t1, t2;
+        };
+
+        mutable amgcl::detail::object_pool<work> pool;
+
+        std::shared_ptr<work> create_work() const {
+            auto w = std::make_shared<work>();
+            w->t1 = Backend::create_vector(backend::rows(*L), bprm);
+            w->t2 = Backend::create_vector(backend::rows(*L), bprm);
+            return w;
+        }
 };
 
-template <class value_type>
-class ilu_solve< backend::builtin<value_type> > {
+template <class value_type, class col_type, class ptr_type, class solver_type>
+class ilu_solve< backend::builtin<value_type, col_type, ptr_type, solver_type> > {
     public:
-        typedef backend::builtin<value_type> Backend;
+        typedef backend::builtin<value_type, col_type, ptr_type, solver_type> Backend;
         typedef typename Backend::params backend_params;
         typedef typename Backend::matrix matrix;
         typedef typename Backend::vector vector;
         typedef typename Backend::matrix_diagonal matrix_diagonal;
-        typedef typename backend::builtin<value_type>::matrix build_matrix;
+        typedef typename Backend::matrix build_matrix;
         typedef typename Backend::rhs_type rhs_type;
         typedef typename math::scalar_of<value_type>::type scalar_type;
 
@@ -207,6 +232,14 @@ class ilu_solve< backend::builtin<value_type> > {
 #endif
         }
 
+        static int team_size() {
+#ifdef _OPENMP
+            return omp_get_num_threads();
+#else
+            return 1;
+#endif
+        }
+
         // copies of the input matrices for the fallback (serial)
         // implementation:
         std::shared_ptr<matrix>          L;
@@ -244,6 +277,35 @@ class ilu_solve< backend::builtin<value_type> > {
             }
         }
 
+        template <class T>
+        void serial_solve(backend::multi_vector<T> &x) {
+            const size_t n = backend::rows(*L);
+            const size_t m = x.cols();
+
+            const matrix          &L = *(this->L);
+            const matrix          &U = *(this->U);
+            const matrix_diagonal &D = *(this->D);
+
+            for(size_t i = 0; i < n; i++) {
+                T *xi = x.row(i);
+                for(ptrdiff_t j = L.ptr[i], e = L.ptr[i+1]; j < e; ++j) {
+                    const T  v  = L.val[j];
+                    const T *xc = x.row(L.col[j]);
+                    for(size_t k = 0; k < m; ++k) xi[k] -= v * xc[k];
+                }
+            }
+
+            for(size_t i = n; i-- > 0;) {
+                T *xi = x.row(i);
+                for(ptrdiff_t j = U.ptr[i], e = U.ptr[i+1]; j < e; ++j) {
+                    const T  v  = U.val[j];
+                    const T *xc = x.row(U.col[j]);
+                    for(size_t k = 0; k < m; ++k) xi[k] -= v * xc[k];
+                }
+                for(size_t k = 0; k < m; ++k) xi[k] *= D[i];
+            }
+        }
+
         // OpenMP solver for sparse triangular systems.
         // The solver uses level scheduling approach.
         // Each level (a set of matrix rows that can be computed independently)
@@ -263,10 +325,10 @@ class ilu_solve< backend::builtin<value_type> > {
 
             // thread-specific storage:
             std::vector< std::vector<task>       > tasks;
-            std::vector< std::vector<ptrdiff_t>  > ptr;
-            std::vector< std::vector<ptrdiff_t>  > col;
+            std::vector< std::vector<ptr_type>   > ptr;
+            std::vector< std::vector<col_type>   > col;
             std::vector< std::vector<value_type> > val;
-            std::vector< std::vector<ptrdiff_t>  > ord; // rows ordered by levels
+            std::vector< std::vector<col_type>   > ord; // rows ordered by levels
             std::vector< std::vector<value_type> > D;
 
             template <class Matrix>
@@ -385,28 +447,78 @@ class ilu_solve< backend::builtin<value_type> > {
 
             template <class Vector>
             void solve(Vector &x) const {
+                const size_t nlev = tasks[0].size();
+
 #pragma omp parallel
                 {
-                    int tid = thread_id();
+                    const int nt = team_size();
+
+                    // The team may be smaller than at the setup (e.g. when the
+                    // solve is called from a nested team), so a thread may
+                    // have to process the tasks of several setup threads.
+                    for(size_t lev = 0; lev < nlev; ++lev) {
+                        for(int tid = thread_id(); tid < nthreads; tid += nt) {
+                            const task &t = tasks[tid][lev];
+                            for(ptrdiff_t r = t.beg; r < t.end; ++r) {
+                                ptrdiff_t i   = ord[tid][r];
+                                ptrdiff_t beg = ptr[tid][r];
+                                ptrdiff_t end = ptr[tid][r+1];
+
+                                rhs_type X = math::zero<rhs_type>();
+                                for(ptrdiff_t j = beg; j < end; ++j)
+                                    X += val[tid][j] * x[col[tid][j]];
+
+                                if (lower)
+                                    x[i] -= X;
+                                else
+                                    x[i] = D[tid][r] * (x[i] - X);
+                            }
+                        }
 
-                    for(const task &t : tasks[tid]) {
-                        for(ptrdiff_t r = t.beg; r < t.end; ++r) {
-                            ptrdiff_t i   = ord[tid][r];
-                            ptrdiff_t beg = ptr[tid][r];
-                            ptrdiff_t end = ptr[tid][r+1];
+                        // each task corresponds to a level, so we need
+                        // to synchronize across threads at this point:
+#pragma omp barrier
+                        ;
+                    }
+                }
+            }
 
-                            rhs_type X = math::zero<rhs_type>();
-                            for(ptrdiff_t j = beg; j < end; ++j)
-                                X += val[tid][j] * x[col[tid][j]];
+            template <class T>
+            void solve(backend::multi_vector<T> &x) const {
+                const size_t m    = x.cols();
+                const size_t nlev = tasks[0].size();
 
-                            if (lower)
-                                x[i] -= X;
-                            else
-                                x[i] = D[tid][r] * (x[i] - X);
+#pragma omp parallel
+                {
+                    const int nt = team_size();
+                    std::vector<T> X(m);
+
+                    // A thread may process the tasks of several setup threads.
+                    for(size_t lev = 0; lev < nlev; ++lev) {
+                        for(int tid = thread_id(); tid < nthreads; tid += nt) {
+                            const task &t = tasks[tid][lev];
+                            for(ptrdiff_t r = t.beg; r < t.end; ++r) {
+                                ptrdiff_t i   = ord[tid][r];
+                                ptrdiff_t beg = ptr[tid][r];
+                                ptrdiff_t end = ptr[tid][r+1];
+
+                                std::fill(X.begin(), X.end(), math::zero<T>());
+                                for(ptrdiff_t j = beg; j < end; ++j) {
+                                    const T  v  = val[tid][j];
+                                    const T *xc = x.row(col[tid][j]);
+                                    for(size_t k = 0; k < m; ++k) X[k] += v * xc[k];
+                                }
+
+                                T *xi = x.row(i);
+                                if (lower) {
+                                    for(size_t k = 0; k < m; ++k) xi[k] -= X[k];
+                                } else {
+                                    const T d = D[tid][r];
+                                    for(size_t k = 0; k < m; ++k) xi[k] = d * (xi[k] - X[k]);
+                                }
+                            }
                         }
 
-                        // each task corresponds to a level, so we need
-                        // to synchronize across threads at this point:
 #pragma omp barrier
                         ;
                     }
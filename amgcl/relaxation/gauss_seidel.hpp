@@ -36,6 +36,7 @@ THE SOFTWARE.
 #include <memory>
 
 #include <amgcl/backend/interface.hpp>
+#include <amgcl/backend/multi_vector.hpp>
 #include <amgcl/util.hpp>
 
 #ifdef _OPENMP
@@ -150,6 +151,14 @@ struct gauss_seidel {
 #endif
         }
 
+        static int team_size() {
+#ifdef _OPENMP
+            return omp_get_num_threads();
+#else
+            return 1;
+#endif
+        }
+
         template <class Matrix, class VectorRHS, class VectorX>
         static void serial_sweep(
                 const Matrix &A, const VectorRHS &rhs, VectorX &x, bool forward)
@@ -182,6 +191,44 @@ struct gauss_seidel {
             }
         }
 
+        template <class Matrix, class T>
+        static void serial_sweep(
+                const Matrix &A, const backend::multi_vector<T> &rhs,
+                backend::multi_vector<T> &x, bool forward)
+        {
+            typedef typename backend::value_type<Matrix>::type val_type;
+
+            const ptrdiff_t n = backend::rows(A);
+            const size_t    m = x.cols();
+
+            const ptrdiff_t beg = forward ? 0 : n-1;
+            const ptrdiff_t end = forward ? n : -1;
+            const ptrdiff_t inc = forward ? 1 : -1;
+
+            std::vector<T> X(m);
+
+            for(ptrdiff_t i = beg; i != end; i += inc) {
+                val_type D = math::identity<val_type>();
+                std::copy(rhs.row(i), rhs.row(i) + m, X.begin());
+
+                for (auto a = backend::row_begin(A, i); a; ++a) {
+                    ptrdiff_t c = a.col();
+                    val_type  v = a.value();
+
+                    if (c == i) {
+                        D = v;
+                    } else {
+                        const T *xc = x.row(c);
+                        for(size_t k = 0; k < m; ++k) X[k] -= v * xc[k];
+                    }
+                }
+
+                T  d  = math::inverse(D);
+                T *xi = x.row(i);
+                for(size_t k = 0; k < m; ++k) xi[k] = d * X[k];
+            }
+        }
+
         template <bool forward>
         struct parallel_sweep {
             typedef typename Backend::value_type value_type;
@@ -320,35 +367,89 @@ struct gauss_seidel {
 
             template <class Vector1, class Vector2>
             void sweep(const Vector1 &rhs, Vector2 &x) const {
+                const size_t nlev = tasks[0].size();
+
 #pragma omp parallel
                 {
-                    int tid = thread_id();
-
-                    for(const task &t : tasks[tid]) {
-                        for(ptrdiff_t r = t.beg; r < t.end; ++r) {
-                            ptrdiff_t i   = ord[tid][r];
-                            ptrdiff_t beg = ptr[tid][r];
-                            ptrdiff_t end = ptr[tid][r+1];
+                    const int nt = team_size();
+
+                    // The team may be smaller than at the setup (e.g. when the
+                    // smoother is applied by a nested team), so a thread may
+                    // have to process the tasks of several setup threads.
+                    for(size_t lev = 0; lev < nlev; ++lev) {
+                        for(int tid = thread_id(); tid < nthreads; tid += nt) {
+                            const task &t = tasks[tid][lev];
+                            for(ptrdiff_t r = t.beg; r < t.end; ++r) {
+                                ptrdiff_t i   = ord[tid][r];
+                                ptrdiff_t beg = ptr[tid][r];
+                                ptrdiff_t end = ptr[tid][r+1];
+
+                                value_type D = math::identity<value_type>();
+                                rhs_type X;
+                                X = rhs[i];
+
+                                for(ptrdiff_t j = beg; j < end; ++j) {
+                                    ptrdiff_t  c = col[tid][j];
+                                    value_type v = val[tid][j];
+
+                                    if (c == i)
+                                        D = v;
+                                    else
+                                        X -= v * x[c];
+                                }
+
+                                x[i] = math::inverse(D) * X;
+                            }
+                        }
 
-                            value_type D = math::identity<value_type>();
-                            rhs_type X;
-                            X = rhs[i];
+                        // each task corresponds to a level, so we need
+                        // to synchronize across threads at this point:
+#pragma omp barrier
+                        ;
+                    }
+                }
+            }
 
-                            for(ptrdiff_t j = beg; j < end; ++j) {
-                                ptrdiff_t  c = col[tid][j];
-                                value_type v = val[tid][j];
+            template <class T>
+            void sweep(const backend::multi_vector<T> &rhs, backend::multi_vector<T> &x) const {
+                const size_t m    = x.cols();
+                const size_t nlev = tasks[0].size();
 
-                                if (c == i)
-                                    D = v;
-                                else
-                                    X -= v * x[c];
+#pragma omp parallel
+                {
+                    const int nt = team_size();
+                    std::vector<T> X(m);
+
+                    // A thread may process the tasks of several setup threads.
+                    for(size_t lev = 0; lev < nlev; ++lev) {
+                        for(int tid = thread_id(); tid < nthreads; tid += nt) {
+                            const task &t = tasks[tid][lev];
+                            for(ptrdiff_t r = t.beg; r < t.end; ++r) {
+                                ptrdiff_t i   = ord[tid][r];
+                                ptrdiff_t beg = ptr[tid][r];
+                                ptrdiff_t end = ptr[tid][r+1];
+
+                                value_type D = math::identity<value_type>();
+                                std::copy(rhs.row(i), rhs.row(i) + m, X.begin());
+
+                                for(ptrdiff_t j = beg; j < end; ++j) {
+                                    ptrdiff_t  c = col[tid][j];
+                                    value_type v = val[tid][j];
+
+                                    if (c == i) {
+                                        D = v;
+                                    } else {
+                                        const T *xc = x.row(c);
+                                        for(size_t k = 0; k < m; ++k) X[k] -= v * xc[k];
+                                    }
+                                }
+
+                                T  d  = math::inverse(D);
+                                T *xi = x.row(i);
+                                for(size_t k = 0; k < m; ++k) xi[k] = d * X[k];
                             }
-
-                            x[i] = math::inverse(D) * X;
                         }
 
-                        // each task corresponds to a level, so we need
-                        // to synchronize across threads at this point:
 #pragma omp barrier
                         ;
                     }
@@ -34,15 +34,15 @@ THE SOFTWARE.
 #include <amgcl/backend/builtin.hpp>
 #include <amgcl/util.hpp>
 #include <amgcl/relaxation/detail/ilu_solve.hpp>
+#include <amgcl/relaxation/detail/ilu_factor.hpp>
 
 namespace amgcl {
 namespace relaxation {
 
 /// ILU(0) smoother.
 /**
- * \note ILU(0) is a serial algorithm and is only applicable to backends that
- * support matrix row iteration (e.g. amgcl::backend::builtin or
- * amgcl::backend::eigen).
+ * \note The factors are computed on the host with the builtin backend data
+ * structures and are then moved to the target backend.
  *
  * \param Backend Backend for temporary structures allocation.
  * \ingroup relaxation
@@ -65,19 +65,38 @@ struct ilu0 {
         /// Parameters for sparse triangular system solver
         typename ilu_solve::params solve;
 
-        params() : damping(1) {}
+        /// Factorization algorithm.
+        /**
+         * The serial algorithm is used by default with less than 4 OpenMP
+         * threads, otherwise the rows are factorized in parallel in the order
+         * of their dependency levels. Both algorithms give the same factors.
+         * The iterative algorithm \cite Chow2015 approximates the factors
+         * with the given number of fine-grained parallel sweeps.
+         */
+        ilu_factorization::type factorization;
+
+        /// Number of sweeps for the iterative factorization.
+        unsigned sweeps;
+
+        params()
+            : damping(1), factorization(ilu_factorization::default_type()), sweeps(3)
+        {}
 
 #ifndef AMGCL_NO_BOOST
         params(const boost::property_tree::ptree &p)
             : AMGCL_PARAMS_IMPORT_VALUE(p, damping)
             , AMGCL_PARAMS_IMPORT_CHILD(p, solve)
+            , AMGCL_PARAMS_IMPORT_VALUE(p, factorization)
+            , AMGCL_PARAMS_IMPORT_VALUE(p, sweeps)
         {
-            check_params(p, {"damping", "solve"}, {"k"});
+            check_params(p, {"damping", "solve", "factorization", "sweeps"}, {"k"});
         }
 
         void get(boost::property_tree::ptree &p, const std::string &path) const {
             AMGCL_PARAMS_EXPORT_VALUE(p, path, damping);
             AMGCL_PARAMS_EXPORT_CHILD(p, path, solve);
+            AMGCL_PARAMS_EXPORT_VALUE(p, path, factorization);
+            AMGCL_PARAMS_EXPORT_VALUE(p, path, sweeps);
         }
 #endif
     } prm;
@@ -87,9 +106,21 @@ struct ilu0 {
     ilu0( const Matrix &A, const params &prm, const typename Backend::params &bprm)
       : prm(prm)
     {
-        typedef typename backend::builtin<value_type>::matrix build_matrix;
+        typedef typename Backend::col_type col_type;
+        typedef typename Backend::ptr_type ptr_type;
+        typedef typename backend::builtin<value_type, col_type, ptr_type>::matrix build_matrix;
         const size_t n = backend::rows(A);
 
+        if (prm.factorization != ilu_factorization::serial) {
+            std::shared_ptr<build_matrix> L, U;
+            auto D = std::make_shared<backend::numa_vector<value_type> >(n, false);
+
+            detail::parallel_ilu(A, prm.factorization, prm.sweeps, L, U, *D);
+
+            ilu = std::make_shared<ilu_solve>(L, U, D, prm.solve, bprm);
+            return;
+        }
+
         size_t Lnz = 0, Unz = 0;
 
         for(ptrdiff_t i = 0; i < static_cast<ptrdiff_t>(n); ++i) {
@@ -34,12 +34,15 @@ THE SOFTWARE.
 #include <vector>
 #include <deque>
 #include <queue>
+#include <algorithm>
+#include <functional>
 #include <cmath>
 
 
 #include <amgcl/backend/builtin.hpp>
 #include <amgcl/util.hpp>
 #include <amgcl/relaxation/detail/ilu_solve.hpp>
+#include <amgcl/relaxation/detail/ilu_factor.hpp>
 
 namespace amgcl {
 namespace relaxation {
@@ -67,21 +70,43 @@ struct iluk {
         /// Parameters for sparse triangular system solver
         typename ilu_solve::params solve;
 
-        params() : k(1), damping(1) {}
+        /// Factorization algorithm.
+        /**
+         * With the parallel algorithms, the nonzero pattern of the factors is
+         * computed serially (without the values), and the numeric
+         * factorization is done on the pattern as in
+         * amgcl::relaxation::ilu0. The serial ILU(k) drops the fill-in with
+         * too high level on the first access, so the factors of the parallel
+         * algorithms may slightly differ from the serial ones. The serial
+         * algorithm is the default, so that the smoother does not depend on
+         * the number of threads.
+         */
+        ilu_factorization::type factorization;
+
+        /// Number of sweeps for the iterative factorization.
+        unsigned sweeps;
+
+        params()
+            : k(1), damping(1), factorization(ilu_factorization::serial), sweeps(3)
+        {}
 
 #ifndef AMGCL_NO_BOOST
         params(const boost::property_tree::ptree &p)
             : AMGCL_PARAMS_IMPORT_VALUE(p, k)
             , AMGCL_PARAMS_IMPORT_VALUE(p, damping)
             , AMGCL_PARAMS_IMPORT_CHILD(p, solve)
+            , AMGCL_PARAMS_IMPORT_VALUE(p, factorization)
+            , AMGCL_PARAMS_IMPORT_VALUE(p, sweeps)
         {
-            check_params(p, {"k", "damping", "solve"});
+            check_params(p, {"k", "damping", "solve", "factorization", "sweeps"});
         }
 
         void get(boost::property_tree::ptree &p, const std::string &path) const {
             AMGCL_PARAMS_EXPORT_VALUE(p, path, k);
             AMGCL_PARAMS_EXPORT_VALUE(p, path, damping);
             AMGCL_PARAMS_EXPORT_CHILD(p, path, solve);
+            AMGCL_PARAMS_EXPORT_VALUE(p, path, factorization);
+            AMGCL_PARAMS_EXPORT_VALUE(p, path, sweeps);
         }
 #endif
     } prm;
@@ -91,10 +116,23 @@ struct iluk {
     iluk( const Matrix &A, const params &prm, const typename Backend::params &bprm)
       : prm(prm)
     {
-        typedef typename backend::builtin<value_type>::matrix build_matrix;
+        typedef typename Backend::col_type col_type;
+        typedef typename Backend::ptr_type ptr_type;
+        typedef typename backend::builtin<value_type, col_type, ptr_type>::matrix build_matrix;
 
         const size_t n = backend::rows(A);
 
+        if (prm.factorization != ilu_factorization::serial) {
+            std::shared_ptr<build_matrix> L, U;
+            auto D = std::make_shared<backend::numa_vector<value_type> >(n, false);
+
+            detail::parallel_ilu(*fill_pattern<build_matrix>(A, prm.k),
+                    prm.factorization, prm.sweeps, L, U, *D);
+
+            ilu = std::make_shared<ilu_solve>(L, U, D, prm.solve, bprm);
+            return;
+        }
+
         size_t Anz = backend::nonzeros(A);
 
         std::vector<ptrdiff_t>  Lptr; Lptr.reserve(n+1); Lptr.push_back(0);
@@ -189,6 +227,78 @@ struct iluk {
     private:
         std::shared_ptr<ilu_solve> ilu;
 
+        // Symbolic ILU(k) factorization. Returns the matrix with the nonzero
+        // pattern of the factors, filled with the values of A.
+        template <class BuildMatrix, class Matrix>
+        static std::shared_ptr<BuildMatrix> fill_pattern(const Matrix &A, int lfil) {
+            const ptrdiff_t n = backend::rows(A);
+
+            std::vector<ptrdiff_t> ptr; ptr.reserve(n+1); ptr.push_back(0);
+            std::vector<ptrdiff_t> col; col.reserve(backend::nonzeros(A));
+            std::vector<int>       lev; lev.reserve(backend::nonzeros(A));
+
+            // Start of the upper triangular part in each row.
+            std::vector<ptrdiff_t> upos(n);
+
+            std::vector<int>       level(n, -1);
+            std::vector<ptrdiff_t> nz;
+            std::priority_queue<ptrdiff_t, std::vector<ptrdiff_t>, std::greater<ptrdiff_t> > q;
+
+            for(ptrdiff_t i = 0; i < n; ++i) {
+                for(auto a = backend::row_begin(A, i); a; ++a) {
+                    ptrdiff_t c = a.col();
+                    level[c] = 0;
+                    nz.push_back(c);
+                    if (c < i) q.push(c);
+                }
+
+                while(!q.empty()) {
+                    ptrdiff_t c = q.top(); q.pop();
+
+                    for(ptrdiff_t j = upos[c], e = ptr[c+1]; j < e; ++j) {
+                        ptrdiff_t u = col[j];
+                        int l = level[c] + lev[j] + 1;
+
+                        if (l > lfil) continue;
+
+                        if (level[u] < 0) {
+                            level[u] = l;
+                            nz.push_back(u);
+                            if (u < i) q.push(u);
+                        } else {
+                            level[u] = std::min(level[u], l);
+                        }
+                    }
+                }
+
+                std::sort(nz.begin(), nz.end());
+
+                upos[i] = col.size() + (std::upper_bound(nz.begin(), nz.end(), i) - nz.begin());
+
+                for(ptrdiff_t c : nz) {
+                    col.push_back(c);
+                    lev.push_back(level[c]);
+                    level[c] = -1;
+                }
+
+                ptr.push_back(col.size());
+                nz.clear();
+            }
+
+            std::vector<value_type> val(col.size(), math::zero<value_type>());
+
+#pragma omp parallel for
+            for(ptrdiff_t i = 0; i < n; ++i) {
+                auto beg = col.begin() + ptr[i];
+                auto end = col.begin() + ptr[i+1];
+
+                for(auto a = backend::row_begin(A, i); a; ++a)
+                    val[std::lower_bound(beg, end, a.col()) - col.begin()] += a.value();
+            }
+
+            return std::make_shared<BuildMatrix>(n, n, ptr, col, val);
+        }
+
         struct nonzero {
             ptrdiff_t  col;
             value_type val;
@@ -138,7 +138,7 @@ struct ilup {
         params(const boost::property_tree::ptree &p)
             : BasePrm(p), AMGCL_PARAMS_IMPORT_VALUE(p, k)
         {
-            check_params(p, {"k", "damping", "solve"});
+            check_params(p, {"k", "damping", "solve", "factorization", "sweeps"});
         }
 
         void get(boost::property_tree::ptree &p, const std::string &path) const {
@@ -212,7 +212,9 @@ struct ilut {
     }
 
     private:
-        typedef typename backend::builtin<value_type>::matrix build_matrix;
+        typedef typename Backend::col_type col_type;
+        typedef typename Backend::ptr_type ptr_type;
+        typedef typename backend::builtin<value_type, col_type, ptr_type>::matrix build_matrix;
         std::shared_ptr<ilu_solve> ilu;
 
         struct sparse_vector {
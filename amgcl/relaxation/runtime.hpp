@@ -269,6 +269,26 @@ struct wrapper {
         }
     }
 
+    /// Only damped_jacobi and spai0 support the row updates.
+    bool supports_update_rows() const {
+        return r == damped_jacobi || r == spai0;
+    }
+
+    template <class VectorR, class VectorX>
+    void update_rows(const VectorR &res, VectorX &x, ptrdiff_t beg, ptrdiff_t end) const
+    {
+        switch(r) {
+            case damped_jacobi:
+                static_cast<amgcl::relaxation::damped_jacobi<Backend>*>(handle)->update_rows(res, x, beg, end);
+                break;
+            case spai0:
+                static_cast<amgcl::relaxation::spai0<Backend>*>(handle)->update_rows(res, x, beg, end);
+                break;
+            default:
+                throw std::logic_error("The relaxation does not support the row updates");
+        }
+    }
+
     size_t bytes() const {
         switch(r) {
 
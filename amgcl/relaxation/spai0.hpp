@@ -109,6 +109,19 @@ struct spai0 {
         backend::vmul(math::identity<scalar_type>(), *M, rhs, math::zero<scalar_type>(), x);
     }
 
+    /// Adds the scaled residual to the given rows of the solution.
+    /**
+     * Computes x += M r for the rows in [beg, end). Used by the AMG cycle
+     * executed by a single team of threads (see amg::params::team_cycle).
+     */
+    template <class VectorR, class VectorX>
+    void update_rows(const VectorR &r, VectorX &x, ptrdiff_t beg, ptrdiff_t end) const
+    {
+        const matrix_diagonal &m = *M;
+        for(ptrdiff_t i = beg; i < end; ++i)
+            x[i] += m[i] * r[i];
+    }
+
     size_t bytes() const {
         return backend::bytes(*M);
     }
@@ -0,0 +1,268 @@
+#ifndef AMGCL_REORDER_NESTED_DISSECTION_HPP
+#define AMGCL_REORDER_NESTED_DISSECTION_HPP
+
+/*
+The MIT License
+
+Copyright (c) 2012-2021 Denis Demidov <dennis.demidov@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/**
+ * \file   amgcl/reorder/nested_dissection.hpp
+ * \author Denis Demidov <dennis.demidov@gmail.com>
+ * \brief  Nested dissection matrix reorder algorithm.
+ */
+
+#include <vector>
+#include <tuple>
+#include <numeric>
+#include <algorithm>
+
+#include <amgcl/backend/interface.hpp>
+#include <amgcl/util.hpp>
+
+namespace amgcl {
+namespace reorder {
+
+/// Nested dissection ordering.
+/**
+ * The graph of the symmetrized matrix \f$A + A^T\f$ is recursively split
+ * into two parts by a vertex separator, and the separator vertices are
+ * ordered after the both parts. The separators are found with the level
+ * structures rooted at pseudo-peripheral vertices (the middle level of the
+ * structure is taken as the separator). The subgraphs smaller than
+ * `leaf_size` vertices are not split further. The ordering reduces the fill-in
+ * of the direct factorization, and results in a wide and short elimination
+ * tree, which exposes the parallelism in the factorization.
+ */
+template <ptrdiff_t leaf_size = 64>
+struct nested_dissection {
+    /// Computes the permutation: perm[i] is the original index of the i-th unknown.
+    template <class Matrix, class Vector>
+    static void get(const Matrix &A, Vector &perm) {
+        const ptrdiff_t n = backend::rows(A);
+
+        std::vector<ptrdiff_t> ptr, col;
+        symmetrize(A, ptr, col);
+
+        // The vertices of the current subgraph are kept in a contiguous
+        // chunk of the work array, which is reordered in place.
+        std::vector<ptrdiff_t> order(n);
+        for(ptrdiff_t i = 0; i < n; ++i) order[i] = i;
+
+        std::vector<ptrdiff_t> tag(n, -1), level(n, -1), queue(n), tmp;
+        std::vector<std::pair<ptrdiff_t, ptrdiff_t> > parts;
+        parts.push_back(std::make_pair(0, n));
+
+        ptrdiff_t ntags = 0;
+
+        while(!parts.empty()) {
+            ptrdiff_t beg = parts.back().first;
+            ptrdiff_t end = parts.back().second;
+            parts.pop_back();
+
+            ptrdiff_t size = end - beg;
+            if (size <= leaf_size) continue;
+
+            ptrdiff_t t = ntags++;
+            for(ptrdiff_t i = beg; i < end; ++i) tag[order[i]] = t;
+
+            // Find a pseudo-peripheral vertex and its level structure.
+            ptrdiff_t root = order[beg];
+            ptrdiff_t nlev = 0, nvis = 0;
+
+            for(int iter = 0; iter < 8; ++iter) {
+                ptrdiff_t lev, cnt;
+                std::tie(lev, cnt) = bfs(root, t, ptr, col, tag, level, queue);
+
+                if (iter && lev <= nlev) {
+                    for(ptrdiff_t i = 0; i < cnt; ++i) level[queue[i]] = -1;
+                    break;
+                }
+
+                nlev = lev;
+                nvis = cnt;
+
+                // Pick the vertex of minimal degree in the last level.
+                ptrdiff_t last = queue[cnt - 1];
+                ptrdiff_t next = last, deg = ptr[last+1] - ptr[last];
+                for(ptrdiff_t i = cnt - 1; i >= 0 && level[queue[i]] == level[last]; --i) {
+                    ptrdiff_t v = queue[i];
+                    ptrdiff_t d = ptr[v+1] - ptr[v];
+                    if (d < deg) { deg = d; next = v; }
+                }
+
+                for(ptrdiff_t i = 0; i < cnt; ++i) level[queue[i]] = -1;
+
+                if (next == root) break;
+                root = next;
+            }
+
+            // Restore the level structure of the final root.
+            std::tie(nlev, nvis) = bfs(root, t, ptr, col, tag, level, queue);
+
+            tmp.clear();
+
+            if (nvis < size) {
+                // The subgraph is disconnected: split it into the reached
+                // component and the rest.
+                for(ptrdiff_t i = 0; i < nvis; ++i) tmp.push_back(queue[i]);
+                for(ptrdiff_t i = beg; i < end; ++i)
+                    if (level[order[i]] < 0) tmp.push_back(order[i]);
+
+                std::copy(tmp.begin(), tmp.end(), order.begin() + beg);
+
+                parts.push_back(std::make_pair(beg, beg + nvis));
+                parts.push_back(std::make_pair(beg + nvis, end));
+            } else if (nlev < 3) {
+                // The subgraph is too dense to be split.
+            } else {
+                // The separator is the level that splits the vertices in
+                // halves. The first and the last levels are excluded, so that
+                // both parts are not empty.
+                std::vector<ptrdiff_t> cnt(nlev, 0);
+                for(ptrdiff_t i = 0; i < nvis; ++i) ++cnt[level[queue[i]]];
+
+                ptrdiff_t m = 1, below = cnt[0];
+                while(m + 2 < nlev && 2 * (below + cnt[m]) < size) below += cnt[m++];
+
+                // The vertices of the separator level without the neighbours
+                // in the next level are moved to the first part.
+                for(ptrdiff_t i = 0; i < nvis; ++i) {
+                    ptrdiff_t v = queue[i];
+                    if (level[v] != m) continue;
+
+                    bool sep = false;
+                    for(ptrdiff_t j = ptr[v]; j < ptr[v+1]; ++j) {
+                        ptrdiff_t u = col[j];
+                        if (tag[u] == t && level[u] == m + 1) {
+                            sep = true;
+                            break;
+                        }
+                    }
+
+                    if (!sep) level[v] = m - 1;
+                }
+
+                for(ptrdiff_t i = 0; i < nvis; ++i)
+                    if (level[queue[i]] < m) tmp.push_back(queue[i]);
+                ptrdiff_t n1 = tmp.size();
+
+                for(ptrdiff_t i = 0; i < nvis; ++i)
+                    if (level[queue[i]] > m) tmp.push_back(queue[i]);
+                ptrdiff_t n2 = tmp.size();
+
+                for(ptrdiff_t i = 0; i < nvis; ++i)
+                    if (level[queue[i]] == m) tmp.push_back(queue[i]);
+
+                std::copy(tmp.begin(), tmp.end(), order.begin() + beg);
+
+                parts.push_back(std::make_pair(beg, beg + n1));
+                parts.push_back(std::make_pair(beg + n1, beg + n2));
+            }
+
+            for(ptrdiff_t i = beg; i < end; ++i) level[order[i]] = -1;
+        }
+
+        for(ptrdiff_t i = 0; i < n; ++i) perm[i] = order[i];
+    }
+
+    private:
+        // Pattern of A + A^T without the diagonal.
+        template <class Matrix>
+        static void symmetrize(const Matrix &A,
+                std::vector<ptrdiff_t> &ptr, std::vector<ptrdiff_t> &col)
+        {
+            const ptrdiff_t n = backend::rows(A);
+
+            ptr.assign(n + 1, 0);
+            for(ptrdiff_t i = 0; i < n; ++i) {
+                for(auto a = backend::row_begin(A, i); a; ++a) {
+                    ptrdiff_t c = a.col();
+                    if (c == i) continue;
+                    ++ptr[i+1];
+                    ++ptr[c+1];
+                }
+            }
+
+            std::partial_sum(ptr.begin(), ptr.end(), ptr.begin());
+            col.resize(ptr[n]);
+
+            {
+                std::vector<ptrdiff_t> head(ptr.begin(), ptr.end() - 1);
+                for(ptrdiff_t i = 0; i < n; ++i) {
+                    for(auto a = backend::row_begin(A, i); a; ++a) {
+                        ptrdiff_t c = a.col();
+                        if (c == i) continue;
+                        col[head[i]++] = c;
+                        col[head[c]++] = i;
+                    }
+                }
+            }
+
+            // Remove the duplicates.
+            ptrdiff_t head = 0;
+            for(ptrdiff_t i = 0, beg = 0; i < n; ++i) {
+                ptrdiff_t end = ptr[i+1];
+                std::sort(col.begin() + beg, col.begin() + end);
+                ptrdiff_t row_beg = head;
+                for(ptrdiff_t j = beg; j < end; ++j)
+                    if (head == row_beg || col[head-1] != col[j])
+                        col[head++] = col[j];
+                beg = end;
+                ptr[i+1] = head;
+            }
+            col.resize(head);
+        }
+
+        // Breadth first search restricted to the vertices with the given tag.
+        // Returns the number of levels and the number of the visited vertices.
+        // The visited vertices are stored in the queue in the order of the
+        // traversal. The levels of the visited vertices should be reset by
+        // the caller before the next search.
+        static std::tuple<ptrdiff_t, ptrdiff_t> bfs(ptrdiff_t root, ptrdiff_t t,
+                const std::vector<ptrdiff_t> &ptr, const std::vector<ptrdiff_t> &col,
+                const std::vector<ptrdiff_t> &tag, std::vector<ptrdiff_t> &level,
+                std::vector<ptrdiff_t> &queue)
+        {
+            ptrdiff_t head = 0, tail = 0;
+
+            queue[tail++] = root;
+            level[root] = 0;
+
+            while(head < tail) {
+                ptrdiff_t v = queue[head++];
+                for(ptrdiff_t j = ptr[v]; j < ptr[v+1]; ++j) {
+                    ptrdiff_t u = col[j];
+                    if (tag[u] != t || level[u] >= 0) continue;
+                    level[u] = level[v] + 1;
+                    queue[tail++] = u;
+                }
+            }
+
+            return std::make_tuple(level[queue[tail-1]] + 1, tail);
+        }
+};
+
+} // namespace reorder
+} // namespace amgcl
+
+#endif
@@ -0,0 +1,141 @@
+#ifndef AMGCL_SOLVER_AUTO_LU_HPP
+#define AMGCL_SOLVER_AUTO_LU_HPP
+
+/*
+The MIT License
+
+Copyright (c) 2012-2021 Denis Demidov <dennis.demidov@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/**
+ * \file   amgcl/solver/auto_lu.hpp
+ * \author Denis Demidov <dennis.demidov@gmail.com>
+ * \brief  Direct solver that switches between sparse and dense factorizations.
+ */
+
+#include <memory>
+
+#ifndef AMGCL_NO_BOOST
+#  include <boost/property_tree/ptree.hpp>
+#endif
+
+#include <amgcl/backend/interface.hpp>
+#include <amgcl/value_type/interface.hpp>
+#include <amgcl/solver/skyline_lu.hpp>
+#include <amgcl/solver/dense_lu.hpp>
+#include <amgcl/util.hpp>
+
+namespace amgcl {
+namespace solver {
+
+/// Direct solver that chooses between sparse and dense factorizations.
+/**
+ * The dense solver is used when the share of the nonzero entries in the
+ * matrix exceeds the given density, and the sparse solver is used otherwise.
+ * The Galerkin operators tend to get denser with each level of the AMG
+ * hierarchy, and the dense solver is faster for the dense enough coarse
+ * levels, since it does not suffer from the fill-in and has a much higher
+ * arithmetic intensity.
+ */
+template <
+    typename ValueType,
+    class Sparse = skyline_lu<ValueType>,
+    class Dense  = dense_lu<ValueType>
+    >
+class auto_lu {
+    public:
+        typedef ValueType value_type;
+        typedef typename math::scalar_of<value_type>::type scalar_type;
+        typedef typename math::rhs_of<value_type>::type    rhs_type;
+
+        struct params {
+            /// Minimal share of the nonzero entries to use the dense solver.
+            float density;
+
+            /// Sparse solver parameters.
+            typename Sparse::params sparse;
+
+            /// Dense solver parameters.
+            typename Dense::params dense;
+
+            params() : density(0.1f) {}
+
+#ifndef AMGCL_NO_BOOST
+            params(const boost::property_tree::ptree &p)
+                : AMGCL_PARAMS_IMPORT_VALUE(p, density),
+                  AMGCL_PARAMS_IMPORT_CHILD(p, sparse),
+                  AMGCL_PARAMS_IMPORT_CHILD(p, dense)
+            {
+                check_params(p, {"density", "sparse", "dense"});
+            }
+
+            void get(boost::property_tree::ptree &p, const std::string &path) const {
+                AMGCL_PARAMS_EXPORT_VALUE(p, path, density);
+                AMGCL_PARAMS_EXPORT_CHILD(p, path, sparse);
+                AMGCL_PARAMS_EXPORT_CHILD(p, path, dense);
+            }
+#endif
+        };
+
+        static size_t coarse_enough() {
+            return Sparse::coarse_enough();
+        }
+
+        template <class Matrix>
+        auto_lu(const Matrix &A, const params &prm = params())
+        {
+            const ptrdiff_t n = backend::rows(A);
+
+            ptrdiff_t nnz = 0;
+            for(ptrdiff_t i = 0; i < n; ++i)
+                for(auto a = backend::row_begin(A, i); a; ++a) ++nnz;
+
+            if (nnz >= prm.density * n * n)
+                dense = std::make_shared<Dense>(A, prm.dense);
+            else
+                sparse = std::make_shared<Sparse>(A, prm.sparse);
+        }
+
+        /// Returns true if the dense solver is used.
+        bool is_dense() const {
+            return static_cast<bool>(dense);
+        }
+
+        template <class Vec1, class Vec2>
+        void operator()(const Vec1 &rhs, Vec2 &x) const {
+            if (dense)
+                (*dense)(rhs, x);
+            else
+                (*sparse)(rhs, x);
+        }
+
+        size_t bytes() const {
+            return dense ? backend::bytes(*dense) : backend::bytes(*sparse);
+        }
+    private:
+        std::shared_ptr<Sparse> sparse;
+        std::shared_ptr<Dense>  dense;
+};
+
+} // namespace solver
+} // namespace amgcl
+
+#endif
@@ -0,0 +1,250 @@
+#ifndef AMGCL_SOLVER_BLOCK_CG_HPP
+#define AMGCL_SOLVER_BLOCK_CG_HPP
+
+/*
+The MIT License
+
+Copyright (c) 2012-2021 Denis Demidov <dennis.demidov@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/**
+ * \file   amgcl/solver/block_cg.hpp
+ * \author Denis Demidov <dennis.demidov@gmail.com>
+ * \brief  Block Conjugate Gradient method for multiple right-hand sides.
+ */
+
+#include <tuple>
+#include <vector>
+#include <iostream>
+
+#include <amgcl/backend/interface.hpp>
+#include <amgcl/backend/multi_vector.hpp>
+#include <amgcl/solver/detail/default_inner_product.hpp>
+#include <amgcl/solver/detail/block_ops.hpp>
+#include <amgcl/util.hpp>
+
+namespace amgcl {
+namespace solver {
+
+/** Block Conjugate Gradients method.
+ * \rst
+ * Solves a symmetric positive definite system with several right-hand sides
+ * stored in a :cpp:class:`amgcl::backend::multi_vector`. The search space is
+ * shared by all of the right-hand sides [OLea80]_, so that each iteration
+ * uses the information gathered for all of the columns, and the
+ * preconditioner and the matrix are applied to the whole block at once. The
+ * search directions are orthonormalized, and the linearly dependent ones are
+ * dropped (the breakdown-free variant [JiLi17]_). The columns that have
+ * converged are removed from the block.
+ * \endrst
+ */
+template <
+    class Backend,
+    class InnerProduct = detail::default_inner_product
+    >
+class block_cg {
+    public:
+        typedef Backend backend_type;
+
+        typedef typename Backend::vector     vector;
+        typedef typename Backend::value_type value_type;
+        typedef typename Backend::params     backend_params;
+
+        typedef typename math::scalar_of<value_type>::type scalar_type;
+
+        /// Solver parameters.
+        struct params {
+            /// Maximum number of iterations.
+            size_t maxiter;
+
+            /// Target relative residual error (for each of the columns).
+            scalar_type tol;
+
+            /// Target absolute residual error (for each of the columns).
+            scalar_type abstol;
+
+            /// Verbose output (show iterations and error)
+            bool verbose;
+
+            params()
+                : maxiter(100), tol(1e-8),
+                  abstol(std::numeric_limits<scalar_type>::min()),
+                  verbose(false)
+            {}
+
+#ifndef AMGCL_NO_BOOST
+            params(const boost::property_tree::ptree &p)
+                : AMGCL_PARAMS_IMPORT_VALUE(p, maxiter),
+                  AMGCL_PARAMS_IMPORT_VALUE(p, tol),
+                  AMGCL_PARAMS_IMPORT_VALUE(p, abstol),
+                  AMGCL_PARAMS_IMPORT_VALUE(p, verbose)
+            {
+                check_params(p, {"maxiter", "tol", "abstol", "verbose"});
+            }
+
+            void get(boost::property_tree::ptree &p, const std::string &path) const {
+                AMGCL_PARAMS_EXPORT_VALUE(p, path, maxiter);
+                AMGCL_PARAMS_EXPORT_VALUE(p, path, tol);
+                AMGCL_PARAMS_EXPORT_VALUE(p, path, abstol);
+                AMGCL_PARAMS_EXPORT_VALUE(p, path, verbose);
+            }
+#endif
+        };
+
+        /// The work arrays depend on the number of right-hand sides and are
+        /// allocated for each solve.
+        block_cg(
+                size_t n,
+                const params &prm = params(),
+                const backend_params& = backend_params(),
+                const InnerProduct& = InnerProduct()
+          ) : prm(prm), n(n)
+        { }
+
+        /* Computes the solution for the given system matrix \p A and the
+         * right-hand sides \p rhs.  Returns the number of iterations made and
+         * the largest relative residual over the columns as a ``std::tuple``.
+         * The solution \p x provides initial approximation in input and holds
+         * the computed solution on output.
+         */
+        template <class Matrix, class Precond, class T>
+        std::tuple<size_t, scalar_type> operator()(
+                const Matrix &A, const Precond &P,
+                const backend::multi_vector<T> &rhs,
+                backend::multi_vector<T> &x
+                ) const
+        {
+            typedef backend::multi_vector<T> multi;
+
+            static const T one  = math::identity<T>();
+            static const T zero = math::zero<T>();
+
+            ios_saver ss(std::cout);
+
+            const size_t nrows = rhs.size();
+
+            detail::active_columns<T> act(rhs, x, prm.tol, prm.abstol);
+
+            // Solution and residual of the active columns.
+            multi X(nrows, rhs.cols(), false), R(nrows, rhs.cols(), false);
+            backend::copy(x, X);
+            backend::residual(rhs, A, x, R);
+            detail::keep_columns(X, act.columns());
+            detail::keep_columns(R, act.columns());
+
+            // Preconditioned residual, search directions, and their images.
+            multi Z, S, AS;
+            std::vector<T> StAS, alpha, beta, C;
+
+            size_t iter = 0;
+            while(true) {
+                std::vector<size_t> keep = act.check(R, X, x);
+                if (keep.size() < X.cols()) {
+                    detail::keep_columns(X, keep);
+                    detail::keep_columns(R, keep);
+                }
+
+                if (prm.verbose && iter % 5 == 0)
+                    std::cout << iter << "\t" << std::scientific
+                        << act.max_active_residual() << "\t" << act.size()
+                        << std::endl;
+
+                const size_t k = act.size();
+                if (!k || iter >= prm.maxiter) break;
+
+                if (Z.cols() != k) multi(nrows, k, false).swap(Z);
+                P.apply(R, Z);
+
+                // Make the new directions A-orthogonal to the previous ones.
+                if (iter) {
+                    backend::gram(AS, Z, beta);
+                    detail::cholesky_solve(S.cols(), StAS, k, beta);
+                    backend::mul_add(-one, S, beta, one, Z);
+                }
+
+                size_t s = detail::orth(Z, S, C);
+                if (!s) break;
+
+                if (AS.cols() != s) multi(nrows, s, false).swap(AS);
+                backend::spmv(one, A, S, zero, AS);
+
+                backend::gram(S, AS, StAS);
+                if (!detail::cholesky(s, StAS)) break;
+
+                backend::gram(S, R, alpha);
+                detail::cholesky_solve(s, StAS, k, alpha);
+
+                backend::mul_add( one, S,  alpha, one, X);
+                backend::mul_add(-one, AS, alpha, one, R);
+
+                ++iter;
+            }
+
+            act.finish(X, x);
+
+            return std::make_tuple(iter, act.max_residual());
+        }
+
+        /* Computes the solution for the given right-hand sides \p rhs. The
+         * system matrix is the same that was used for the setup of the
+         * preconditioner \p P.  Returns the number of iterations made and the
+         * largest relative residual as a ``std::tuple``. The solution \p x
+         * provides initial approximation in input and holds the computed
+         * solution on output.
+         */
+        template <class Precond, class T>
+        std::tuple<size_t, scalar_type> operator()(
+                const Precond &P,
+                const backend::multi_vector<T> &rhs,
+                backend::multi_vector<T> &x
+                ) const
+        {
+            return (*this)(P.system_matrix(), P, rhs, x);
+        }
+
+        size_t bytes() const {
+            return 0;
+        }
+
+        friend std::ostream& operator<<(std::ostream &os, const block_cg &s) {
+            return os
+                << "Type:             Block CG"
+                << "\nUnknowns:         " << s.n
+                << "\nMemory footprint: " << human_readable_memory(s.bytes())
+                << std::endl;
+        }
+    public:
+        params prm;
+
+    private:
+        size_t n;
+};
+
+namespace detail {
+
+template <class Backend, class InnerProduct>
+struct is_block_solver< block_cg<Backend, InnerProduct> > : std::true_type {};
+
+} // namespace detail
+} // namespace solver
+} // namespace amgcl
+
+#endif
@@ -0,0 +1,373 @@
+#ifndef AMGCL_SOLVER_BLOCK_GMRES_HPP
+#define AMGCL_SOLVER_BLOCK_GMRES_HPP
+
+/*
+The MIT License
+
+Copyright (c) 2012-2021 Denis Demidov <dennis.demidov@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/**
+ * \file   amgcl/solver/block_gmres.hpp
+ * \author Denis Demidov <dennis.demidov@gmail.com>
+ * \brief  Block GMRES method for multiple right-hand sides.
+ */
+
+#include <tuple>
+#include <vector>
+#include <memory>
+#include <iostream>
+
+#include <amgcl/backend/interface.hpp>
+#include <amgcl/backend/multi_vector.hpp>
+#include <amgcl/solver/detail/default_inner_product.hpp>
+#include <amgcl/solver/detail/givens_rotations.hpp>
+#include <amgcl/solver/detail/block_ops.hpp>
+#include <amgcl/util.hpp>
+
+namespace amgcl {
+namespace solver {
+
+/** Block GMRES method.
+ * \rst
+ * Restarted GMRES for several right-hand sides stored in a
+ * :cpp:class:`amgcl::backend::multi_vector` [Saad03]_. The right-hand sides
+ * share the block Krylov subspace, and each step of the block Arnoldi process
+ * applies the preconditioner and the matrix to the whole block. The basis
+ * blocks are orthonormalized with the Cholesky QR, and the linearly dependent
+ * directions are dropped. The columns that have converged are removed from the
+ * block on restart. The preconditioning is applied on the right.
+ * \endrst
+ */
+template <
+    class Backend,
+    class InnerProduct = detail::default_inner_product
+    >
+class block_gmres {
+    public:
+        typedef Backend backend_type;
+
+        typedef typename Backend::vector     vector;
+        typedef typename Backend::value_type value_type;
+        typedef typename Backend::params     backend_params;
+
+        typedef typename math::scalar_of<value_type>::type scalar_type;
+
+        /// Solver parameters.
+        struct params {
+            /// Number of block iterations before restart.
+            /**
+             * The Krylov basis holds up to (M + 1) * k vectors for k
+             * right-hand sides.
+             */
+            unsigned M;
+
+            /// Maximum number of iterations.
+            unsigned maxiter;
+
+            /// Target relative residual error (for each of the columns).
+            scalar_type tol;
+
+            /// Target absolute residual error (for each of the columns).
+            scalar_type abstol;
+
+            /// Verbose output (show iterations and error)
+            bool verbose;
+
+            params()
+                : M(30), maxiter(100), tol(1e-8),
+                  abstol(std::numeric_limits<scalar_type>::min()),
+                  verbose(false)
+            { }
+
+#ifndef AMGCL_NO_BOOST
+            params(const boost::property_tree::ptree &p)
+                : AMGCL_PARAMS_IMPORT_VALUE(p, M),
+                  AMGCL_PARAMS_IMPORT_VALUE(p, maxiter),
+                  AMGCL_PARAMS_IMPORT_VALUE(p, tol),
+                  AMGCL_PARAMS_IMPORT_VALUE(p, abstol),
+                  AMGCL_PARAMS_IMPORT_VALUE(p, verbose)
+            {
+                check_params(p, {"M", "maxiter", "tol", "abstol", "verbose"});
+            }
+
+            void get(boost::property_tree::ptree &p, const std::string &path) const {
+                AMGCL_PARAMS_EXPORT_VALUE(p, path, M);
+                AMGCL_PARAMS_EXPORT_VALUE(p, path, maxiter);
+                AMGCL_PARAMS_EXPORT_VALUE(p, path, tol);
+                AMGCL_PARAMS_EXPORT_VALUE(p, path, abstol);
+                AMGCL_PARAMS_EXPORT_VALUE(p, path, verbose);
+            }
+#endif
+        };
+
+        /// The work arrays depend on the number of right-hand sides and are
+        /// allocated for each solve.
+        block_gmres(
+                size_t n,
+                const params &prm = params(),
+                const backend_params& = backend_params(),
+                const InnerProduct& = InnerProduct()
+             ) : prm(prm), n(n)
+        { }
+
+        /* Computes the solution for the given system matrix \p A and the
+         * right-hand sides \p rhs.  Returns the number of iterations made and
+         * the largest relative residual over the columns as a ``std::tuple``.
+         * The solution \p x provides initial approximation in input and holds
+         * the computed solution on output.
+         */
+        template <class Matrix, class Precond, class T>
+        std::tuple<size_t, scalar_type> operator()(
+                const Matrix &A, const Precond &P,
+                const backend::multi_vector<T> &rhs,
+                backend::multi_vector<T> &x
+                ) const
+        {
+            typedef backend::multi_vector<T> multi;
+
+            static const T one  = math::identity<T>();
+            static const T zero = math::zero<T>();
+
+            ios_saver ss(std::cout);
+
+            const size_t nrows = rhs.size();
+
+            detail::active_columns<T> act(rhs, x, prm.tol, prm.abstol);
+
+            // Right-hand sides and solution of the active columns.
+            multi B(nrows, rhs.cols(), false), X(nrows, rhs.cols(), false), R;
+            backend::copy(rhs, B);
+            backend::copy(x,   X);
+            detail::keep_columns(B, act.columns());
+            detail::keep_columns(X, act.columns());
+
+            // Basis blocks and their offsets in the Hessenberg matrix. The
+            // blocks are reused between the restarts.
+            std::vector< std::shared_ptr<multi> > V;
+            std::vector<size_t> off;
+            multi Z, W, U;
+
+            // Block Hessenberg matrix (column-major), the transformed
+            // right-hand side of the least squares problem (row-major), and
+            // the Givens rotations.
+            std::vector<T> H, G, C, Hij, cs, sn;
+            std::vector<size_t> rot;
+
+            size_t iter = 0;
+            while(true) {
+                const size_t k0 = X.cols();
+                if (R.cols() != k0) multi(nrows, k0, false).swap(R);
+                backend::residual(B, A, X, R);
+
+                std::vector<size_t> keep = act.check(R, X, x);
+                if (keep.size() < k0) {
+                    detail::keep_columns(B, keep);
+                    detail::keep_columns(X, keep);
+                    detail::keep_columns(R, keep);
+                }
+
+                const size_t k = act.size();
+                if (!k || iter >= prm.maxiter) break;
+
+                // -- Block Arnoldi process
+                off.clear();
+                rot.clear();
+                cs.clear();
+                sn.clear();
+
+                const size_t rows = (prm.M + 1) * k;
+                const size_t cols = prm.M * k;
+
+                H.assign(rows * cols, zero);
+                G.assign(rows * k,    zero);
+
+                if (V.empty()) V.push_back(std::make_shared<multi>());
+                size_t nb = detail::orth(R, *V[0], C);
+                if (!nb) break;
+
+                std::copy(C.begin(), C.end(), G.begin());
+                off.push_back(0);
+
+                size_t ncols = 0;
+                for(unsigned j = 0; j < prm.M && iter < prm.maxiter; ) {
+                    const multi &Vj = *V[j];
+                    const size_t w = Vj.cols();
+
+                    if (Z.cols() != w) multi(nrows, w, false).swap(Z);
+                    if (W.cols() != w) multi(nrows, w, false).swap(W);
+
+                    P.apply(Vj, Z);
+                    backend::spmv(one, A, Z, zero, W);
+
+                    std::vector<T> wn;
+                    backend::column_inner_products(W, W, wn);
+                    T wmax = zero;
+                    for(T v : wn) wmax = std::max(wmax, std::sqrt(v));
+
+                    for(unsigned i = 0; i <= j; ++i) {
+                        const multi &Vi = *V[i];
+                        const size_t wi = Vi.cols();
+
+                        backend::gram(Vi, W, Hij);
+                        backend::mul_add(-one, Vi, Hij, one, W);
+
+                        for(size_t a = 0; a < wi; ++a)
+                            for(size_t b = 0; b < w; ++b)
+                                H[(off[j] + b) * rows + off[i] + a] = Hij[a * w + b];
+                    }
+
+                    if (V.size() <= j + 1) V.push_back(std::make_shared<multi>());
+                    size_t s = detail::orth(W, *V[j+1], C,
+                            1e3 * std::numeric_limits<T>::epsilon() * wmax);
+
+                    for(size_t a = 0; a < s; ++a)
+                        for(size_t b = 0; b < w; ++b)
+                            H[(off[j] + b) * rows + nb + a] = C[a * w + b];
+
+                    // Reduce the new columns of H to the upper triangular
+                    // form, and apply the same rotations to G.
+                    const size_t last = nb + s;
+                    for(size_t b = 0; b < w; ++b) {
+                        const size_t q = off[j] + b;
+                        T *h = &H[q * rows];
+
+                        for(size_t r = 0; r < rot.size(); ++r)
+                            detail::apply_plane_rotation(h[rot[r]], h[rot[r]+1], cs[r], sn[r]);
+
+                        for(size_t i = last; --i > q; ) {
+                            T c, t;
+                            detail::generate_plane_rotation(h[i-1], h[i], c, t);
+                            detail::apply_plane_rotation(h[i-1], h[i], c, t);
+                            for(size_t l = 0; l < k; ++l)
+                                detail::apply_plane_rotation(G[(i-1) * k + l], G[i * k + l], c, t);
+
+                            rot.push_back(i-1);
+                            cs.push_back(c);
+                            sn.push_back(t);
+                        }
+                    }
+
+                    ncols = off[j] + w;
+                    ++j, ++iter;
+
+                    // The residual estimates for the columns.
+                    bool done = true;
+                    T max_res = zero;
+                    for(size_t l = 0; l < k; ++l) {
+                        T r = zero;
+                        for(size_t i = ncols; i < last; ++i)
+                            r += G[i * k + l] * G[i * k + l];
+                        r = std::sqrt(r);
+
+                        const size_t c = act.columns()[l];
+                        if (r > act.tolerance(c)) done = false;
+                        max_res = std::max(max_res, r / act.rhs_norm(c));
+                    }
+
+                    if (prm.verbose && iter % 5 == 0)
+                        std::cout << iter << "\t" << std::scientific
+                            << max_res << "\t" << k << std::endl;
+
+                    // No new directions: the Krylov space is exhausted.
+                    if (!s) break;
+
+                    off.push_back(nb);
+                    nb = last;
+
+                    if (done) break;
+                }
+
+                // -- Solve the upper triangular system H Y = G (in-place).
+                for(size_t i = ncols; i-- > 0; ) {
+                    T d = H[i * rows + i];
+                    for(size_t l = 0; l < k; ++l) {
+                        T v = G[i * k + l];
+                        for(size_t q = i + 1; q < ncols; ++q)
+                            v -= H[q * rows + i] * G[q * k + l];
+                        G[i * k + l] = math::is_zero(d) ? zero : v / d;
+                    }
+                }
+
+                // -- Update the solution: X += M V Y
+                if (U.cols() != k) multi(nrows, k, false).swap(U);
+                if (Z.cols() != k) multi(nrows, k, false).swap(Z);
+
+                for(size_t i = 0; i < off.size() && off[i] < ncols; ++i) {
+                    const size_t wi = V[i]->cols();
+                    std::vector<T> Y(G.begin() + off[i] * k, G.begin() + (off[i] + wi) * k);
+                    backend::mul_add(one, *V[i], Y, i ? one : zero, U);
+                }
+
+                P.apply(U, Z);
+                backend::axpby(one, Z, one, X);
+            }
+
+            act.finish(X, x);
+
+            return std::make_tuple(iter, act.max_residual());
+        }
+
+        /* Computes the solution for the given right-hand sides \p rhs. The
+         * system matrix is the same that was used for the setup of the
+         * preconditioner \p P.  Returns the number of iterations made and the
+         * largest relative residual as a ``std::tuple``. The solution \p x
+         * provides initial approximation in input and holds the computed
+         * solution on output.
+         */
+        template <class Precond, class T>
+        std::tuple<size_t, scalar_type> operator()(
+                const Precond &P,
+                const backend::multi_vector<T> &rhs,
+                backend::multi_vector<T> &x
+                ) const
+        {
+            return (*this)(P.system_matrix(), P, rhs, x);
+        }
+
+        size_t bytes() const {
+            return 0;
+        }
+
+        friend std::ostream& operator<<(std::ostream &os, const block_gmres &s) {
+            return os
+                << "Type:             Block GMRES(" << s.prm.M << ")"
+                << "\nUnknowns:         " << s.n
+                << "\nMemory footprint: " << human_readable_memory(s.bytes())
+                << std::endl;
+        }
+    public:
+        params prm;
+
+    private:
+        size_t n;
+};
+
+namespace detail {
+
+template <class Backend, class InnerProduct>
+struct is_block_solver< block_gmres<Backend, InnerProduct> > : std::true_type {};
+
+} // namespace detail
+} // namespace solver
+} // namespace amgcl
+
+#endif
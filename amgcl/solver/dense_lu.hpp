@@ -0,0 +1,339 @@
+#ifndef AMGCL_SOLVER_DENSE_LU_HPP
+#define AMGCL_SOLVER_DENSE_LU_HPP
+
+/*
+The MIT License
+
+Copyright (c) 2012-2021 Denis Demidov <dennis.demidov@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/**
+ * \file   amgcl/solver/dense_lu.hpp
+ * \author Denis Demidov <dennis.demidov@gmail.com>
+ * \brief  Dense LU factorization solver.
+ */
+
+#include <vector>
+#include <algorithm>
+#include <memory>
+
+#ifndef AMGCL_NO_BOOST
+#  include <boost/property_tree/ptree.hpp>
+#endif
+
+#include <amgcl/backend/interface.hpp>
+#include <amgcl/value_type/interface.hpp>
+#include <amgcl/io/binary.hpp>
+#include <amgcl/util.hpp>
+
+namespace amgcl {
+namespace solver {
+
+/// Direct solver that uses dense LU factorization.
+/**
+ * The matrix is converted to the dense format and factorized with the
+ * blocked right-looking LU algorithm with partial pivoting. The updates of
+ * the trailing submatrix, which take most of the time, are done in parallel.
+ * By default, the explicit inverse of the matrix is computed from the
+ * factors, so that the solution is a single dense matrix-vector product,
+ * which is branch-free, vectorizable, and is parallelized over the rows of
+ * the matrix. This is usually much faster than sparse triangular solves for
+ * small coarse systems with relatively dense Galerkin operators.
+ */
+template <typename ValueType>
+class dense_lu {
+    public:
+        typedef ValueType value_type;
+        typedef typename math::scalar_of<value_type>::type scalar_type;
+        typedef typename math::rhs_of<value_type>::type    rhs_type;
+
+        struct params {
+            /// Compute the explicit inverse of the matrix.
+            /**
+             * The solution is then a dense matrix-vector product.
+             * Otherwise, the forward and backward substitutions with the
+             * LU factors are used.
+             */
+            bool inverse;
+
+            params() : inverse(true) {}
+
+#ifndef AMGCL_NO_BOOST
+            params(const boost::property_tree::ptree &p)
+                : AMGCL_PARAMS_IMPORT_VALUE(p, inverse)
+            {
+                check_params(p, {"inverse"});
+            }
+
+            void get(boost::property_tree::ptree &p, const std::string &path) const {
+                AMGCL_PARAMS_EXPORT_VALUE(p, path, inverse);
+            }
+#endif
+        } prm;
+
+        static size_t coarse_enough() {
+            return 2000 / math::static_rows<value_type>::value;
+        }
+
+        template <class Matrix>
+        dense_lu(const Matrix &A, const params &prm = params())
+            : prm(prm), n(backend::rows(A)), perm(n), D(n),
+              M(static_cast<size_t>(n) * n, math::zero<value_type>())
+        {
+            for(ptrdiff_t i = 0; i < n; ++i) {
+                perm[i] = i;
+                for(auto a = backend::row_begin(A, i); a; ++a)
+                    M[i * n + a.col()] += a.value();
+            }
+
+            factorize();
+            if (prm.inverse) invert();
+        }
+
+        template <class Vec1, class Vec2>
+        void operator()(const Vec1 &rhs, Vec2 &x) const {
+            if (prm.inverse) {
+#pragma omp parallel for
+                for(ptrdiff_t i = 0; i < n; ++i) {
+                    const value_type *m = &M[i * n];
+                    rhs_type s = math::zero<rhs_type>();
+                    for(ptrdiff_t j = 0; j < n; ++j)
+                        s += m[j] * rhs[j];
+                    x[i] = s;
+                }
+            } else {
+                // The temporary vector is allocated for each call, so that
+                // the solver may be used from several threads at once.
+                std::vector<rhs_type> y(n);
+
+                for(ptrdiff_t i = 0; i < n; ++i) {
+                    const value_type *m = &M[i * n];
+                    rhs_type s = rhs[perm[i]];
+                    for(ptrdiff_t j = 0; j < i; ++j)
+                        s -= m[j] * y[j];
+                    y[i] = s;
+                }
+
+                for(ptrdiff_t i = n; i --> 0; ) {
+                    const value_type *m = &M[i * n];
+                    rhs_type s = y[i];
+                    for(ptrdiff_t j = i + 1; j < n; ++j)
+                        s -= m[j] * y[j];
+                    y[i] = D[i] * s;
+                }
+
+                for(ptrdiff_t i = 0; i < n; ++i) x[i] = y[i];
+            }
+        }
+
+        size_t bytes() const {
+            return
+                backend::bytes(perm) +
+                backend::bytes(D) +
+                backend::bytes(M);
+        }
+
+        /// Saves the factorization (or the inverse) to a binary stream.
+        void save(std::ostream &f) const {
+            const std::uint64_t size[2] = {
+                static_cast<std::uint64_t>(n),
+                static_cast<std::uint64_t>(prm.inverse)
+            };
+
+            precondition(
+                    f.write(signature(), 8) &&
+                    io::detail::write_array(f, size, 2) &&
+                    io::detail::write_array(f, perm.data(), n) &&
+                    io::detail::write_array(f, D.data(), n) &&
+                    io::detail::write_array(f, M.data(), M.size()),
+                    "File I/O error");
+        }
+
+        /// Loads the factorization saved with save().
+        /**
+         * Returns an empty pointer if the stream does not contain the
+         * dense_lu factorization.
+         */
+        static std::shared_ptr<dense_lu> load(std::istream &f) {
+            char sig[8];
+            if (!f.read(sig, 8) || !std::equal(sig, sig + 8, signature()))
+                return std::shared_ptr<dense_lu>();
+
+            std::uint64_t size[2];
+            precondition(io::detail::read_array(f, size, 2), "File I/O error");
+
+            std::shared_ptr<dense_lu> s(new dense_lu());
+            s->prm.inverse = size[1] != 0;
+            s->n = size[0];
+            s->perm.resize(s->n);
+            s->D.resize(s->n);
+            s->M.resize(static_cast<size_t>(s->n) * s->n);
+
+            precondition(
+                    io::detail::read_array(f, s->perm.data(), s->n) &&
+                    io::detail::read_array(f, s->D.data(), s->n) &&
+                    io::detail::read_array(f, s->M.data(), s->M.size()),
+                    "File I/O error");
+
+            return s;
+        }
+    private:
+        dense_lu() {}
+
+        static const char* signature() {
+            return "DENSELU1";
+        }
+
+        // Width of the panels in the blocked factorization, and of the
+        // column tiles in the updates.
+        static const ptrdiff_t nb = 64;
+        static const ptrdiff_t tile = 256;
+
+        ptrdiff_t n;
+        std::vector<ptrdiff_t>  perm; // perm[i] is the original row of the i-th row of M.
+        std::vector<value_type> D;    // Inverted diagonal of U.
+        std::vector<value_type> M;    // LU factors or the inverse, row-major.
+
+        void factorize() {
+            for(ptrdiff_t k0 = 0; k0 < n; k0 += nb) {
+                ptrdiff_t k1 = std::min(n, k0 + nb);
+
+                // Factorize the panel M[k0:n, k0:k1].
+                for(ptrdiff_t k = k0; k < k1; ++k) {
+                    ptrdiff_t   p = k;
+                    scalar_type v = math::norm(M[k * n + k]);
+                    for(ptrdiff_t i = k + 1; i < n; ++i) {
+                        scalar_type w = math::norm(M[i * n + k]);
+                        if (w > v) { v = w; p = i; }
+                    }
+
+                    precondition(!math::is_zero(M[p * n + k]),
+                            "Zero pivot in dense_lu");
+
+                    if (p != k) {
+                        std::swap_ranges(&M[k * n], &M[k * n] + n, &M[p * n]);
+                        std::swap(perm[k], perm[p]);
+                    }
+
+                    value_type d = math::inverse(M[k * n + k]);
+                    D[k] = d;
+
+                    const value_type *u = &M[k * n];
+
+#pragma omp parallel for if(n - k > 256)
+                    for(ptrdiff_t i = k + 1; i < n; ++i) {
+                        value_type *m = &M[i * n];
+                        value_type  l = m[k] * d;
+                        m[k] = l;
+                        for(ptrdiff_t j = k + 1; j < k1; ++j)
+                            m[j] -= l * u[j];
+                    }
+                }
+
+                if (k1 == n) break;
+
+                // U12 = L11^-1 A12
+#pragma omp parallel for
+                for(ptrdiff_t j0 = k1; j0 < n; j0 += tile) {
+                    ptrdiff_t j1 = std::min(n, j0 + tile);
+                    for(ptrdiff_t k = k0 + 1; k < k1; ++k) {
+                        value_type *m = &M[k * n];
+                        for(ptrdiff_t kk = k0; kk < k; ++kk) {
+                            value_type l = m[kk];
+                            const value_type *u = &M[kk * n];
+                            for(ptrdiff_t j = j0; j < j1; ++j)
+                                m[j] -= l * u[j];
+                        }
+                    }
+                }
+
+                // A22 -= L21 U12
+#pragma omp parallel for
+                for(ptrdiff_t i = k1; i < n; ++i) {
+                    value_type *m = &M[i * n];
+                    for(ptrdiff_t j0 = k1; j0 < n; j0 += tile) {
+                        ptrdiff_t j1 = std::min(n, j0 + tile);
+                        for(ptrdiff_t k = k0; k < k1; ++k) {
+                            value_type l = m[k];
+                            const value_type *u = &M[k * n];
+                            for(ptrdiff_t j = j0; j < j1; ++j)
+                                m[j] -= l * u[j];
+                        }
+                    }
+                }
+            }
+        }
+
+        // Replaces the factors with the inverse of the matrix. The columns of
+        // the permuted identity are processed in tiles, in the order of the
+        // rows of the factors, so that the forward substitution for a tile
+        // starts at the first nonzero row.
+        void invert() {
+            std::vector<value_type> X(M.size(), math::zero<value_type>());
+
+#pragma omp parallel for schedule(dynamic, 1)
+            for(ptrdiff_t q0 = 0; q0 < n; q0 += tile) {
+                ptrdiff_t q1 = std::min(n, q0 + tile);
+
+                for(ptrdiff_t q = q0; q < q1; ++q)
+                    X[q * n + q] = math::identity<value_type>();
+
+                for(ptrdiff_t i = q0 + 1; i < n; ++i) {
+                    value_type *x = &X[i * n];
+                    const value_type *m = &M[i * n];
+                    for(ptrdiff_t j = q0; j < i; ++j) {
+                        value_type l = m[j];
+                        const value_type *y = &X[j * n];
+                        for(ptrdiff_t q = q0, qe = std::min(q1, j + 1); q < qe; ++q)
+                            x[q] -= l * y[q];
+                    }
+                }
+
+                for(ptrdiff_t i = n; i --> 0; ) {
+                    value_type *x = &X[i * n];
+                    const value_type *m = &M[i * n];
+                    for(ptrdiff_t j = i + 1; j < n; ++j) {
+                        value_type u = m[j];
+                        const value_type *y = &X[j * n];
+                        for(ptrdiff_t q = q0; q < q1; ++q)
+                            x[q] -= u * y[q];
+                    }
+                    for(ptrdiff_t q = q0; q < q1; ++q)
+                        x[q] = D[i] * x[q];
+                }
+            }
+
+            // Undo the row permutation: the q-th column of X is the
+            // perm[q]-th column of the inverse.
+#pragma omp parallel for
+            for(ptrdiff_t i = 0; i < n; ++i) {
+                value_type *m = &M[i * n];
+                const value_type *x = &X[i * n];
+                for(ptrdiff_t q = 0; q < n; ++q)
+                    m[perm[q]] = x[q];
+            }
+        }
+};
+
+} // namespace solver
+} // namespace amgcl
+
+#endif
@@ -0,0 +1,359 @@
+#ifndef AMGCL_SOLVER_DETAIL_BLOCK_OPS_HPP
+#define AMGCL_SOLVER_DETAIL_BLOCK_OPS_HPP
+
+/*
+The MIT License
+
+Copyright (c) 2012-2021 Denis Demidov <dennis.demidov@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/**
+ * \file   amgcl/solver/detail/block_ops.hpp
+ * \author Denis Demidov <dennis.demidov@gmail.com>
+ * \brief  Small dense operations used in the block Krylov solvers.
+ */
+
+#include <vector>
+#include <algorithm>
+#include <limits>
+#include <cmath>
+#include <type_traits>
+
+#include <amgcl/backend/multi_vector.hpp>
+#include <amgcl/util.hpp>
+#include <amgcl/value_type/interface.hpp>
+
+namespace amgcl {
+namespace solver {
+namespace detail {
+
+// Block solvers work with multi-vectors instead of single vectors.
+template <class Solver>
+struct is_block_solver : std::false_type {};
+
+// Keeps only the given columns of the multi-vector.
+template <class T>
+void keep_columns(backend::multi_vector<T> &X, const std::vector<size_t> &cols) {
+    const size_t m = cols.size();
+
+    std::vector<size_t> pos(m);
+    for(size_t j = 0; j < m; ++j) pos[j] = j;
+
+    backend::multi_vector<T> Y(X.size(), m, false);
+    backend::copy_columns(X, cols, Y, pos);
+    X.swap(Y);
+}
+
+// Tracks the columns of a block system that have not converged yet.
+// Converged columns are dropped from the active set (and from the work
+// arrays of the solver), so that the solver only spends time on the columns
+// that still need it.
+template <class T>
+class active_columns {
+    public:
+        // The columns of x with (numerically) zero right-hand sides are set
+        // to zero and are excluded from the active set.
+        active_columns(const backend::multi_vector<T> &rhs,
+                backend::multi_vector<T> &x, T tol, T abstol)
+            : norm_rhs(rhs.cols()), eps(rhs.cols()),
+              res(rhs.cols(), math::zero<T>())
+        {
+            const ptrdiff_t n = rhs.size();
+            const size_t    m = rhs.cols();
+
+            backend::column_inner_products(rhs, rhs, norm_rhs);
+
+            std::vector<size_t> zero;
+            for(size_t j = 0; j < m; ++j) {
+                norm_rhs[j] = std::sqrt(norm_rhs[j]);
+                eps[j] = std::max(tol * norm_rhs[j], abstol);
+
+                if (norm_rhs[j] < amgcl::detail::eps<T>(1))
+                    zero.push_back(j);
+                else
+                    idx.push_back(j);
+            }
+
+            if (!zero.empty()) {
+#pragma omp parallel for
+                for(ptrdiff_t i = 0; i < n; ++i)
+                    for(size_t j : zero) x(i, j) = math::zero<T>();
+            }
+        }
+
+        // Number of active columns.
+        size_t size() const {
+            return idx.size();
+        }
+
+        // Original numbers of the active columns.
+        const std::vector<size_t>& columns() const {
+            return idx;
+        }
+
+        // Norm of the j-th right-hand side.
+        T rhs_norm(size_t j) const {
+            return norm_rhs[j];
+        }
+
+        // Target residual norm for the j-th column.
+        T tolerance(size_t j) const {
+            return eps[j];
+        }
+
+        // Updates the residuals of the active columns given the residual
+        // block R. The converged columns of the active solution X are copied
+        // to x and are excluded from the active set. Returns the positions of
+        // the remaining columns in X and R.
+        std::vector<size_t> check(const backend::multi_vector<T> &R,
+                const backend::multi_vector<T> &X, backend::multi_vector<T> &x)
+        {
+            std::vector<T> nr;
+            backend::column_inner_products(R, R, nr);
+
+            std::vector<size_t> keep, done_pos, done_idx;
+            for(size_t j = 0; j < idx.size(); ++j) {
+                T r = std::sqrt(nr[j]);
+                res[idx[j]] = r / norm_rhs[idx[j]];
+
+                if (r > eps[idx[j]]) {
+                    keep.push_back(j);
+                } else {
+                    done_pos.push_back(j);
+                    done_idx.push_back(idx[j]);
+                }
+            }
+
+            if (!done_pos.empty()) {
+                backend::copy_columns(X, done_pos, x, done_idx);
+
+                std::vector<size_t> active;
+                for(size_t j : keep) active.push_back(idx[j]);
+                idx.swap(active);
+            }
+
+            return keep;
+        }
+
+        // Copies the remaining active columns of X to x.
+        void finish(const backend::multi_vector<T> &X, backend::multi_vector<T> &x) const {
+            std::vector<size_t> pos(idx.size());
+            for(size_t j = 0; j < pos.size(); ++j) pos[j] = j;
+            backend::copy_columns(X, pos, x, idx);
+        }
+
+        // The largest relative residual over all columns.
+        T max_residual() const {
+            T r = math::zero<T>();
+            for(T v : res) r = std::max(r, v);
+            return r;
+        }
+
+        // The largest relative residual over the active columns.
+        T max_active_residual() const {
+            T r = math::zero<T>();
+            for(size_t j : idx) r = std::max(r, res[j]);
+            return r;
+        }
+    private:
+        std::vector<size_t> idx;
+        std::vector<T> norm_rhs, eps, res;
+};
+
+// Single pass of the Cholesky QR with column pivoting.
+// See the description of orth() below.
+template <class T>
+size_t orth_pass(const backend::multi_vector<T> &W,
+        backend::multi_vector<T> &Q, std::vector<T> &C, T zero_norm, T &min_pivot)
+{
+    // Drop the directions that are more than this close to the span of the
+    // already selected ones (the squared sine of the angle). This keeps the
+    // condition number of the accepted columns well below the limit where
+    // the second pass of CholQR is able to restore the orthogonality.
+    const T tau = 1e3 * std::numeric_limits<T>::epsilon();
+
+    const size_t n = W.size();
+    const size_t k = W.cols();
+
+    std::vector<T> G;
+    backend::gram(W, W, G);
+
+    // Normalize the columns, so that the rank decision is scale-invariant.
+    std::vector<T>    d(k);
+    std::vector<char> done(k);
+    for(size_t c = 0; c < k; ++c) {
+        d[c]    = std::sqrt(std::max(G[c * k + c], math::zero<T>()));
+        done[c] = !(d[c] > zero_norm);
+    }
+
+    // Pivoted Cholesky decomposition of the normalized Gram matrix.
+    std::vector<T> L(k * k, math::zero<T>()), diag(k, math::identity<T>());
+    std::vector<size_t> sel;
+    min_pivot = math::identity<T>();
+
+    for(size_t t = 0; t < k; ++t) {
+        size_t p = k;
+        T best = tau;
+        for(size_t c = 0; c < k; ++c)
+            if (!done[c] && diag[c] > best) { p = c; best = diag[c]; }
+        if (p == k) break;
+
+        min_pivot = std::min(min_pivot, best);
+
+        T lpp = std::sqrt(diag[p]);
+        L[p * k + t] = lpp;
+        done[p] = true;
+        sel.push_back(p);
+
+        for(size_t c = 0; c < k; ++c) {
+            if (done[c]) continue;
+            T v = G[c * k + p] / (d[c] * d[p]);
+            for(size_t u = 0; u < t; ++u) v -= L[c * k + u] * L[p * k + u];
+            v /= lpp;
+            L[c * k + t] = v;
+            diag[c] -= v * v;
+        }
+    }
+
+    const size_t s = sel.size();
+
+    // The selected columns are W_s = Q R, where R is upper triangular with
+    // R(a,b) = L(sel[b],a). Q = W M, where M is the scaled inverse of R.
+    std::vector<T> Ri(s * s, math::zero<T>());
+    for(size_t b = 0; b < s; ++b) {
+        Ri[b * s + b] = math::inverse(L[sel[b] * k + b]);
+        for(size_t a = b; a-- > 0; ) {
+            T v = math::zero<T>();
+            for(size_t j = a + 1; j <= b; ++j)
+                v += L[sel[j] * k + a] * Ri[j * s + b];
+            Ri[a * s + b] = -v / L[sel[a] * k + a];
+        }
+    }
+
+    std::vector<T> M(k * s, math::zero<T>());
+    for(size_t a = 0; a < s; ++a)
+        for(size_t b = a; b < s; ++b)
+            M[sel[a] * s + b] = Ri[a * s + b] / d[sel[a]];
+
+    // Q may refer to W, in which case the update is done in-place when
+    // no columns are dropped (mul_add processes the rows one at a time).
+    if (&Q == &W ? s != k : Q.size() != n || Q.cols() != s) {
+        backend::multi_vector<T> Y(n, s, false);
+        if (s) backend::mul_add(math::identity<T>(), W, M, math::zero<T>(), Y);
+        Q.swap(Y);
+    } else if (s) {
+        backend::mul_add(math::identity<T>(), W, M, math::zero<T>(), Q);
+    }
+
+    C.assign(s * k, math::zero<T>());
+    for(size_t t = 0; t < s; ++t)
+        for(size_t c = 0; c < k; ++c)
+            C[t * k + c] = L[c * k + t] * d[c];
+
+    return s;
+}
+
+// Orthonormalizes the columns of W.
+// On output, Q holds s <= W.cols() orthonormal columns, and W = Q C, where C
+// is the s by W.cols() matrix in row-major order. The columns with norms
+// below zero_norm and the numerically dependent directions are dropped.
+// The method is the Cholesky QR. The loss of orthogonality after a single
+// pass is about eps / p, where p is the smallest pivot (the squared sine of
+// the angle between a column and the span of the previous ones), so the
+// second pass (CholQR2) is only done for nearly dependent columns.
+template <class T>
+size_t orth(const backend::multi_vector<T> &W,
+        backend::multi_vector<T> &Q, std::vector<T> &C, T zero_norm = T())
+{
+    static const T reorth = std::pow(std::numeric_limits<T>::epsilon(), T(0.25));
+
+    std::vector<T> C1, C2;
+    T min_pivot;
+
+    size_t s1 = orth_pass(W, Q, C1, zero_norm, min_pivot);
+    if (!s1 || min_pivot > reorth) {
+        C.swap(C1);
+        return s1;
+    }
+
+    size_t s = orth_pass(Q, Q, C2, math::zero<T>(), min_pivot);
+
+    // C = C2 * C1
+    const size_t k = W.cols();
+    C.assign(s * k, math::zero<T>());
+    for(size_t i = 0; i < s; ++i)
+        for(size_t j = 0; j < s1; ++j) {
+            T v = C2[i * s1 + j];
+            for(size_t c = 0; c < k; ++c)
+                C[i * k + c] += v * C1[j * k + c];
+        }
+
+    return s;
+}
+
+// In-place Cholesky decomposition of the s by s SPD matrix A = L L^T (only
+// the lower triangle of A is referenced). Returns false when A is not
+// positive definite.
+template <class T>
+bool cholesky(size_t s, std::vector<T> &A) {
+    for(size_t j = 0; j < s; ++j) {
+        T d = A[j * s + j];
+        for(size_t u = 0; u < j; ++u) d -= A[j * s + u] * A[j * s + u];
+        if (!(d > 0)) return false;
+        d = std::sqrt(d);
+        A[j * s + j] = d;
+
+        for(size_t i = j + 1; i < s; ++i) {
+            T v = A[i * s + j];
+            for(size_t u = 0; u < j; ++u) v -= A[i * s + u] * A[j * s + u];
+            A[i * s + j] = v / d;
+        }
+    }
+    return true;
+}
+
+// Solves L L^T X = B for the s by k matrix B in-place.
+template <class T>
+void cholesky_solve(size_t s, const std::vector<T> &L, size_t k, std::vector<T> &B) {
+    for(size_t i = 0; i < s; ++i) {
+        for(size_t u = 0; u < i; ++u) {
+            T l = L[i * s + u];
+            for(size_t c = 0; c < k; ++c) B[i * k + c] -= l * B[u * k + c];
+        }
+        T d = math::inverse(L[i * s + i]);
+        for(size_t c = 0; c < k; ++c) B[i * k + c] *= d;
+    }
+
+    for(size_t i = s; i-- > 0; ) {
+        for(size_t u = i + 1; u < s; ++u) {
+            T l = L[u * s + i];
+            for(size_t c = 0; c < k; ++c) B[i * k + c] -= l * B[u * k + c];
+        }
+        T d = math::inverse(L[i * s + i]);
+        for(size_t c = 0; c < k; ++c) B[i * k + c] *= d;
+    }
+}
+
+} // namespace detail
+} // namespace solver
+} // namespace amgcl
+
+#endif
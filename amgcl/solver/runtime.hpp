@@ -51,6 +51,8 @@ THE SOFTWARE.
 #include <amgcl/solver/idrs.hpp>
 #include <amgcl/solver/richardson.hpp>
 #include <amgcl/solver/preonly.hpp>
+#include <amgcl/solver/block_cg.hpp>
+#include <amgcl/solver/block_gmres.hpp>
 #include <amgcl/solver/detail/default_inner_product.hpp>
 
 namespace amgcl {
@@ -59,9 +61,11 @@ namespace solver {
 
 enum type {
     cg,         ///< Conjugate gradients method
+    block_cg,   ///< Block conjugate gradients method (multiple right-hand sides)
     bicgstab,   ///< BiConjugate Gradient Stabilized
     bicgstabl,  ///< BiCGStab(ell)
     gmres,      ///< GMRES
+    block_gmres,///< Block GMRES (multiple right-hand sides)
     lgmres,     ///< LGMRES
     fgmres,     ///< FGMRES
     idrs,       ///< IDR(s)
@@ -74,12 +78,16 @@ inline std::ostream& operator<<(std::ostream &os, type s)
     switch (s) {
         case cg:
             return os << "cg";
+        case block_cg:
+            return os << "block_cg";
         case bicgstab:
             return os << "bicgstab";
         case bicgstabl:
             return os << "bicgstabl";
         case gmres:
             return os << "gmres";
+        case block_gmres:
+            return os << "block_gmres";
         case lgmres:
             return os << "lgmres";
         case fgmres:
@@ -102,12 +110,16 @@ inline std::istream& operator>>(std::istream &in, type &s)
 
     if (val == "cg")
         s = cg;
+    else if (val == "block_cg")
+        s = block_cg;
     else if (val == "bicgstab")
         s = bicgstab;
     else if (val == "bicgstabl")
         s = bicgstabl;
     else if (val == "gmres")
         s = gmres;
+    else if (val == "block_gmres")
+        s = block_gmres;
     else if (val == "lgmres")
         s = lgmres;
     else if (val == "fgmres")
@@ -120,11 +132,47 @@ inline std::istream& operator>>(std::istream &in, type &s)
         s = preonly;
     else
         throw std::invalid_argument("Invalid solver value. Valid choices are: "
-                "cg, bicgstab, bicgstabl, gmres, lgmres, fgmres, idrs, richardson, preonly.");
+                "cg, block_cg, bicgstab, bicgstabl, gmres, block_gmres, lgmres, fgmres, idrs, "
+                "richardson, preonly.");
 
     return in;
 }
 
+namespace detail {
+
+// The block solvers only work with multi-vectors, and the rest of the solvers
+// only work with single vectors. The unsupported combinations are rejected at
+// runtime, so that the wrapper may be instantiated with either kind of
+// vectors.
+template <class Solver, class Vec>
+struct supports_vector : std::integral_constant<bool,
+    amgcl::solver::detail::is_block_solver<Solver>::value ==
+    backend::detail::is_multi_vector<typename std::decay<Vec>::type>::value
+    >
+{};
+
+template <class Solver, class Matrix, class Precond, class Vec1, class Vec2>
+typename std::enable_if<
+    supports_vector<Solver, Vec2>::value,
+    std::tuple<size_t, typename Solver::scalar_type>
+    >::type
+solve(const Solver &S, const Matrix &A, const Precond &P, const Vec1 &rhs, Vec2 &x) {
+    return S(A, P, rhs, x);
+}
+
+template <class Solver, class Matrix, class Precond, class Vec1, class Vec2>
+typename std::enable_if<
+    !supports_vector<Solver, Vec2>::value,
+    std::tuple<size_t, typename Solver::scalar_type>
+    >::type
+solve(const Solver&, const Matrix&, const Precond&, const Vec1&, Vec2&) {
+    throw std::logic_error(amgcl::solver::detail::is_block_solver<Solver>::value ?
+            "Block solvers require multi-vectors" :
+            "Multi-vectors are only supported by the block solvers");
+}
+
+} // namespace detail
+
 template <
     class Backend,
     class InnerProduct = amgcl::solver::detail::default_inner_product
@@ -155,9 +203,11 @@ struct wrapper {
                 break
 
             AMGCL_RUNTIME_SOLVER(cg);
+            AMGCL_RUNTIME_SOLVER(block_cg);
             AMGCL_RUNTIME_SOLVER(bicgstab);
             AMGCL_RUNTIME_SOLVER(bicgstabl);
             AMGCL_RUNTIME_SOLVER(gmres);
+            AMGCL_RUNTIME_SOLVER(block_gmres);
             AMGCL_RUNTIME_SOLVER(lgmres);
             AMGCL_RUNTIME_SOLVER(fgmres);
             AMGCL_RUNTIME_SOLVER(idrs);
@@ -180,9 +230,11 @@ struct wrapper {
                 break
 
             AMGCL_RUNTIME_SOLVER(cg);
+            AMGCL_RUNTIME_SOLVER(block_cg);
             AMGCL_RUNTIME_SOLVER(bicgstab);
             AMGCL_RUNTIME_SOLVER(bicgstabl);
             AMGCL_RUNTIME_SOLVER(gmres);
+            AMGCL_RUNTIME_SOLVER(block_gmres);
             AMGCL_RUNTIME_SOLVER(lgmres);
             AMGCL_RUNTIME_SOLVER(fgmres);
             AMGCL_RUNTIME_SOLVER(idrs);
@@ -201,12 +253,14 @@ struct wrapper {
 
 #define AMGCL_RUNTIME_SOLVER(type) \
             case type: \
-                return static_cast<amgcl::solver::type<Backend, InnerProduct>*>(handle)->operator()(A, P, rhs, x)
+                return detail::solve(*static_cast<amgcl::solver::type<Backend, InnerProduct>*>(handle), A, P, rhs, x)
 
             AMGCL_RUNTIME_SOLVER(cg);
+            AMGCL_RUNTIME_SOLVER(block_cg);
             AMGCL_RUNTIME_SOLVER(bicgstab);
             AMGCL_RUNTIME_SOLVER(bicgstabl);
             AMGCL_RUNTIME_SOLVER(gmres);
+            AMGCL_RUNTIME_SOLVER(block_gmres);
             AMGCL_RUNTIME_SOLVER(lgmres);
             AMGCL_RUNTIME_SOLVER(fgmres);
             AMGCL_RUNTIME_SOLVER(idrs);
@@ -235,9 +289,11 @@ struct wrapper {
                 return os << *static_cast<amgcl::solver::type<Backend, InnerProduct>*>(w.handle)
 
             AMGCL_RUNTIME_SOLVER(cg);
+            AMGCL_RUNTIME_SOLVER(block_cg);
             AMGCL_RUNTIME_SOLVER(bicgstab);
             AMGCL_RUNTIME_SOLVER(bicgstabl);
             AMGCL_RUNTIME_SOLVER(gmres);
+            AMGCL_RUNTIME_SOLVER(block_gmres);
             AMGCL_RUNTIME_SOLVER(lgmres);
             AMGCL_RUNTIME_SOLVER(fgmres);
             AMGCL_RUNTIME_SOLVER(idrs);
@@ -259,9 +315,11 @@ struct wrapper {
                 return backend::bytes(*static_cast<amgcl::solver::type<Backend, InnerProduct>*>(handle))
 
             AMGCL_RUNTIME_SOLVER(cg);
+            AMGCL_RUNTIME_SOLVER(block_cg);
             AMGCL_RUNTIME_SOLVER(bicgstab);
             AMGCL_RUNTIME_SOLVER(bicgstabl);
             AMGCL_RUNTIME_SOLVER(gmres);
+            AMGCL_RUNTIME_SOLVER(block_gmres);
             AMGCL_RUNTIME_SOLVER(lgmres);
             AMGCL_RUNTIME_SOLVER(fgmres);
             AMGCL_RUNTIME_SOLVER(idrs);
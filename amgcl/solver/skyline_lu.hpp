@@ -68,10 +68,12 @@ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <vector>
 #include <algorithm>
+#include <memory>
 
 #include <amgcl/backend/interface.hpp>
 #include <amgcl/value_type/interface.hpp>
 #include <amgcl/reorder/cuthill_mckee.hpp>
+#include <amgcl/io/binary.hpp>
 #include <amgcl/util.hpp>
 
 namespace amgcl {
@@ -96,7 +98,7 @@ class skyline_lu {
 
         template <class Matrix>
         skyline_lu(const Matrix &A, const params& = params())
-            : n( backend::rows(A) ), perm(n), ptr(n + 1, 0), D(n, math::zero<value_type>()), y(n)
+            : n( backend::rows(A) ), perm(n), ptr(n + 1, 0), D(n, math::zero<value_type>())
         {
             // Find the permutation for the ordering.
             ordering::get(A, perm);
@@ -180,6 +182,10 @@ class skyline_lu {
             // y = L^-1 * perm[rhs] ;
             // y = U^-1 * y ;
             // x = invperm[y];
+            //
+            // The temporary vector is allocated for each call, so that the
+            // solver may be used from several threads at once.
+            std::vector<rhs_type> y(n);
 
             for(int i = 0; i < n; ++i) {
                 rhs_type sum;
@@ -207,7 +213,63 @@ class skyline_lu {
                 backend::bytes(U) +
                 backend::bytes(D);
         }
+
+        /// Saves the factorization to a binary stream.
+        void save(std::ostream &f) const {
+            const std::uint64_t size[2] = {
+                static_cast<std::uint64_t>(n),
+                static_cast<std::uint64_t>(ptr.back())
+            };
+
+            precondition(
+                    f.write(signature(), 8) &&
+                    io::detail::write_array(f, size, 2) &&
+                    io::detail::write_array(f, perm.data(), n) &&
+                    io::detail::write_array(f, ptr.data(), n + 1) &&
+                    io::detail::write_array(f, L.data(), size[1]) &&
+                    io::detail::write_array(f, U.data(), size[1]) &&
+                    io::detail::write_array(f, D.data(), n),
+                    "File I/O error");
+        }
+
+        /// Loads the factorization saved with save().
+        /**
+         * Returns an empty pointer if the stream does not contain the
+         * skyline_lu factorization.
+         */
+        static std::shared_ptr<skyline_lu> load(std::istream &f) {
+            char sig[8];
+            if (!f.read(sig, 8) || !std::equal(sig, sig + 8, signature()))
+                return std::shared_ptr<skyline_lu>();
+
+            std::uint64_t size[2];
+            precondition(io::detail::read_array(f, size, 2), "File I/O error");
+
+            std::shared_ptr<skyline_lu> s(new skyline_lu());
+            s->n = size[0];
+            s->perm.resize(size[0]);
+            s->ptr.resize(size[0] + 1);
+            s->L.resize(size[1]);
+            s->U.resize(size[1]);
+            s->D.resize(size[0]);
+
+            precondition(
+                    io::detail::read_array(f, s->perm.data(), s->n) &&
+                    io::detail::read_array(f, s->ptr.data(), s->n + 1) &&
+                    io::detail::read_array(f, s->L.data(), size[1]) &&
+                    io::detail::read_array(f, s->U.data(), size[1]) &&
+                    io::detail::read_array(f, s->D.data(), s->n),
+                    "File I/O error");
+
+            return s;
+        }
     private:
+        skyline_lu() {}
+
+        static const char* signature() {
+            return "SKYLNLU1";
+        }
+
         int n;
         std::vector<int> perm;
         std::vector<int> ptr;
@@ -215,8 +277,6 @@ class skyline_lu {
         std::vector<value_type> U;
         std::vector<value_type> D;
 
-        mutable std::vector<rhs_type> y;
-
         /*
          * Perform and in-place LU factorization of a skyline matrix by Crout's
          * algorithm. The diagonal of U contains the 1's.
@@ -0,0 +1,589 @@
+#ifndef AMGCL_SOLVER_SUPERNODAL_LU_HPP
+#define AMGCL_SOLVER_SUPERNODAL_LU_HPP
+
+/*
+The MIT License
+
+Copyright (c) 2012-2021 Denis Demidov <dennis.demidov@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/**
+ * \file   amgcl/solver/supernodal_lu.hpp
+ * \author Denis Demidov <dennis.demidov@gmail.com>
+ * \brief  Multithreaded supernodal LU factorization solver.
+ */
+
+#include <vector>
+#include <algorithm>
+#include <numeric>
+
+#ifdef _OPENMP
+#  include <omp.h>
+#endif
+
+#include <amgcl/backend/interface.hpp>
+#include <amgcl/value_type/interface.hpp>
+#include <amgcl/reorder/nested_dissection.hpp>
+#include <amgcl/util.hpp>
+
+namespace amgcl {
+namespace solver {
+
+/// Direct solver that uses multithreaded supernodal LU factorization.
+/**
+ * The matrix is reordered (with nested dissection by default) and factorized
+ * without pivoting on the nonzero pattern of \f$A + A^T\f$, so the solver is
+ * suitable for the matrices that may be factorized without pivoting (which is
+ * the case for the coarse level matrices in AMG). The columns of the factors
+ * with the same structure are grouped into supernodes, which are stored as
+ * dense blocks. The supernodes are processed in the order of the levels of
+ * the elimination tree, and the supernodes within each level are factorized
+ * (and the triangular systems are solved) in parallel. Since the fill-in is
+ * much smaller than with the skyline format, much larger coarse levels may be
+ * used with the solver.
+ */
+template <
+    typename ValueType,
+    class ordering = reorder::nested_dissection<>
+    >
+class supernodal_lu {
+    public:
+        typedef ValueType value_type;
+        typedef typename math::scalar_of<value_type>::type scalar_type;
+        typedef typename math::rhs_of<value_type>::type    rhs_type;
+
+        typedef amgcl::detail::empty_params params;
+
+        static size_t coarse_enough() {
+            return 5000 / math::static_rows<value_type>::value;
+        }
+
+        template <class Matrix>
+        supernodal_lu(const Matrix &A, const params& = params())
+            : n( backend::rows(A) ), perm(n)
+        {
+            ordering::get(A, perm);
+
+            std::vector<ptrdiff_t> Bptr, Bcol;
+            std::vector<value_type> Bval;
+            permute(A, Bptr, Bcol, Bval);
+
+            symbolic(Bptr, Bcol);
+            numeric(Bptr, Bcol, Bval);
+        }
+
+        template <class Vec1, class Vec2>
+        void operator()(const Vec1 &rhs, Vec2 &x) const {
+            // The temporary vector is allocated for each call, so that the
+            // solver may be used from several threads at once.
+            std::vector<rhs_type> y(n);
+
+            for(ptrdiff_t i = 0; i < n; ++i) y[i] = rhs[perm[i]];
+
+            const ptrdiff_t nlev = lev_ptr.size() - 1;
+
+#pragma omp parallel
+            {
+                // Forward substitution: L y = b.
+                for(ptrdiff_t l = 0; l < nlev; ++l) {
+#pragma omp for schedule(dynamic, 1)
+                    for(ptrdiff_t j = lev_ptr[l]; j < lev_ptr[l+1]; ++j) {
+                        ptrdiff_t s = lev_node[j];
+                        ptrdiff_t f = sn_ptr[s];
+                        ptrdiff_t w = sn_ptr[s+1] - f;
+
+                        // Contributions of the descendants.
+                        for(ptrdiff_t k = upd_ptr[s]; k < upd_ptr[s+1]; ++k) {
+                            ptrdiff_t d  = upd_src[k];
+                            ptrdiff_t fd = sn_ptr[d];
+                            ptrdiff_t wd = sn_ptr[d+1] - fd;
+                            const ptrdiff_t  *R = &row[row_ptr[d]];
+                            const value_type *F = &Lval[L_ptr[d]];
+
+                            for(ptrdiff_t r = upd_beg[k]; r < upd_end[k]; ++r) {
+                                rhs_type sum = y[R[r]];
+                                for(ptrdiff_t m = 0; m < wd; ++m)
+                                    sum -= F[r * wd + m] * y[fd + m];
+                                y[R[r]] = sum;
+                            }
+                        }
+
+                        // The diagonal block (unit lower triangular).
+                        const value_type *F = &Lval[L_ptr[s]];
+                        for(ptrdiff_t i = 1; i < w; ++i) {
+                            rhs_type sum = y[f + i];
+                            for(ptrdiff_t m = 0; m < i; ++m)
+                                sum -= F[i * w + m] * y[f + m];
+                            y[f + i] = sum;
+                        }
+                    }
+                }
+
+                // Backward substitution: U x = y.
+                for(ptrdiff_t l = nlev; l-- > 0; ) {
+#pragma omp for schedule(dynamic, 1)
+                    for(ptrdiff_t j = lev_ptr[l]; j < lev_ptr[l+1]; ++j) {
+                        ptrdiff_t s = lev_node[j];
+                        ptrdiff_t f = sn_ptr[s];
+                        ptrdiff_t w = sn_ptr[s+1] - f;
+                        ptrdiff_t h = row_ptr[s+1] - row_ptr[s];
+
+                        const ptrdiff_t  *R = &row[row_ptr[s]];
+                        const value_type *F = &Lval[L_ptr[s]];
+                        const value_type *G = &Uval[U_ptr[s]];
+
+                        for(ptrdiff_t i = w; i-- > 0; ) {
+                            rhs_type sum = y[f + i];
+                            for(ptrdiff_t m = i + 1; m < w; ++m)
+                                sum -= F[i * w + m] * y[f + m];
+                            for(ptrdiff_t r = w; r < h; ++r)
+                                sum -= G[(r - w) * w + i] * y[R[r]];
+                            y[f + i] = D[f + i] * sum;
+                        }
+                    }
+                }
+            }
+
+            for(ptrdiff_t i = 0; i < n; ++i) x[perm[i]] = y[i];
+        }
+
+        size_t bytes() const {
+            return
+                backend::bytes(perm) +
+                backend::bytes(sn_ptr) +
+                backend::bytes(row_ptr) +
+                backend::bytes(row) +
+                backend::bytes(L_ptr) +
+                backend::bytes(U_ptr) +
+                backend::bytes(Lval) +
+                backend::bytes(Uval) +
+                backend::bytes(D) +
+                backend::bytes(lev_ptr) +
+                backend::bytes(lev_node) +
+                backend::bytes(upd_ptr) +
+                backend::bytes(upd_src) +
+                backend::bytes(upd_beg) +
+                backend::bytes(upd_end);
+        }
+    private:
+        ptrdiff_t n;
+        std::vector<ptrdiff_t> perm;
+
+        // Supernode s consists of the columns [sn_ptr[s], sn_ptr[s+1]). Its
+        // rows (in the ascending order, starting with the supernode columns)
+        // are stored in row[row_ptr[s]:row_ptr[s+1]]. Lval holds the dense
+        // h x w block (row-major) with the columns of L for each supernode,
+        // where the top w x w part keeps the diagonal block of both L and U.
+        // Uval holds the (h - w) x w block with the rows of U to the right of
+        // the diagonal block (transposed). D is the inverted diagonal of U.
+        std::vector<ptrdiff_t>  sn_ptr;
+        std::vector<ptrdiff_t>  row_ptr, row;
+        std::vector<ptrdiff_t>  L_ptr, U_ptr;
+        std::vector<value_type> Lval, Uval, D;
+
+        // Supernodes grouped by the levels of the elimination tree.
+        std::vector<ptrdiff_t> lev_ptr, lev_node;
+
+        // Updates for each supernode s: the rows
+        // row[row_ptr[upd_src[k]] + upd_beg[k] : ... + upd_end[k]] of the
+        // descendant supernode upd_src[k] belong to s.
+        std::vector<ptrdiff_t> upd_ptr, upd_src, upd_beg, upd_end;
+
+        // Permuted matrix P A P^T, with the pattern extended to the pattern
+        // of A + A^T and sorted rows.
+        template <class Matrix>
+        void permute(const Matrix &A, std::vector<ptrdiff_t> &ptr,
+                std::vector<ptrdiff_t> &col, std::vector<value_type> &val) const
+        {
+            std::vector<ptrdiff_t> iperm(n);
+            for(ptrdiff_t i = 0; i < n; ++i) iperm[perm[i]] = i;
+
+            ptr.assign(n + 1, 0);
+
+            for(ptrdiff_t i = 0; i < n; ++i) {
+                ptrdiff_t pi = iperm[i];
+                for(auto a = backend::row_begin(A, i); a; ++a) {
+                    ptrdiff_t pj = iperm[a.col()];
+                    ++ptr[pi + 1];
+                    if (pj != pi) ++ptr[pj + 1];
+                }
+            }
+
+            std::partial_sum(ptr.begin(), ptr.end(), ptr.begin());
+
+            col.resize(ptr[n]);
+            val.resize(ptr[n]);
+
+            std::vector<ptrdiff_t> head(ptr.begin(), ptr.end() - 1);
+
+            for(ptrdiff_t i = 0; i < n; ++i) {
+                ptrdiff_t pi = iperm[i];
+                for(auto a = backend::row_begin(A, i); a; ++a) {
+                    ptrdiff_t pj = iperm[a.col()];
+
+                    col[head[pi]] = pj;
+                    val[head[pi]] = a.value();
+                    ++head[pi];
+
+                    if (pj != pi) {
+                        col[head[pj]] = pi;
+                        val[head[pj]] = math::zero<value_type>();
+                        ++head[pj];
+                    }
+                }
+            }
+
+            // Sort the rows and merge the duplicates.
+            ptrdiff_t nnz = 0;
+            std::vector< std::pair<ptrdiff_t, value_type> > buf;
+            for(ptrdiff_t i = 0, beg = 0; i < n; ++i) {
+                ptrdiff_t end = ptr[i + 1];
+
+                buf.clear();
+                for(ptrdiff_t j = beg; j < end; ++j)
+                    buf.push_back(std::make_pair(col[j], val[j]));
+
+                std::sort(buf.begin(), buf.end(),
+                        [](const std::pair<ptrdiff_t, value_type> &a,
+                           const std::pair<ptrdiff_t, value_type> &b)
+                        {
+                            return a.first < b.first;
+                        });
+
+                ptrdiff_t row_beg = nnz;
+                for(const auto &e : buf) {
+                    if (nnz > row_beg && col[nnz - 1] == e.first) {
+                        val[nnz - 1] += e.second;
+                    } else {
+                        col[nnz] = e.first;
+                        val[nnz] = e.second;
+                        ++nnz;
+                    }
+                }
+
+                beg = end;
+                ptr[i + 1] = nnz;
+            }
+
+            col.resize(nnz);
+            val.resize(nnz);
+        }
+
+        // Symbolic factorization: elimination tree, structure of the
+        // factors, supernodes, and the update lists.
+        void symbolic(const std::vector<ptrdiff_t> &ptr, const std::vector<ptrdiff_t> &col) {
+            // Elimination tree.
+            std::vector<ptrdiff_t> parent(n, -1), ancestor(n, -1);
+
+            for(ptrdiff_t i = 0; i < n; ++i) {
+                for(ptrdiff_t j = ptr[i]; j < ptr[i+1]; ++j) {
+                    ptrdiff_t k = col[j];
+                    if (k >= i) break;
+
+                    while(ancestor[k] != -1 && ancestor[k] != i) {
+                        ptrdiff_t next = ancestor[k];
+                        ancestor[k] = i;
+                        k = next;
+                    }
+
+                    if (ancestor[k] == -1) {
+                        ancestor[k] = i;
+                        parent[k] = i;
+                    }
+                }
+            }
+
+            // Column structure of L (strictly lower part). The row i of L
+            // consists of the nodes on the paths from the nonzeros in the
+            // i-th row of A to i in the elimination tree.
+            std::vector<ptrdiff_t> Lcnt(n + 1, 0), mark(n, -1);
+
+            for(int pass = 0; pass < 2; ++pass) {
+                if (pass) {
+                    std::partial_sum(Lcnt.begin(), Lcnt.end(), Lcnt.begin());
+                    ancestor.resize(Lcnt[n]);
+                    std::fill(mark.begin(), mark.end(), -1);
+                }
+
+                std::vector<ptrdiff_t> head(Lcnt.begin(), Lcnt.end() - 1);
+
+                for(ptrdiff_t i = 0; i < n; ++i) {
+                    mark[i] = i;
+                    for(ptrdiff_t j = ptr[i]; j < ptr[i+1]; ++j) {
+                        ptrdiff_t k = col[j];
+                        if (k >= i) break;
+
+                        for(; mark[k] != i; k = parent[k]) {
+                            mark[k] = i;
+                            if (pass)
+                                ancestor[head[k]++] = i;
+                            else
+                                ++Lcnt[k + 1];
+                        }
+                    }
+                }
+            }
+
+            // The column structure is stored in ancestor[Lcnt[j]:Lcnt[j+1]].
+            std::vector<ptrdiff_t> &Lrow = ancestor;
+
+            // Fundamental supernodes.
+            std::vector<ptrdiff_t> nchild(n, 0);
+            for(ptrdiff_t i = 0; i < n; ++i)
+                if (parent[i] >= 0) ++nchild[parent[i]];
+
+            sn_ptr.clear();
+            sn_ptr.push_back(0);
+            for(ptrdiff_t j = 1; j < n; ++j) {
+                if (parent[j-1] != j || nchild[j] != 1 ||
+                        Lcnt[j] - Lcnt[j-1] != Lcnt[j+1] - Lcnt[j] + 1)
+                    sn_ptr.push_back(j);
+            }
+            sn_ptr.push_back(n);
+
+            const ptrdiff_t ns = sn_ptr.size() - 1;
+
+            std::vector<ptrdiff_t> sn_of(n);
+            for(ptrdiff_t s = 0; s < ns; ++s)
+                for(ptrdiff_t j = sn_ptr[s]; j < sn_ptr[s+1]; ++j) sn_of[j] = s;
+
+            // Row structure and storage of the supernodes.
+            row_ptr.resize(ns + 1);
+            L_ptr.resize(ns + 1);
+            U_ptr.resize(ns + 1);
+
+            row_ptr[0] = L_ptr[0] = U_ptr[0] = 0;
+            for(ptrdiff_t s = 0; s < ns; ++s) {
+                ptrdiff_t f = sn_ptr[s];
+                ptrdiff_t w = sn_ptr[s+1] - f;
+                ptrdiff_t h = Lcnt[f+1] - Lcnt[f] + 1;
+
+                row_ptr[s+1] = row_ptr[s] + h;
+                L_ptr[s+1] = L_ptr[s] + h * w;
+                U_ptr[s+1] = U_ptr[s] + (h - w) * w;
+            }
+
+            row.resize(row_ptr[ns]);
+            for(ptrdiff_t s = 0; s < ns; ++s) {
+                ptrdiff_t f = sn_ptr[s];
+                ptrdiff_t h = row_ptr[s];
+                row[h++] = f;
+                for(ptrdiff_t j = Lcnt[f]; j < Lcnt[f+1]; ++j) row[h++] = Lrow[j];
+            }
+
+            // Supernodal elimination tree levels.
+            std::vector<ptrdiff_t> level(ns, 0);
+            ptrdiff_t nlev = 0;
+            for(ptrdiff_t s = 0; s < ns; ++s) {
+                nlev = std::max(nlev, level[s] + 1);
+                ptrdiff_t p = parent[sn_ptr[s+1] - 1];
+                if (p >= 0) {
+                    ptrdiff_t t = sn_of[p];
+                    level[t] = std::max(level[t], level[s] + 1);
+                }
+            }
+
+            lev_ptr.assign(nlev + 1, 0);
+            for(ptrdiff_t s = 0; s < ns; ++s) ++lev_ptr[level[s] + 1];
+            std::partial_sum(lev_ptr.begin(), lev_ptr.end(), lev_ptr.begin());
+
+            lev_node.resize(ns);
+            {
+                std::vector<ptrdiff_t> head(lev_ptr.begin(), lev_ptr.end() - 1);
+                for(ptrdiff_t s = 0; s < ns; ++s) lev_node[head[level[s]]++] = s;
+            }
+
+            // Update lists. The rows of a supernode are sorted, so the rows
+            // belonging to the same ancestor are contiguous.
+            upd_ptr.assign(ns + 1, 0);
+            for(int pass = 0; pass < 2; ++pass) {
+                if (pass) {
+                    std::partial_sum(upd_ptr.begin(), upd_ptr.end(), upd_ptr.begin());
+                    upd_src.resize(upd_ptr[ns]);
+                    upd_beg.resize(upd_ptr[ns]);
+                    upd_end.resize(upd_ptr[ns]);
+                }
+
+                std::vector<ptrdiff_t> head(upd_ptr.begin(), upd_ptr.end() - 1);
+
+                for(ptrdiff_t s = 0; s < ns; ++s) {
+                    ptrdiff_t w = sn_ptr[s+1] - sn_ptr[s];
+                    ptrdiff_t h = row_ptr[s+1] - row_ptr[s];
+                    const ptrdiff_t *R = &row[row_ptr[s]];
+
+                    for(ptrdiff_t r = w; r < h; ) {
+                        ptrdiff_t t = sn_of[R[r]];
+                        ptrdiff_t e = r + 1;
+                        while(e < h && R[e] < sn_ptr[t+1]) ++e;
+
+                        if (pass) {
+                            ptrdiff_t k = head[t]++;
+                            upd_src[k] = s;
+                            upd_beg[k] = r;
+                            upd_end[k] = e;
+                        } else {
+                            ++upd_ptr[t + 1];
+                        }
+
+                        r = e;
+                    }
+                }
+            }
+        }
+
+        // Numeric factorization.
+        void numeric(const std::vector<ptrdiff_t> &ptr,
+                const std::vector<ptrdiff_t> &col,
+                const std::vector<value_type> &val)
+        {
+            const ptrdiff_t ns   = sn_ptr.size() - 1;
+            const ptrdiff_t nlev = lev_ptr.size() - 1;
+
+            Lval.resize(L_ptr[ns]);
+            Uval.resize(U_ptr[ns]);
+            D.resize(n);
+
+            bool pivot = true;
+
+#pragma omp parallel
+            {
+                // Position of the row in the structure of the current supernode.
+                std::vector<ptrdiff_t> pos(n, -1);
+
+                for(ptrdiff_t l = 0; l < nlev; ++l) {
+#pragma omp for schedule(dynamic, 1) reduction(&&:pivot)
+                    for(ptrdiff_t j = lev_ptr[l]; j < lev_ptr[l+1]; ++j) {
+                        ptrdiff_t s = lev_node[j];
+                        ptrdiff_t f = sn_ptr[s];
+                        ptrdiff_t w = sn_ptr[s+1] - f;
+                        ptrdiff_t h = row_ptr[s+1] - row_ptr[s];
+
+                        const ptrdiff_t *R = &row[row_ptr[s]];
+                        value_type *F = &Lval[L_ptr[s]];
+                        value_type *G = &Uval[U_ptr[s]];
+
+                        for(ptrdiff_t r = 0; r < h; ++r) pos[R[r]] = r;
+
+                        std::fill(F, F + h * w, math::zero<value_type>());
+                        std::fill(G, G + (h - w) * w, math::zero<value_type>());
+
+                        // Scatter the values of A. The pattern of A is
+                        // symmetric, so the column c of A is found by the
+                        // column indices in the row c.
+                        for(ptrdiff_t c = 0; c < w; ++c) {
+                            ptrdiff_t i = f + c;
+                            for(ptrdiff_t k = ptr[i]; k < ptr[i+1]; ++k) {
+                                ptrdiff_t cc = col[k];
+                                if (cc < f) continue;
+
+                                // a(i, cc)
+                                if (cc < f + w) {
+                                    F[c * w + cc - f] = val[k];
+                                } else {
+                                    G[(pos[cc] - w) * w + c] = val[k];
+
+                                    // a(cc, i)
+                                    const ptrdiff_t *b = col.data() + ptr[cc];
+                                    const ptrdiff_t *e = col.data() + ptr[cc+1];
+                                    F[pos[cc] * w + c] = val[std::lower_bound(b, e, i) - col.data()];
+                                }
+                            }
+                        }
+
+                        // Updates from the descendants.
+                        for(ptrdiff_t k = upd_ptr[s]; k < upd_ptr[s+1]; ++k) {
+                            ptrdiff_t d  = upd_src[k];
+                            ptrdiff_t p  = upd_beg[k];
+                            ptrdiff_t q  = upd_end[k];
+                            ptrdiff_t wd = sn_ptr[d+1] - sn_ptr[d];
+                            ptrdiff_t hd = row_ptr[d+1] - row_ptr[d];
+
+                            const ptrdiff_t  *Rd = &row[row_ptr[d]];
+                            const value_type *Fd = &Lval[L_ptr[d]];
+                            const value_type *Gd = &Uval[U_ptr[d]];
+
+                            for(ptrdiff_t r = p; r < hd; ++r) {
+                                ptrdiff_t pr = pos[Rd[r]];
+                                const value_type *Fr = Fd + r * wd;
+                                const value_type *Gr = Gd + (r - wd) * wd;
+
+                                for(ptrdiff_t c = p; c < q; ++c) {
+                                    ptrdiff_t pc = Rd[c] - f;
+                                    const value_type *Fc = Fd + c * wd;
+                                    const value_type *Gc = Gd + (c - wd) * wd;
+
+                                    // L(r, c) or the diagonal block.
+                                    value_type sum = math::zero<value_type>();
+                                    for(ptrdiff_t m = 0; m < wd; ++m)
+                                        sum += Fr[m] * Gc[m];
+                                    F[pr * w + pc] -= sum;
+
+                                    // U(c, r)
+                                    if (r >= q) {
+                                        sum = math::zero<value_type>();
+                                        for(ptrdiff_t m = 0; m < wd; ++m)
+                                            sum += Fc[m] * Gr[m];
+                                        G[(pr - w) * w + pc] -= sum;
+                                    }
+                                }
+                            }
+                        }
+
+                        // Factorize the diagonal block, and compute the
+                        // off-diagonal parts of L and U.
+                        for(ptrdiff_t k = 0; k < w; ++k) {
+                            value_type d = F[k * w + k];
+                            if (math::is_zero(d)) {
+                                pivot = false;
+                                break;
+                            }
+
+                            d = math::inverse(d);
+                            D[f + k] = d;
+
+                            for(ptrdiff_t i = k + 1; i < h; ++i) {
+                                value_type *Fi = F + i * w;
+                                value_type t = Fi[k] * d;
+                                Fi[k] = t;
+                                for(ptrdiff_t m = k + 1; m < w; ++m)
+                                    Fi[m] -= t * F[k * w + m];
+                            }
+
+                            for(ptrdiff_t i = 0; i < h - w; ++i) {
+                                value_type *Gi = G + i * w;
+                                for(ptrdiff_t m = k + 1; m < w; ++m)
+                                    Gi[m] -= F[m * w + k] * Gi[k];
+                            }
+                        }
+
+                        for(ptrdiff_t r = 0; r < h; ++r) pos[R[r]] = -1;
+                    }
+                }
+            }
+
+            precondition(pivot, "Zero pivot in supernodal_lu");
+        }
+};
+
+} // namespace solver
+} // namespace amgcl
+
+#endif
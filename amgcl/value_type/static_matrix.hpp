@@ -145,18 +145,22 @@ static_matrix<T, N, M> operator-(static_matrix<T, N, M> a, const static_matrix<U
     return a -= b;
 }
 
+// The result uses the wider of the two scalar types, so that a reduced
+// precision matrix may be multiplied with a full precision vector.
 template <typename T, typename U, int N, int K, int M>
-static_matrix<T, N, M> operator*(
+static_matrix<typename std::common_type<T, U>::type, N, M> operator*(
         const static_matrix<T, N, K> &a,
         const static_matrix<U, K, M> &b
         )
 {
-    static_matrix<T, N, M> c;
+    typedef typename std::common_type<T, U>::type R;
+
+    static_matrix<R, N, M> c;
     for(int i = 0; i < N; ++i) {
         for(int j = 0; j < M; ++j)
-            c(i,j) = math::zero<T>();
+            c(i,j) = math::zero<R>();
         for(int k = 0; k < K; ++k) {
-            T aik = a(i,k);
+            R aik = a(i,k);
             for(int j = 0; j < M; ++j)
                 c(i,j) += aik * b(k,j);
         }
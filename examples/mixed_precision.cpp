@@ -18,6 +18,7 @@
 #    define SOLVER_BACKEND_BUILTIN
 #  endif
 #  include <amgcl/backend/builtin.hpp>
+#  include <amgcl/backend/builtin_mixed.hpp>
    typedef amgcl::backend::builtin<float>  fBackend;
    typedef amgcl::backend::builtin<double> dBackend;
 #endif
@@ -82,5 +83,37 @@ int main() {
 
     std::cout << "Iterations: " << iters << std::endl
               << "Error:      " << error << std::endl
-              << prof << std::endl;
+              << std::endl;
+
+#if defined(SOLVER_BACKEND_BUILTIN)
+    // Store the preconditioner matrices in single precision, but keep the
+    // vectors and the arithmetic in double precision.
+    typedef amgcl::make_solver<
+        amgcl::amg<
+            amgcl::backend::builtin_mixed<double, float>,
+            amgcl::coarsening::smoothed_aggregation,
+            amgcl::relaxation::spai0
+            >,
+        amgcl::solver::cg< dBackend >
+        >
+        MSolver;
+
+    prof.tic("setup (float storage)");
+    MSolver M(std::tie(n, ptr, col, val));
+    prof.toc("setup (float storage)");
+
+    std::cout << M << std::endl;
+
+    std::fill(x.begin(), x.end(), 0.0);
+
+    prof.tic("solve (float storage)");
+    std::tie(iters, error) = M(A_d, f, x);
+    prof.toc("solve (float storage)");
+
+    std::cout << "Iterations: " << iters << std::endl
+              << "Error:      " << error << std::endl
+              << std::endl;
+#endif
+
+    std::cout << prof << std::endl;
 }
@@ -0,0 +1,196 @@
+#include <iostream>
+#include <vector>
+#include <random>
+#include <algorithm>
+
+#include <boost/program_options.hpp>
+
+#include <amgcl/backend/builtin.hpp>
+#include <amgcl/adapter/crs_tuple.hpp>
+#include <amgcl/profiler.hpp>
+
+namespace amgcl { profiler<> prof; }
+using amgcl::prof;
+
+//---------------------------------------------------------------------------
+// 2D Poisson problem on n x n grid with additional dense rows and columns
+// (e.g. wells or Lagrange multipliers coupled to many grid cells).
+void dense_rows_problem(ptrdiff_t n, int ndense, int width,
+        std::vector<ptrdiff_t> &ptr,
+        std::vector<ptrdiff_t> &col,
+        std::vector<double>    &val)
+{
+    const ptrdiff_t n2 = n * n;
+    const ptrdiff_t m  = n2 + ndense;
+
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<ptrdiff_t> cell(0, n2 - 1);
+
+    // Cells coupled to each of the dense rows.
+    std::vector< std::vector<ptrdiff_t> > cells(ndense);
+    std::vector< std::vector<ptrdiff_t> > coupled(n2);
+    for(int k = 0; k < ndense; ++k) {
+        for(int j = 0; j < width; ++j) cells[k].push_back(cell(rng));
+        std::sort(cells[k].begin(), cells[k].end());
+        cells[k].erase(std::unique(cells[k].begin(), cells[k].end()), cells[k].end());
+        for(ptrdiff_t c : cells[k]) coupled[c].push_back(n2 + k);
+    }
+
+    ptr.clear(); ptr.reserve(m + 1); ptr.push_back(0);
+    col.clear(); val.clear();
+
+    for(ptrdiff_t j = 0, idx = 0; j < n; ++j) {
+        for(ptrdiff_t i = 0; i < n; ++i, ++idx) {
+            if (j > 0)     { col.push_back(idx - n); val.push_back(-1); }
+            if (i > 0)     { col.push_back(idx - 1); val.push_back(-1); }
+            col.push_back(idx); val.push_back(4 + coupled[idx].size());
+            if (i + 1 < n) { col.push_back(idx + 1); val.push_back(-1); }
+            if (j + 1 < n) { col.push_back(idx + n); val.push_back(-1); }
+            for(ptrdiff_t c : coupled[idx]) { col.push_back(c); val.push_back(-1); }
+            ptr.push_back(col.size());
+        }
+    }
+
+    for(int k = 0; k < ndense; ++k) {
+        for(ptrdiff_t c : cells[k]) { col.push_back(c); val.push_back(-1); }
+        col.push_back(n2 + k); val.push_back(cells[k].size());
+        ptr.push_back(col.size());
+    }
+}
+
+//---------------------------------------------------------------------------
+// Random matrix with power-law distribution of the row lengths.
+void power_law_problem(ptrdiff_t n, double alpha,
+        std::vector<ptrdiff_t> &ptr,
+        std::vector<ptrdiff_t> &col,
+        std::vector<double>    &val)
+{
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<double>   rnd(0, 1);
+    std::uniform_int_distribution<ptrdiff_t> any(0, n - 1);
+
+    ptr.clear(); ptr.reserve(n + 1); ptr.push_back(0);
+    col.clear(); val.clear();
+
+    for(ptrdiff_t i = 0; i < n; ++i) {
+        // Pareto-distributed row width, capped by the matrix size.
+        ptrdiff_t w = std::min<ptrdiff_t>(n, 1 + std::pow(1 - rnd(rng), -1 / alpha));
+
+        std::vector<ptrdiff_t> c(w);
+        c[0] = i;
+        for(ptrdiff_t j = 1; j < w; ++j) c[j] = any(rng);
+        std::sort(c.begin(), c.end());
+        c.erase(std::unique(c.begin(), c.end()), c.end());
+
+        for(ptrdiff_t j : c) {
+            col.push_back(j);
+            val.push_back(j == i ? c.size() : -1.0);
+        }
+        ptr.push_back(col.size());
+    }
+}
+
+//---------------------------------------------------------------------------
+int main(int argc, char *argv[]) {
+    namespace po = boost::program_options;
+
+    po::options_description desc("Options");
+
+    desc.add_options()
+        ("help,h", "Show this help.")
+        ("problem,p",
+         po::value<std::string>()->default_value("dense"),
+         "Problem type: 'dense' (Poisson with dense rows) or 'power' (power-law row lengths)"
+        )
+        ("size,n",
+         po::value<ptrdiff_t>()->default_value(1024),
+         "Problem size (grid size for 'dense', number of rows for 'power')"
+        )
+        ("dense-rows,d",
+         po::value<int>()->default_value(8),
+         "Number of dense rows for the 'dense' problem"
+        )
+        ("dense-width,w",
+         po::value<int>()->default_value(100000),
+         "Number of nonzeros in each dense row"
+        )
+        ("alpha,a",
+         po::value<double>()->default_value(1.2),
+         "Exponent of the power-law distribution for the 'power' problem"
+        )
+        ("iters,i",
+         po::value<int>()->default_value(100),
+         "Number of SpMV operations to measure"
+        )
+        ;
+
+    po::variables_map vm;
+    po::store(po::parse_command_line(argc, argv, desc), vm);
+    po::notify(vm);
+
+    if (vm.count("help")) {
+        std::cout << desc << std::endl;
+        return 0;
+    }
+
+    std::vector<ptrdiff_t> ptr, col;
+    std::vector<double>    val;
+
+    prof.tic("assemble");
+    if (vm["problem"].as<std::string>() == "power") {
+        power_law_problem(vm["size"].as<ptrdiff_t>(), vm["alpha"].as<double>(), ptr, col, val);
+    } else {
+        dense_rows_problem(vm["size"].as<ptrdiff_t>(),
+                vm["dense-rows"].as<int>(), vm["dense-width"].as<int>(),
+                ptr, col, val);
+    }
+    prof.toc("assemble");
+
+    ptrdiff_t n = ptr.size() - 1;
+
+    ptrdiff_t max_width = 0;
+    for(ptrdiff_t i = 0; i < n; ++i)
+        max_width = std::max<ptrdiff_t>(max_width, ptr[i+1] - ptr[i]);
+
+    std::cout
+        << "rows:      " << n << std::endl
+        << "nonzeros:  " << ptr.back() << std::endl
+        << "max width: " << max_width << std::endl
+        << std::endl;
+
+    // The tuple adapter uses the generic row-wise OpenMP loop, while the
+    // crs matrix uses the nonzero-balanced (merge-path) partition.
+    auto T = std::tie(n, ptr, col, val);
+    amgcl::backend::crs<double> A(T);
+
+    amgcl::backend::numa_vector<double> x(n), y(n), z(n);
+    for(ptrdiff_t i = 0; i < n; ++i) x[i] = 1.0 / (1 + i % 13);
+
+    const int iters = vm["iters"].as<int>();
+
+    // Warm up (and compute the partition).
+    amgcl::backend::spmv(1.0, T, x, 0.0, z);
+    amgcl::backend::spmv(1.0, A, x, 0.0, y);
+
+    prof.tic("row-wise");
+    for(int k = 0; k < iters; ++k)
+        amgcl::backend::spmv(1.0, T, x, 0.0, z);
+    double t_row = prof.toc("row-wise");
+
+    prof.tic("merge-path");
+    for(int k = 0; k < iters; ++k)
+        amgcl::backend::spmv(1.0, A, x, 0.0, y);
+    double t_mp = prof.toc("merge-path");
+
+    double err = 0;
+    for(ptrdiff_t i = 0; i < n; ++i)
+        err = std::max(err, std::abs(y[i] - z[i]));
+
+    std::cout
+        << "row-wise:   " << t_row / iters * 1e3 << " ms/spmv" << std::endl
+        << "merge-path: " << t_mp  / iters * 1e3 << " ms/spmv" << std::endl
+        << "speedup:    " << t_row / t_mp << std::endl
+        << "max diff:   " << err << std::endl
+        << std::endl
+        << prof << std::endl;
+}
@@ -0,0 +1,303 @@
+#define BOOST_TEST_MODULE TestCoarsening
+#include <boost/test/unit_test.hpp>
+
+#include <vector>
+
+#ifdef _OPENMP
+#  include <omp.h>
+#endif
+
+#include <amgcl/backend/builtin.hpp>
+#include <amgcl/adapter/crs_tuple.hpp>
+#include <amgcl/coarsening/plain_aggregates.hpp>
+#include <amgcl/coarsening/pointwise_aggregates.hpp>
+#include <amgcl/coarsening/ruge_stuben.hpp>
+#include <amgcl/coarsening/aggregation.hpp>
+#include <amgcl/coarsening/smoothed_aggregation.hpp>
+#include <amgcl/relaxation/spai0.hpp>
+#include <amgcl/solver/cg.hpp>
+#include <amgcl/make_solver.hpp>
+#include <amgcl/amg.hpp>
+#include <amgcl/profiler.hpp>
+#include "sample_problem.hpp"
+
+namespace amgcl {
+    profiler<> prof;
+}
+
+typedef amgcl::backend::crs<double> Matrix;
+
+// Checks that the aggregates cover all of the variables but the lonely ones.
+template <class Aggregates>
+void check_aggregates(const Matrix &A, const Aggregates &aggr) {
+    const ptrdiff_t n = A.nrows;
+
+    std::vector<int> size(aggr.count, 0);
+    for(ptrdiff_t i = 0; i < n; ++i) {
+        ptrdiff_t id = aggr.id[i];
+
+        bool lonely = true;
+        for(ptrdiff_t j = A.ptr[i]; j < A.ptr[i+1]; ++j)
+            if (aggr.strong_connection[j]) lonely = false;
+
+        if (lonely) {
+            BOOST_CHECK(id == Aggregates::removed);
+        } else {
+            BOOST_REQUIRE(id >= 0 && id < static_cast<ptrdiff_t>(aggr.count));
+            ++size[id];
+        }
+    }
+
+    for(int s : size) BOOST_CHECK(s > 0);
+}
+
+BOOST_AUTO_TEST_SUITE( test_coarsening )
+
+BOOST_AUTO_TEST_CASE(parallel_aggregation)
+{
+    std::vector<ptrdiff_t> ptr;
+    std::vector<ptrdiff_t> col;
+    std::vector<double>    val;
+    std::vector<double>    rhs;
+
+    const ptrdiff_t n = sample_problem(32, val, col, ptr, rhs);
+
+    // Make a few rows look like Dirichlet conditions, so that the
+    // connectivity becomes nonsymmetric, and there are lonely variables.
+    for(ptrdiff_t i = 0; i < n; i += 97)
+        for(ptrdiff_t j = ptr[i]; j < ptr[i+1]; ++j)
+            if (col[j] != i) val[j] = 0;
+
+    Matrix A(std::tie(n, ptr, col, val));
+
+    amgcl::coarsening::plain_aggregates::params prm;
+    amgcl::coarsening::plain_aggregates serial(A, prm);
+
+    prm.parallel = true;
+    amgcl::coarsening::plain_aggregates parallel(A, prm);
+
+    check_aggregates(A, serial);
+    check_aggregates(A, parallel);
+
+    // The aggregates should be of comparable size.
+    BOOST_CHECK(parallel.count < 2 * serial.count);
+    BOOST_CHECK(serial.count < 2 * parallel.count);
+
+#ifdef _OPENMP
+    // The result should not depend on the number of threads.
+    int nt = omp_get_max_threads();
+    omp_set_num_threads(1);
+    amgcl::coarsening::plain_aggregates single(A, prm);
+    omp_set_num_threads(nt);
+
+    BOOST_CHECK_EQUAL(single.count, parallel.count);
+    BOOST_CHECK(single.id == parallel.id);
+
+    // Nor on the number of threads that actually join the team (the
+    // nested region is inactive, and has a single thread).
+    std::shared_ptr<amgcl::coarsening::plain_aggregates> nested;
+#pragma omp parallel num_threads(2)
+    {
+#pragma omp single
+        nested = std::make_shared<amgcl::coarsening::plain_aggregates>(A, prm);
+    }
+
+    BOOST_CHECK_EQUAL(nested->count, parallel.count);
+    BOOST_CHECK(nested->id == parallel.id);
+#endif
+
+    // Pointwise aggregates pass the parameter through.
+    amgcl::coarsening::pointwise_aggregates::params pprm;
+    pprm.parallel = true;
+    amgcl::coarsening::pointwise_aggregates pointwise(A, pprm, 1);
+
+    BOOST_CHECK_EQUAL(pointwise.count, parallel.count);
+}
+
+BOOST_AUTO_TEST_CASE(ruge_stuben_splitting)
+{
+    std::vector<ptrdiff_t> ptr;
+    std::vector<ptrdiff_t> col;
+    std::vector<double>    val;
+    std::vector<double>    rhs;
+
+    const ptrdiff_t n = sample_problem(32, val, col, ptr, rhs);
+    Matrix A(std::tie(n, ptr, col, val));
+
+    typedef amgcl::coarsening::ruge_stuben<amgcl::backend::builtin<double> > RS;
+
+    amgcl::coarsening::cf_splitting::type split[] = {
+        amgcl::coarsening::cf_splitting::classic,
+        amgcl::coarsening::cf_splitting::pmis,
+        amgcl::coarsening::cf_splitting::hmis
+    };
+
+    for(auto s : split) {
+        BOOST_TEST_MESSAGE("split: " << s);
+
+        RS::params prm;
+        prm.split = s;
+        RS C(prm);
+
+        std::shared_ptr<Matrix> P, R;
+        std::tie(P, R) = C.transfer_operators(A);
+
+        BOOST_CHECK(P->ncols < A.nrows);
+
+        // Each of the rows with strong connections is interpolated.
+        for(ptrdiff_t i = 0; i < n; ++i)
+            BOOST_CHECK(P->ptr[i+1] > P->ptr[i]);
+
+#ifdef _OPENMP
+        if (s == amgcl::coarsening::cf_splitting::pmis) {
+            // PMIS does not depend on the number of threads.
+            int nt = omp_get_max_threads();
+            omp_set_num_threads(1);
+            std::shared_ptr<Matrix> P1, R1;
+            std::tie(P1, R1) = C.transfer_operators(A);
+            omp_set_num_threads(nt);
+
+            BOOST_CHECK_EQUAL(P1->ncols, P->ncols);
+            BOOST_CHECK_EQUAL(amgcl::backend::nonzeros(*P1), amgcl::backend::nonzeros(*P));
+        }
+
+        if (s == amgcl::coarsening::cf_splitting::hmis) {
+            // HMIS does not depend on the number of threads that actually
+            // join the team.
+            std::shared_ptr<Matrix> P1, R1;
+#pragma omp parallel num_threads(2)
+            {
+#pragma omp single
+                std::tie(P1, R1) = C.transfer_operators(A);
+            }
+
+            BOOST_CHECK_EQUAL(P1->ncols, P->ncols);
+            BOOST_CHECK_EQUAL(amgcl::backend::nonzeros(*P1), amgcl::backend::nonzeros(*P));
+
+            // With a single block, the classic pass sees the complete
+            // strength graph, and HMIS reduces to the classic splitting.
+            RS::params cprm;
+            cprm.split = amgcl::coarsening::cf_splitting::classic;
+            RS Cc(cprm);
+
+            int nt = omp_get_max_threads();
+            omp_set_num_threads(1);
+            std::shared_ptr<Matrix> P2, R2, Pc, Rc;
+            std::tie(P2, R2) = C.transfer_operators(A);
+            std::tie(Pc, Rc) = Cc.transfer_operators(A);
+            omp_set_num_threads(nt);
+
+            BOOST_CHECK_EQUAL(P2->ncols, Pc->ncols);
+            BOOST_CHECK_EQUAL(amgcl::backend::nonzeros(*P2), amgcl::backend::nonzeros(*Pc));
+        }
+#endif
+
+        typedef amgcl::backend::builtin<double> Backend;
+        typedef amgcl::make_solver<
+            amgcl::amg<Backend, amgcl::coarsening::ruge_stuben, amgcl::relaxation::spai0>,
+            amgcl::solver::cg<Backend>
+            > Solver;
+
+        Solver::params sprm;
+        sprm.precond.coarsening.split = s;
+
+        Solver solve(A, sprm);
+
+        std::vector<double> x(n, 0.0);
+        size_t iters;
+        double error;
+        std::tie(iters, error) = solve(rhs, x);
+
+        BOOST_CHECK_SMALL(error, 1e-8);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(aggregate_galerkin)
+{
+    std::vector<ptrdiff_t> ptr;
+    std::vector<ptrdiff_t> col;
+    std::vector<double>    val;
+    std::vector<double>    rhs;
+
+    const ptrdiff_t n = sample_problem(16, val, col, ptr, rhs);
+    Matrix A(std::tie(n, ptr, col, val));
+
+    typedef amgcl::coarsening::aggregation<amgcl::backend::builtin<double> > Aggregation;
+
+    for(int block_size = 1; block_size <= 2; ++block_size) {
+        Aggregation::params prm;
+        prm.aggr.block_size = block_size;
+        Aggregation C(prm);
+
+        std::shared_ptr<Matrix> P, R;
+        std::tie(P, R) = C.transfer_operators(A);
+
+        // R is the transpose of P.
+        auto T = amgcl::backend::transpose(*P);
+
+        BOOST_REQUIRE_EQUAL(R->nrows, T->nrows);
+        BOOST_REQUIRE_EQUAL(R->nnz, T->nnz);
+        for(size_t i = 0; i <= R->nrows; ++i)
+            BOOST_CHECK_EQUAL(R->ptr[i], T->ptr[i]);
+        for(size_t j = 0; j < R->nnz; ++j) {
+            BOOST_CHECK_EQUAL(R->col[j], T->col[j]);
+            BOOST_CHECK_EQUAL(R->val[j], T->val[j]);
+        }
+
+        // The coarse operator matches the scaled product R A P.
+        auto Ac = C.coarse_operator(A, *P, *R);
+        auto RAP = amgcl::backend::product(*R, *amgcl::backend::product(A, *P));
+        amgcl::backend::sort_rows(*Ac);
+        amgcl::backend::sort_rows(*RAP);
+
+        BOOST_REQUIRE_EQUAL(Ac->nnz, RAP->nnz);
+        for(size_t j = 0; j < Ac->nnz; ++j) {
+            BOOST_CHECK_EQUAL(Ac->col[j], RAP->col[j]);
+            BOOST_CHECK_CLOSE(Ac->val[j], RAP->val[j] * (1 / prm.over_interp), 1e-8);
+        }
+    }
+}
+
+template <template <class> class Coarsening>
+void test_lean_setup() {
+    typedef amgcl::backend::builtin<double> Backend;
+    typedef amgcl::make_solver<
+        amgcl::amg<Backend, Coarsening, amgcl::relaxation::spai0>,
+        amgcl::solver::cg<Backend>
+        > Solver;
+
+    std::vector<ptrdiff_t> ptr;
+    std::vector<ptrdiff_t> col;
+    std::vector<double>    val;
+    std::vector<double>    rhs;
+
+    const ptrdiff_t n = sample_problem(32, val, col, ptr, rhs);
+
+    size_t iters[2];
+    double error[2];
+
+    for(int lean = 0; lean < 2; ++lean) {
+        typename Solver::params prm;
+        prm.precond.lean_setup = lean;
+
+        Solver solve(std::tie(n, ptr, col, val), prm);
+
+        BOOST_CHECK_GE(solve.precond().peak_setup_bytes(), solve.precond().bytes());
+
+        std::vector<double> x(n, 0.0);
+        std::tie(iters[lean], error[lean]) = solve(rhs, x);
+    }
+
+    // The lean setup results in the same hierarchy.
+    BOOST_CHECK_EQUAL(iters[0], iters[1]);
+    BOOST_CHECK_CLOSE(error[0], error[1], 1e-6);
+}
+
+BOOST_AUTO_TEST_CASE(lean_setup)
+{
+    test_lean_setup<amgcl::coarsening::aggregation>();
+    test_lean_setup<amgcl::coarsening::smoothed_aggregation>();
+    test_lean_setup<amgcl::coarsening::ruge_stuben>();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,164 @@
+#define BOOST_TEST_MODULE TestDenseLU
+#include <boost/test/unit_test.hpp>
+
+#include <amgcl/adapter/zero_copy.hpp>
+#include <amgcl/adapter/crs_tuple.hpp>
+#include <amgcl/solver/dense_lu.hpp>
+#include <amgcl/solver/auto_lu.hpp>
+#include <amgcl/backend/builtin.hpp>
+#include <amgcl/value_type/static_matrix.hpp>
+#include <amgcl/make_solver.hpp>
+#include <amgcl/amg.hpp>
+#include <amgcl/coarsening/smoothed_aggregation.hpp>
+#include <amgcl/relaxation/spai0.hpp>
+#include <amgcl/solver/bicgstab.hpp>
+#include <amgcl/profiler.hpp>
+#include "sample_problem.hpp"
+
+namespace amgcl {
+    profiler<> prof;
+}
+
+BOOST_AUTO_TEST_SUITE( test_dense_lu )
+
+BOOST_AUTO_TEST_CASE(dense_lu)
+{
+    std::vector<ptrdiff_t> ptr;
+    std::vector<ptrdiff_t> col;
+    std::vector<double>    val;
+    std::vector<double>    rhs;
+
+    size_t n = sample_problem(8, val, col, ptr, rhs);
+
+    // Reverse the order of the rows, so that the factorization is not
+    // possible without pivoting.
+    {
+        std::vector<ptrdiff_t> p(n + 1, 0);
+        std::vector<ptrdiff_t> c; c.reserve(col.size());
+        std::vector<double>    v; v.reserve(val.size());
+
+        for(size_t i = n; i --> 0; ) {
+            c.insert(c.end(), col.begin() + ptr[i], col.begin() + ptr[i+1]);
+            v.insert(v.end(), val.begin() + ptr[i], val.begin() + ptr[i+1]);
+            p[n - i] = c.size();
+        }
+
+        ptr.swap(p);
+        col.swap(c);
+        val.swap(v);
+    }
+
+    auto A = amgcl::adapter::zero_copy(n, ptr.data(), col.data(), val.data());
+
+    for(bool inverse : {true, false}) {
+        amgcl::solver::dense_lu<double>::params prm;
+        prm.inverse = inverse;
+
+        amgcl::solver::dense_lu<double> solve(*A, prm);
+
+        std::vector<double> x(n);
+        std::vector<double> r(n);
+
+        solve(rhs, x);
+
+        amgcl::backend::residual(rhs, *A, x, r);
+
+        BOOST_CHECK_SMALL(sqrt(amgcl::backend::inner_product(r, r)), 1e-8);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(dense_lu_block)
+{
+    typedef amgcl::static_matrix<double, 2, 2> value_type;
+    typedef amgcl::static_matrix<double, 2, 1> rhs_type;
+
+    std::vector<ptrdiff_t>  ptr;
+    std::vector<ptrdiff_t>  col;
+    std::vector<value_type> val;
+    std::vector<rhs_type>   rhs;
+
+    size_t n = sample_problem(6, val, col, ptr, rhs);
+
+    amgcl::backend::crs<value_type> A(std::tie(n, ptr, col, val));
+
+    for(bool inverse : {true, false}) {
+        amgcl::solver::dense_lu<value_type>::params prm;
+        prm.inverse = inverse;
+
+        amgcl::solver::dense_lu<value_type> solve(A, prm);
+
+        std::vector<rhs_type> x(n);
+        std::vector<rhs_type> r(n);
+
+        solve(rhs, x);
+
+        amgcl::backend::residual(rhs, A, x, r);
+
+        BOOST_CHECK_SMALL(sqrt(amgcl::backend::inner_product(r, r)), 1e-8);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(auto_lu)
+{
+    std::vector<ptrdiff_t> ptr;
+    std::vector<ptrdiff_t> col;
+    std::vector<double>    val;
+    std::vector<double>    rhs;
+
+    // The share of the nonzero entries in the sample problem is about 3%
+    // for the 4x4x4 grid, and 0.7% for the 8x8x8 grid.
+    amgcl::solver::auto_lu<double>::params prm;
+    prm.density = 0.02f;
+
+    for(int m : {4, 8}) {
+        size_t n = sample_problem(m, val, col, ptr, rhs);
+
+        auto A = amgcl::adapter::zero_copy(n, ptr.data(), col.data(), val.data());
+
+        amgcl::solver::auto_lu<double> solve(*A, prm);
+        BOOST_CHECK_EQUAL(solve.is_dense(), m == 4);
+
+        std::vector<double> x(n);
+        std::vector<double> r(n);
+
+        solve(rhs, x);
+
+        amgcl::backend::residual(rhs, *A, x, r);
+
+        BOOST_CHECK_SMALL(sqrt(amgcl::backend::inner_product(r, r)), 1e-8);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(dense_lu_coarse_solver)
+{
+    typedef amgcl::backend::builtin<double, ptrdiff_t, ptrdiff_t,
+            amgcl::solver::dense_lu<double> > Backend;
+
+    typedef amgcl::make_solver<
+        amgcl::amg<
+            Backend,
+            amgcl::coarsening::smoothed_aggregation,
+            amgcl::relaxation::spai0
+            >,
+        amgcl::solver::bicgstab<Backend>
+        > Solver;
+
+    std::vector<ptrdiff_t> ptr;
+    std::vector<ptrdiff_t> col;
+    std::vector<double>    val;
+    std::vector<double>    rhs;
+
+    size_t n = sample_problem(32, val, col, ptr, rhs);
+
+    Solver solve(std::tie(n, ptr, col, val));
+
+    std::vector<double> x(n, 0.0);
+    size_t iters;
+    double error;
+
+    std::tie(iters, error) = solve(rhs, x);
+
+    BOOST_CHECK_SMALL(error, 1e-8);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -1,7 +1,16 @@
 #define BOOST_TEST_MODULE TestSkylineLU
 #include <boost/test/unit_test.hpp>
 
+#include <sstream>
+
 #include <amgcl/io/mm.hpp>
+#include <amgcl/io/binary.hpp>
+#include <amgcl/backend/builtin.hpp>
+#include <amgcl/make_solver.hpp>
+#include <amgcl/amg.hpp>
+#include <amgcl/coarsening/smoothed_aggregation.hpp>
+#include <amgcl/relaxation/spai0.hpp>
+#include <amgcl/solver/cg.hpp>
 #include <amgcl/adapter/crs_tuple.hpp>
 #include <amgcl/profiler.hpp>
 #include "sample_problem.hpp"
@@ -48,5 +57,52 @@ BOOST_AUTO_TEST_CASE(io_mm)
     }
 }
 
+BOOST_AUTO_TEST_CASE(io_hierarchy)
+{
+    typedef amgcl::backend::builtin<double> Backend;
+
+    typedef amgcl::make_solver<
+        amgcl::amg<
+            Backend,
+            amgcl::coarsening::smoothed_aggregation,
+            amgcl::relaxation::spai0
+            >,
+        amgcl::solver::cg<Backend>
+        > Solver;
+
+    std::vector<ptrdiff_t> ptr;
+    std::vector<ptrdiff_t> col;
+    std::vector<double>    val;
+    std::vector<double>    rhs;
+
+    size_t n = sample_problem(32, val, col, ptr, rhs);
+
+    Solver::params prm;
+    prm.precond.coarse_enough = 500;
+
+    Solver solve1(std::tie(n, ptr, col, val), prm);
+
+    std::stringstream f(std::ios::in | std::ios::out | std::ios::binary);
+    solve1.save(f);
+
+    Solver solve2(amgcl::io::saved_hierarchy(f), prm);
+
+    BOOST_CHECK_EQUAL(solve1.precond().bytes(), solve2.precond().bytes());
+
+    std::vector<double> x1(n, 0.0), x2(n, 0.0);
+
+    size_t iters1, iters2;
+    double error1, error2;
+
+    std::tie(iters1, error1) = solve1(rhs, x1);
+    std::tie(iters2, error2) = solve2(rhs, x2);
+
+    // The loaded hierarchy is identical to the saved one.
+    BOOST_CHECK_EQUAL(iters1, iters2);
+    BOOST_CHECK_EQUAL(error1, error2);
+    for(size_t i = 0; i < n; ++i)
+        BOOST_CHECK_EQUAL(x1[i], x2[i]);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
@@ -0,0 +1,290 @@
+#define BOOST_TEST_MODULE TestMultiVector
+#include <boost/test/unit_test.hpp>
+
+#include <amgcl/backend/builtin.hpp>
+#include <amgcl/backend/multi_vector.hpp>
+#include <amgcl/amg.hpp>
+#include <amgcl/make_solver.hpp>
+#include <amgcl/solver/runtime.hpp>
+#include <amgcl/coarsening/runtime.hpp>
+#include <amgcl/relaxation/runtime.hpp>
+#include <amgcl/adapter/crs_tuple.hpp>
+#include <amgcl/profiler.hpp>
+#include "sample_problem.hpp"
+
+namespace amgcl {
+    profiler<> prof;
+}
+
+BOOST_AUTO_TEST_SUITE( test_multi_vector )
+
+BOOST_AUTO_TEST_CASE(multi_vector_ops)
+{
+    typedef amgcl::backend::multi_vector<double> mvec;
+
+    std::vector<ptrdiff_t> ptr;
+    std::vector<ptrdiff_t> col;
+    std::vector<double>    val;
+    std::vector<double>    rhs;
+
+    const ptrdiff_t n = sample_problem(16, val, col, ptr, rhs);
+    const size_t    m = 3;
+
+    amgcl::backend::crs<double> A(std::tie(n, ptr, col, val));
+
+    mvec X(n, m), Y(n, m), R(n, m);
+    for(ptrdiff_t i = 0; i < n; ++i)
+        for(size_t j = 0; j < m; ++j) {
+            X(i,j) = 1.0 / (1 + i + j);
+            Y(i,j) = 1.0 * j - i % 3;
+        }
+
+    amgcl::backend::spmv(2.0, A, X, 0.5, Y);
+    amgcl::backend::residual(Y, A, X, R);
+
+    std::vector<double> s;
+    amgcl::backend::column_inner_products(X, R, s);
+
+    for(size_t j = 0; j < m; ++j) {
+        amgcl::backend::numa_vector<double> x(n), y(n), r(n);
+
+        for(ptrdiff_t i = 0; i < n; ++i) {
+            x[i] = 1.0 / (1 + i + j);
+            y[i] = 1.0 * j - i % 3;
+        }
+
+        amgcl::backend::spmv(2.0, A, x, 0.5, y);
+        amgcl::backend::residual(y, A, x, r);
+
+        for(ptrdiff_t i = 0; i < n; ++i) {
+            BOOST_CHECK_CLOSE(Y(i,j), y[i], 1e-8);
+            BOOST_CHECK_CLOSE(R(i,j), r[i], 1e-8);
+        }
+
+        BOOST_CHECK_CLOSE(s[j], amgcl::backend::inner_product(x, r), 1e-8);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(multi_vector_amg)
+{
+    typedef amgcl::backend::builtin<double> Backend;
+    typedef amgcl::backend::multi_vector<double> mvec;
+
+    typedef amgcl::amg<
+        Backend,
+        amgcl::runtime::coarsening::wrapper,
+        amgcl::runtime::relaxation::wrapper
+        > AMG;
+
+    std::vector<ptrdiff_t> ptr;
+    std::vector<ptrdiff_t> col;
+    std::vector<double>    val;
+    std::vector<double>    rhs;
+
+    const ptrdiff_t n = sample_problem(16, val, col, ptr, rhs);
+    const size_t    m = 3;
+
+    amgcl::runtime::relaxation::type relaxation[] = {
+        amgcl::runtime::relaxation::spai0,
+        amgcl::runtime::relaxation::spai1,
+        amgcl::runtime::relaxation::damped_jacobi,
+        amgcl::runtime::relaxation::gauss_seidel,
+        amgcl::runtime::relaxation::ilu0,
+        amgcl::runtime::relaxation::iluk,
+        amgcl::runtime::relaxation::ilup,
+        amgcl::runtime::relaxation::ilut,
+        amgcl::runtime::relaxation::chebyshev
+    };
+
+    for(amgcl::runtime::relaxation::type r : relaxation) {
+        for(int serial = 0; serial < 2; ++serial) {
+            boost::property_tree::ptree prm;
+            prm.put("coarse_enough", 100);
+            prm.put("relax.type", r);
+
+            switch (r) {
+                case amgcl::runtime::relaxation::gauss_seidel:
+                case amgcl::runtime::relaxation::ilu0:
+                case amgcl::runtime::relaxation::iluk:
+                case amgcl::runtime::relaxation::ilup:
+                case amgcl::runtime::relaxation::ilut:
+                    prm.put("relax.serial", serial);
+                    prm.put("relax.solve.serial", serial);
+                    break;
+                default:
+                    if (serial) continue;
+            }
+
+            // Only one of the parameters is valid for each of relaxations
+            if (r == amgcl::runtime::relaxation::gauss_seidel)
+                prm.erase("relax.solve");
+            else
+                prm.erase("relax.serial");
+
+            AMG amg(std::tie(n, ptr, col, val), prm);
+
+            mvec F(n, m), X(n, m);
+            for(ptrdiff_t i = 0; i < n; ++i)
+                for(size_t j = 0; j < m; ++j)
+                    F(i,j) = rhs[i] * (1 + j) + (i % (j + 2));
+
+            amg.apply(F, X);
+
+            for(size_t j = 0; j < m; ++j) {
+                amgcl::backend::numa_vector<double> f(n), x(n);
+                F.get_column(j, f);
+                amg.apply(f, x);
+
+                for(ptrdiff_t i = 0; i < n; ++i)
+                    BOOST_CHECK_SMALL(X(i,j) - x[i], 1e-10);
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(block_solvers)
+{
+    typedef amgcl::backend::builtin<double> Backend;
+    typedef amgcl::backend::multi_vector<double> mvec;
+
+    typedef amgcl::make_solver<
+        amgcl::amg<
+            Backend,
+            amgcl::runtime::coarsening::wrapper,
+            amgcl::runtime::relaxation::wrapper
+            >,
+        amgcl::runtime::solver::wrapper<Backend>
+        > Solver;
+
+    std::vector<ptrdiff_t> ptr;
+    std::vector<ptrdiff_t> col;
+    std::vector<double>    val;
+    std::vector<double>    rhs;
+
+    const ptrdiff_t n = sample_problem(32, val, col, ptr, rhs);
+    const size_t    m = 4;
+
+    amgcl::backend::crs<double> A(std::tie(n, ptr, col, val));
+
+    // The third column is zero, and the last one duplicates the first one.
+    mvec F(n, m);
+    for(ptrdiff_t i = 0; i < n; ++i) {
+        F(i,0) = rhs[i];
+        F(i,1) = 1.0 * (i % 7) - 3;
+        F(i,2) = 0;
+        F(i,3) = 2 * rhs[i];
+    }
+
+    amgcl::runtime::solver::type solver[] = {
+        amgcl::runtime::solver::block_cg,
+        amgcl::runtime::solver::block_gmres
+    };
+
+    for(amgcl::runtime::solver::type s : solver) {
+        boost::property_tree::ptree prm;
+        prm.put("precond.coarse_enough", 500);
+        prm.put("solver.type", s);
+        prm.put("solver.tol", 1e-8);
+
+        Solver solve(std::tie(n, ptr, col, val), prm);
+
+        mvec X(n, m), R(n, m);
+        for(ptrdiff_t i = 0; i < n; ++i)
+            for(size_t j = 0; j < m; ++j) X(i,j) = 1;
+
+        size_t iters;
+        double error;
+        std::tie(iters, error) = solve(F, X);
+
+        BOOST_CHECK(iters > 0);
+        BOOST_CHECK_SMALL(error, 1e-8);
+
+        amgcl::backend::residual(F, A, X, R);
+
+        std::vector<double> rr, ff;
+        amgcl::backend::column_inner_products(R, R, rr);
+        amgcl::backend::column_inner_products(F, F, ff);
+
+        for(size_t j = 0; j < m; ++j) {
+            if (j == 2) {
+                BOOST_CHECK_EQUAL(rr[j], 0.0);
+            } else {
+                BOOST_CHECK_SMALL(sqrt(rr[j] / ff[j]), 1e-7);
+            }
+        }
+
+        // The block solvers need multi-vectors.
+        amgcl::backend::numa_vector<double> f(n), x(n);
+        BOOST_CHECK_THROW(solve(f, x), std::logic_error);
+    }
+
+    // The single vector solvers do not accept multi-vectors.
+    boost::property_tree::ptree prm;
+    prm.put("solver.type", amgcl::runtime::solver::cg);
+    Solver solve(std::tie(n, ptr, col, val), prm);
+
+    mvec X(n, m);
+    BOOST_CHECK_THROW(solve(F, X), std::logic_error);
+}
+
+BOOST_AUTO_TEST_CASE(amg_cycles)
+{
+    typedef amgcl::backend::builtin<double> Backend;
+    typedef amgcl::backend::multi_vector<double> mvec;
+
+    typedef amgcl::amg<
+        Backend,
+        amgcl::runtime::coarsening::wrapper,
+        amgcl::runtime::relaxation::wrapper
+        > AMG;
+
+    std::vector<ptrdiff_t> ptr;
+    std::vector<ptrdiff_t> col;
+    std::vector<double>    val;
+    std::vector<double>    rhs;
+
+    const ptrdiff_t n = sample_problem(32, val, col, ptr, rhs);
+    const size_t    m = 2;
+
+    mvec F(n, m);
+    for(ptrdiff_t i = 0; i < n; ++i)
+        for(size_t j = 0; j < m; ++j)
+            F(i,j) = rhs[i] * (1 + j) + (i % (j + 2));
+
+    amgcl::cycle_type::type cycle[] = {
+        amgcl::cycle_type::standard,
+        amgcl::cycle_type::fcycle,
+        amgcl::cycle_type::kcycle,
+        amgcl::cycle_type::additive
+    };
+
+    for(amgcl::cycle_type::type c : cycle) {
+        boost::property_tree::ptree prm;
+        prm.put("coarse_enough", 100);
+        prm.put("coarsening.type", amgcl::runtime::coarsening::aggregation);
+        prm.put("cycle", c);
+
+        AMG amg(std::tie(n, ptr, col, val), prm);
+
+        mvec X(n, m);
+        amg.apply(F, X);
+
+        // The K-cycle falls back to the standard cycle for multi-vectors,
+        // the other cycles are applied to each of the columns.
+        if (c == amgcl::cycle_type::kcycle)
+            prm.put("cycle", amgcl::cycle_type::standard);
+
+        AMG ref(std::tie(n, ptr, col, val), prm);
+
+        for(size_t j = 0; j < m; ++j) {
+            amgcl::backend::numa_vector<double> f(n), x(n);
+            F.get_column(j, f);
+            ref.apply(f, x);
+
+            for(ptrdiff_t i = 0; i < n; ++i)
+                BOOST_CHECK_SMALL(X(i,j) - x[i], 1e-10);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
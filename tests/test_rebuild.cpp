@@ -0,0 +1,171 @@
+#define BOOST_TEST_MODULE TestRebuild
+#include <boost/test/unit_test.hpp>
+
+#include <vector>
+#include <string>
+
+#include <amgcl/backend/builtin.hpp>
+#include <amgcl/amg.hpp>
+#include <amgcl/make_solver.hpp>
+#include <amgcl/coarsening/runtime.hpp>
+#include <amgcl/relaxation/runtime.hpp>
+#include <amgcl/solver/cg.hpp>
+#include <amgcl/preconditioner/runtime.hpp>
+#include <amgcl/adapter/crs_tuple.hpp>
+#include <amgcl/profiler.hpp>
+#include "sample_problem.hpp"
+
+namespace amgcl {
+    profiler<> prof;
+}
+
+typedef amgcl::backend::builtin<double> Backend;
+
+typedef amgcl::amg<
+    Backend,
+    amgcl::runtime::coarsening::wrapper,
+    amgcl::runtime::relaxation::wrapper
+    > AMG;
+
+BOOST_AUTO_TEST_SUITE( test_rebuild )
+
+BOOST_AUTO_TEST_CASE(numeric_rebuild)
+{
+    std::vector<ptrdiff_t> ptr;
+    std::vector<ptrdiff_t> col;
+    std::vector<double>    val;
+    std::vector<double>    rhs;
+
+    const ptrdiff_t n = sample_problem(24, val, col, ptr, rhs);
+
+    // Scaling does not change the aggregates or the C/F splitting, so the
+    // rebuilt hierarchy should match the one constructed from scratch.
+    std::vector<double> val2(val);
+    for(auto &v : val2) v *= 2.5;
+
+    const char *coarsening[] = {
+        "aggregation", "smoothed_aggregation", "smoothed_aggr_emin", "ruge_stuben"
+    };
+
+    for(const char *c : coarsening) {
+        BOOST_TEST_MESSAGE("coarsening: " << c);
+
+        boost::property_tree::ptree prm;
+        prm.put("coarsening.type", c);
+        prm.put("relax.type", "spai0");
+        prm.put("coarse_enough", 500);
+        prm.put("allow_rebuild", true);
+
+        AMG amg(std::tie(n, ptr, col, val), prm);
+        amg.rebuild(std::tie(n, ptr, col, val2));
+
+        AMG ref(std::tie(n, ptr, col, val2), prm);
+
+        std::vector<double> x0(n, 0.0), x1(n, 0.0);
+        ref.apply(rhs, x0);
+        amg.apply(rhs, x1);
+
+        for(ptrdiff_t i = 0; i < n; ++i)
+            BOOST_CHECK_CLOSE(x0[i], x1[i], 1e-8);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(rebuild_solver)
+{
+    std::vector<ptrdiff_t> ptr;
+    std::vector<ptrdiff_t> col;
+    std::vector<double>    val;
+    std::vector<double>    rhs;
+
+    const ptrdiff_t n = sample_problem(24, val, col, ptr, rhs);
+
+    typedef amgcl::make_solver<AMG, amgcl::solver::cg<Backend> > Solver;
+
+    Solver::params prm;
+    prm.precond.allow_rebuild = true;
+
+    Solver solve(std::tie(n, ptr, col, val), prm);
+
+    // Change the values keeping the matrix symmetric and diagonally dominant.
+    for(ptrdiff_t i = 0; i < n; ++i)
+        for(ptrdiff_t j = ptr[i]; j < ptr[i+1]; ++j)
+            val[j] *= 1 + 0.5 * ((i + col[j]) % 3);
+
+    for(ptrdiff_t i = 0; i < n; ++i) {
+        double s = 0;
+        for(ptrdiff_t j = ptr[i]; j < ptr[i+1]; ++j)
+            if (col[j] != i) s += std::abs(val[j]);
+        for(ptrdiff_t j = ptr[i]; j < ptr[i+1]; ++j)
+            if (col[j] == i) val[j] = std::max(val[j], s);
+    }
+
+    auto A = std::tie(n, ptr, col, val);
+    solve.rebuild(A);
+
+    std::vector<double> x(n, 0.0);
+    size_t iters;
+    double error;
+    std::tie(iters, error) = solve(A, rhs, x);
+
+    BOOST_CHECK_SMALL(error, 1e-8);
+
+    // Different nonzero pattern.
+    col.back() = 0;
+    BOOST_CHECK_THROW(solve.rebuild(A), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(reuse_transfer_operators)
+{
+    std::vector<ptrdiff_t> ptr;
+    std::vector<ptrdiff_t> col;
+    std::vector<double>    val;
+    std::vector<double>    rhs;
+
+    const ptrdiff_t n = sample_problem(24, val, col, ptr, rhs);
+
+    typedef amgcl::make_solver<
+        amgcl::runtime::preconditioner<Backend>,
+        amgcl::solver::cg<Backend>
+        > Solver;
+
+    boost::property_tree::ptree prm;
+    prm.put("precond.class", "amg");
+    prm.put("precond.allow_rebuild", true);
+
+    Solver solve(std::tie(n, ptr, col, val), prm);
+
+    // Scale the matrix and add explicit zeros to the first and the last
+    // rows, so that the nonzero pattern changes.
+    std::vector<ptrdiff_t> ptr2(1, 0);
+    std::vector<ptrdiff_t> col2;
+    std::vector<double>    val2;
+
+    for(ptrdiff_t i = 0; i < n; ++i) {
+        for(ptrdiff_t j = ptr[i]; j < ptr[i+1]; ++j) {
+            col2.push_back(col[j]);
+            val2.push_back(val[j] * (1 + 0.1 * (i % 7)) * (1 + 0.1 * (col[j] % 7)));
+        }
+        if (i == 0)     { col2.push_back(n - 1); val2.push_back(0.0); }
+        if (i == n - 1) { col2.push_back(0);     val2.push_back(0.0); }
+        ptr2.push_back(col2.size());
+    }
+
+    auto A = std::tie(n, ptr2, col2, val2);
+
+    // The transfer operators may not be recomputed for a different pattern.
+    BOOST_CHECK_THROW(solve.rebuild(A), std::runtime_error);
+
+    solve.rebuild(A, /*update_transfer_ops*/false);
+
+    std::vector<double> x(n, 0.0);
+    size_t iters;
+    double error;
+    std::tie(iters, error) = solve(A, rhs, x);
+
+    BOOST_CHECK_SMALL(error, 1e-8);
+
+    // The coarsening data refers to the old pattern now.
+    BOOST_CHECK_THROW(solve.rebuild(A), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
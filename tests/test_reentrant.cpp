@@ -0,0 +1,112 @@
+#define BOOST_TEST_MODULE TestReentrant
+#include <boost/test/unit_test.hpp>
+
+#include <thread>
+#include <vector>
+
+#include <amgcl/backend/builtin.hpp>
+#include <amgcl/amg.hpp>
+#include <amgcl/make_solver.hpp>
+#include <amgcl/coarsening/smoothed_aggregation.hpp>
+#include <amgcl/relaxation/chebyshev.hpp>
+#include <amgcl/solver/runtime.hpp>
+#include <amgcl/adapter/crs_tuple.hpp>
+#include <amgcl/profiler.hpp>
+#include "sample_problem.hpp"
+
+namespace amgcl {
+    profiler<> prof;
+}
+
+typedef amgcl::backend::builtin<double> Backend;
+
+typedef amgcl::amg<
+    Backend,
+    amgcl::coarsening::smoothed_aggregation,
+    amgcl::relaxation::chebyshev
+    > AMG;
+
+BOOST_AUTO_TEST_SUITE( test_reentrant )
+
+BOOST_AUTO_TEST_CASE(concurrent_solve)
+{
+    std::vector<ptrdiff_t> ptr;
+    std::vector<ptrdiff_t> col;
+    std::vector<double>    val;
+    std::vector<double>    rhs;
+
+    const ptrdiff_t n = sample_problem(24, val, col, ptr, rhs);
+    const int nthreads = 4;
+
+    boost::property_tree::ptree prm;
+    prm.put("solver.type", "bicgstab");
+
+    amgcl::make_solver<AMG, amgcl::runtime::solver::wrapper<Backend> > solve(
+            std::tie(n, ptr, col, val), prm);
+
+    // Each thread solves the system for its own right-hand side.
+    std::vector< std::vector<double> > f(nthreads, rhs);
+    for(int t = 0; t < nthreads; ++t)
+        for(ptrdiff_t i = 0; i < n; ++i)
+            f[t][i] *= 1 + (t + i) % (t + 2);
+
+    std::vector< std::vector<double> > x0(nthreads, std::vector<double>(n, 0.0));
+    std::vector< std::vector<double> > x1(nthreads, std::vector<double>(n, 0.0));
+    std::vector<size_t> it0(nthreads), it1(nthreads);
+
+    // Serial reference.
+    for(int t = 0; t < nthreads; ++t) {
+        double err;
+        std::tie(it0[t], err) = solve(f[t], x0[t]);
+        BOOST_CHECK_SMALL(err, 1e-8);
+    }
+
+    for(int k = 0; k < 3; ++k) {
+        std::vector<std::thread> pool;
+        for(int t = 0; t < nthreads; ++t) {
+            pool.emplace_back([&, t]() {
+                    std::fill(x1[t].begin(), x1[t].end(), 0.0);
+                    double err;
+                    std::tie(it1[t], err) = solve(f[t], x1[t]);
+                    });
+        }
+        for(auto &t : pool) t.join();
+
+        for(int t = 0; t < nthreads; ++t) {
+            BOOST_CHECK_EQUAL(it0[t], it1[t]);
+            for(ptrdiff_t i = 0; i < n; ++i)
+                BOOST_CHECK_CLOSE(x0[t][i], x1[t][i], 1e-8);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(explicit_workspace)
+{
+    std::vector<ptrdiff_t> ptr;
+    std::vector<ptrdiff_t> col;
+    std::vector<double>    val;
+    std::vector<double>    rhs;
+
+    const ptrdiff_t n = sample_problem(16, val, col, ptr, rhs);
+    const int nthreads = 3;
+
+    AMG amg(std::tie(n, ptr, col, val));
+
+    std::vector<double> x0(n, 0.0);
+    amg.apply(rhs, x0);
+
+    std::vector< std::vector<double> > x(nthreads, std::vector<double>(n, 0.0));
+    std::vector< std::shared_ptr<AMG::workspace> > ws(nthreads);
+    for(int t = 0; t < nthreads; ++t) ws[t] = amg.create_workspace();
+
+    std::vector<std::thread> pool;
+    for(int t = 0; t < nthreads; ++t)
+        pool.emplace_back([&, t]() { amg.apply(rhs, x[t], *ws[t]); });
+    for(auto &t : pool) t.join();
+
+    for(int t = 0; t < nthreads; ++t)
+        for(ptrdiff_t i = 0; i < n; ++i)
+            BOOST_CHECK_CLOSE(x0[i], x[t][i], 1e-8);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,218 @@
+#define BOOST_TEST_MODULE TestRelaxation
+#include <boost/test/unit_test.hpp>
+
+#include <vector>
+
+#include <amgcl/backend/builtin.hpp>
+#include <amgcl/value_type/static_matrix.hpp>
+#include <amgcl/adapter/crs_tuple.hpp>
+#include <amgcl/make_solver.hpp>
+#include <amgcl/amg.hpp>
+#include <amgcl/coarsening/smoothed_aggregation.hpp>
+#include <amgcl/relaxation/runtime.hpp>
+#include <amgcl/relaxation/as_preconditioner.hpp>
+#include <amgcl/relaxation/ilu0.hpp>
+#include <amgcl/relaxation/iluk.hpp>
+#include <amgcl/relaxation/ilup.hpp>
+#include <amgcl/solver/bicgstab.hpp>
+#include <amgcl/solver/runtime.hpp>
+#include <amgcl/profiler.hpp>
+#include "sample_problem.hpp"
+
+namespace amgcl {
+    profiler<> prof;
+}
+
+namespace {
+
+// Applies the smoother constructed with the given factorization algorithm to
+// the right-hand side.
+template <class Relax, class Matrix, class Vector>
+Vector apply_relax(const Matrix &A, const Vector &rhs,
+        amgcl::relaxation::ilu_factorization::type f)
+{
+    typedef typename Relax::value_type value_type;
+    typedef typename amgcl::backend::builtin<value_type>::params bprm;
+
+    typename Relax::params prm;
+    prm.factorization = f;
+
+    Relax relax(A, prm, bprm());
+
+    Vector x(rhs.size());
+    relax.apply(A, rhs, x);
+    return x;
+}
+
+template <template <class> class Relax>
+void test_ilu_factorization(bool exact = true) {
+    typedef amgcl::backend::builtin<double> Backend;
+    typedef amgcl::relaxation::ilu_factorization::type type;
+
+    std::vector<ptrdiff_t> ptr;
+    std::vector<ptrdiff_t> col;
+    std::vector<double>    val;
+    std::vector<double>    rhs;
+
+    const ptrdiff_t n = sample_problem(16, val, col, ptr, rhs);
+    auto A = std::make_shared<Backend::matrix>(std::tie(n, ptr, col, val));
+
+    // Level-scheduled factorization gives the same factors as the serial one.
+    if (exact) {
+        auto x0 = apply_relax< Relax<Backend> >(*A, rhs, amgcl::relaxation::ilu_factorization::serial);
+        auto x1 = apply_relax< Relax<Backend> >(*A, rhs, amgcl::relaxation::ilu_factorization::levels);
+
+        for(ptrdiff_t i = 0; i < n; ++i)
+            BOOST_CHECK_CLOSE(x0[i], x1[i], 1e-8);
+    }
+
+    // All of the algorithms give a decent preconditioner.
+    typedef amgcl::make_solver<
+        amgcl::relaxation::as_preconditioner<Backend, Relax>,
+        amgcl::solver::bicgstab<Backend>
+        > Solver;
+
+    for(type f : {type::serial, type::levels, type::iterative}) {
+        typename Solver::params prm;
+        prm.precond.factorization = f;
+
+        Solver solve(*A, prm);
+
+        std::vector<double> x(n, 0.0);
+        size_t iters;
+        double error;
+
+        std::tie(iters, error) = solve(rhs, x);
+
+        BOOST_CHECK_SMALL(error, 1e-8);
+        BOOST_CHECK_LT(iters, 50u);
+    }
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE( test_relaxation )
+
+BOOST_AUTO_TEST_CASE(ilu0_factorization)
+{
+    test_ilu_factorization<amgcl::relaxation::ilu0>();
+}
+
+BOOST_AUTO_TEST_CASE(iluk_factorization)
+{
+    // The serial ILU(k) drops the fill-in on the first access when its level
+    // is too high, so the factors may slightly differ from the ILU(0) on the
+    // ILU(k) pattern used with the parallel algorithms.
+    test_ilu_factorization<amgcl::relaxation::iluk>(false);
+
+    // Hence the serial algorithm is the default for any number of threads.
+    typedef amgcl::relaxation::iluk< amgcl::backend::builtin<double> > ILUK;
+#ifdef _OPENMP
+    int nt = omp_get_max_threads();
+    omp_set_num_threads(4);
+#endif
+    BOOST_CHECK_EQUAL(ILUK::params().factorization, amgcl::relaxation::ilu_factorization::serial);
+#ifdef _OPENMP
+    omp_set_num_threads(nt);
+#endif
+}
+
+BOOST_AUTO_TEST_CASE(ilup_factorization)
+{
+    test_ilu_factorization<amgcl::relaxation::ilup>();
+}
+
+BOOST_AUTO_TEST_CASE(ilu0_block_factorization)
+{
+    typedef amgcl::static_matrix<double, 2, 2> value_type;
+    typedef amgcl::static_matrix<double, 2, 1> rhs_type;
+    typedef amgcl::backend::builtin<value_type> Backend;
+
+    std::vector<ptrdiff_t>   ptr;
+    std::vector<ptrdiff_t>   col;
+    std::vector<value_type>  val;
+    std::vector<rhs_type>    rhs;
+
+    const ptrdiff_t n = sample_problem(16, val, col, ptr, rhs);
+    auto A = std::make_shared<Backend::matrix>(std::tie(n, ptr, col, val));
+
+    auto x0 = apply_relax< amgcl::relaxation::ilu0<Backend> >(*A, rhs, amgcl::relaxation::ilu_factorization::serial);
+    auto x1 = apply_relax< amgcl::relaxation::ilu0<Backend> >(*A, rhs, amgcl::relaxation::ilu_factorization::levels);
+
+    for(ptrdiff_t i = 0; i < n; ++i) {
+        BOOST_CHECK_CLOSE(x0[i](0,0), x1[i](0,0), 1e-8);
+        BOOST_CHECK_CLOSE(x0[i](1,0), x1[i](1,0), 1e-8);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(per_level_relaxation)
+{
+    typedef amgcl::backend::builtin<double> Backend;
+    typedef amgcl::amg<
+        Backend,
+        amgcl::coarsening::smoothed_aggregation,
+        amgcl::runtime::relaxation::wrapper
+        > AMG;
+
+    std::vector<ptrdiff_t> ptr;
+    std::vector<ptrdiff_t> col;
+    std::vector<double>    val;
+    std::vector<double>    rhs;
+
+    const ptrdiff_t n = sample_problem(32, val, col, ptr, rhs);
+
+    // The overrides of every level are applied instead of the global
+    // smoother.
+    {
+        boost::property_tree::ptree p0, p1;
+        p0.put("coarse_enough", 100);
+        p0.put("relax.type", "spai0");
+
+        p1.put("coarse_enough", 100);
+        p1.put("relax.type", "damped_jacobi");
+        for(int i = 0; i < 10; ++i)
+            p1.put("level." + std::to_string(i) + ".relax.type", "spai0");
+
+        AMG amg0(std::tie(n, ptr, col, val), p0);
+        AMG amg1(std::tie(n, ptr, col, val), p1);
+
+        std::vector<double> x0(n), x1(n);
+        amg0.apply(rhs, x0);
+        amg1.apply(rhs, x1);
+
+        for(ptrdiff_t i = 0; i < n; ++i)
+            BOOST_CHECK_CLOSE(x0[i], x1[i], 1e-8);
+    }
+
+    // Different smoothers and numbers of sweeps on each level.
+    {
+        typedef amgcl::make_solver<AMG, amgcl::runtime::solver::wrapper<Backend> > Solver;
+
+        boost::property_tree::ptree prm;
+        prm.put("solver.type", "bicgstab");
+        prm.put("precond.coarse_enough", 100);
+        prm.put("precond.relax.type", "chebyshev");
+        prm.put("precond.level.0.relax.type", "ilu0");
+        prm.put("precond.level.2.relax.type", "gauss_seidel");
+        prm.put("precond.level.2.npre", 2);
+        prm.put("precond.level.2.npost", 2);
+
+        Solver solve(std::tie(n, ptr, col, val), prm);
+
+        std::vector<double> x(n, 0.0);
+        size_t iters;
+        double error;
+        std::tie(iters, error) = solve(rhs, x);
+
+        BOOST_CHECK_SMALL(error, 1e-8);
+
+        // The overrides are exported with the rest of the parameters.
+        boost::property_tree::ptree p;
+        solve.precond().prm.get(p, "");
+        BOOST_CHECK_EQUAL(p.get<std::string>("level.0.relax.type"), "ilu0");
+        BOOST_CHECK_EQUAL(p.get<unsigned>("level.2.npre"), 2u);
+        BOOST_CHECK_EQUAL(p.get<unsigned>("level.0.npre"), 1u);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -19,6 +19,45 @@ namespace amgcl {
     profiler<> prof;
 }
 
+//---------------------------------------------------------------------------
+// Converts the input matrix to the internal format of the backend (this is
+// only needed when the backend uses non-default index types).
+template <class Backend, class Matrix>
+std::shared_ptr<Matrix> build_matrix(std::shared_ptr<Matrix> A, std::true_type) {
+    return A;
+}
+
+template <class Backend, class Matrix>
+std::shared_ptr<
+    typename amgcl::backend::builtin<
+        typename Backend::value_type,
+        typename Backend::col_type,
+        typename Backend::ptr_type
+        >::matrix
+    >
+build_matrix(std::shared_ptr<Matrix> A, std::false_type) {
+    typedef typename amgcl::backend::builtin<
+        typename Backend::value_type,
+        typename Backend::col_type,
+        typename Backend::ptr_type
+        >::matrix matrix_type;
+
+    return std::make_shared<matrix_type>(*A);
+}
+
+template <class Backend, class Matrix>
+auto build_matrix(std::shared_ptr<Matrix> A) ->
+    decltype(build_matrix<Backend>(A, std::false_type()))
+{
+    typedef typename amgcl::backend::builtin<
+        typename Backend::value_type,
+        typename Backend::col_type,
+        typename Backend::ptr_type
+        >::matrix matrix_type;
+
+    return build_matrix<Backend>(A, std::is_same<Matrix, matrix_type>());
+}
+
 //---------------------------------------------------------------------------
 template <class Backend, class Matrix>
 void test_solver(
@@ -28,21 +67,23 @@ void test_solver(
         amgcl::runtime::solver::type     solver,
         amgcl::runtime::relaxation::type relaxation,
         amgcl::runtime::coarsening::type coarsening,
-        bool test_null_space = false
+        bool test_null_space = false,
+        amgcl::cycle_type::type cycle = amgcl::cycle_type::standard
         )
 {
     boost::property_tree::ptree prm;
     prm.put("precond.coarse_enough",   500);
     prm.put("precond.coarsening.type", coarsening);
     prm.put("precond.relax.type",      relaxation);
+    prm.put("precond.cycle",           cycle);
     prm.put("solver.type",             solver);
 
-    typedef typename Backend::value_type value_type;
-    std::vector<value_type> null;
+    // The near null-space vectors are always passed in double precision.
+    std::vector<double> null;
 
     if (test_null_space) {
         size_t n = amgcl::backend::rows(*A);
-        null.resize(n, amgcl::math::constant<value_type>(1));
+        null.resize(n, 1.0);
 
         prm.put("precond.coarsening.nullspace.cols", 1);
         prm.put("precond.coarsening.nullspace.rows", n);
@@ -52,7 +93,7 @@ void test_solver(
     amgcl::make_solver<
         amgcl::amg<Backend, amgcl::runtime::coarsening::wrapper, amgcl::runtime::relaxation::wrapper>,
         amgcl::runtime::solver::wrapper<Backend>
-        > solve(A, prm);
+        > solve(build_matrix<Backend>(A), prm);
 
     std::cout << solve.precond() << std::endl;
 
@@ -87,7 +128,7 @@ void test_rap(
     amgcl::make_solver<
         amgcl::relaxation::as_preconditioner<Backend, amgcl::runtime::relaxation::wrapper>,
         amgcl::runtime::solver::wrapper<Backend>
-        > solve(A, prm);
+        > solve(build_matrix<Backend>(A), prm);
 
     std::cout << "Using " << relaxation << " as preconditioner" << std::endl;
 
@@ -147,6 +188,12 @@ void test_problem(
         amgcl::runtime::solver::idrs
     };
 
+    amgcl::cycle_type::type cycle[] = {
+        amgcl::cycle_type::fcycle,
+        amgcl::cycle_type::kcycle,
+        amgcl::cycle_type::additive
+    };
+
     typename Backend::params prm;
 
     auto y = Backend::copy_vector(rhs, prm);
@@ -163,6 +210,16 @@ void test_problem(
         } catch(const std::logic_error&) {}
     }
 
+    // Test cycles (the K-cycle is a nonlinear preconditioner, so a flexible
+    // solver is used)
+    for(amgcl::cycle_type::type c : cycle) {
+        std::cout << "Cycle: " << c << std::endl;
+        test_solver<Backend>(
+                amgcl::adapter::zero_copy(n, ptr.data(), col.data(), val.data()),
+                y, x, amgcl::runtime::solver::fgmres, relaxation[0], coarsening[0],
+                false, c);
+    }
+
     // Test smoothers
     for(amgcl::runtime::relaxation::type r : relaxation) {
         std::cout << "Relaxation: " << r << std::endl;
@@ -11,4 +11,9 @@ BOOST_AUTO_TEST_CASE(test_builtin_backend)
     test_backend< amgcl::backend::builtin<double> >();
 }
 
+BOOST_AUTO_TEST_CASE(test_builtin_backend_int32)
+{
+    test_backend< amgcl::backend::builtin<double, int> >();
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,20 @@
+#define BOOST_TEST_MODULE TestSolvers
+#include <boost/test/unit_test.hpp>
+#include <amgcl/backend/builtin_mixed.hpp>
+#include <amgcl/value_type/static_matrix.hpp>
+
+#include "test_solver.hpp"
+
+BOOST_AUTO_TEST_SUITE( test_solvers )
+
+BOOST_AUTO_TEST_CASE(test_builtin_mixed_backend)
+{
+    test_backend< amgcl::backend::builtin_mixed<double> >();
+}
+
+BOOST_AUTO_TEST_CASE(test_builtin_mixed_backend_block)
+{
+    test_backend< amgcl::backend::builtin_mixed< amgcl::static_matrix<double, 2, 2> > >();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
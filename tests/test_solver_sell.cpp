@@ -0,0 +1,164 @@
+#define BOOST_TEST_MODULE TestSolvers
+#include <boost/test/unit_test.hpp>
+#include <amgcl/backend/sell.hpp>
+#include <amgcl/value_type/static_matrix.hpp>
+#include <amgcl/adapter/crs_tuple.hpp>
+
+#include "test_solver.hpp"
+
+// The test is also built with the AVX2 and AVX-512 target flags (see
+// tests/CMakeLists.txt) in order to cover the explicitly vectorized kernels.
+// Those builds are skipped on the CPUs without the instructions.
+bool simd_supported() {
+#if defined(__AVX512F__)
+    return __builtin_cpu_supports("avx512f");
+#elif defined(__AVX2__) && defined(__FMA__)
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#elif defined(__AVX2__)
+    return __builtin_cpu_supports("avx2");
+#else
+    return true;
+#endif
+}
+
+// Values for the SpMV tests. The blocks get distinct entries, so that a row
+// of the SELL matrix paired with a wrong vector element is noticed.
+template <class T>
+struct test_value {
+    static T get(double a) { return a; }
+};
+
+template <class T, int N, int M>
+struct test_value< amgcl::static_matrix<T, N, M> > {
+    static amgcl::static_matrix<T, N, M> get(double a) {
+        amgcl::static_matrix<T, N, M> v;
+        for(int i = 0; i < N; ++i)
+            for(int j = 0; j < M; ++j)
+                v(i,j) = a / (1 + i + 2 * j) + i - j;
+        return v;
+    }
+};
+
+// Compares SpMV and residual of the SELL matrix with the CRS ones for
+// several sorting scopes. The matrix has rows of different lengths
+// (including Dirichlet rows with the diagonal only), so that the rows are
+// actually reordered when sigma > 1.
+template <class V>
+void test_sell_sigma() {
+    typedef amgcl::backend::builtin_sell<V>            Backend;
+    typedef amgcl::backend::crs<V>                     Matrix;
+    typedef typename amgcl::math::rhs_of<V>::type      rhs_type;
+    typedef amgcl::backend::numa_vector<rhs_type>      vector;
+
+    const ptrdiff_t n = 203;
+
+    std::vector<ptrdiff_t> ptr(1, 0), col;
+    std::vector<V>         val;
+
+    for(ptrdiff_t i = 0; i < n; ++i) {
+        ptrdiff_t w = (i % 7 == 0) ? 0 : 1 + (i * 5) % 9;
+        for(ptrdiff_t j = std::max<ptrdiff_t>(0, i - w); j <= std::min(n - 1, i + w); ++j) {
+            col.push_back(j);
+            val.push_back(test_value<V>::get(i == j ? 4.0 + w : -1.0 / (1 + i + j)));
+        }
+        ptr.push_back(col.size());
+    }
+
+    auto A = std::make_shared<Matrix>(std::make_tuple(n, ptr, col, val));
+
+    vector x(n), f(n), y0(n);
+    for(ptrdiff_t i = 0; i < n; ++i) {
+        x[i]  = test_value<rhs_type>::get(std::sin(0.1 * i));
+        f[i]  = test_value<rhs_type>::get(std::cos(0.2 * i));
+        y0[i] = test_value<rhs_type>::get(1 + 0.5 * std::sin(0.3 * i));
+    }
+
+    const double alpha = 0.5, beta = -0.25;
+
+    vector y_ref(n), z_ref(n), r_ref(n);
+    amgcl::backend::spmv(alpha, *A, x, 0.0, y_ref);
+    amgcl::backend::copy(y0, z_ref);
+    amgcl::backend::spmv(alpha, *A, x, beta, z_ref);
+    amgcl::backend::residual(f, *A, x, r_ref);
+
+    const int chunk = Backend::matrix::chunk;
+
+    for(int sigma : {1, 2 * chunk, static_cast<int>(n), static_cast<int>(2 * n)}) {
+        typename Backend::params prm;
+        prm.sigma = sigma;
+
+        auto S = Backend::copy_matrix(A, prm);
+
+        BOOST_CHECK_EQUAL(amgcl::backend::nonzeros(*S), amgcl::backend::nonzeros(*A));
+
+        bool sorted = false;
+        for(ptrdiff_t i = 0; i < n; ++i) {
+            BOOST_CHECK_EQUAL(S->original(S->sorted(i)), i);
+            BOOST_CHECK_EQUAL(amgcl::backend::row_nonzeros(*S, i), amgcl::backend::row_nonzeros(*A, i));
+            if (S->sorted(i) != i) sorted = true;
+        }
+        BOOST_CHECK_EQUAL(sorted, sigma > 1);
+
+        vector y(n), z(n), r(n);
+        amgcl::backend::spmv(alpha, *S, x, 0.0, y);
+        amgcl::backend::copy(y0, z);
+        amgcl::backend::spmv(alpha, *S, x, beta, z);
+        amgcl::backend::residual(f, *S, x, r);
+
+        for(ptrdiff_t i = 0; i < n; ++i) {
+            BOOST_CHECK_SMALL(amgcl::math::norm(y[i] - y_ref[i]), 1e-12);
+            BOOST_CHECK_SMALL(amgcl::math::norm(z[i] - z_ref[i]), 1e-12);
+            BOOST_CHECK_SMALL(amgcl::math::norm(r[i] - r_ref[i]), 1e-12);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_SUITE( test_solvers )
+
+BOOST_AUTO_TEST_CASE(test_builtin_sell_backend)
+{
+    if (!simd_supported()) return;
+    test_backend< amgcl::backend::builtin_sell<double> >();
+}
+
+BOOST_AUTO_TEST_CASE(test_builtin_sell_backend_int32)
+{
+    if (!simd_supported()) return;
+    test_backend< amgcl::backend::builtin_sell<double, int> >();
+}
+
+BOOST_AUTO_TEST_CASE(test_builtin_sell_backend_float)
+{
+    if (!simd_supported()) return;
+
+    // Only the Poisson problem is solved here: IDR(s) breaks down on the
+    // trivial problem in single precision.
+    std::vector<ptrdiff_t> ptr;
+    std::vector<ptrdiff_t> col;
+    std::vector<float>     val;
+    std::vector<float>     rhs;
+
+    size_t n = sample_problem(32, val, col, ptr, rhs);
+
+    test_problem< amgcl::backend::builtin_sell<float> >(n, ptr, col, val, rhs);
+}
+
+BOOST_AUTO_TEST_CASE(test_builtin_sell_backend_block)
+{
+    if (!simd_supported()) return;
+    test_backend< amgcl::backend::builtin_sell< amgcl::static_matrix<double, 2, 2> > >();
+}
+
+BOOST_AUTO_TEST_CASE(test_builtin_sell_sigma)
+{
+    if (!simd_supported()) return;
+    test_sell_sigma<double>();
+}
+
+BOOST_AUTO_TEST_CASE(test_builtin_sell_sigma_block)
+{
+    if (!simd_supported()) return;
+    test_sell_sigma< amgcl::static_matrix<double, 2, 2> >();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,127 @@
+#define BOOST_TEST_MODULE TestSpGEMM
+#include <boost/test/unit_test.hpp>
+
+#include <vector>
+
+#include <amgcl/backend/builtin.hpp>
+#include <amgcl/adapter/crs_tuple.hpp>
+#include <amgcl/detail/spgemm.hpp>
+#include <amgcl/profiler.hpp>
+#include "sample_problem.hpp"
+
+namespace amgcl {
+    profiler<> prof;
+}
+
+typedef amgcl::backend::crs<double> Matrix;
+
+void check_equal(const Matrix &A, const Matrix &B) {
+    BOOST_REQUIRE_EQUAL(A.nrows, B.nrows);
+    BOOST_REQUIRE_EQUAL(A.ncols, B.ncols);
+
+    for(size_t i = 0; i <= A.nrows; ++i)
+        BOOST_REQUIRE_EQUAL(A.ptr[i], B.ptr[i]);
+
+    for(size_t j = 0; j < A.nnz; ++j) {
+        BOOST_CHECK_EQUAL(A.col[j], B.col[j]);
+        BOOST_CHECK_CLOSE(A.val[j], B.val[j], 1e-8);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE( test_spgemm )
+
+BOOST_AUTO_TEST_CASE(spgemm_algorithms)
+{
+    std::vector<ptrdiff_t> ptr;
+    std::vector<ptrdiff_t> col;
+    std::vector<double>    val;
+    std::vector<double>    rhs;
+
+    const ptrdiff_t n = sample_problem(16, val, col, ptr, rhs);
+    Matrix A(std::tie(n, ptr, col, val));
+
+    // Prolongation-like matrix with overlapping groups of columns.
+    const ptrdiff_t m = n / 4 + 1;
+    Matrix P;
+    P.set_size(n, m);
+    P.ptr[0] = 0;
+    for(ptrdiff_t i = 0; i < n; ++i)
+        P.ptr[i+1] = (i % 3 == 0) ? 0 : 1 + i % 2;
+    P.set_nonzeros(P.scan_row_sizes());
+    for(ptrdiff_t i = 0; i < n; ++i) {
+        for(ptrdiff_t j = P.ptr[i], k = 0; j < P.ptr[i+1]; ++j, ++k) {
+            P.col[j] = (i / 4 + k) % m;
+            P.val[j] = 1.0 / (1 + k + i % 5);
+        }
+    }
+
+    Matrix AP_saad, AP_rmerge, AP_hash, AP_auto;
+    amgcl::backend::spgemm_saad  (A, P, AP_saad, true);
+    amgcl::backend::spgemm_rmerge(A, P, AP_rmerge);
+    amgcl::backend::spgemm_hash  (A, P, AP_hash, true);
+    amgcl::backend::spgemm       (A, P, AP_auto, true);
+
+    check_equal(AP_saad, AP_rmerge);
+    check_equal(AP_saad, AP_hash);
+    check_equal(AP_saad, AP_auto);
+
+    // Unsorted result of the hash-based product has the same columns in the
+    // order of their appearance.
+    Matrix AA_saad, AA_hash;
+    amgcl::backend::spgemm_saad(A, A, AA_saad, false);
+    amgcl::backend::spgemm_hash(A, A, AA_hash, false);
+    check_equal(AA_saad, AA_hash);
+}
+
+BOOST_AUTO_TEST_CASE(triple_product)
+{
+    std::vector<ptrdiff_t> ptr;
+    std::vector<ptrdiff_t> col;
+    std::vector<double>    val;
+    std::vector<double>    rhs;
+
+    const ptrdiff_t n = sample_problem(16, val, col, ptr, rhs);
+    Matrix A(std::tie(n, ptr, col, val));
+
+    // Aggregation-like prolongation with a single nonzero per row.
+    const ptrdiff_t m = n / 8 + 1;
+    Matrix P;
+    P.set_size(n, m);
+    P.ptr[0] = 0;
+    for(ptrdiff_t i = 0; i < n; ++i)
+        P.ptr[i+1] = (i % 7 != 3);
+    P.set_nonzeros(P.scan_row_sizes());
+    for(ptrdiff_t i = 0, j = 0; i < n; ++i) {
+        if (P.ptr[i+1] == P.ptr[i]) continue;
+        P.col[j] = (i * 5 / 8) % m;
+        P.val[j] = 1 + 0.1 * (i % 3);
+        ++j;
+    }
+
+    auto R = amgcl::backend::transpose(P);
+
+    Matrix Ac;
+    amgcl::backend::spgemm_rap(*R, A, P, Ac, true);
+
+    Matrix AP, RAP;
+    amgcl::backend::spgemm_saad(A, P, AP, true);
+    amgcl::backend::spgemm_saad(*R, AP, RAP, true);
+
+    check_equal(RAP, Ac);
+
+    // Chunked product gives the same result for any chunk size.
+    for(ptrdiff_t chunk : {1, 7, 1024}) {
+        Matrix Ak;
+        amgcl::backend::spgemm_rap_chunked(*R, A, P, Ak, true, chunk);
+        check_equal(RAP, Ak);
+    }
+
+    // Numeric phase for the scaled matrix.
+    for(ptrdiff_t j = 0; j < A.ptr[n]; ++j) A.val[j] *= 2;
+    amgcl::backend::spgemm_rap_numeric(*R, A, P, Ac);
+
+    for(size_t j = 0; j < RAP.nnz; ++j)
+        BOOST_CHECK_CLOSE(Ac.val[j], 2 * RAP.val[j], 1e-8);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
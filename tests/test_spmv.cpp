@@ -0,0 +1,109 @@
+#define BOOST_TEST_MODULE TestSpMV
+#include <boost/test/unit_test.hpp>
+
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+#include <amgcl/backend/builtin.hpp>
+#include <amgcl/adapter/crs_tuple.hpp>
+#include <amgcl/profiler.hpp>
+
+#ifdef _OPENMP
+#  include <omp.h>
+#endif
+
+namespace amgcl {
+    profiler<> prof;
+}
+
+typedef amgcl::backend::crs<double> Matrix;
+
+// Diagonal matrix with a few dense rows and a few empty rows. Each dense row
+// holds more nonzeros than a thread gets in the merge-path partition, so the
+// rows have to be split between the threads.
+Matrix split_row_matrix(ptrdiff_t n) {
+    std::vector<ptrdiff_t> ptr(1, 0), col;
+    std::vector<double>    val;
+
+    for(ptrdiff_t i = 0; i < n; ++i) {
+        if (i % 97 == 13) {
+            // Empty row.
+        } else if (i == 1 || i == n / 2) {
+            for(ptrdiff_t j = 0; j < n; ++j) {
+                col.push_back(j);
+                val.push_back(1.0 / (1 + std::abs(i - j)));
+            }
+        } else {
+            col.push_back(i);
+            val.push_back(2.0 + i % 3);
+        }
+        ptr.push_back(col.size());
+    }
+
+    return Matrix(std::make_tuple(n, ptr, col, val));
+}
+
+BOOST_AUTO_TEST_SUITE( test_spmv )
+
+BOOST_AUTO_TEST_CASE(merge_path_split_rows)
+{
+#ifdef _OPENMP
+    const int nt_save = omp_get_max_threads();
+#endif
+
+    const ptrdiff_t n = 2000;
+    Matrix A = split_row_matrix(n);
+    BOOST_REQUIRE_GT(n, static_cast<ptrdiff_t>(A.nnz / 4));
+
+    std::vector<double> x(n), f(n), y0(n);
+    for(ptrdiff_t i = 0; i < n; ++i) {
+        x[i]  = std::sin(0.1 * i);
+        f[i]  = std::cos(0.2 * i);
+        y0[i] = 1.0 + 0.5 * std::sin(0.3 * i);
+    }
+
+    // Serial reference: z = A * x
+    std::vector<double> z(n, 0.0);
+    for(ptrdiff_t i = 0; i < n; ++i)
+        for(ptrdiff_t j = A.ptr[i]; j < A.ptr[i+1]; ++j)
+            z[i] += A.val[j] * x[A.col[j]];
+
+    const double alpha = 0.5, beta = -0.25;
+
+    for(int nt : {4, 7, 16}) {
+#ifdef _OPENMP
+        omp_set_num_threads(nt);
+#endif
+        auto part = A.merge_path();
+
+        // Make sure the partition actually splits some of the rows.
+        bool split = false;
+        for(int p = 1; p < part->nparts; ++p)
+            if (part->nnz[p] > A.ptr[part->row[p]]) split = true;
+#ifdef _OPENMP
+        BOOST_CHECK(split);
+#endif
+
+        std::vector<double> y(n, 42.0);
+        amgcl::backend::spmv(alpha, A, x, 0.0, y);
+        for(ptrdiff_t i = 0; i < n; ++i)
+            BOOST_CHECK_SMALL(y[i] - alpha * z[i], 1e-12);
+
+        y = y0;
+        amgcl::backend::spmv(alpha, A, x, beta, y);
+        for(ptrdiff_t i = 0; i < n; ++i)
+            BOOST_CHECK_SMALL(y[i] - (alpha * z[i] + beta * y0[i]), 1e-12);
+
+        std::vector<double> r(n, 42.0);
+        amgcl::backend::residual(f, A, x, r);
+        for(ptrdiff_t i = 0; i < n; ++i)
+            BOOST_CHECK_SMALL(r[i] - (f[i] - z[i]), 1e-12);
+    }
+
+#ifdef _OPENMP
+    omp_set_num_threads(nt_save);
+#endif
+}
+
+BOOST_AUTO_TEST_SUITE_END()
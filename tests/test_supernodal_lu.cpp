@@ -0,0 +1,110 @@
+#define BOOST_TEST_MODULE TestSupernodalLU
+#include <boost/test/unit_test.hpp>
+
+#include <amgcl/adapter/zero_copy.hpp>
+#include <amgcl/adapter/crs_tuple.hpp>
+#include <amgcl/solver/supernodal_lu.hpp>
+#include <amgcl/backend/builtin.hpp>
+#include <amgcl/value_type/static_matrix.hpp>
+#include <amgcl/make_solver.hpp>
+#include <amgcl/amg.hpp>
+#include <amgcl/coarsening/smoothed_aggregation.hpp>
+#include <amgcl/relaxation/spai0.hpp>
+#include <amgcl/solver/bicgstab.hpp>
+#include <amgcl/profiler.hpp>
+#include "sample_problem.hpp"
+
+namespace amgcl {
+    profiler<> prof;
+}
+
+BOOST_AUTO_TEST_SUITE( test_supernodal_lu )
+
+BOOST_AUTO_TEST_CASE(supernodal_lu)
+{
+    std::vector<ptrdiff_t> ptr;
+    std::vector<ptrdiff_t> col;
+    std::vector<double>    val;
+    std::vector<double>    rhs;
+
+    size_t n = sample_problem(16, val, col, ptr, rhs);
+
+    // Make the matrix nonsymmetric (but keep the diagonal dominance).
+    for(size_t i = 0; i < n; ++i)
+        for(ptrdiff_t j = ptr[i]; j < ptr[i+1]; ++j)
+            if (col[j] > static_cast<ptrdiff_t>(i)) val[j] *= 0.8;
+
+    auto A = amgcl::adapter::zero_copy(n, ptr.data(), col.data(), val.data());
+
+    amgcl::solver::supernodal_lu<double> solve(*A);
+
+    std::vector<double> x(n);
+    std::vector<double> r(n);
+
+    solve(rhs, x);
+
+    amgcl::backend::residual(rhs, *A, x, r);
+
+    BOOST_CHECK_SMALL(sqrt(amgcl::backend::inner_product(r, r) /
+                amgcl::backend::inner_product(rhs, rhs)), 1e-10);
+}
+
+BOOST_AUTO_TEST_CASE(supernodal_lu_block)
+{
+    typedef amgcl::static_matrix<double, 2, 2> value_type;
+    typedef amgcl::static_matrix<double, 2, 1> rhs_type;
+
+    std::vector<ptrdiff_t>  ptr;
+    std::vector<ptrdiff_t>  col;
+    std::vector<value_type> val;
+    std::vector<rhs_type>   rhs;
+
+    size_t n = sample_problem(12, val, col, ptr, rhs);
+
+    amgcl::backend::crs<value_type> A(std::tie(n, ptr, col, val));
+    amgcl::solver::supernodal_lu<value_type> solve(A);
+
+    std::vector<rhs_type> x(n);
+    std::vector<rhs_type> r(n);
+
+    solve(rhs, x);
+
+    amgcl::backend::residual(rhs, A, x, r);
+
+    BOOST_CHECK_SMALL(sqrt(amgcl::backend::inner_product(r, r) /
+                amgcl::backend::inner_product(rhs, rhs)), 1e-10);
+}
+
+BOOST_AUTO_TEST_CASE(supernodal_lu_coarse_solver)
+{
+    typedef amgcl::backend::builtin<double, ptrdiff_t, ptrdiff_t,
+            amgcl::solver::supernodal_lu<double> > Backend;
+
+    typedef amgcl::make_solver<
+        amgcl::amg<
+            Backend,
+            amgcl::coarsening::smoothed_aggregation,
+            amgcl::relaxation::spai0
+            >,
+        amgcl::solver::bicgstab<Backend>
+        > Solver;
+
+    std::vector<ptrdiff_t> ptr;
+    std::vector<ptrdiff_t> col;
+    std::vector<double>    val;
+    std::vector<double>    rhs;
+
+    size_t n = sample_problem(32, val, col, ptr, rhs);
+
+    Solver solve(std::tie(n, ptr, col, val));
+
+    std::vector<double> x(n, 0.0);
+    size_t iters;
+    double error;
+
+    std::tie(iters, error) = solve(rhs, x);
+
+    BOOST_CHECK_SMALL(error, 1e-8);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,188 @@
+#define BOOST_TEST_MODULE TestThreads
+#include <boost/test/unit_test.hpp>
+
+#include <vector>
+
+#include <amgcl/backend/builtin.hpp>
+#include <amgcl/amg.hpp>
+#include <amgcl/coarsening/smoothed_aggregation.hpp>
+#include <amgcl/relaxation/chebyshev.hpp>
+#include <amgcl/relaxation/runtime.hpp>
+#include <amgcl/adapter/crs_tuple.hpp>
+#include <amgcl/profiler.hpp>
+#include "sample_problem.hpp"
+
+#ifdef _OPENMP
+#  include <omp.h>
+#endif
+
+namespace amgcl {
+    profiler<> prof;
+}
+
+typedef amgcl::backend::builtin<double> Backend;
+
+typedef amgcl::amg<
+    Backend,
+    amgcl::coarsening::smoothed_aggregation,
+    amgcl::relaxation::chebyshev
+    > AMG;
+
+BOOST_AUTO_TEST_SUITE( test_threads )
+
+BOOST_AUTO_TEST_CASE(team_cycle)
+{
+    typedef amgcl::amg<
+        Backend,
+        amgcl::coarsening::smoothed_aggregation,
+        amgcl::runtime::relaxation::wrapper
+        > TeamAMG;
+
+    std::vector<ptrdiff_t> ptr;
+    std::vector<ptrdiff_t> col;
+    std::vector<double>    val;
+    std::vector<double>    rhs;
+
+    const ptrdiff_t n = sample_problem(32, val, col, ptr, rhs);
+
+#ifdef _OPENMP
+    const int nt = omp_get_max_threads();
+    omp_set_num_threads(4);
+#endif
+
+    // The gauss_seidel smoother does not support the team cycle, and falls
+    // back to the usual one.
+    amgcl::runtime::relaxation::type relax[] = {
+        amgcl::runtime::relaxation::spai0,
+        amgcl::runtime::relaxation::damped_jacobi,
+        amgcl::runtime::relaxation::gauss_seidel
+    };
+
+    for(amgcl::runtime::relaxation::type r : relax) {
+        for(unsigned ncycle = 1; ncycle <= 2; ++ncycle) {
+            TeamAMG::params prm;
+            prm.coarse_enough = 100;
+            prm.ncycle = ncycle;
+            prm.relax.put("type", r);
+
+            TeamAMG amg0(std::tie(n, ptr, col, val), prm);
+
+            prm.team_cycle = true;
+            prm.team_min_rows = 1000;
+
+            TeamAMG amg1(std::tie(n, ptr, col, val), prm);
+
+            std::vector<double> x0(n), x1(n);
+
+            amg0.apply(rhs, x0);
+            amg1.apply(rhs, x1);
+
+            for(ptrdiff_t i = 0; i < n; ++i)
+                BOOST_CHECK_CLOSE(x0[i], x1[i], 1e-8);
+        }
+    }
+
+#ifdef _OPENMP
+    omp_set_num_threads(nt);
+#endif
+}
+
+BOOST_AUTO_TEST_CASE(additive_teams)
+{
+    std::vector<ptrdiff_t> ptr;
+    std::vector<ptrdiff_t> col;
+    std::vector<double>    val;
+    std::vector<double>    rhs;
+
+    const ptrdiff_t n = sample_problem(32, val, col, ptr, rhs);
+
+#ifdef _OPENMP
+    const int nt     = omp_get_max_threads();
+    const int active = omp_get_max_active_levels();
+    omp_set_num_threads(4);
+#endif
+
+    AMG::params prm;
+    prm.coarse_enough = 100;
+    prm.cycle = amgcl::cycle_type::additive;
+
+    AMG amg(std::tie(n, ptr, col, val), prm);
+
+    // The levels are smoothed one after another without the nested
+    // parallelism, and by the teams of threads with it. The setting of the
+    // caller is not changed in either case.
+    std::vector<double> x0(n), x1(n);
+
+#ifdef _OPENMP
+    omp_set_max_active_levels(1);
+#endif
+    amg.apply(rhs, x0);
+#ifdef _OPENMP
+    BOOST_CHECK_EQUAL(omp_get_max_active_levels(), 1);
+    omp_set_max_active_levels(2);
+#endif
+    amg.apply(rhs, x1);
+#ifdef _OPENMP
+    BOOST_CHECK_EQUAL(omp_get_max_active_levels(), 2);
+    BOOST_CHECK_EQUAL(omp_get_max_threads(), 4);
+#endif
+
+    for(ptrdiff_t i = 0; i < n; ++i)
+        BOOST_CHECK_CLOSE(x0[i], x1[i], 1e-8);
+
+#ifdef _OPENMP
+    omp_set_max_active_levels(active);
+    omp_set_num_threads(nt);
+#endif
+}
+
+BOOST_AUTO_TEST_CASE(level_threads)
+{
+    std::vector<ptrdiff_t> ptr;
+    std::vector<ptrdiff_t> col;
+    std::vector<double>    val;
+    std::vector<double>    rhs;
+
+    const ptrdiff_t n = sample_problem(32, val, col, ptr, rhs);
+
+#ifdef _OPENMP
+    const int nt = omp_get_max_threads();
+    omp_set_num_threads(4);
+#endif
+
+    // The per-level thread selection is enabled by default.
+    BOOST_CHECK_GT(AMG::params().min_rows_per_thread, 0u);
+
+    // All threads on each level, the default limit, and the single thread
+    // on each level.
+    unsigned min_rows[] = {0, AMG::params().min_rows_per_thread, 1u << 30};
+
+    std::vector<double> x0(n);
+    for(unsigned m : min_rows) {
+        AMG::params prm;
+        prm.min_rows_per_thread = m;
+
+        AMG amg(std::tie(n, ptr, col, val), prm);
+
+        std::vector<double> x(n);
+        amg.apply(rhs, x);
+
+        if (m == 0) {
+            x0 = x;
+        } else {
+            for(ptrdiff_t i = 0; i < n; ++i)
+                BOOST_CHECK_CLOSE(x0[i], x[i], 1e-8);
+        }
+
+#ifdef _OPENMP
+        // The thread limit of the caller is restored.
+        BOOST_CHECK_EQUAL(omp_get_max_threads(), 4);
+#endif
+    }
+
+#ifdef _OPENMP
+    omp_set_num_threads(nt);
+#endif
+}
+
+BOOST_AUTO_TEST_SUITE_END()